@@ -30,6 +30,7 @@
 #include <queue>
 #include <set>
 #include <memory>
+#include <random>
 
 #ifndef let
 #define let const auto
@@ -259,3 +260,127 @@ void DoWriteOutput(const ConfigParameters& config)
 
 template void DoWriteOutput<float>(const ConfigParameters& config);
 template void DoWriteOutput<double>(const ConfigParameters& config);
+
+// ===========================================================================
+// DoOptimizeForEvaluation() - implements CNTK "optimizeForEval" command
+// ===========================================================================
+
+// Evaluate the outputs numIterations times on one random minibatch and return the average time in milliseconds.
+// The inputs are generated from the names of the input nodes, so that two networks with the same inputs see the same data.
+template <typename ElemType>
+static double MeasureEvaluationLatency(const ComputationNetworkPtr& net, const vector<wstring>& outputNodeNames, size_t minibatchSize, size_t numIterations,
+                                       vector<vector<ElemType>>& outputValues)
+{
+    ScopedNetworkOperationMode modeGuard(net, NetworkOperationMode::inferring);
+    auto outputNodes = net->OutputNodesByName(outputNodeNames);
+    auto inputNodes = net->InputNodesForOutputs(outputNodeNames);
+    net->AllocateAllMatrices({}, outputNodes, nullptr);
+    net->StartEvaluateMinibatchLoop(outputNodes);
+
+    for (const auto& node : inputNodes)
+    {
+        Matrix<ElemType>& value = dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value();
+        size_t numRows = node->GetSampleLayout().GetNumElements();
+        unsigned long seed = (unsigned long)std::hash<wstring>()(node->NodeName());
+        if (value.GetMatrixType() == MatrixType::SPARSE)
+        {
+            // one-hot columns, as for word or label inputs
+            mt19937 rng(seed);
+            vector<CPUSPARSE_INDEX_TYPE> columnStarts(minibatchSize + 1);
+            vector<CPUSPARSE_INDEX_TYPE> rows(minibatchSize);
+            vector<ElemType> ones(minibatchSize, 1);
+            for (size_t j = 0; j < minibatchSize; j++)
+            {
+                columnStarts[j] = (CPUSPARSE_INDEX_TYPE)j;
+                rows[j] = (CPUSPARSE_INDEX_TYPE)(rng() % numRows);
+            }
+            columnStarts[minibatchSize] = (CPUSPARSE_INDEX_TYPE)minibatchSize;
+            value.SetMatrixFromCSCFormat(columnStarts.data(), rows.data(), ones.data(), minibatchSize, numRows, minibatchSize);
+        }
+        else
+        {
+            value.Resize(numRows, minibatchSize);
+            value.SetUniformRandomValue(-1, 1, seed);
+        }
+
+        if (node->HasMBLayout())
+        {
+            node->GetMBLayout()->Init(1, minibatchSize);
+            node->GetMBLayout()->AddSequence(0, 0, 0, minibatchSize);
+        }
+    }
+
+    // the first pass is not timed
+    auto start = chrono::high_resolution_clock::now();
+    for (size_t iteration = 0; iteration <= numIterations; iteration++)
+    {
+        if (iteration == 1)
+            start = chrono::high_resolution_clock::now();
+
+        ComputationNetwork::BumpEvalTimeStamp(inputNodes);
+        net->ForwardProp(outputNodes);
+
+        outputValues.resize(outputNodes.size());
+        for (size_t i = 0; i < outputNodes.size(); i++)
+        {
+            const Matrix<ElemType>& value = dynamic_pointer_cast<ComputationNode<ElemType>>(outputNodes[i])->Value();
+            unique_ptr<ElemType[]> data(value.CopyToArray());
+            outputValues[i].assign(data.get(), data.get() + value.GetNumElements());
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    return numIterations == 0 ? 0 : chrono::duration<double, milli>(end - start).count() / numIterations;
+}
+
+// Rewrite a trained model for evaluation (see ComputationNetwork::OptimizeForEvaluation()) and save the result as a new model.
+// The original and the optimized network are compared on the same random inputs.
+template <typename ElemType>
+void DoOptimizeForEvaluation(const ConfigParameters& config)
+{
+    DEVICEID_TYPE deviceId = DeviceFromConfig(config);
+    wstring modelPath = config(L"modelPath");
+    wstring outputModelPath = config(L"outputModelPath");
+    size_t minibatchSize = config(L"minibatchSize", (size_t)1);
+    size_t numIterations = config(L"numIterations", (size_t)100);
+
+    ConfigArray outputNodeNames = config(L"outputNodeNames", "");
+    vector<wstring> outputNodeNamesVector;
+    for (int i = 0; i < outputNodeNames.size(); ++i)
+    {
+        outputNodeNamesVector.push_back(outputNodeNames[i]);
+    }
+
+    if (modelPath == outputModelPath)
+        InvalidArgument("optimizeForEval command: outputModelPath must differ from modelPath.");
+    if (minibatchSize == 0)
+        InvalidArgument("optimizeForEval command: minibatchSize must be positive.");
+
+    ComputationNetworkPtr net = ComputationNetwork::CreateFromFile<ElemType>(deviceId, modelPath);
+    ComputationNetworkPtr optimizedNet = ComputationNetwork::CreateFromFile<ElemType>(deviceId, modelPath);
+    optimizedNet->OptimizeForEvaluation<ElemType>();
+    optimizedNet->Save(outputModelPath);
+
+    vector<vector<ElemType>> outputValues;
+    vector<vector<ElemType>> optimizedOutputValues;
+    double latency = MeasureEvaluationLatency(net, outputNodeNamesVector, minibatchSize, numIterations, outputValues);
+    double optimizedLatency = MeasureEvaluationLatency(optimizedNet, outputNodeNamesVector, minibatchSize, numIterations, optimizedOutputValues);
+
+    double maxDifference = 0;
+    for (size_t i = 0; i < outputValues.size(); i++)
+    {
+        if (outputValues[i].size() != optimizedOutputValues[i].size())
+            LogicError("optimizeForEval command: output %d has %d elements in the optimized network instead of %d.", (int)i, (int)optimizedOutputValues[i].size(), (int)outputValues[i].size());
+        for (size_t j = 0; j < outputValues[i].size(); j++)
+            maxDifference = max(maxDifference, (double)fabs(outputValues[i][j] - optimizedOutputValues[i][j]));
+    }
+
+    fprintf(stderr, "\noptimizeForEval: saved the optimized model to '%ls'.\n", outputModelPath.c_str());
+    fprintf(stderr, "optimizeForEval: number of nodes: %d before, %d after.\n", (int)net->GetTotalNumberOfNodes(), (int)optimizedNet->GetTotalNumberOfNodes());
+    if (numIterations > 0)
+        fprintf(stderr, "optimizeForEval: latency per minibatch of %d samples: %.3f ms before, %.3f ms after (%.2fx).\n",
+                (int)minibatchSize, latency, optimizedLatency, optimizedLatency > 0 ? latency / optimizedLatency : 0);
+    fprintf(stderr, "optimizeForEval: largest difference between the outputs: %g\n", maxDifference);
+}
+
+template void DoOptimizeForEvaluation<float>(const ConfigParameters& config);
+template void DoOptimizeForEvaluation<double>(const ConfigParameters& config);
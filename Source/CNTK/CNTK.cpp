@@ -18,6 +18,8 @@
 #include "NDLNetworkBuilder.h"
 #include "ModelEditLanguage.h"
 #include "CPUMatrix.h" // used for SetNumThreads()
+#include "CPUFastMath.h"
+#include "CPUGemm.h"
 #include "CommonMatrix.h"
 #include "SGD.h"
 #include "MPIWrapper.h"
@@ -60,6 +62,10 @@
 // sharing is ready to be enabled by default
 bool g_shareNodeValueMatrices = false;
 
+// Flag that enables fusing chains of element-wise nodes when compiling a network,
+// see ComputationNetwork::FuseElementwiseNodes()
+bool g_fuseElementwiseNodes = false;
+
 using namespace std;
 using namespace Microsoft::MSR;
 using namespace Microsoft::MSR::CNTK;
@@ -293,6 +299,10 @@ void DoCommands(const ConfigParameters& config, const shared_ptr<MPIWrapper>& mp
                 {
                     DoParameterSVD<ElemType>(commandParams);
                 }
+                else if (thisAction == "optimizeForEval")
+                {
+                    DoOptimizeForEvaluation<ElemType>(commandParams);
+                }
                 else
                 {
                     RuntimeError("unknown action: %s  in command set: %s", thisAction.c_str(), command[i].c_str());
@@ -478,6 +488,9 @@ int wmainWithBS(int argc, wchar_t* argv[]) // called from wmain which is a wrapp
         mpi = MPIWrapper::GetInstance(true /*create*/);
 
     g_shareNodeValueMatrices = config(L"shareNodeValueMatrices", false);
+    g_fuseElementwiseNodes = config(L"fuseElementwiseNodes", false);
+    SetCPUMathFunctions(ParseCPUMathFunctions(config(L"mathFunctions", L"exact"))); // process-wide, see CPUFastMath.h
+    SetCPUGemmPolicy(ParseCPUGemmPolicy(config(L"cpuGemm", L"blas")));               // process-wide, see CPUGemm.h
 
     TracingGPUMemoryAllocator::SetTraceLevel(config(L"traceGPUMemoryAllocations", 0));
 
@@ -576,6 +589,9 @@ int wmainOldCNTKConfig(int argc, wchar_t* argv[])
         mpi = MPIWrapper::GetInstance(true /*create*/);
 
     g_shareNodeValueMatrices = config(L"shareNodeValueMatrices", false);
+    g_fuseElementwiseNodes = config(L"fuseElementwiseNodes", false);
+    SetCPUMathFunctions(ParseCPUMathFunctions(config(L"mathFunctions", L"exact"))); // process-wide, see CPUFastMath.h
+    SetCPUGemmPolicy(ParseCPUGemmPolicy(config(L"cpuGemm", L"blas")));               // process-wide, see CPUGemm.h
 
     TracingGPUMemoryAllocator::SetTraceLevel(config(L"traceGPUMemoryAllocations", 0));
 
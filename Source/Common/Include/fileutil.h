@@ -603,6 +603,41 @@ std::vector<char*> fgetfilelines(const std::wstring& pathname, std::vector<char>
 
 }}
 
+// ----------------------------------------------------------------------------
+// mappedfile -- read-only memory mapping of an entire file
+// Pages are brought in by the OS on access and shared between processes
+// that map the same file, so large archives cost no heap memory.
+// ----------------------------------------------------------------------------
+
+namespace msra { namespace files {
+
+class mappedfile
+{
+    const char* p; // start of the mapping; NULL for an empty file
+    size_t n;      // file size in bytes
+#ifdef _WIN32
+    HANDLE hfile;
+    HANDLE hmapping;
+#else
+    int fd;
+#endif
+    mappedfile(const mappedfile&);            // non-copyable
+    mappedfile& operator=(const mappedfile&);
+
+public:
+    mappedfile(const std::wstring& pathname); // open and map, or throw
+    ~mappedfile();
+    const char* data() const
+    {
+        return p;
+    }
+    size_t size() const
+    {
+        return n;
+    }
+};
+}}
+
 #ifdef _WIN32
 // ----------------------------------------------------------------------------
 // getfiletime(), setfiletime(): access modification time
@@ -21,6 +21,8 @@
 #include <string>
 #include <unordered_map>
 #include <algorithm> // for find()
+#include <memory>
+#include <mutex>
 #include "simplesenonehmm.h"
 #include "Matrix.h"
 
@@ -916,9 +918,25 @@ public:
         fwriteOrDie(v, f);
     }
 
-    void fwrite(FILE* f)
+    // 'compact' selects the V3 format (see packv3()); lattices that do not fit it are written as V2
+    void fwrite(FILE* f, bool compact = false)
     {
 #if 1
+        if (compact)
+        {
+            std::vector<unsigned char> packednodes, packededges, packedtokens;
+            if (packv3(packednodes, packededges, packedtokens))
+            {
+                fwritetag(f, "LAT ", 3);
+                fwriteOrDie(&info, sizeof(info), 1, f);
+                fwritevector(f, "PNOD", packednodes);
+                fwritevector(f, "PEDG", packededges);
+                fwritevector(f, "PALN", packedtokens);
+                fputTag(f, "END ");
+                return;
+            }
+            fprintf(stderr, "fwrite: lattice '%S' has unexpected alignment records, cannot write it in compact format; using V2\n", key.c_str());
+        }
         const size_t version = 2; // format version
         fwritetag(f, "LAT ", version);
         fwriteOrDie(&info, sizeof(info), 1, f);
@@ -939,6 +957,7 @@ public:
 
     // empty constructor, e.g. for use in minibatch source
     lattice()
+        : decoded(false)
     {
     }
 
@@ -990,79 +1009,450 @@ public:
             freadvector(f, "EDGS", edges2, info.numedges); // uniqued edges
             freadvector(f, "ALNS", uniquededgedatatokens); // uniqued alignments
             fcheckTag(f, "END ");
+            finishv2(idmap, spunit);
+        }
+        else if (version == 3)
+        {
+            freadOrDie(&info, sizeof(info), 1, f);
+            std::vector<unsigned char> packednodes, packededges, packedtokens;
+            freadvector(f, "PNOD", packednodes);
+            freadvector(f, "PEDG", packededges);
+            freadvector(f, "PALN", packedtokens);
+            fcheckTag(f, "END ");
+            unpackv3(packednodes, packededges, packedtokens);
+            if (nodes.back().t != info.numframes)
+                RuntimeError("fread: mismatch between info.numframes and last node's time");
+            finishv2(idmap, spunit);
+        }
+        else
+            RuntimeError("fread: unsupported lattice format version");
+    }
+
+    // second half of reading a V2 (or V3) lattice, after nodes, edges2 and uniquededgedatatokens have been loaded:
+    // map the units to the user's symbol map and reconstruct edges/align
+    template <class IDMAP>
+    void finishv2(const IDMAP& idmap, size_t spunit)
+    {
 // check if we need to map
-#if 1                                                                                     // post-bugfix for incorrect inference of spunit
-            if (info.impliedspunitid != SIZE_MAX && info.impliedspunitid >= idmap.size()) // we have buggy lattices like that--what do they mean??
-            {
-                fprintf(stderr, "fread: detected buggy spunit id %d which is out of range (%d entries in map)\n", (int) info.impliedspunitid, (int) idmap.size());
-                RuntimeError("fread: out of bounds spunitid");
-            }
+#if 1                                                                                 // post-bugfix for incorrect inference of spunit
+        if (info.impliedspunitid != SIZE_MAX && info.impliedspunitid >= idmap.size()) // we have buggy lattices like that--what do they mean??
+        {
+            fprintf(stderr, "fread: detected buggy spunit id %d which is out of range (%d entries in map)\n", (int) info.impliedspunitid, (int) idmap.size());
+            RuntimeError("fread: out of bounds spunitid");
+        }
 #endif
-            // This is critical--we have a buggy lattice set that requires no mapping where mapping would fail
-            bool needsmapping = false;
-            foreach_index (k, idmap)
-            {
-                if (idmap[k] != (size_t) k
+        // This is critical--we have a buggy lattice set that requires no mapping where mapping would fail
+        bool needsmapping = false;
+        foreach_index (k, idmap)
+        {
+            if (idmap[k] != (size_t) k
 #if 1
-                    && (k != (int) idmap.size() - 1 || idmap[k] != spunit) // that HACK that we add one more /sp/ entry at the end...
+                && (k != (int) idmap.size() - 1 || idmap[k] != spunit) // that HACK that we add one more /sp/ entry at the end...
 #endif
-                    )
-                {
-                    needsmapping = true;
-                    break;
-                }
+                )
+            {
+                needsmapping = true;
+                break;
             }
-            // map align ids to user's symmap  --the lattice gets updated in place here
-            if (needsmapping)
+        }
+        // map align ids to user's symmap  --the lattice gets updated in place here
+        if (needsmapping)
+        {
+            if (info.impliedspunitid != SIZE_MAX)
+                info.impliedspunitid = idmap[info.impliedspunitid];
+
+            // deal with broken (zero-token) edges
+            std::vector<bool> isendworkaround;
+            if (info.impliedspunitid != spunit)
             {
-                if (info.impliedspunitid != SIZE_MAX)
-                    info.impliedspunitid = idmap[info.impliedspunitid];
+                fprintf(stderr, "fread: lattice with broken spunit, using workaround to handle potentially broken zero-token edges\n");
+                inferends(isendworkaround);
+            }
 
-                // deal with broken (zero-token) edges
-                std::vector<bool> isendworkaround;
-                if (info.impliedspunitid != spunit)
+            size_t uniquealignments = 1;
+            const size_t skipscoretokens = info.hasacscores ? 2 : 1;
+            for (size_t k = skipscoretokens; k < uniquededgedatatokens.size(); k++)
+            {
+                if (!isendworkaround.empty() && isendworkaround[k]) // secondary criterion to detect ends in broken lattices
                 {
-                    fprintf(stderr, "fread: lattice with broken spunit, using workaround to handle potentially broken zero-token edges\n");
-                    inferends(isendworkaround);
+                    k--; // don't advance, since nothing to advance over
                 }
-
-                size_t uniquealignments = 1;
-                const size_t skipscoretokens = info.hasacscores ? 2 : 1;
-                for (size_t k = skipscoretokens; k < uniquededgedatatokens.size(); k++)
+                else
                 {
-                    if (!isendworkaround.empty() && isendworkaround[k]) // secondary criterion to detect ends in broken lattices
-                    {
-                        k--; // don't advance, since nothing to advance over
-                    }
-                    else
-                    {
-                        // this is a regular token: update it in-place
-                        auto& ai = uniquededgedatatokens[k];
-                        if (ai.unit >= idmap.size())
-                            RuntimeError("fread: broken-file heuristics failed");
-                        ai.updateunit(idmap); // updates itself
-                        if (!ai.last)
-                            continue;
-                    }
-                    // if last then skip over the lm and ac scores
-                    k += skipscoretokens;
-                    uniquealignments++;
+                    // this is a regular token: update it in-place
+                    auto& ai = uniquededgedatatokens[k];
+                    if (ai.unit >= idmap.size())
+                        RuntimeError("fread: broken-file heuristics failed");
+                    ai.updateunit(idmap); // updates itself
+                    if (!ai.last)
+                        continue;
                 }
-                fprintf(stderr, "fread: mapped %d unique alignments\n", (int) uniquealignments);
+                // if last then skip over the lm and ac scores
+                k += skipscoretokens;
+                uniquealignments++;
             }
-            if (info.impliedspunitid != spunit)
+            fprintf(stderr, "fread: mapped %d unique alignments\n", (int) uniquealignments);
+        }
+        if (info.impliedspunitid != spunit)
+        {
+            // fprintf (stderr, "fread: inconsistent spunit id in file %d vs. expected %d; due to erroneous heuristic\n", info.impliedspunitid, spunit);    // [v-hansu] comment out becaues it takes up most of the log
+            // it's actually OK, we can live with this, since we only decompress and then move on without any assumptions
+            // RuntimeError("fread: mismatching /sp/ units");
+        }
+        // reconstruct old lattice format from this   --TODO: remove once we change to new data representation
+        rebuildedges(info.impliedspunitid != spunit /*to be able to read somewhat broken V2 lattice archives*/);
+    }
+
+private:
+    // -----------------------------------------------------------------------
+    // compact (V3) format
+    // Same content as V2, but with all integers variable-length coded
+    // (7 bits per byte, high bit set if more bytes follow) and most of them
+    // as deltas:
+    //  - PNOD: node times, each relative to the previous node
+    //  - PEDG: per edge, S relative to the previous edge's S; E relative to S
+    //    (with implysp in the lowest bit); firstalign relative to the previous edge's
+    //  - PALN: per unique alignment, the raw ac (if any) and LM scores, followed
+    //    by unit and (frames, last) of each token up to the one flagged 'last'
+    // Deltas are zig-zag coded so that small negative values stay short.
+    // -----------------------------------------------------------------------
+
+    static void putvarint(std::vector<unsigned char>& buf, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            buf.push_back((unsigned char) (v | 0x80));
+            v >>= 7;
+        }
+        buf.push_back((unsigned char) v);
+    }
+    static uint64_t getvarint(const unsigned char*& p, const unsigned char* end)
+    {
+        uint64_t v = 0;
+        for (size_t shift = 0;; shift += 7)
+        {
+            if (p == end || shift > 63)
+                RuntimeError("getvarint: malformed compact lattice");
+            const unsigned char b = *p++;
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                return v;
+        }
+    }
+    static uint64_t zigzag(int64_t v)
+    {
+        return ((uint64_t) v << 1) ^ (uint64_t)(v >> 63);
+    }
+    static int64_t unzigzag(uint64_t v)
+    {
+        return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    }
+
+    // encode nodes/edges2/uniquededgedatatokens; returns false if the tokens are not a sequence of well-formed alignment records
+    bool packv3(std::vector<unsigned char>& packednodes, std::vector<unsigned char>& packededges, std::vector<unsigned char>& packedtokens) const
+    {
+        packednodes.clear();
+        packededges.clear();
+        packedtokens.clear();
+        int64_t prevt = 0;
+        foreach_index (i, nodes)
+        {
+            putvarint(packednodes, zigzag((int64_t) nodes[i].t - prevt));
+            prevt = nodes[i].t;
+        }
+        int64_t prevS = 0;
+        int64_t prevfirstalign = 0;
+        foreach_index (j, edges2)
+        {
+            const auto& e = edges2[j];
+            putvarint(packededges, zigzag((int64_t) e.S - prevS));
+            putvarint(packededges, (zigzag((int64_t) e.E - (int64_t) e.S) << 1) | e.implysp);
+            putvarint(packededges, zigzag((int64_t) e.firstalign - prevfirstalign));
+            prevS = e.S;
+            prevfirstalign = e.firstalign;
+        }
+        const size_t skipscoretokens = info.hasacscores ? 2 : 1;
+        const size_t numtokens = uniquededgedatatokens.size();
+        for (size_t k = 0; k < numtokens;)
+        {
+            if (k + skipscoretokens > numtokens)
+                return false;
+            const unsigned char* scores = (const unsigned char*) &uniquededgedatatokens[k];
+            packedtokens.insert(packedtokens.end(), scores, scores + skipscoretokens * sizeof(aligninfo));
+            k += skipscoretokens;
+            while (k < numtokens) // (a final !NULL edge has no tokens)
             {
-                // fprintf (stderr, "fread: inconsistent spunit id in file %d vs. expected %d; due to erroneous heuristic\n", info.impliedspunitid, spunit);    // [v-hansu] comment out becaues it takes up most of the log
-                // it's actually OK, we can live with this, since we only decompress and then move on without any assumptions
-                // RuntimeError("fread: mismatching /sp/ units");
+                const aligninfo& ai = uniquededgedatatokens[k++];
+                if (ai.unused != 0)
+                    return false;
+                putvarint(packedtokens, ai.unit);
+                putvarint(packedtokens, (ai.frames << 1) | ai.last);
+                if (ai.last)
+                    break;
+                if (k == numtokens) // missing 'last' flag
+                    return false;
             }
-            // reconstruct old lattice format from this   --TODO: remove once we change to new data representation
-            rebuildedges(info.impliedspunitid != spunit /*to be able to read somewhat broken V2 lattice archives*/);
+        }
+        return true;
+    }
+
+    // inverse of packv3(); info must have been read already
+    void unpackv3(const_array_ref<unsigned char> packednodes, const_array_ref<unsigned char> packededges, const_array_ref<unsigned char> packedtokens)
+    {
+        const unsigned char* p = packednodes.size() > 0 ? &packednodes[0] : NULL;
+        const unsigned char* end = p + packednodes.size();
+        nodes.resize(info.numnodes);
+        int64_t t = 0;
+        foreach_index (i, nodes)
+        {
+            t += unzigzag(getvarint(p, end));
+            nodes[i] = nodeinfo((size_t) t);
+        }
+        if (p != end || nodes.empty())
+            RuntimeError("unpackv3: malformed PNOD block");
+
+        p = packededges.size() > 0 ? &packededges[0] : NULL;
+        end = p + packededges.size();
+        edges2.resize(info.numedges);
+        int64_t S = 0;
+        int64_t firstalign = 0;
+        foreach_index (j, edges2)
+        {
+            S += unzigzag(getvarint(p, end));
+            const uint64_t v = getvarint(p, end);
+            const int64_t E = S + unzigzag(v >> 1);
+            firstalign += unzigzag(getvarint(p, end));
+            edges2[j] = edgeinfo((size_t) S, (size_t) E, (size_t) firstalign);
+            edges2[j].implysp = v & 1;
+        }
+        if (p != end)
+            RuntimeError("unpackv3: malformed PEDG block");
+
+        p = packedtokens.size() > 0 ? &packedtokens[0] : NULL;
+        end = p + packedtokens.size();
+        const size_t skipscoretokens = info.hasacscores ? 2 : 1;
+        uniquededgedatatokens.clear();
+        uniquededgedatatokens.reserve(packedtokens.size() / 2); // (rough guess: 2 bytes per token)
+        while (p != end)
+        {
+            if ((size_t)(end - p) < skipscoretokens * sizeof(aligninfo))
+                RuntimeError("unpackv3: malformed PALN block");
+            const size_t k = uniquededgedatatokens.size();
+            uniquededgedatatokens.resize(k + skipscoretokens);
+            memcpy(&uniquededgedatatokens[k], p, skipscoretokens * sizeof(aligninfo));
+            p += skipscoretokens * sizeof(aligninfo);
+            while (p != end)
+            {
+                const size_t unit = (size_t) getvarint(p, end);
+                const uint64_t v = getvarint(p, end);
+                aligninfo ai(unit, (size_t)(v >> 1));
+                ai.last = v & 1;
+                uniquededgedatatokens.push_back(ai);
+                if (ai.last)
+                    break;
+                if (p == end)
+                    RuntimeError("unpackv3: malformed PALN block, missing 'last' flag");
+            }
+        }
+    }
+
+public:
+    // -----------------------------------------------------------------------
+    // reading from memory-mapped archives
+    // -----------------------------------------------------------------------
+
+    // zero-copy view of one lattice inside a memory-mapped archive, as located through the archive's TOC
+    // The blocks point directly into the mapping, which 'file' keeps alive. Which blocks are set depends on the version:
+    // V1: nodes, edges, align; V2: nodes, edges2, uniquededgedatatokens; V3: the packed* blocks.
+    // Blocks are not necessarily aligned within the file; they are only ever memcpy()'d out.
+    struct mappedview
+    {
+        std::shared_ptr<const msra::files::mappedfile> file;
+        std::shared_ptr<const std::vector<unsigned int>> idmap; // [archive unit] -> unit in user's symbol map
+        size_t spunit;
+        size_t version;
+        header_v1_v2 info;
+        const_array_ref<nodeinfo> nodes;
+        const_array_ref<edgeinfowithscores> edges;
+        const_array_ref<aligninfo> align;
+        const_array_ref<edgeinfo> edges2;
+        const_array_ref<aligninfo> uniquededgedatatokens;
+        const_array_ref<unsigned char> packednodes;
+        const_array_ref<unsigned char> packededges;
+        const_array_ref<unsigned char> packedtokens;
+    };
+
+private:
+    // cursor for reading a lattice from memory, with the same tag checks as freadtag()/freadvector()
+    class memreader
+    {
+        const char* p;
+        const char* end;
+
+    public:
+        memreader(const char* p, const char* end)
+            : p(p), end(end)
+        {
+        }
+        const char* get(size_t bytes) // skip 'bytes' bytes and return where they begin
+        {
+            if (bytes > (size_t)(end - p))
+                RuntimeError("memreader: unexpected end of lattice archive");
+            const char* q = p;
+            p += bytes;
+            return q;
+        }
+        void checktag(const char* tag)
+        {
+            const char* q = get(4);
+            if (memcmp(q, tag, 4) != 0)
+                RuntimeError("memreader: invalid tag '%.4s' found; expected '%s'", q, tag);
+        }
+        size_t readtag(const char* tag)
+        {
+            checktag(tag);
+            unsigned int n;
+            memcpy(&n, get(sizeof(n)), sizeof(n));
+            return n;
+        }
+        template <class T>
+        const_array_ref<T> readvector(const char* tag, size_t expectedsize = SIZE_MAX)
+        {
+            const size_t sz = readtag(tag);
+            if (expectedsize != SIZE_MAX && sz != expectedsize)
+                RuntimeError("memreader: malformed file, number of vector elements differs from head, for tag %s", tag);
+            return const_array_ref<T>((const T*) get(sz * sizeof(T)), sz);
+        }
+    };
+
+    template <class T>
+    static void copyfrommapped(std::vector<T>& v, const_array_ref<T> block)
+    {
+        v.resize(block.size());
+        if (!v.empty())
+            memcpy(v.data(), &block[0], v.size() * sizeof(T));
+    }
+
+    std::shared_ptr<const mappedview> mapped; // if set, the content lives in a memory-mapped archive and is decoded on demand
+    bool decoded;                             // (if 'mapped') nodes/edges/align currently hold the decoded content
+
+    // decode the content from the mapped archive into nodes/edges/align, as fread() does from a file
+    void decode()
+    {
+        const mappedview& v = *mapped;
+        const auto& idmap = *v.idmap;
+        info = v.info;
+        if (v.version == 1)
+        {
+            copyfrommapped(nodes, v.nodes);
+            copyfrommapped(edges, v.edges);
+            copyfrommapped(align, v.align);
+            foreach_index (k, align)
+                align[k].updateunit(idmap); // updates itself
         }
         else
-            RuntimeError("fread: unsupported lattice format version");
+        {
+            if (v.version == 2)
+            {
+                copyfrommapped(nodes, v.nodes);
+                copyfrommapped(edges2, v.edges2);
+                copyfrommapped(uniquededgedatatokens, v.uniquededgedatatokens);
+            }
+            else
+                unpackv3(v.packednodes, v.packededges, v.packedtokens);
+            if (nodes.back().t != info.numframes)
+                RuntimeError("decode: mismatch between info.numframes and last node's time");
+            finishv2(idmap, v.spunit);
+        }
+        decoded = true;
+    }
+
+public:
+    // locate a lattice at 'offset' in a memory-mapped archive; only the header and the block sizes are read
+    static std::shared_ptr<const mappedview> mapview(const std::shared_ptr<const msra::files::mappedfile>& file, uint64_t offset,
+                                                     const std::shared_ptr<const std::vector<unsigned int>>& idmap, size_t spunit)
+    {
+        if (offset > file->size())
+            RuntimeError("mapview: lattice offset %llu beyond end of archive", (unsigned long long) offset);
+        memreader r(file->data() + offset, file->data() + file->size());
+        auto v = std::make_shared<mappedview>();
+        v->file = file;
+        v->idmap = idmap;
+        v->spunit = spunit;
+        v->version = r.readtag("LAT ");
+        memcpy(&v->info, r.get(sizeof(v->info)), sizeof(v->info));
+        if (v->version == 1)
+        {
+            v->nodes = r.readvector<nodeinfo>("NODE", v->info.numnodes);
+            v->edges = r.readvector<edgeinfowithscores>("EDGE", v->info.numedges);
+            v->align = r.readvector<aligninfo>("ALIG");
+        }
+        else if (v->version == 2)
+        {
+            v->nodes = r.readvector<nodeinfo>("NODS", v->info.numnodes);
+            v->edges2 = r.readvector<edgeinfo>("EDGS", v->info.numedges);
+            v->uniquededgedatatokens = r.readvector<aligninfo>("ALNS");
+        }
+        else if (v->version == 3)
+        {
+            v->packednodes = r.readvector<unsigned char>("PNOD");
+            v->packededges = r.readvector<unsigned char>("PEDG");
+            v->packedtokens = r.readvector<unsigned char>("PALN");
+        }
+        else
+            RuntimeError("mapview: unsupported lattice format version");
+        r.checktag("END ");
+        if (v->info.numnodes == 0)
+            RuntimeError("mapview: lattice without nodes");
+        return v;
+    }
+
+    // point this lattice to one in a memory-mapped archive; the content is decoded on demand, see ensuredecoded()
+    void attach(const std::shared_ptr<const mappedview>& view)
+    {
+        mapped = view;
+        info = view->info;
+        freedecoded();
+    }
+
+    // decode now and drop the reference to the archive, making this an ordinary in-memory lattice
+    void materialize()
+    {
+        if (mapped)
+        {
+            if (!decoded)
+                decode();
+            mapped.reset();
+        }
+    }
+
+    // Decode if attached to a memory-mapped archive and not decoded yet. Call this before accessing the content.
+    // Lattices are passed around as const; decoding does not change what they represent, hence the const_cast.
+    // Not thread-safe for the same lattice object.
+    void ensuredecoded() const
+    {
+        if (mapped && !decoded)
+            const_cast<lattice*>(this)->decode();
+    }
+
+    // free the decoded content of a lattice that is attached to a memory-mapped archive; it will be decoded again on next use
+    void releasedecoded() const
+    {
+        if (mapped && decoded)
+            const_cast<lattice*>(this)->freedecoded();
+    }
+
+private:
+    void freedecoded()
+    {
+        std::vector<nodeinfo>().swap(nodes);
+        std::vector<edgeinfowithscores>().swap(edges);
+        std::vector<aligninfo>().swap(align);
+        decoded = false;
     }
 
+public:
+
     // parallel versions (defined in parallelforwardbackward.cpp)
     class parallelstate
     {
@@ -1144,7 +1534,7 @@ class archive
     // set of phoneme mappings
     // Each archive file has its associated .symlist that defines the symbol mappings
     typedef std::vector<unsigned int> symbolidmapping;
-    mutable std::vector<symbolidmapping> symmaps; // [archiveindex][unit] -> global unit map
+    mutable std::vector<std::shared_ptr<symbolidmapping>> symmaps; // [archiveindex][unit] -> global unit map; shared with lattices read from the archive
     template <class SYMMAP>
     static size_t getid(const SYMMAP& symmap, const std::string& key)
     {
@@ -1154,9 +1544,11 @@ class archive
         return iter->second;
     }
     template <class SYMMAP>
-    const symbolidmapping& getcachedidmap(size_t archiveindex, const SYMMAP& symmap /*[string] -> numeric id*/) const
+    std::shared_ptr<const symbolidmapping> getcachedidmap(size_t archiveindex, const SYMMAP& symmap /*[string] -> numeric id*/) const
     {
-        symbolidmapping& idmap = symmaps[archiveindex];
+        if (!symmaps[archiveindex])
+            symmaps[archiveindex] = std::make_shared<symbolidmapping>();
+        symbolidmapping& idmap = *symmaps[archiveindex];
         if (idmap.empty()) // TODO: delete this: && !modelsymmap.empty()/*no mapping; used in conversion*/)
         {                  // need to read the map and establish the mapping
             // get the symlist file
@@ -1196,7 +1588,7 @@ class archive
             // append a fixed-position entry: last entry means /sp/
             idmap.push_back((unsigned int) getid(symmap, "sp"));
         }
-        return idmap;
+        return symmaps[archiveindex];
     }
     // all lattices read so far
     struct latticeref
@@ -1210,9 +1602,9 @@ class archive
     };
     static_assert(sizeof(latticeref) == 8, "unexpected byte size of struct latticeref");
 
-    mutable size_t currentarchiveindex;               // which archive is open
-    mutable auto_file_ptr f;                          // cached archive file handle of currentarchiveindex
-    std::unordered_map<std::wstring, latticeref> toc; // [key] -> (file, offset)  --table of content (.toc file)
+    mutable std::vector<std::shared_ptr<const msra::files::mappedfile>> mappedfiles; // [archiveindex] archive file, memory-mapped on first access
+    mutable std::mutex mappinglock;                                                   // guards mappedfiles[] and symmaps[]
+    std::unordered_map<std::wstring, latticeref> toc;                                 // [key] -> (file, offset)  --table of content (.toc file)
 public:
     // construct = open the archive
     // archive() : currentarchiveindex (SIZE_MAX) {}
@@ -1228,7 +1620,7 @@ public:
 
     // construct from a list of TOC files
     archive(const std::vector<std::wstring>& tocpaths, const std::unordered_map<std::string, size_t>& modelsymmap, const std::wstring prefixPath = L"")
-        : currentarchiveindex(SIZE_MAX), modelsymmap(modelsymmap), prefixPathInToc(prefixPath), verbosity(0)
+        : modelsymmap(modelsymmap), prefixPathInToc(prefixPath), verbosity(0)
     {
         if (tocpaths.empty()) // nothing to read--keep silent
             return;
@@ -1291,8 +1683,9 @@ public:
                 RuntimeError("open: TOC entry leads to duplicate key: %s", line);
         }
 
-        // initialize symmaps  --alloc the array, but actually read the symmap on demand
+        // initialize symmaps and mappings  --alloc the arrays, but actually read the symmap and map the file on demand
         symmaps.resize(archivepaths.size());
+        mappedfiles.resize(archivepaths.size());
     }
 
     // check if a lattice for a given key is available  --do this during initial check ideally
@@ -1318,8 +1711,10 @@ public:
     // 'key' is supposed to be known to exist. Use haslattice() to ensure. This is because this function is called from a retry loop.
     // Lattices will have unit ids updated according to the modelsymmap.
     // V1 lattices will be converted. 'spsenoneid' is used in the conversion for optimizing storing 0-frame /sp/ aligns.
+    // Archives are memory-mapped. With 'ondemand', L only gets the header and a view into the mapping; the content is decoded
+    // when it is used and freed again afterwards (see lattice::ensuredecoded()), so lattices cost RAM only while in use.
     void getlattice(const std::wstring& key, lattice& L,
-                    size_t expectedframes = SIZE_MAX /*if unknown*/) const
+                    size_t expectedframes = SIZE_MAX /*if unknown*/, bool ondemand = false) const
     {
         auto iter = toc.find(key);
         if (iter == toc.end())
@@ -1327,26 +1722,32 @@ public:
         // get the archive that the lattice lives in and its byte offset
         const size_t archiveindex = iter->second.archiveindex;
         const auto offset = iter->second.offset;
-        // get id map (used below); this may lazily load a .symlist file. We do it here rather than later w.r.t. an outer retry loop.
-        auto& idmap = getcachedidmap(archiveindex, modelsymmap); // at first time, this will load the .symlist file and create a mapping to the user SYMMAP
-        const size_t spunit = idmap.back();                      // ugh--getcachedidmap() just appends it to the end
-#if 1                                                            // prep for fixing the pushing of /sp/ at the end  --we actually can just look it up! Duh
+        std::shared_ptr<const symbolidmapping> idmap;
+        std::shared_ptr<const msra::files::mappedfile> file;
+        {
+            std::lock_guard<std::mutex> lock(mappinglock);
+            // get id map (used below); this may lazily load a .symlist file. We do it here rather than later w.r.t. an outer retry loop.
+            idmap = getcachedidmap(archiveindex, modelsymmap); // at first time, this will load the .symlist file and create a mapping to the user SYMMAP
+            // map the archive file in case this is the first access
+            if (!mappedfiles[archiveindex])
+                mappedfiles[archiveindex] = std::make_shared<msra::files::mappedfile>(archivepaths[archiveindex]); // or throw
+            file = mappedfiles[archiveindex];
+        }
+        const size_t spunit = idmap->back(); // ugh--getcachedidmap() just appends it to the end
+#if 1                                        // prep for fixing the pushing of /sp/ at the end  --we actually can just look it up! Duh
         const size_t spunit2 = getid(modelsymmap, "sp");
         if (spunit2 != spunit)
             LogicError("getlattice: huh? same lookup of /sp/ gives different result?");
 #endif
-        // open archive file in case it is not the current one
-        if (archiveindex != currentarchiveindex)
-        {
-            f = fopenOrDie(archivepaths[archiveindex], L"rbS"); // or throw (will close old 'f' iff succeeded)
-            currentarchiveindex = archiveindex;
-        }
+#ifdef HACK_IN_SILENCE // the hack modifies the decoded lattice, which would get lost when decoding again
+        ondemand = false;
+#endif
         try // (for read operation)
         {
-            // seek to start
-            fsetpos(f, offset);
-            // get it
-            L.fread(f, idmap, spunit);
+            // locate it in the mapping and possibly decode it
+            L.attach(lattice::mapview(file, offset, idmap, spunit));
+            if (!ondemand)
+                L.materialize();
             L.setverbosity(verbosity);
 #ifdef HACK_IN_SILENCE // hack to simulate DEL in the lattice
             const size_t silunit = getid(modelsymmap, "sil");
@@ -1354,10 +1755,11 @@ public:
             L.hackinsilencesubstitutionedges(silunit, spunit, addsp);
 #endif
         }
-        catch (...) // to retry a read error due to a disconnected file handle, we need to reopen the file
+        catch (...) // to retry a read error due to a disconnected file, we need to map the file again
         {
-            currentarchiveindex = SIZE_MAX;
-            f = NULL; // this closes the file handle
+            std::lock_guard<std::mutex> lock(mappinglock);
+            if (mappedfiles[archiveindex] == file)
+                mappedfiles[archiveindex].reset(); // this unmaps the file once no lattice refers to it anymore
             throw;
         }
         // check if number of frames is as expected
@@ -1380,6 +1782,10 @@ public:
     //  - merge two lattices (for merging numer into denom lattices)
     static void convert(const std::wstring& intocpath, const std::wstring& intocpath2, const std::wstring& outpath,
                         const msra::asr::simplesenonehmm& hset);
+
+    // static method for rewriting an archive in the compact (V3) format, see lattice::packv3()
+    static void compact(const std::wstring& intocpath, const std::wstring& outpath,
+                        const msra::asr::simplesenonehmm& hset);
 };
 };
 };
@@ -65,7 +65,7 @@ public:
     void getlattices(const std::wstring& key, std::shared_ptr<const latticepair>& L, size_t expectedframes) const
     {
         std::shared_ptr<latticepair> LP(new latticepair);
-        denlattices.getlattice(key, LP->second, expectedframes); // this loads the lattice from disk, using the existing L.second object
+        denlattices.getlattice(key, LP->second, expectedframes, true /*ondemand*/); // this only reads the header; the content is decoded from the mapped archive when used
         L = LP;
     }
 
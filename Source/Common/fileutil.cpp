@@ -22,6 +22,8 @@
 #ifdef __unix__
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <glob.h>
 #endif
@@ -1663,6 +1665,77 @@ vector<char*> msra::files::fgetfilelines(const wstring& path, vector<char>& buff
     return lines;
 }
 
+// ----------------------------------------------------------------------------
+// mappedfile -- read-only memory mapping of an entire file
+// ----------------------------------------------------------------------------
+
+msra::files::mappedfile::mappedfile(const wstring& pathname)
+    : p(NULL), n(0)
+{
+#ifdef _WIN32
+    hmapping = NULL;
+    hfile = CreateFileW(pathname.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (hfile == INVALID_HANDLE_VALUE)
+        RuntimeError("mappedfile: error opening file '%ls': error code %d", pathname.c_str(), (int) GetLastError());
+    LARGE_INTEGER filesize;
+    if (!GetFileSizeEx(hfile, &filesize))
+    {
+        CloseHandle(hfile);
+        RuntimeError("mappedfile: error determining size of file '%ls': error code %d", pathname.c_str(), (int) GetLastError());
+    }
+    n = (size_t) filesize.QuadPart;
+    if (n == 0) // cannot map an empty file
+        return;
+    hmapping = CreateFileMappingW(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hmapping != NULL)
+        p = (const char*) MapViewOfFile(hmapping, FILE_MAP_READ, 0, 0, 0);
+    if (p == NULL)
+    {
+        const int err = (int) GetLastError();
+        if (hmapping != NULL)
+            CloseHandle(hmapping);
+        CloseHandle(hfile);
+        RuntimeError("mappedfile: error mapping file '%ls': error code %d", pathname.c_str(), err);
+    }
+#else
+    fd = open(wtocharpath(pathname).c_str(), O_RDONLY);
+    if (fd == -1)
+        RuntimeError("mappedfile: error opening file '%ls': %s", pathname.c_str(), strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        RuntimeError("mappedfile: error determining size of file '%ls': %s", pathname.c_str(), strerror(errno));
+    }
+    n = (size_t) st.st_size;
+    if (n == 0) // cannot map an empty file
+        return;
+    void* mapping = mmap(NULL, n, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        const int err = errno;
+        ::close(fd);
+        RuntimeError("mappedfile: error mapping file '%ls': %s", pathname.c_str(), strerror(err));
+    }
+    p = (const char*) mapping;
+#endif
+}
+
+msra::files::mappedfile::~mappedfile()
+{
+#ifdef _WIN32
+    if (p != NULL)
+        UnmapViewOfFile(p);
+    if (hmapping != NULL)
+        CloseHandle(hmapping);
+    CloseHandle(hfile);
+#else
+    if (p != NULL)
+        munmap((void*) p, n);
+    ::close(fd);
+#endif
+}
+
 // ----------------------------------------------------------------------------
 // getfiletime(): access modification time
 // ----------------------------------------------------------------------------
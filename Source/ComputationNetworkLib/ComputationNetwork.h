@@ -362,6 +362,7 @@ public:
     void DeleteNode(const std::wstring& nodeName);
     void ChangeNode(wstring nodeName, ComputationNodeBasePtr newNode);
     void ReplaceLeafNode(wstring oldNodeName, ComputationNodeBasePtr newNode);
+    void ReplaceNode(ComputationNodeBasePtr oldNode, ComputationNodeBasePtr newNode);
     void ReplaceFinalCriterionNode(wstring oldNodeName, ComputationNodeBasePtr newNode);
     void AddFeatureNode(ComputationNodeBasePtr featureNode);
     //ComputationNodeBasePtr RemoveFeatureNode(ComputationNodeBasePtr featureNode);
@@ -657,6 +658,13 @@ public:
     template <class ElemType>
     void SaveToDbnFile(ComputationNetworkPtr net, const std::wstring& fileName) const;
 
+    // rewrite a trained network into a smaller one that computes the same outputs in inference
+    template <class ElemType>
+    void OptimizeForEvaluation();
+
+    // replace chains of Plus, Sigmoid/Tanh/RectifiedLinear and optionally ElementTimes by FusedElementwise nodes
+    size_t FuseElementwiseNodes();
+
     // -----------------------------------------------------------------------
     // construction
     // -----------------------------------------------------------------------
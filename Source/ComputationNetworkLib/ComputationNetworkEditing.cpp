@@ -234,6 +234,38 @@ void ComputationNetwork::ReplaceLeafNode(wstring oldNodeName, ComputationNodeBas
     DeleteNode(oldNodeName); // TODO: can this just be RemoveNodeFromNet()?
 }
 
+// replace oldNode by newNode, which is already part of the network, including moving over all network links and node-group memberships
+// newNode must not depend on oldNode (it may e.g. be an input of it). oldNode is removed from the network.
+void ComputationNetwork::ReplaceNode(ComputationNodeBasePtr oldNode, ComputationNodeBasePtr newNode)
+{
+    InvalidateCompiledNetwork();
+
+    // relink the inputs of all nodes that use oldNode
+    for (auto nodeIter = m_nameToNodeMap.begin(); nodeIter != m_nameToNodeMap.end(); nodeIter++)
+    {
+        ComputationNodeBasePtr node = nodeIter->second;
+        for (int i = 0; i < node->GetNumInputs(); i++)
+            if (node->GetInputs()[i] == oldNode)
+                node->SetInput(i, newNode);
+    }
+
+    // update node groups; newNode takes the place of oldNode unless it is in the group already
+    for (auto groupIter : GetAllNodeGroups())
+    {
+        auto& group = *groupIter;
+        auto oldIter = std::find(group.begin(), group.end(), oldNode);
+        if (oldIter == group.end())
+            continue;
+        if (std::find(group.begin(), group.end(), newNode) == group.end())
+            *oldIter = newNode;
+        else
+            group.erase(oldIter);
+    }
+
+    oldNode->DetachInputs();
+    RemoveNodeFromNet(oldNode);
+}
+
 // add a new criterion node and at the same time orphan the previous one (it won't be removed)
 // The newNode can have the same name and come with pre-connected inputs, which will be used to connect to existing nodes of the same name.
 // BUGBUG: Can this operate on both new and existing nodes?
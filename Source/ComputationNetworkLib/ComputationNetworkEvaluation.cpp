@@ -406,6 +406,10 @@ void ComputationNetwork::CompileNetwork()
     // Or just invalidate it again, which is easier and safer.
     InvalidateCompiledNetwork();
 
+    // STEP: Fuse chains of element-wise nodes if requested. This edits the network, so it must come first.
+    if (g_fuseElementwiseNodes)
+        FuseElementwiseNodes();
+
     // all steps below have to be repeated for all root nodes (=nodes without parents and PreComputeNodes)
     DetermineSetOfAllRoots();
 
@@ -0,0 +1,590 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#define _CRT_SECURE_NO_WARNINGS // "secure" CRT not available on all platforms  --add this at the top of all CPP files that give "function or variable may be unsafe" warnings
+
+#include "Basics.h"
+#include "ComputationNode.h"
+#include "ComputationNetwork.h"
+#include "InputAndParamNodes.h"
+#include "LinearAlgebraNodes.h"
+#include "ConvolutionalNodes.h"
+#include "PreComputeNodes.h"
+#include "TrainingNodes.h"
+#include "NonlinearityNodes.h"
+#include "MatrixPool.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <memory>
+
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// This source file contains the rewrites of ComputationNetwork::OptimizeForEvaluation(). They rely on what nodes do in
+// inference (e.g. Dropout passes its input through and BatchNormalization uses its running statistics), so the result
+// computes the same outputs as the original network in evaluation, but must not be trained any further.
+// It also contains ComputationNetwork::FuseElementwiseNodes(), which rewrites a network for training and inference alike.
+
+typedef map<ComputationNodeBasePtr, set<ComputationNodeBasePtr>> ParentsMap;
+
+// -----------------------------------------------------------------------
+// helpers
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+static vector<ElemType> GetNodeValues(const ComputationNodeBasePtr& node)
+{
+    const Matrix<ElemType>& value = dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value();
+    unique_ptr<ElemType[]> data(value.CopyToArray());
+    return vector<ElemType>(data.get(), data.get() + value.GetNumElements());
+}
+
+template <class ElemType>
+static void SetNodeValues(const ComputationNodeBasePtr& node, vector<ElemType>& values)
+{
+    Matrix<ElemType>& value = dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value();
+    if (values.size() != value.GetNumElements())
+        LogicError("SetNodeValues: %d values given for %ls %ls operation with %d elements.", (int)values.size(), node->NodeName().c_str(), node->OperationName().c_str(), (int)value.GetNumElements());
+    value.SetValue(value.GetNumRows(), value.GetNumCols(), value.GetDeviceId(), values.data());
+}
+
+static bool IsParameter(const ComputationNodeBasePtr& node)
+{
+    return node->OperationName() == OperationNameOf(LearnableParameter);
+}
+
+// whether the value of the node is known without evaluating the network: parameters and precomputed statistics
+static bool HasFixedValue(const ComputationNodeBasePtr& node)
+{
+    if (IsParameter(node))
+        return true;
+    auto preComputeNode = dynamic_pointer_cast<IPreComputeNode>(node);
+    return preComputeNode && preComputeNode->HasComputed();
+}
+
+static bool IsInNodeGroup(const ComputationNetwork& net, const ComputationNodeBasePtr& node)
+{
+    for (const auto* group : { &net.FeatureNodes(), &net.LabelNodes(), &net.FinalCriterionNodes(), &net.EvaluationNodes(), &net.OutputNodes() })
+    {
+        if (find(group->begin(), group->end(), node) != group->end())
+            return true;
+    }
+    return false;
+}
+
+// whether 'user' is the only consumer of the node, so that the node may be changed as long as the value of 'user' stays the same
+static bool IsUsedOnlyBy(const ComputationNetwork& net, ParentsMap& parents, const ComputationNodeBasePtr& node, const ComputationNodeBasePtr& user)
+{
+    const auto& consumers = parents[node];
+    return consumers.size() == 1 && *consumers.begin() == user && !IsInNodeGroup(net, node);
+}
+
+static wstring MakeUniqueNodeName(const ComputationNetwork& net, const wstring& name)
+{
+    wstring uniqueName = name;
+    for (int i = 1; net.NodeNameExists(uniqueName); i++)
+        uniqueName = name + msra::strfun::wstrprintf(L"%d", i);
+    return uniqueName;
+}
+
+// Replace the node by 'replacement'. Unless 'replacement' is in use under its own name elsewhere, it also takes over the name
+// of the node, so that e.g. hidden layers can still be requested as outputs by their names.
+static void ReplaceNodeKeepingName(ComputationNetwork& net, const ComputationNodeBasePtr& node, const ComputationNodeBasePtr& replacement)
+{
+    auto parents = net.CreateParentsMap();
+    const auto& consumers = parents[replacement];
+    bool takeOverName = !IsInNodeGroup(net, replacement) && (consumers.empty() || (consumers.size() == 1 && *consumers.begin() == node));
+
+    wstring name = node->NodeName();
+    net.ReplaceNode(node, replacement);
+    if (takeOverName)
+        net.RenameNode(replacement, name);
+}
+
+// -----------------------------------------------------------------------
+// rewrites
+// -----------------------------------------------------------------------
+
+// Dropout is the identity in inference.
+static size_t RemoveDropoutNodes(ComputationNetwork& net)
+{
+    size_t count = 0;
+    for (const auto& node : net.GetNodesWithType(OperationNameOf(DropoutNode)))
+    {
+        ReplaceNodeKeepingName(net, node, node->GetInputs()[0]);
+        count++;
+    }
+    return count;
+}
+
+// In inference, BatchNormalization computes y = scale * (x - mean) * invStdDev + bias = a * x + c per map, where
+// a = scale * invStdDev and c = bias - a * mean. If x = W * u (+ b) with a Times or Convolution node, the weights that
+// compute map m are multiplied by a[m], and b becomes a * b + c (or is added as c).
+template <class ElemType>
+static bool TryFoldBatchNormalization(ComputationNetwork& net, const ComputationNodeBasePtr& bn)
+{
+    const auto& inputs = bn->GetInputs();
+    if (!dynamic_pointer_cast<BatchNormalizationNode<ElemType>>(bn)->UsesCntkEngine())
+        return false;
+    for (size_t i = 1; i < inputs.size(); i++)
+    {
+        if (!HasFixedValue(inputs[i]))
+            return false;
+    }
+
+    auto parents = net.CreateParentsMap();
+
+    // x = product + bias, or x = product
+    ComputationNodeBasePtr x = inputs[0];
+    ComputationNodeBasePtr product = x;
+    ComputationNodeBasePtr bias;
+    if (x->OperationName() == OperationNameOf(PlusNode))
+    {
+        size_t biasIndex = IsParameter(x->GetInputs()[1]) ? 1 : 0;
+        product = x->GetInputs()[1 - biasIndex];
+        bias = x->GetInputs()[biasIndex];
+        if (!IsParameter(bias) || !IsUsedOnlyBy(net, parents, bias, x) || !IsUsedOnlyBy(net, parents, product, x))
+            return false;
+    }
+    if (!IsUsedOnlyBy(net, parents, x, bn))
+        return false;
+
+    bool isConvolution = product->OperationName() == OperationNameOf(ConvolutionNode);
+    if (!isConvolution && product->OperationName() != OperationNameOf(TimesNode))
+        return false;
+    ComputationNodeBasePtr weight = product->GetInputs()[0];
+    if (!IsParameter(weight) || !IsUsedOnlyBy(net, parents, weight, product))
+        return false;
+
+    vector<ElemType> scale = GetNodeValues<ElemType>(inputs[1]);
+    vector<ElemType> shift = GetNodeValues<ElemType>(inputs[2]);
+    vector<ElemType> mean = GetNodeValues<ElemType>(inputs[3]);
+    vector<ElemType> invStdDev = GetNodeValues<ElemType>(inputs[4]);
+    size_t mapCount = scale.size();
+    size_t outputSize = product->GetSampleLayout().GetNumElements();
+    if (mapCount == 0 || shift.size() != mapCount || mean.size() != mapCount || invStdDev.size() != mapCount || outputSize % mapCount != 0)
+        return false;
+    size_t spatialSize = outputSize / mapCount; // BatchNormalization maps output row r to map r / spatialSize
+
+    vector<ElemType> w = GetNodeValues<ElemType>(weight);
+    const auto& outputDims = product->GetSampleLayout().GetDims();
+    if (isConvolution)
+    {
+        // The kernels are stored one after another for the CHW layout, and each map must be one output channel.
+        auto convolution = dynamic_pointer_cast<ConvolutionNode<ElemType>>(product);
+        if (convolution->GetImageLayoutKind() != ImageLayoutKind::CHW || convolution->MapCount().GetNumElements() != mapCount ||
+            outputDims.empty() || outputDims.back() != mapCount || w.size() % mapCount != 0)
+            return false;
+    }
+    else
+    {
+        // W is [outputSize x inputSize] in column-major order
+        if (w.size() % outputSize != 0)
+            return false;
+    }
+
+    // a bias is either per output element or, for convolutions, of shape [1 x ... x 1 x K]
+    vector<ElemType> b;
+    bool perMapBias = false;
+    if (bias)
+    {
+        b = GetNodeValues<ElemType>(bias);
+        const auto& biasDims = bias->GetSampleLayout().GetDims();
+        perMapBias = isConvolution && b.size() == mapCount && spatialSize != 1 && biasDims.size() == outputDims.size() && biasDims.back() == mapCount;
+        if (b.size() != outputSize && !perMapBias)
+            return false;
+    }
+
+    vector<ElemType> a(mapCount);
+    vector<ElemType> c(mapCount);
+    for (size_t m = 0; m < mapCount; m++)
+    {
+        a[m] = scale[m] * invStdDev[m];
+        c[m] = shift[m] - a[m] * mean[m];
+    }
+
+    if (isConvolution)
+    {
+        size_t kernelSize = w.size() / mapCount;
+        for (size_t i = 0; i < w.size(); i++)
+            w[i] *= a[i / kernelSize];
+    }
+    else
+    {
+        for (size_t i = 0; i < w.size(); i++)
+            w[i] *= a[(i % outputSize) / spatialSize];
+    }
+    SetNodeValues(weight, w);
+
+    if (bias)
+    {
+        for (size_t i = 0; i < b.size(); i++)
+        {
+            size_t m = perMapBias ? i : i / spatialSize;
+            b[i] = a[m] * b[i] + c[m];
+        }
+        SetNodeValues(bias, b);
+        ReplaceNodeKeepingName(net, bn, x);
+    }
+    else
+    {
+        TensorShape biasShape = product->GetSampleLayout();
+        if (isConvolution)
+        {
+            vector<size_t> biasDims(outputDims.size(), 1);
+            biasDims.back() = mapCount;
+            biasShape = TensorShape(biasDims);
+            b = c;
+        }
+        else
+        {
+            b.resize(outputSize);
+            for (size_t i = 0; i < outputSize; i++)
+                b[i] = c[i / spatialSize];
+        }
+
+        auto biasNode = net.AddNodeToNetWithElemType(New<LearnableParameter<ElemType>>(net.GetDeviceId(), MakeUniqueNodeName(net, bn->NodeName() + L"-bias"), biasShape));
+        SetNodeValues(biasNode, b);
+        auto plus = net.AddNodeToNetAndAttachInputs(New<PlusNode<ElemType>>(net.GetDeviceId(), MakeUniqueNodeName(net, bn->NodeName() + L"-folded")), { product, biasNode });
+        ReplaceNodeKeepingName(net, bn, plus);
+    }
+    return true;
+}
+
+template <class ElemType>
+static size_t FoldBatchNormalization(ComputationNetwork& net)
+{
+    size_t count = 0;
+    for (const auto& node : net.GetNodesWithType(OperationNameOf(BatchNormalizationNode)))
+    {
+        if (TryFoldBatchNormalization<ElemType>(net, node))
+            count++;
+    }
+    return count;
+}
+
+// PerDimMeanVarNormalization followed by an affine layer: W * ((x - mean) .* invStdDev) + b = W' * x + (b - W' * mean),
+// where W' = W * diag(invStdDev). The Times nodes that consume the normalization are changed to read x directly.
+template <class ElemType>
+static size_t FoldMeanVarNormalization(ComputationNetwork& net)
+{
+    size_t count = 0;
+    for (const auto& normalization : net.GetNodesWithType(OperationNameOf(PerDimMeanVarNormalizationNode)))
+    {
+        const auto& inputs = normalization->GetInputs();
+        if (!HasFixedValue(inputs[1]) || !HasFixedValue(inputs[2]))
+            continue;
+        vector<ElemType> mean = GetNodeValues<ElemType>(inputs[1]);
+        vector<ElemType> invStdDev = GetNodeValues<ElemType>(inputs[2]);
+        size_t inputSize = normalization->GetSampleLayout().GetNumElements();
+        if (mean.size() != inputSize || invStdDev.size() != inputSize) // broadcast statistics are not supported
+            continue;
+
+        auto parents = net.CreateParentsMap();
+        bool folded = false;
+        for (const auto& times : parents[normalization])
+        {
+            if (times->OperationName() != OperationNameOf(TimesNode) || times->GetInputs()[1] != normalization || times->GetInputs()[0] == normalization ||
+                IsInNodeGroup(net, times) || parents[times].size() != 1)
+                continue;
+            ComputationNodeBasePtr weight = times->GetInputs()[0];
+            ComputationNodeBasePtr plus = *parents[times].begin();
+            if (!IsParameter(weight) || !IsUsedOnlyBy(net, parents, weight, times) || plus->OperationName() != OperationNameOf(PlusNode))
+                continue;
+            ComputationNodeBasePtr bias = plus->GetInputs()[0] == times ? plus->GetInputs()[1] : plus->GetInputs()[0];
+            size_t outputSize = times->GetSampleLayout().GetNumElements();
+            if (!IsParameter(bias) || !IsUsedOnlyBy(net, parents, bias, plus) || bias->GetSampleLayout().GetNumElements() != outputSize)
+                continue;
+
+            vector<ElemType> w = GetNodeValues<ElemType>(weight);
+            vector<ElemType> b = GetNodeValues<ElemType>(bias);
+            if (w.size() != outputSize * inputSize)
+                continue;
+
+            vector<double> shift(outputSize, 0);
+            for (size_t j = 0; j < inputSize; j++)
+            {
+                for (size_t i = 0; i < outputSize; i++)
+                {
+                    ElemType& wij = w[i + j * outputSize];
+                    wij *= invStdDev[j];
+                    shift[i] += (double)wij * mean[j];
+                }
+            }
+            for (size_t i = 0; i < outputSize; i++)
+                b[i] = (ElemType)(b[i] - shift[i]);
+
+            SetNodeValues(weight, w);
+            SetNodeValues(bias, b);
+            net.InvalidateCompiledNetwork();
+            times->SetInput(1, inputs[0]);
+            folded = true;
+        }
+        if (folded)
+            count++;
+    }
+    return count;
+}
+
+// Replace the subgraphs that only depend on parameters by parameters that hold their values, e.g. a weight matrix
+// that is computed from factors, or constant expressions of a BrainScript model.
+template <class ElemType>
+static size_t FoldConstants(ComputationNetwork& net)
+{
+    net.CompileNetwork();
+    list<ComputationNodeBasePtr> evalOrder = net.GetEvalOrder(nullptr); // (copy since the network gets modified below)
+
+    set<ComputationNodeBasePtr> constants;
+    for (const auto& node : evalOrder)
+    {
+        bool isConstant;
+        if (node->IsLeaf() || dynamic_pointer_cast<IPreComputeNode>(node))
+            isConstant = HasFixedValue(node);
+        else
+        {
+            isConstant = !node->HasMBLayout() && !node->IsPartOfLoop();
+            for (const auto& input : node->GetInputs())
+                isConstant = isConstant && constants.find(input) != constants.end();
+        }
+        if (isConstant)
+            constants.insert(node);
+    }
+
+    // fold the constant nodes that are used by non-constant ones or belong to a node group
+    auto parents = net.CreateParentsMap();
+    vector<ComputationNodeBasePtr> roots;
+    for (const auto& node : evalOrder)
+    {
+        if (constants.find(node) == constants.end() || HasFixedValue(node))
+            continue;
+        bool isRoot = IsInNodeGroup(net, node);
+        for (const auto& consumer : parents[node])
+            isRoot = isRoot || constants.find(consumer) == constants.end();
+        if (isRoot)
+            roots.push_back(node);
+    }
+    if (roots.empty())
+        return 0;
+
+    // evaluate them in evaluation order
+    list<ComputationNodeBasePtr> nodesToEvaluate = ComputationNodeBase::EnumerateNodes(roots);
+    set<ComputationNodeBasePtr> toEvaluate(nodesToEvaluate.begin(), nodesToEvaluate.end());
+    NetworkOperationMode previousMode = net.Environment().SetOperationMode(NetworkOperationMode::inferring);
+    MatrixPool matrixPool;
+    for (const auto& node : evalOrder)
+    {
+        if (toEvaluate.find(node) == toEvaluate.end() || HasFixedValue(node))
+            continue;
+        node->MarkValueNonSharable();
+        node->RequestMatricesBeforeForwardProp(matrixPool);
+        node->BeginForwardProp();
+        node->ForwardProp(FrameRange(nullptr));
+        node->EndForwardProp();
+    }
+    net.Environment().SetOperationMode(previousMode);
+
+    for (const auto& node : roots)
+    {
+        ComputationNodeBasePtr parameter = net.AddNodeToNetWithElemType(New<LearnableParameter<ElemType>>(net.GetDeviceId(), MakeUniqueNodeName(net, node->NodeName() + L"-const"), node->GetSampleLayout()));
+        parameter->SetLearningRateMultiplier(0);
+        vector<ElemType> values = GetNodeValues<ElemType>(node);
+        SetNodeValues(parameter, values);
+        ReplaceNodeKeepingName(net, node, parameter);
+    }
+    return roots.size();
+}
+
+// A Convolution followed by adding a bias per output map and optionally RectifiedLinear, e.g. after a BatchNormalization was
+// folded into it, is replaced by a FusedConvolution node, which lets the convolution engine add the bias and apply the ReLU
+// while it writes the output (see ConvolutionEngine::ForwardWithBias()).
+template <class ElemType>
+static size_t FuseConvolutionBias(ComputationNetwork& net)
+{
+    size_t count = 0;
+    for (const auto& node : net.GetNodesWithType(OperationNameOf(ConvolutionNode)))
+    {
+        auto convolution = dynamic_pointer_cast<ConvolutionNode<ElemType>>(node);
+        auto parents = net.CreateParentsMap();
+        if (!convolution || convolution->GetImageLayoutKind() != ImageLayoutKind::CHW || parents[node].size() != 1 || IsInNodeGroup(net, node))
+            continue;
+
+        // the sum is a Plus node or, if FuseElementwiseNodes() has run, a FusedElementwise node that also applies RectifiedLinear
+        ComputationNodeBasePtr sum = *parents[node].begin();
+        bool relu = false;
+        if (sum->OperationName() == OperationNameOf(FusedElementwiseNode))
+        {
+            if (sum->GetNumInputs() != 2 || dynamic_pointer_cast<FusedElementwiseNode<ElemType>>(sum)->Nonlinearity() != OperationNameOf(RectifiedLinearNode))
+                continue;
+            relu = true;
+        }
+        else if (sum->OperationName() != OperationNameOf(PlusNode))
+            continue;
+
+        // the bias must be of shape [1 x ... x 1 x K]
+        ComputationNodeBasePtr bias = sum->GetInputs()[0] == node ? sum->GetInputs()[1] : sum->GetInputs()[0];
+        const auto& outputDims = node->GetSampleLayout().GetDims();
+        const auto& biasDims = bias->GetSampleLayout().GetDims();
+        size_t mapCount = convolution->MapCount().GetNumElements();
+        if (bias == node || bias->HasMBLayout() || outputDims.empty() || outputDims.back() != mapCount ||
+            biasDims.size() != outputDims.size() || biasDims.back() != mapCount || bias->GetSampleLayout().GetNumElements() != mapCount)
+            continue;
+
+        // FusedConvolution only supports the geometry of the cudnn layout, which must give the same output
+        const auto& inputShape = node->GetInputs()[1]->GetSampleLayout();
+        if (inputShape.GetRank() != convolution->KernelShape().GetRank())
+            continue;
+        auto outputShape = ConvolveGeometry::ComputeOutputShape(inputShape, convolution->KernelShape(), convolution->MapCount(),
+                                                                convolution->Stride(), convolution->Sharing(), convolution->AutoPad(),
+                                                                convolution->LowerPad(), convolution->UpperPad());
+        if (outputShape != node->GetSampleLayout())
+            continue;
+
+        ComputationNodeBasePtr last = sum;
+        if (!relu && parents[sum].size() == 1 && !IsInNodeGroup(net, sum) && (*parents[sum].begin())->OperationName() == OperationNameOf(RectifiedLinearNode))
+        {
+            last = *parents[sum].begin();
+            relu = true;
+        }
+
+        auto fused = net.AddNodeToNetAndAttachInputs(New<FusedConvolutionNode<ElemType>>(net.GetDeviceId(), MakeUniqueNodeName(net, last->NodeName() + L"-fused"),
+                                                                                         convolution->KernelShape(), convolution->MapCount(), convolution->Stride(),
+                                                                                         convolution->Sharing(), convolution->AutoPad(), convolution->LowerPad(),
+                                                                                         convolution->UpperPad(), convolution->MaxTempMemSizeInSamples(), relu),
+                                                     { node->GetInputs()[0], node->GetInputs()[1], bias });
+        ReplaceNodeKeepingName(net, last, fused);
+        count++;
+    }
+    return count;
+}
+
+// Remove the nodes left without consumers by the rewrites above, e.g. the inputs of folded subgraphs. Nodes that were unused
+// before are kept, since they may be requested as outputs by name.
+static size_t RemoveDanglingNodes(ComputationNetwork& net, const set<ComputationNodeBasePtr>& unusedBefore)
+{
+    size_t count = 0;
+    for (bool removed = true; removed;)
+    {
+        removed = false;
+        auto parents = net.CreateParentsMap();
+        for (const auto& node : net.GetAllNodes())
+        {
+            if (parents[node].empty() && !IsInNodeGroup(net, node) && unusedBefore.find(node) == unusedBefore.end())
+            {
+                net.DeleteNode(node->NodeName());
+                count++;
+                removed = true;
+            }
+        }
+    }
+    return count;
+}
+
+// -----------------------------------------------------------------------
+// FuseElementwiseNodes() -- replace Plus -> Sigmoid/Tanh/RectifiedLinear (-> ElementTimes) by a FusedElementwise node
+// -----------------------------------------------------------------------
+
+// Each of the nodes of such a chain reads and writes its full output, and holds an output matrix (and a gradient matrix
+// in training). The fused node computes f(a + b) (.* c) in a single tensor op instead. Only the last node of the chain
+// keeps its name, so the intermediate nodes must neither be used elsewhere nor be in a node group.
+// This is called by CompileNetwork() if g_fuseElementwiseNodes is set, before anything else is done to the network.
+template <class ElemType>
+static ComputationNodeBasePtr NewFusedElementwiseNode(ComputationNetwork& net, const wstring& name, const wstring& nonlinearity, const vector<ComputationNodeBasePtr>& inputs)
+{
+    return net.AddNodeToNetAndAttachInputs(New<FusedElementwiseNode<ElemType>>(net.GetDeviceId(), name, nonlinearity), inputs);
+}
+
+size_t ComputationNetwork::FuseElementwiseNodes()
+{
+    size_t count = 0;
+    for (const auto& plus : GetNodesWithType(OperationNameOf(PlusNode)))
+    {
+        auto parents = CreateParentsMap();
+        const auto& plusConsumers = parents[plus];
+        if (plusConsumers.size() != 1 || IsInNodeGroup(*this, plus))
+            continue;
+
+        ComputationNodeBasePtr nonlinearity = *plusConsumers.begin();
+        wstring nonlinearityName = nonlinearity->OperationName();
+        if (nonlinearityName != OperationNameOf(SigmoidNode) && nonlinearityName != OperationNameOf(TanhNode) && nonlinearityName != OperationNameOf(RectifiedLinearNode))
+            continue;
+
+        vector<ComputationNodeBasePtr> inputs = plus->GetInputs();
+        ComputationNodeBasePtr product;
+        const auto& nonlinearityConsumers = parents[nonlinearity];
+        if (nonlinearityName != OperationNameOf(RectifiedLinearNode) && nonlinearityConsumers.size() == 1 && !IsInNodeGroup(*this, nonlinearity) &&
+            (*nonlinearityConsumers.begin())->OperationName() == OperationNameOf(ElementTimesNode))
+        {
+            const auto& productInputs = (*nonlinearityConsumers.begin())->GetInputs();
+            if (productInputs[0] != productInputs[1]) // f(a + b) .* f(a + b) is left alone
+            {
+                product = *nonlinearityConsumers.begin();
+                inputs.push_back(productInputs[0] == nonlinearity ? productInputs[1] : productInputs[0]);
+            }
+        }
+
+        ComputationNodeBasePtr last = product ? product : nonlinearity;
+        wstring name = last->NodeName();
+        wstring fusedName = MakeUniqueNodeName(*this, name + L"-fused");
+        ComputationNodeBasePtr fused;
+        if (dynamic_pointer_cast<ComputationNode<float>>(plus))
+            fused = NewFusedElementwiseNode<float>(*this, fusedName, nonlinearityName, inputs);
+        else if (dynamic_pointer_cast<ComputationNode<double>>(plus))
+            fused = NewFusedElementwiseNode<double>(*this, fusedName, nonlinearityName, inputs);
+        else
+            LogicError("FuseElementwiseNodes: Unexpected element type of %ls %ls operation.", plus->NodeName().c_str(), plus->OperationName().c_str());
+
+        ReplaceNode(last, fused);
+        if (product)
+            DeleteNode(nonlinearity->NodeName());
+        DeleteNode(plus->NodeName());
+        RenameNode(fused, name);
+        count++;
+    }
+
+    if (count > 0)
+        fprintf(stderr, "FuseElementwiseNodes: fused %d chains of element-wise nodes.\n", (int)count);
+    return count;
+}
+
+// -----------------------------------------------------------------------
+// OptimizeForEvaluation() -- the rewrites above in order
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+void ComputationNetwork::OptimizeForEvaluation()
+{
+    VerifyIsCompiled("OptimizeForEvaluation");
+
+    size_t numNodesBefore = GetTotalNumberOfNodes();
+    set<ComputationNodeBasePtr> unusedBefore;
+    for (const auto& iter : CreateParentsMap())
+    {
+        if (iter.second.empty())
+            unusedBefore.insert(iter.first);
+    }
+
+    size_t numDropout = RemoveDropoutNodes(*this);
+    size_t numBatchNormalization = FoldBatchNormalization<ElemType>(*this);
+    size_t numMeanVarNormalization = FoldMeanVarNormalization<ElemType>(*this);
+    size_t numConstants = FoldConstants<ElemType>(*this);
+    size_t numConvolutions = FuseConvolutionBias<ElemType>(*this);
+    size_t numRemoved = RemoveDanglingNodes(*this, unusedBefore);
+
+    CompileNetwork();
+
+    fprintf(stderr, "OptimizeForEvaluation: removed %d Dropout nodes, folded %d BatchNormalization and %d PerDimMeanVarNormalization nodes into weights, "
+                    "replaced %d constant subgraphs by parameters, fused the bias into %d Convolution nodes and deleted %d unused nodes.\n",
+            (int)numDropout, (int)numBatchNormalization, (int)numMeanVarNormalization, (int)numConstants, (int)numConvolutions, (int)numRemoved);
+    fprintf(stderr, "OptimizeForEvaluation: %d nodes before, %d nodes after.\n", (int)numNodesBefore, (int)GetTotalNumberOfNodes());
+}
+
+template void ComputationNetwork::OptimizeForEvaluation<float>();
+template void ComputationNetwork::OptimizeForEvaluation<double>();
+
+}}}
@@ -40,6 +40,7 @@
 #define CURRENT_CNTK_MODEL_VERSION CNTK_MODEL_VERSION_8
 
 extern bool g_shareNodeValueMatrices;
+extern bool g_fuseElementwiseNodes;
 
 // helper mode for debugging
 // If TRACK_GAP_NANS is defined then initialize layout gaps to NaN and do NaN checks. Also do detailed logging of node computations.
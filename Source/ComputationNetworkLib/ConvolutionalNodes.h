@@ -64,6 +64,17 @@ public:
     {
     }
 
+public:
+    const TensorShape& KernelShape() const { return m_kernelShape; }
+    const TensorShape& MapCount() const { return m_mapCount; }
+    const TensorShape& Stride() const { return m_stride; }
+    const std::vector<bool>& Sharing() const { return m_sharing; }
+    const std::vector<bool>& AutoPad() const { return m_autoPad; }
+    const TensorShape& LowerPad() const { return m_lowerPad; }
+    const TensorShape& UpperPad() const { return m_upperPad; }
+    size_t MaxTempMemSizeInSamples() const { return m_maxTempMemSizeInSamples; }
+    ImageLayoutKind GetImageLayoutKind() const { return m_imageLayout; }
+
 public:
     void Save(File& fstream) const override
     {
@@ -412,6 +423,137 @@ protected:
     bool m_convolution2D;
 };
 
+// -----------------------------------------------------------------------
+// FusedConvolutionNode (convolutionWeights, inputFeature, bias)
+// -----------------------------------------------------------------------
+// Computes Convolution(W, x) + b or RectifiedLinear(Convolution(W, x) + b) with one bias value per output map, through
+// ConvolutionEngine::ForwardWithBias(). The Direct engine adds the bias and applies the ReLU while it writes the output,
+// instead of two more passes over it. This node is not meant to be written by users. ComputationNetwork::OptimizeForEvaluation()
+// creates it for a Convolution in the cudnn (CHW) layout that is followed by Plus and optionally RectifiedLinear.
+// Like the other rewrites of OptimizeForEvaluation() it is for inference only, and has no backprop.
+
+template <class ElemType>
+class FusedConvolutionNode : public ConvolutionNodeBase<ElemType>, public NumInputs<3>
+{
+    typedef ConvolutionNodeBase<ElemType> Base;
+    UsingConvolutionNodeBaseMembers;
+    static const std::wstring TypeName()
+    {
+        return L"FusedConvolution";
+    }
+
+public:
+    FusedConvolutionNode(DEVICEID_TYPE deviceId, const wstring& name)
+        : Base(deviceId, name), m_relu(false)
+    {
+    }
+    FusedConvolutionNode(DEVICEID_TYPE deviceId, const wstring& name, const TensorShape& kernelShape, const TensorShape& mapCount, const TensorShape& strideShape,
+                         const std::vector<bool>& sharing, const std::vector<bool>& autoPadding, const TensorShape& lowerPad, const TensorShape& upperPad,
+                         size_t maxTempMemSizeInSamples, bool relu)
+                         : Base(deviceId, name, kernelShape, mapCount, strideShape, sharing, autoPadding, lowerPad, upperPad, PoolKind::None, ImageLayoutKind::CHW, maxTempMemSizeInSamples),
+                         m_relu(relu)
+    {
+    }
+    FusedConvolutionNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : FusedConvolutionNode(configp->Get(L"deviceId"), L"<placeholder>", configp->Get(L"kernelShape"), configp->Get(L"mapCount"), configp->Get(L"strideShape"),
+                               configp->Get(L"dimSharing"), configp->Get(L"dimPadding"), configp->Get(L"dimPadLower"), configp->Get(L"dimPadUpper"),
+                               configp->Get(L"maxTempMemSizeInSamples"), configp->Get(L"relu"))
+    {
+        AttachInputsFromConfig(configp, GetExpectedNumInputs());
+    }
+
+public:
+    void Save(File& fstream) const override
+    {
+        Base::Save(fstream);
+        fstream << m_relu;
+    }
+
+    void Load(File& fstream, size_t modelVersion) override
+    {
+        Base::Load(fstream, modelVersion);
+        fstream >> m_relu;
+    }
+
+    void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override
+    {
+        Base::CopyTo(nodeP, newName, flags);
+        if (flags & CopyNodeFlags::copyNodeValue)
+        {
+            auto node = dynamic_pointer_cast<FusedConvolutionNode<ElemType>>(nodeP);
+            node->m_relu = m_relu;
+        }
+    }
+
+    bool HasReLU() const { return m_relu; }
+
+    void ForwardProp(const FrameRange& fr) override
+    {
+        Matrix<ElemType> sliceOutputValue = ValueFor(fr);
+        const Matrix<ElemType>& input0 = Input(0)->ValueAsMatrix();
+        Matrix<ElemType> sliceInput1Value = Input(1)->ValueFor(fr);
+        const Matrix<ElemType>& bias = Input(2)->ValueAsMatrix();
+        m_convEng->ForwardWithBias(sliceInput1Value, input0, bias, m_relu, sliceOutputValue, *m_tempMatrix);
+    }
+
+    void BackpropTo(const size_t /*inputIndex*/, const FrameRange& /*fr*/) override
+    {
+        LogicError("%ls %ls operation is created by OptimizeForEvaluation() and cannot be trained.", NodeName().c_str(), OperationName().c_str());
+    }
+
+    bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return false; }
+
+    void Validate(bool isFinalValidationPass) override
+    {
+        Base::Validate(isFinalValidationPass);
+        InferMBLayoutFromInputsForStandardCase(isFinalValidationPass);
+
+        TensorShape inputShape = GetInputSampleLayout(1);
+        auto outDims = ConvolveGeometry::ComputeOutputShape(inputShape, m_kernelShape, m_mapCount, m_stride,
+                                                            m_sharing, m_autoPad, m_lowerPad, m_upperPad);
+        SetDims(outDims, HasMBLayout());
+
+        if (isFinalValidationPass)
+        {
+            if (m_convEng == nullptr)
+            {
+                auto geometry = std::make_shared<ConvolveGeometry>(inputShape, m_kernelShape, m_mapCount, m_stride,
+                                                                   m_sharing, m_autoPad, m_lowerPad, m_upperPad);
+                m_convEng = ConvolutionEngine<ElemType>::Create(geometry, m_deviceId, m_imageLayout,
+                                                                m_maxTempMemSizeInSamples, m_poolKind);
+            }
+
+            if (Input(0)->GetAsMatrixNumCols() != m_kernelShape.GetNumElements() ||
+                Input(0)->GetAsMatrixNumRows() != m_convEng->Geometry()->KernelCount())
+            {
+                LogicError("Convolution weight matrix %ls should have dimension [%d, %d] which is [kernelCount, kernelWidth * kernelHeight * inputChannels]",
+                           Input(0)->NodeName().c_str(), (int)m_convEng->Geometry()->KernelCount(), (int)m_kernelShape.GetNumElements());
+            }
+            if (Input(2)->GetSampleLayout().GetNumElements() != m_mapCount.GetNumElements())
+            {
+                LogicError("%ls %ls operation: the bias %ls should have one value per output map (%d).", NodeName().c_str(), OperationName().c_str(),
+                           Input(2)->NodeName().c_str(), (int)m_mapCount.GetNumElements());
+            }
+        }
+    }
+
+    void RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) override
+    {
+        Base::RequestMatricesBeforeForwardProp(matrixPool);
+        RequestMatrixFromPool(m_tempMatrix, matrixPool);
+    }
+
+    void ReleaseMatricesAfterForwardProp(MatrixPool& matrixPool) override
+    {
+        Base::ReleaseMatricesAfterForwardProp(matrixPool);
+        ReleaseMatrixToPool(m_tempMatrix, matrixPool);
+    }
+
+private:
+    bool m_relu;
+};
+
 // -----------------------------------------------------------------------
 // PoolingNode (inputFeature)
 // -----------------------------------------------------------------------
@@ -562,6 +562,177 @@ public:
 template class ClipNode<float>;
 template class ClipNode<double>;
 
+// -----------------------------------------------------------------------
+// FusedElementwiseNode (a, b) or (a, b, c)
+// -----------------------------------------------------------------------
+// Computes f(a + b) or f(a + b) .* c in a single tensor op, where f is Sigmoid, Tanh or RectifiedLinear (the latter
+// only without the product). This node is not meant to be written by users. ComputationNetwork::FuseElementwiseNodes()
+// creates it for chains of Plus, a nonlinearity and optionally ElementTimes, which otherwise make a full pass over
+// memory and hold an output matrix each, e.g. for the gates of an LSTM.
+// Backprop through f(a + b) uses the output value. With the product, the gradients of a and b are computed from the
+// inputs instead, f(a + b) .* c being all that is kept.
+
+template <class ElemType>
+class FusedElementwiseNode : public ComputationNode<ElemType>
+{
+    typedef ComputationNode<ElemType> Base;
+    UsingComputationNodeMembersBoilerplate;
+
+    static const std::wstring TypeName()
+    {
+        return L"FusedElementwise";
+    }
+
+public:
+    FusedElementwiseNode(DEVICEID_TYPE deviceId, const wstring& name, const std::wstring& nonlinearity = L"Sigmoid")
+        : Base(deviceId, name), m_nonlinearity(nonlinearity)
+    {
+    }
+
+    FusedElementwiseNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : FusedElementwiseNode(configp->Get(L"deviceId"), L"<placeholder>", configp->Get(L"nonlinearity"))
+    {
+        AttachInputsFromConfig(configp);
+    }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override
+    {
+        Base::CopyTo(nodeP, newName, flags);
+        if (flags & CopyNodeFlags::copyNodeValue)
+        {
+            auto node = dynamic_pointer_cast<FusedElementwiseNode<ElemType>>(nodeP);
+            node->m_nonlinearity = m_nonlinearity;
+        }
+    }
+
+    virtual void Save(File& fstream) const override
+    {
+        Base::Save(fstream);
+        fstream << m_nonlinearity;
+    }
+
+    virtual void Load(File& fstream, size_t modelVersion) override
+    {
+        Base::Load(fstream, modelVersion);
+        fstream >> m_nonlinearity;
+    }
+
+    const std::wstring& Nonlinearity() const { return m_nonlinearity; }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override
+    {
+        size_t rank = DetermineElementwiseTensorRank();
+        auto result =           ValueTensorFor(rank, fr);
+        auto input0 = Input(0)->ValueTensorFor(rank, fr.AllowBroadcast());
+        auto input1 = Input(1)->ValueTensorFor(rank, fr.AllowBroadcast());
+        if (!HasProduct())
+            result.DoBinaryOpOf(0, input0, input1, 1, ForwardOp(), opSum);
+        else
+        {
+            auto input2 = Input(2)->ValueTensorFor(rank, fr.AllowBroadcast());
+            result.DoTernaryOpOf(0, input0, input1, input2, 1, ForwardOp(), opSum);
+        }
+    }
+
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
+    {
+        size_t rank = DetermineElementwiseTensorRank();
+        auto gradient      =                    GradientTensorFor(rank, fr);
+        auto inputGradient = Input(inputIndex)->GradientTensorFor(rank, fr.AllowBroadcast());
+
+        // if reduction then mask the respective input(s) (zero out the gaps)
+        if (Input(inputIndex)->ReducesInTimeWrt(shared_from_this()))
+            MaskMissingGradientColumnsToZero(fr);
+
+        if (!HasProduct()) // d/da f(a + b) = d/db f(a + b) = f'(a + b), which is a function of the output
+        {
+            auto output = ValueTensorFor(rank, fr);
+            inputGradient.DoBinaryOpOf(1, gradient, output, 1, BackwardFromOutputOp(), opSum);
+            return;
+        }
+
+        for (size_t i = 0; i < GetNumInputs(); i++)
+        {
+            if (i != inputIndex && Input(inputIndex)->ReducesInTimeWrt(Input(i)))
+                Input(i)->MaskMissingValueColumnsToZero(fr);
+        }
+
+        auto input0 = Input(0)->ValueTensorFor(rank, fr.AllowBroadcast());
+        auto input1 = Input(1)->ValueTensorFor(rank, fr.AllowBroadcast());
+        auto input2 = Input(2)->ValueTensorFor(rank, fr.AllowBroadcast());
+        if (inputIndex == 2) // d/dc f(a + b) .* c = f(a + b)
+            inputGradient.DoTernaryOpOf(1, input0, input1, gradient, 1, ForwardOp(), opSum);
+        else // d/da f(a + b) .* c = c .* f'(a + b)
+        {
+            m_gradientTimesInput2->Resize(Value());
+            auto gradientTimesInput2 = DataTensorFor(m_gradientTimesInput2, rank, fr);
+            gradientTimesInput2.AssignElementwiseProductOf(gradient, input2);
+            inputGradient.DoTernaryOpOf(1, gradientTimesInput2, input0, input1, 1, BackwardFromSumOp(), opSum);
+        }
+    }
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return !HasProduct(); }
+    virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return HasProduct(); }
+
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override
+    {
+        if (GetNumInputs() == 2)
+            ValidateBinaryZip(isFinalValidationPass, /* allow broadcast */ true);
+        else if (GetNumInputs() == 3)
+            ValidateNaryZip(isFinalValidationPass, /* allow broadcast */ true, /* num Inputs */ 3);
+        else
+            InvalidArgument("%ls %ls operation requires two or three inputs.", NodeName().c_str(), OperationName().c_str());
+        ForwardOp(); // verifies m_nonlinearity
+    }
+
+    virtual void RequestMatricesBeforeBackprop(MatrixPool& matrixPool) override
+    {
+        Base::RequestMatricesBeforeBackprop(matrixPool);
+        if (HasProduct())
+            RequestMatrixFromPool(m_gradientTimesInput2, matrixPool);
+    }
+
+    // release gradient and temp matrices that no longer needed after all the children's gradients are computed.
+    virtual void ReleaseMatricesAfterBackprop(MatrixPool& matrixPool) override
+    {
+        Base::ReleaseMatricesAfterBackprop(matrixPool);
+        if (HasProduct())
+            ReleaseMatrixToPool(m_gradientTimesInput2, matrixPool);
+    }
+
+private:
+    bool HasProduct() const { return GetNumInputs() == 3; }
+
+    ElementWiseOperator ForwardOp() const
+    {
+        if (m_nonlinearity == L"Sigmoid")
+            return HasProduct() ? opSigmoidOfSumTimes : opSigmoidOfSum;
+        else if (m_nonlinearity == L"Tanh")
+            return HasProduct() ? opTanhOfSumTimes : opTanhOfSum;
+        else if (m_nonlinearity == L"RectifiedLinear" && !HasProduct())
+            return opLinearRectifierOfSum;
+        InvalidArgument("%ls %ls operation: Nonlinearity '%ls' is not supported with %d inputs.", NodeName().c_str(), OperationName().c_str(), m_nonlinearity.c_str(), (int) GetNumInputs());
+    }
+
+    ElementWiseOperator BackwardFromOutputOp() const
+    {
+        return m_nonlinearity == L"Sigmoid" ? opElementwiseProductWithSigmoidDerivativeFromOutput :
+               m_nonlinearity == L"Tanh"    ? opElementwiseProductWithTanhDerivativeFromOutput :
+                                              opElementwiseProductWithLinearRectifierDerivativeFromOutput;
+    }
+
+    ElementWiseOperator BackwardFromSumOp() const
+    {
+        return m_nonlinearity == L"Sigmoid" ? opElementwiseProductWithSigmoidDerivativeOfSum : opElementwiseProductWithTanhDerivativeOfSum;
+    }
+
+    std::wstring m_nonlinearity; // "Sigmoid", "Tanh" or "RectifiedLinear"
+    shared_ptr<Matrix<ElemType>> m_gradientTimesInput2;
+};
+
+template class FusedElementwiseNode<float>;
+template class FusedElementwiseNode<double>;
+
 
 // -----------------------------------------------------------------------
 // CompareNode(a,b)
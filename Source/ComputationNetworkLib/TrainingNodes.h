@@ -134,6 +134,14 @@ public:
             Input(0)->GradientFor(fr).Print("CrossEntropyWithSoftmaxNode Partial-Left-in");
 #endif
 
+            // the fused forward computation does not produce log(softmax), it is only needed here
+            if (!m_hasLogSoftmaxOfRight)
+            {
+                m_logSoftmaxOfRight->AssignLogSoftmaxOf(Input(1)->ValueFor(fr), true);
+                MaskMissingColumnsToZero(*m_logSoftmaxOfRight, Input(1)->GetMBLayout(), fr);
+                m_hasLogSoftmaxOfRight = true;
+            }
+
             auto gradient = Input(0)->GradientFor(fr);
             Matrix<ElemType>::Multiply1x1AndWeightedAdd(-1.0f, Gradient() /*1x1*/, *m_logSoftmaxOfRight, 1.0f, gradient);
 #if DUMPOUTPUT
@@ -168,13 +176,26 @@ public:
 
     virtual void UpdateFunctionMBSize() override
     {
-        m_logSoftmaxOfRight->Resize(Input(1)->Value());
-        m_softmaxOfRight->Resize(*m_logSoftmaxOfRight);
+        // m_logSoftmaxOfRight is resized when it is computed
+        m_softmaxOfRight->Resize(Input(1)->Value());
     }
 
     virtual void /*ComputationNodeNonLooping::*/ ForwardPropNonLooping() override // -sum(left_i * log(softmax_i(right)))
     {
         FrameRange fr(Input(0)->GetMBLayout());
+        if (Input(1)->Value().GetDeviceId() == CPUDEVICE)
+        {
+            // Compute the softmax and the criterion together from the column-wise log-sum-exp of the input, visiting
+            // only the non-zero labels. Gaps are masked to zero in the labels, so they contribute zero to the sum.
+            Value().Resize(1, 1);
+            Value().SetValue(Matrix<ElemType>::SoftmaxAndCrossEntropy(Input(0)->MaskedValueFor(fr), Input(1)->ValueFor(fr), *m_softmaxOfRight));
+            m_hasLogSoftmaxOfRight = false;
+#if NANCHECK
+            Value().HasNan("CrossEntropyWithSoftmax");
+#endif
+            return;
+        }
+
         // first compute the softmax (column-wise)
         // Note that we need both log and non-log for gradient computation.
         m_logSoftmaxOfRight->AssignLogSoftmaxOf(Input(1)->ValueFor(fr), true);
@@ -186,6 +207,7 @@ public:
         // reduce over all frames
         Value().AssignInnerProductOfMatrices(Input(0)->MaskedValueFor(fr), *m_logSoftmaxOfRight);
         Value() *= -1;
+        m_hasLogSoftmaxOfRight = true;
 #if NANCHECK
         Value().HasNan("CrossEntropyWithSoftmax");
 #endif
@@ -207,6 +229,7 @@ public:
             auto node = dynamic_pointer_cast<CrossEntropyWithSoftmaxNode<ElemType>>(nodeP);
             node->m_logSoftmaxOfRight->SetValue(*m_logSoftmaxOfRight);
             node->m_softmaxOfRight->SetValue(*m_softmaxOfRight);
+            node->m_hasLogSoftmaxOfRight = m_hasLogSoftmaxOfRight;
         }
     }
 
@@ -221,6 +244,7 @@ public:
 protected:
     shared_ptr<Matrix<ElemType>> m_logSoftmaxOfRight;
     shared_ptr<Matrix<ElemType>> m_softmaxOfRight;
+    bool m_hasLogSoftmaxOfRight = false; // whether m_logSoftmaxOfRight holds log(softmax) of the current minibatch
 };
 
 template class CrossEntropyWithSoftmaxNode<float>;
@@ -1405,6 +1429,7 @@ template class LogisticNode<double>;
 // -----------------------------------------------------------------------
 // DropoutNode (input) -- perform drop-out
 // Output is scaled such that no post-scaling is necessary.
+// On the CPU, the mask is kept as one bit per element and applied by fused mask-and-scale operations.
 // -----------------------------------------------------------------------
 
 template <class ElemType>
@@ -1431,7 +1456,9 @@ public:
         Matrix<ElemType> sliceInput0Grad = Input(0)->GradientFor(fr);
         Matrix<ElemType> sliceOutputGrad = GradientFor(fr);
 
-        if (m_dropoutRate > 0)
+        if (m_dropoutRate > 0 && UseBitMask())
+            sliceInput0Grad.AddDropoutGradientOf(sliceOutputGrad, DropoutScale(), DataWithMBLayoutFor(*m_bitMaskOfDropout, fr, m_pMBLayout));
+        else if (m_dropoutRate > 0)
             sliceInput0Grad.AddElementProductOf(sliceOutputGrad, DataFor(*m_maskOfDropout, fr));
         else
             sliceInput0Grad += sliceOutputGrad;
@@ -1444,7 +1471,13 @@ public:
     {
         Base::UpdateFunctionMBSize();
         // resize temporaries to their proper size
-        if (m_dropoutRate > 0)
+        if (m_dropoutRate > 0 && UseBitMask())
+        {
+            if (!m_bitMaskOfDropout)
+                m_bitMaskOfDropout = make_shared<Matrix<char>>(CPUDEVICE);
+            m_bitMaskOfDropout->Resize((Input(0)->Value().GetNumRows() + 7) / 8, Input(0)->Value().GetNumCols());
+        }
+        else if (m_dropoutRate > 0)
             m_maskOfDropout->Resize(Input(0)->Value());
     }
 
@@ -1457,11 +1490,17 @@ public:
         {
             sliceOutputValue.SetValue(sliceInput0Value);
         }
+        else if (UseBitMask())
+        {
+            // determine drop-out mask for this minibatch and apply it in one go
+            auto sliceBitMask = DataWithMBLayoutFor(*m_bitMaskOfDropout, fr, m_pMBLayout);
+            sliceOutputValue.AssignDropoutOf(sliceInput0Value, (ElemType)m_dropoutRate, DropoutScale() /*pre-scaled*/, GetRNGHandle(), sliceBitMask);
+        }
         else
         {
             // determine drop-out mask for this minibatch
             auto sliceMask = DataFor(*m_maskOfDropout, fr);
-            sliceMask.SetUniformRandomMask((ElemType)m_dropoutRate, (ElemType)(1.0 / (1.0 - m_dropoutRate)) /*pre-scaled*/, GetRNGHandle());
+            sliceMask.SetUniformRandomMask((ElemType)m_dropoutRate, DropoutScale() /*pre-scaled*/, GetRNGHandle());
             // apply dropout mask
             sliceOutputValue.AssignElementProductOf(sliceMask, sliceInput0Value);
         }
@@ -1506,6 +1545,7 @@ public:
             node->m_dropoutRate = m_dropoutRate;
             node->m_randomSeed = m_randomSeed;
             node->m_maskOfDropout = m_maskOfDropout;
+            node->m_bitMaskOfDropout = m_bitMaskOfDropout;
         }
     }
     // request matrices needed to do node function value evaluation
@@ -1523,11 +1563,23 @@ public:
     }
 
 private:
+    // the bit-packed mask is only implemented on the CPU
+    bool UseBitMask() const
+    {
+        return m_deviceId == CPUDEVICE;
+    }
+
+    ElemType DropoutScale() const
+    {
+        return (ElemType)(1.0 / (1.0 - m_dropoutRate));
+    }
+
     double m_dropoutRate;
     unsigned long m_randomSeed;
     std::shared_ptr<RNGHandle> m_RNGHandle;
 
     shared_ptr<Matrix<ElemType>> m_maskOfDropout;
+    shared_ptr<Matrix<char>> m_bitMaskOfDropout; // one bit per element, used instead of m_maskOfDropout on the CPU
 };
 
 template class DropoutNode<float>;
@@ -1840,6 +1892,10 @@ public:
             ReleaseMatrixToPool(m_dBias, matrixPool);
         }
 
+    // Whether the node uses the CNTK implementation, which in inference computes
+    // output = scale * (input - runMean) * runInvStdDev + bias.
+    bool UsesCntkEngine() const { return m_useCntkEngine; }
+
     void SetNormalizationTimeConstants(double normalizationTimeConstant, double prevNormalizationTimeConstant,
                                        double blendTimeConstant, double prevBlendTimeConstant)
     {
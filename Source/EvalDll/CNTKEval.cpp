@@ -11,6 +11,7 @@
 #include "Actions.h"
 #include "CNTKEval.h"
 #include "CPUMatrix.h" // for SetNumThreads()
+#include "CPUFastMath.h"
 #include "SimpleOutputWriter.h"
 #include "NDLNetworkBuilder.h"
 #ifdef LEAKDETECT
@@ -29,6 +30,10 @@
 // sharing is ready to be enabled by default
 bool g_shareNodeValueMatrices = false;
 
+// Flag that enables fusing chains of element-wise nodes when compiling a network,
+// see ComputationNetwork::FuseElementwiseNodes()
+bool g_fuseElementwiseNodes = false;
+
 namespace Microsoft { namespace MSR { namespace CNTK {
 
 
@@ -39,6 +44,11 @@ void CNTKEvalBase<ElemType>::Init(const std::string& config)
     size_t nThreads = m_config("numCPUThreads", "1");
     CPUMatrix<ElemType>::SetNumThreads(nThreads);
     g_shareNodeValueMatrices = m_config(L"shareNodeValueMatrices", false);
+    g_fuseElementwiseNodes = m_config(L"fuseElementwiseNodes", false);
+    // process-wide (see CPUFastMath.h), so only change it if this model's config asks for it, and leave the
+    // setting of the host application or a previously loaded model alone otherwise
+    if (m_config.Exists(L"mathFunctions"))
+        SetCPUMathFunctions(ParseCPUMathFunctions(m_config(L"mathFunctions")));
 }
 
 
@@ -57,6 +67,12 @@ void CNTKEvalBase<ElemType>::CreateNetwork(const std::string& networkDescription
     {
         LogicError("Unable to construct network from description");
     }
+
+    // optionally rewrite the trained network into one that evaluates faster, see ComputationNetwork::OptimizeForEvaluation()
+    if (config(L"optimizeForEvaluation", false))
+    {
+        m_net->OptimizeForEvaluation<ElemType>();
+    }
 }
 
 
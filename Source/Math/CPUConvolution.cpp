@@ -0,0 +1,530 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUConvolution.cpp : native kernels for 2D convolutions on the CPU
+//
+
+#include "stdafx.h"
+#include "CPUConvolution.h"
+#include "CPUMatrix.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+static std::atomic<CPUConvolutionAlgorithm> s_convolutionAlgorithm(CPUConvolutionAlgorithm::Auto);
+
+void SetCPUConvolutionAlgorithm(CPUConvolutionAlgorithm algorithm)
+{
+    s_convolutionAlgorithm.store(algorithm);
+}
+
+CPUConvolutionAlgorithm GetCPUConvolutionAlgorithm()
+{
+    return s_convolutionAlgorithm.load();
+}
+
+// Channels per block of the direct convolution. The accumulators of a block fill two SSE registers in single precision.
+static const int ChannelBlock = 8;
+
+// Neighbouring output cells of a row the direct convolution computes at a time.
+static const int CellBlock = 4;
+
+// The direct convolution computes a row of output for a group of output channel blocks at a time, whose packed kernels
+// take up to this many bytes so that they stay in L2 while the row is computed.
+static const size_t DirectKernelGroupBytes = 256 * 1024;
+
+// Under CPUConvolutionAlgorithm::Auto, the Direct engine is picked for outputs with at least this many cells per map.
+// Single core, batch 2, the blocked direct convolution against im2col + OpenBLAS:
+// 56x56x64 -> 64 3x3: 34 ms vs 44 ms; 224x224x3 -> 64 7x7/2: 35 ms vs 46 ms; 56x56x64 -> 256 1x1: 15 ms vs 19 ms;
+// 28x28x128 -> 128 3x3: 34 ms vs 36 ms; 14x14x256 -> 256 3x3: 36 ms vs 28 ms; 7x7x512 -> 512 3x3: 51 ms vs 34 ms.
+static const int DirectMinOutputCells = 32 * 32;
+
+// Tiles are transformed and multiplied in chunks with at most this many transformed input and output elements,
+// so that the transformed tiles stay in cache between the three steps.
+static const size_t WinogradChunkElements = 1 << 20;
+
+template <class ElemType>
+static inline ElemType Activate(ElemType value, bool relu)
+{
+    return relu && value < 0 ? 0 : value;
+}
+
+// ---------------------------------------------------------------------------
+// blocked direct convolution
+// ---------------------------------------------------------------------------
+
+// The direct convolution enumerates the taps of a kernel, i.e. the input cells and channels an output cell depends on,
+// by input channel block, row, column and channel within the block. The kernels are packed in this order into
+// K/8 x taps x 8k, and for each group of neighbouring output cells the input values under their taps into a
+// taps x N panel, so that the inner loop streams through both and updates N x 8 accumulators the compiler keeps
+// in SIMD registers, as in the micro-kernel of CPUGemm. The panel is read from the padded copy of the sample, where
+// the rows of the channels of a block are next to each other (C/8 x H x 8c x W).
+template <class ElemType, int N>
+static void PackDirectPanel(const CPUConvolution2DShape& s, const ElemType* packedIn, int paddedW, int paddedH, int x, int y, ElemType* panel)
+{
+    const int B = ChannelBlock;
+    const int inBlocks = (s.m_inC + B - 1) / B;
+    for (int cb = 0; cb < inBlocks; cb++)
+    {
+        const int channels = std::min(B, s.m_inC - cb * B);
+        for (int ky = 0; ky < s.m_kernelH; ky++)
+        {
+            const ElemType* row = packedIn + (size_t) (cb * paddedH + y * s.m_strideH + ky) * B * paddedW + x * s.m_strideW;
+            for (int kx = 0; kx < s.m_kernelW; kx++)
+            {
+                for (int c = 0; c < channels; c++)
+                {
+                    const ElemType* cell = row + (size_t) c * paddedW + kx;
+                    for (int j = 0; j < N; j++)
+                        *panel++ = cell[j * s.m_strideW];
+                }
+            }
+        }
+    }
+}
+
+// Computes N output cells from (x, y) on for the 8 output channels of block kb from their panel.
+template <class ElemType, int N>
+static void DirectCells(const CPUConvolution2DShape& s, int taps, const ElemType* panel, const ElemType* packedKernel,
+                        int kb, int x, int y, const ElemType* bias, bool relu, ElemType* out)
+{
+    const int B = ChannelBlock;
+    ElemType acc[N][B];
+    for (int j = 0; j < N; j++)
+        for (int k = 0; k < B; k++)
+            acc[j][k] = 0;
+
+    const ElemType* w = packedKernel + (size_t) kb * taps * B;
+    for (int p = 0; p < taps; p++, panel += N, w += B)
+    {
+        for (int j = 0; j < N; j++)
+        {
+            const ElemType v = panel[j];
+            for (int k = 0; k < B; k++)
+                acc[j][k] += v * w[k];
+        }
+    }
+
+    const int outChannels = std::min(B, s.m_outC - kb * B);
+    const size_t plane = (size_t) s.m_outW * s.m_outH;
+    ElemType* o = out + kb * B * plane + (size_t) y * s.m_outW + x;
+    for (int k = 0; k < outChannels; k++, o += plane)
+    {
+        const ElemType b = bias ? bias[kb * B + k] : 0;
+        for (int j = 0; j < N; j++)
+            o[j] = Activate(acc[j][k] + b, relu);
+    }
+}
+
+// The same for the given number of cells, at most CellBlock.
+template <class ElemType>
+static void PackDirectPanel(const CPUConvolution2DShape& s, const ElemType* packedIn, int paddedW, int paddedH, int x, int y, int cells, ElemType* panel)
+{
+    switch (cells)
+    {
+    case 4: PackDirectPanel<ElemType, 4>(s, packedIn, paddedW, paddedH, x, y, panel); break;
+    case 3: PackDirectPanel<ElemType, 3>(s, packedIn, paddedW, paddedH, x, y, panel); break;
+    case 2: PackDirectPanel<ElemType, 2>(s, packedIn, paddedW, paddedH, x, y, panel); break;
+    default: PackDirectPanel<ElemType, 1>(s, packedIn, paddedW, paddedH, x, y, panel); break;
+    }
+}
+
+template <class ElemType>
+static void DirectCells(const CPUConvolution2DShape& s, int taps, const ElemType* panel, const ElemType* packedKernel,
+                        int kb, int x, int y, int cells, const ElemType* bias, bool relu, ElemType* out)
+{
+    switch (cells)
+    {
+    case 4: DirectCells<ElemType, 4>(s, taps, panel, packedKernel, kb, x, y, bias, relu, out); break;
+    case 3: DirectCells<ElemType, 3>(s, taps, panel, packedKernel, kb, x, y, bias, relu, out); break;
+    case 2: DirectCells<ElemType, 2>(s, taps, panel, packedKernel, kb, x, y, bias, relu, out); break;
+    default: DirectCells<ElemType, 1>(s, taps, panel, packedKernel, kb, x, y, bias, relu, out); break;
+    }
+}
+
+template <class ElemType>
+static void ForwardDirect(const CPUConvolution2DShape& s, const ElemType* in, int batchSize, const ElemType* kernel,
+                          const ElemType* bias, bool relu, ElemType* out)
+{
+    const int B = ChannelBlock;
+    const int inBlocks = (s.m_inC + B - 1) / B;
+    const int outBlocks = (s.m_outC + B - 1) / B;
+    const int taps = s.m_kernelW * s.m_kernelH * s.m_inC;
+    const size_t inSize = (size_t) s.m_inW * s.m_inH * s.m_inC;
+    const size_t outSize = (size_t) s.m_outW * s.m_outH * s.m_outC;
+
+    // The padded input covers the receptive fields of all output cells, starting at the first one.
+    const int paddedW = (s.m_outW - 1) * s.m_strideW + s.m_kernelW;
+    const int paddedH = (s.m_outH - 1) * s.m_strideH + s.m_kernelH;
+
+    // Kernels in K/8 x taps x 8k, zero for the output channels past K.
+    std::vector<ElemType> packedKernel((size_t) outBlocks * taps * B, 0);
+#pragma omp parallel for
+    for (long k = 0; k < s.m_outC; k++)
+    {
+        const ElemType* src = kernel + k * (size_t) taps;
+        ElemType* dst = packedKernel.data() + (size_t) (k / B) * taps * B + k % B;
+        for (int cb = 0; cb < inBlocks; cb++)
+        {
+            const int channels = std::min(B, s.m_inC - cb * B);
+            for (int ky = 0; ky < s.m_kernelH; ky++)
+            {
+                for (int kx = 0; kx < s.m_kernelW; kx++)
+                {
+                    for (int c = 0; c < channels; c++, dst += B)
+                        *dst = src[kx + s.m_kernelW * (ky + s.m_kernelH * (cb * B + c))];
+                }
+            }
+        }
+    }
+
+    // One sample at a time, so that its padded copy stays in cache.
+    std::vector<ElemType> packedIn((size_t) inBlocks * paddedH * B * paddedW);
+    const int xBegin = std::max(0, -s.m_firstW);
+    const int xEnd = std::min(paddedW, s.m_inW - s.m_firstW);
+    // The output channel blocks are processed in groups whose kernels fit into the cache together.
+    const int groupBlocks = std::max(1, (int) (DirectKernelGroupBytes / ((size_t) taps * B * sizeof(ElemType))));
+    const int kernelGroups = (outBlocks + groupBlocks - 1) / groupBlocks;
+    for (int n = 0; n < batchSize; n++)
+    {
+        const ElemType* sample = in + n * inSize;
+        ElemType* sampleOut = out + n * outSize;
+
+#pragma omp parallel for
+        for (long cby = 0; cby < (long) inBlocks * paddedH; cby++)
+        {
+            const int cb = (int) (cby / paddedH);
+            const int y = (int) (cby % paddedH) + s.m_firstH;
+            const int channels = std::min(B, s.m_inC - cb * B);
+            for (int c = 0; c < channels; c++)
+            {
+                ElemType* dst = packedIn.data() + ((size_t) cby * B + c) * paddedW;
+                if (y < 0 || y >= s.m_inH)
+                {
+                    std::fill(dst, dst + paddedW, (ElemType) 0);
+                    continue;
+                }
+                const ElemType* src = sample + (size_t) (cb * B + c) * s.m_inW * s.m_inH + (size_t) y * s.m_inW + s.m_firstW;
+                std::fill(dst, dst + xBegin, (ElemType) 0);
+                std::copy(src + xBegin, src + xEnd, dst + xBegin);
+                std::fill(dst + xEnd, dst + paddedW, (ElemType) 0);
+            }
+        }
+
+#pragma omp parallel
+        {
+            std::vector<ElemType> panels((size_t) taps * s.m_outW);
+#pragma omp for
+            for (long gy = 0; gy < (long) kernelGroups * s.m_outH; gy++)
+            {
+                const int kbBegin = (int) (gy / s.m_outH) * groupBlocks;
+                const int kbEnd = std::min(outBlocks, kbBegin + groupBlocks);
+                const int y = (int) (gy % s.m_outH);
+                for (int x = 0; x < s.m_outW; x += CellBlock)
+                    PackDirectPanel(s, packedIn.data(), paddedW, paddedH, x, y, std::min(CellBlock, s.m_outW - x), panels.data() + (size_t) x * taps);
+                for (int kb = kbBegin; kb < kbEnd; kb++)
+                {
+                    for (int x = 0; x < s.m_outW; x += CellBlock)
+                        DirectCells(s, taps, panels.data() + (size_t) x * taps, packedKernel.data(), kb, x, y, std::min(CellBlock, s.m_outW - x), bias, relu, sampleOut);
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Winograd F(MxM, 3x3)
+// ---------------------------------------------------------------------------
+
+// Transform matrices of F(M, 3) from Lavin, Gray: input transform B' (A x A), kernel transform G (A x 3) and
+// output transform A' (M x A), where A = M + 2 is the size of an input tile.
+template <int M>
+struct WinogradMatrices;
+
+template <>
+struct WinogradMatrices<2>
+{
+    static double BT(int i, int j)
+    {
+        static const double bt[4][4] =
+        {
+            { 1,  0, -1,  0 },
+            { 0,  1,  1,  0 },
+            { 0, -1,  1,  0 },
+            { 0,  1,  0, -1 }
+        };
+        return bt[i][j];
+    }
+
+    static double G(int i, int j)
+    {
+        static const double g[4][3] =
+        {
+            { 1,    0,   0   },
+            { 0.5,  0.5, 0.5 },
+            { 0.5, -0.5, 0.5 },
+            { 0,    0,   1   }
+        };
+        return g[i][j];
+    }
+
+    static double AT(int i, int j)
+    {
+        static const double at[2][4] =
+        {
+            { 1, 1,  1,  0 },
+            { 0, 1, -1, -1 }
+        };
+        return at[i][j];
+    }
+};
+
+template <>
+struct WinogradMatrices<4>
+{
+    static double BT(int i, int j)
+    {
+        static const double bt[6][6] =
+        {
+            { 4,  0, -5,  0, 1, 0 },
+            { 0, -4, -4,  1, 1, 0 },
+            { 0,  4, -4, -1, 1, 0 },
+            { 0, -2, -1,  2, 1, 0 },
+            { 0,  2, -1, -2, 1, 0 },
+            { 0,  4,  0, -5, 0, 1 }
+        };
+        return bt[i][j];
+    }
+
+    static double G(int i, int j)
+    {
+        static const double g[6][3] =
+        {
+            {  1.0 / 4,   0,          0        },
+            { -1.0 / 6,  -1.0 / 6,   -1.0 / 6  },
+            { -1.0 / 6,   1.0 / 6,   -1.0 / 6  },
+            {  1.0 / 24,  1.0 / 12,   1.0 / 6  },
+            {  1.0 / 24, -1.0 / 12,   1.0 / 6  },
+            {  0,         0,          1        }
+        };
+        return g[i][j];
+    }
+
+    static double AT(int i, int j)
+    {
+        static const double at[4][6] =
+        {
+            { 1, 1,  1, 1,  1, 0 },
+            { 0, 1, -1, 2, -2, 0 },
+            { 0, 1,  1, 4,  4, 0 },
+            { 0, 1, -1, 8, -8, 1 }
+        };
+        return at[i][j];
+    }
+};
+
+// The three steps each produce or consume A x A matrices, one per element of a tile, stored one after another:
+//  - u: the transformed kernels G g G', C x K each,
+//  - v: the transformed input tiles B' d B, tiles x C each,
+//  - m: their products v u, tiles x K each, from which the output tiles A' m A are computed.
+template <class ElemType, int M>
+static void ForwardWinograd(const CPUConvolution2DShape& s, const ElemType* in, int batchSize, const ElemType* kernel,
+                            const ElemType* bias, bool relu, ElemType* out)
+{
+    typedef WinogradMatrices<M> T;
+    const int A = M + 2;
+    const int C = s.m_inC;
+    const int K = s.m_outC;
+    const size_t inPlane = (size_t) s.m_inW * s.m_inH;
+    const size_t outPlane = (size_t) s.m_outW * s.m_outH;
+    const size_t kernelSize = 9 * (size_t) C;
+
+    std::vector<ElemType> u((size_t) A * A * C * K);
+#pragma omp parallel for
+    for (long k = 0; k < K; k++)
+    {
+        for (int c = 0; c < C; c++)
+        {
+            const ElemType* g = kernel + k * kernelSize + 9 * c; // g[ky * 3 + kx]
+            double gg[A][3];
+            for (int i = 0; i < A; i++)
+                for (int j = 0; j < 3; j++)
+                    gg[i][j] = T::G(i, 0) * g[j] + T::G(i, 1) * g[3 + j] + T::G(i, 2) * g[6 + j];
+            for (int i = 0; i < A; i++)
+                for (int j = 0; j < A; j++)
+                    u[(i * A + j) * (size_t) C * K + c + (size_t) C * k] = (ElemType) (gg[i][0] * T::G(j, 0) + gg[i][1] * T::G(j, 1) + gg[i][2] * T::G(j, 2));
+        }
+    }
+
+    const int tilesW = (s.m_outW + M - 1) / M;
+    const int tilesH = (s.m_outH + M - 1) / M;
+    const size_t tilesPerSample = (size_t) tilesW * tilesH;
+    const size_t totalTiles = tilesPerSample * batchSize;
+    const size_t chunk = std::max((size_t) 1, std::min(totalTiles, WinogradChunkElements / ((size_t) A * A * (C + K))));
+
+    std::vector<ElemType> v((size_t) A * A * C * chunk);
+    std::vector<ElemType> m((size_t) A * A * K * chunk);
+    CPUMatrix<ElemType> uMat(C, A * A * K, u.data(), matrixFlagDontOwnBuffer);
+    std::vector<size_t> offsetsU(A * A), offsetsV(A * A), offsetsM(A * A);
+    for (int i = 0; i < A * A; i++)
+        offsetsU[i] = i * (size_t) C * K;
+
+    for (size_t first = 0; first < totalTiles; first += chunk)
+    {
+        const size_t tiles = std::min(chunk, totalTiles - first);
+
+#pragma omp parallel for
+        for (long t = 0; t < (long) tiles; t++)
+        {
+            const size_t tile = first + t;
+            const size_t n = tile / tilesPerSample;
+            const int ty = (int) (tile % tilesPerSample) / tilesW;
+            const int tx = (int) (tile % tilesPerSample) % tilesW;
+            const int x0 = tx * M + s.m_firstW;
+            const int y0 = ty * M + s.m_firstH;
+            const bool inside = x0 >= 0 && y0 >= 0 && x0 + A <= s.m_inW && y0 + A <= s.m_inH;
+            for (int c = 0; c < C; c++)
+            {
+                const ElemType* plane = in + n * C * inPlane + c * inPlane;
+                ElemType d[A][A];
+                for (int i = 0; i < A; i++)
+                {
+                    const int y = y0 + i;
+                    for (int j = 0; j < A; j++)
+                    {
+                        const int x = x0 + j;
+                        d[i][j] = inside || (x >= 0 && y >= 0 && x < s.m_inW && y < s.m_inH) ? plane[(size_t) y * s.m_inW + x] : 0;
+                    }
+                }
+                ElemType bd[A][A];
+                for (int i = 0; i < A; i++)
+                {
+                    for (int j = 0; j < A; j++)
+                    {
+                        ElemType sum = 0;
+                        for (int l = 0; l < A; l++)
+                            sum += (ElemType) T::BT(i, l) * d[l][j];
+                        bd[i][j] = sum;
+                    }
+                }
+                for (int i = 0; i < A; i++)
+                {
+                    for (int j = 0; j < A; j++)
+                    {
+                        ElemType sum = 0;
+                        for (int l = 0; l < A; l++)
+                            sum += bd[i][l] * (ElemType) T::BT(j, l);
+                        v[(i * A + j) * tiles * C + t + tiles * c] = sum;
+                    }
+                }
+            }
+        }
+
+        for (int i = 0; i < A * A; i++)
+        {
+            offsetsV[i] = i * tiles * C;
+            offsetsM[i] = i * tiles * K;
+        }
+        CPUMatrix<ElemType> vMat(tiles, A * A * C, v.data(), matrixFlagDontOwnBuffer);
+        CPUMatrix<ElemType> mMat(tiles, A * A * K, m.data(), matrixFlagDontOwnBuffer);
+        CPUMatrix<ElemType>::BatchMultiplyAndWeightedAdd(1, vMat, false, offsetsV, uMat, false, offsetsU, 0, mMat, offsetsM, tiles, K, C);
+
+#pragma omp parallel for
+        for (long t = 0; t < (long) tiles; t++)
+        {
+            const size_t tile = first + t;
+            const size_t n = tile / tilesPerSample;
+            const int ty = (int) (tile % tilesPerSample) / tilesW;
+            const int tx = (int) (tile % tilesPerSample) % tilesW;
+            const int rows = std::min(M, s.m_outH - ty * M);
+            const int cols = std::min(M, s.m_outW - tx * M);
+            for (int k = 0; k < K; k++)
+            {
+                ElemType mt[A][A];
+                for (int i = 0; i < A; i++)
+                    for (int j = 0; j < A; j++)
+                        mt[i][j] = m[(i * A + j) * tiles * K + t + tiles * k];
+                ElemType am[M][A];
+                for (int i = 0; i < M; i++)
+                {
+                    for (int j = 0; j < A; j++)
+                    {
+                        ElemType sum = 0;
+                        for (int l = 0; l < A; l++)
+                            sum += (ElemType) T::AT(i, l) * mt[l][j];
+                        am[i][j] = sum;
+                    }
+                }
+                const ElemType b = bias ? bias[k] : 0;
+                ElemType* o = out + n * K * outPlane + k * outPlane + (size_t) ty * M * s.m_outW + tx * M;
+                for (int i = 0; i < rows; i++)
+                {
+                    for (int j = 0; j < cols; j++)
+                    {
+                        ElemType sum = b;
+                        for (int l = 0; l < A; l++)
+                            sum += am[i][l] * (ElemType) T::AT(j, l);
+                        o[(size_t) i * s.m_outW + j] = Activate(sum, relu);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// CPUConvolution
+// ---------------------------------------------------------------------------
+
+template <class ElemType>
+CPUConvolutionAlgorithm CPUConvolution<ElemType>::ChooseAlgorithm(const CPUConvolution2DShape& shape)
+{
+    const bool winograd = shape.m_kernelW == 3 && shape.m_kernelH == 3 && shape.m_strideW == 1 && shape.m_strideH == 1;
+    // read the setting once, it can be changed by another thread in the meantime
+    const CPUConvolutionAlgorithm algorithm = s_convolutionAlgorithm.load();
+    switch (algorithm)
+    {
+    case CPUConvolutionAlgorithm::Winograd2x2:
+    case CPUConvolutionAlgorithm::Winograd4x4:
+        return winograd ? algorithm : CPUConvolutionAlgorithm::Direct;
+    default:
+        return CPUConvolutionAlgorithm::Direct;
+    }
+}
+
+template <class ElemType>
+bool CPUConvolution<ElemType>::IsFasterThanGemm(const CPUConvolution2DShape& shape)
+{
+    if (s_convolutionAlgorithm.load() != CPUConvolutionAlgorithm::Auto)
+        return true;
+    return shape.m_outW * shape.m_outH >= DirectMinOutputCells;
+}
+
+template <class ElemType>
+void CPUConvolution<ElemType>::Forward(const CPUConvolution2DShape& shape, const ElemType* in, int batchSize, const ElemType* kernel,
+                                       const ElemType* bias, bool relu, ElemType* out)
+{
+    if (batchSize == 0)
+        return;
+
+    switch (ChooseAlgorithm(shape))
+    {
+    case CPUConvolutionAlgorithm::Winograd2x2:
+        ForwardWinograd<ElemType, 2>(shape, in, batchSize, kernel, bias, relu, out);
+        break;
+    case CPUConvolutionAlgorithm::Winograd4x4:
+        ForwardWinograd<ElemType, 4>(shape, in, batchSize, kernel, bias, relu, out);
+        break;
+    default:
+        ForwardDirect(shape, in, batchSize, kernel, bias, relu, out);
+        break;
+    }
+}
+
+template class CPUConvolution<float>;
+template class CPUConvolution<double>;
+
+}}}
@@ -0,0 +1,68 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUConvolution.h : native kernels for 2D convolutions on the CPU
+//
+
+#pragma once
+
+#include "CommonMatrix.h"
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Which algorithm CPUConvolution::Forward uses.
+enum class CPUConvolutionAlgorithm
+{
+    Auto,        // the blocked direct convolution, and the Direct engine only where it is faster than GEMM (see IsFasterThanGemm())
+    Direct,      // always the blocked direct convolution
+    Winograd2x2, // Winograd F(2x2, 3x3) for 3x3 stride 1 convolutions, direct otherwise
+    Winograd4x4  // Winograd F(4x4, 3x3) for 3x3 stride 1 convolutions, direct otherwise
+};
+
+// Anything but Auto opts into the Direct engine for all geometries it supports. Winograd changes the numerics of the
+// forward pass (while the backward passes still use GEMM), so it is never chosen on its own.
+MATH_API void SetCPUConvolutionAlgorithm(CPUConvolutionAlgorithm algorithm);
+MATH_API CPUConvolutionAlgorithm GetCPUConvolutionAlgorithm();
+
+// A 2D convolution with full sharing whose kernels span all input channels. Following CNTK, all tensors are column-major:
+// a sample is W x H x C (W fastest), a kernel is X x Y x C and an output sample is W' x H' x K.
+struct CPUConvolution2DShape
+{
+    int m_inW, m_inH, m_inC;
+    int m_kernelW, m_kernelH;
+    int m_outW, m_outH, m_outC;
+    int m_strideW, m_strideH;
+    // Input cell under the first kernel tap of output cell 0, negative when the input is padded.
+    int m_firstW, m_firstH;
+};
+
+// Forward convolution for the convolution engine of kind Direct. There are two algorithms:
+//  - blocked direct convolution: the sample is copied into a zero-padded layout with the input channels in blocks of 8
+//    (C/8 x H x 8c x W) and the kernels into blocks of 8 output channels (K/8 x XYC x 8k). For 4 neighbouring output
+//    cells at a time the input values under the kernel are gathered into a small panel, from which a register-blocked
+//    loop computes the 4 x 8k outputs of each block of output channels, without ever unrolling the whole input,
+//  - Winograd minimal filtering F(2x2, 3x3) or F(4x4, 3x3) for 3x3 kernels with stride 1 (Lavin, Gray: Fast
+//    Algorithms for Convolutional Neural Networks): the input tiles and the kernels are transformed, multiplied
+//    as a batch of 16 (36) matrix products over the channels and transformed back, which needs 2.25x (4x) fewer
+//    multiplications than the direct convolution. F(4x4, 3x3) is less accurate, its errors in single precision
+//    are about 1e-5 relative to the magnitude of the outputs.
+// Both algorithms optionally fuse adding a bias per output channel and a ReLU into writing the output.
+template <class ElemType>
+class MATH_API CPUConvolution
+{
+public:
+    // out = op(conv(in, kernel) + bias) for batchSize samples stored one after another, where op is ReLU if relu is true
+    // and the identity otherwise. kernel holds the K kernels one after another (the layout of the row-major K x XYC
+    // kernel matrix of the convolution engines). bias has K values or is null.
+    static void Forward(const CPUConvolution2DShape& shape, const ElemType* in, int batchSize, const ElemType* kernel,
+                        const ElemType* bias, bool relu, ElemType* out);
+
+    // Algorithm Forward() uses for the shape under the current setting: Direct, Winograd2x2 or Winograd4x4.
+    static CPUConvolutionAlgorithm ChooseAlgorithm(const CPUConvolution2DShape& shape);
+
+    // Whether ConvolutionEngine::Create() picks the Direct engine over the GEMM engine for the shape under the current setting.
+    static bool IsFasterThanGemm(const CPUConvolution2DShape& shape);
+};
+
+}}}
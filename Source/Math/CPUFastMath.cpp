@@ -0,0 +1,215 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUFastMath.cpp : fast approximate transcendental functions for the CPU tensor ops
+//
+
+#include "stdafx.h"
+#include "CPUFastMath.h"
+#include "TensorOps.h"
+#include <emmintrin.h> // SSE2
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+static std::atomic<CPUMathFunctions> s_mathFunctions(CPUMathFunctions::Exact);
+
+void SetCPUMathFunctions(CPUMathFunctions functions)
+{
+    s_mathFunctions.store(functions);
+}
+
+CPUMathFunctions GetCPUMathFunctions()
+{
+    return s_mathFunctions.load();
+}
+
+CPUMathFunctions ParseCPUMathFunctions(const std::wstring& name)
+{
+    if (name == L"exact")
+        return CPUMathFunctions::Exact;
+    else if (name == L"fast")
+        return CPUMathFunctions::Fast;
+    else
+        InvalidArgument("mathFunctions: '%ls' is not a valid value, use 'exact' or 'fast'.", name.c_str());
+}
+
+// -----------------------------------------------------------------------
+// SSE2 versions of the fast functions in TensorOps.h
+//
+// These perform the same operations in the same order as the scalar versions. Since Math is compiled with
+// fast floating point semantics the compiler may still contract or reorder some of them, so the two versions
+// can differ in the last bit.
+// -----------------------------------------------------------------------
+
+// select a where mask is set and b elsewhere
+static inline __m128 Select4(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// x < lo ? lo : (x > hi ? hi : x), as in the scalar functions, also for NaN
+static inline __m128 Clamp4(__m128 x, float lo, float hi)
+{
+    return _mm_min_ps(_mm_set1_ps(hi), _mm_max_ps(_mm_set1_ps(lo), x));
+}
+
+static inline __m128 FastExp4(__m128 x)
+{
+    __m128 xx = Clamp4(x, -87.0f, 88.0f);
+    __m128 t = _mm_mul_ps(xx, _mm_set1_ps(1.44269504088896341f));
+    __m128 half = Select4(_mm_cmpge_ps(t, _mm_setzero_ps()), _mm_set1_ps(0.5f), _mm_set1_ps(-0.5f));
+    __m128i n = _mm_cvttps_epi32(_mm_add_ps(t, half));
+    __m128 fn = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(xx, _mm_mul_ps(fn, _mm_set1_ps(0.693359375f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(fn, _mm_set1_ps(-2.12194440e-4f)));
+    __m128 p = _mm_set1_ps(1.9875691500e-4f);
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.3981999507e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(8.3334519073e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(4.1665795894e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.6666665459e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.0000001201e-1f));
+    p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
+
+static inline __m128 FastLog4(__m128 x)
+{
+    __m128i bits = _mm_castps_si128(x);
+    __m128i expField = _mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff));
+    __m128 infOrNaN = _mm_castsi128_ps(_mm_cmpeq_epi32(expField, _mm_set1_epi32(0xff)));
+    __m128i e = _mm_sub_epi32(expField, _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+    __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356237f));
+    m = Select4(big, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+    __m128 fe = _mm_cvtepi32_ps(_mm_sub_epi32(e, _mm_castps_si128(big))); // big is -1 where set
+    __m128 f = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+    __m128 z = _mm_mul_ps(f, f);
+    __m128 y = _mm_set1_ps(7.0376836292e-2f);
+    y = _mm_sub_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.1514610310e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.1676998740e-1f));
+    y = _mm_sub_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.2420140846e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.4249322787e-1f));
+    y = _mm_sub_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.6668057665e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(2.0000714765e-1f));
+    y = _mm_sub_ps(_mm_mul_ps(y, f), _mm_set1_ps(2.4999993993e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(3.3333331174e-1f));
+    y = _mm_mul_ps(_mm_mul_ps(y, f), z);
+    y = _mm_add_ps(y, _mm_mul_ps(fe, _mm_set1_ps(-2.12194440e-4f)));
+    y = _mm_sub_ps(y, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    __m128 result = _mm_add_ps(_mm_add_ps(f, y), _mm_mul_ps(fe, _mm_set1_ps(0.693359375f)));
+    return Select4(infOrNaN, x, result);
+}
+
+static inline __m128 FastTanh4(__m128 x)
+{
+    __m128 xx = Clamp4(x, -7.90531110763549805f, 7.90531110763549805f);
+    __m128 x2 = _mm_mul_ps(xx, xx);
+    __m128 p = _mm_set1_ps(-2.76076847742355e-16f);
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(2.00018790482477e-13f));
+    p = _mm_sub_ps(_mm_mul_ps(p, x2), _mm_set1_ps(8.60467152213735e-11f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(5.12229709037114e-08f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.48572235717979e-05f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(6.37261928875436e-04f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(4.89352455891786e-03f));
+    p = _mm_mul_ps(p, xx);
+    __m128 q = _mm_set1_ps(1.19825839466702e-06f);
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(1.18534705686654e-04f));
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(2.26843463243900e-03f));
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(4.89352518554385e-03f));
+    return _mm_div_ps(p, q);
+}
+
+// the unary ops, as a vectorized and a scalar version
+struct FastSigmoidOp
+{
+    static __m128 Compute4(__m128 x) { return _mm_add_ps(_mm_set1_ps(0.5f), _mm_mul_ps(_mm_set1_ps(0.5f), FastTanh4(_mm_mul_ps(_mm_set1_ps(0.5f), x)))); }
+    static float Compute(float x) { return OpFastSigmoid(x); }
+};
+
+struct FastTanhOp
+{
+    static __m128 Compute4(__m128 x) { return FastTanh4(x); }
+    static float Compute(float x) { return OpFastTanh(x); }
+};
+
+struct FastExpOp
+{
+    static __m128 Compute4(__m128 x) { return FastExp4(x); }
+    static float Compute(float x) { return OpFastExp(x); }
+};
+
+struct FastLogOp // with the clipping of ClippedLog()
+{
+    static __m128 Compute4(__m128 x) { return Select4(_mm_cmplt_ps(x, _mm_set1_ps(EPS_IN_LOG)), _mm_set1_ps(LOG_OF_EPS_IN_LOG), FastLog4(x)); }
+    static float Compute(float x) { return OpFastLog(x); }
+};
+
+// Below this many elements the op runs on a single thread.
+static const size_t FastMathChunkSize = 16384;
+
+template <class OP>
+static void FastUnaryOp(float beta, const float* a, float alpha, float* c, size_t n)
+{
+    int numChunks = (int) ((n + FastMathChunkSize - 1) / FastMathChunkSize);
+#pragma omp parallel for if (numChunks > 1)
+    for (int chunk = 0; chunk < numChunks; chunk++)
+    {
+        size_t begin = chunk * FastMathChunkSize;
+        size_t end = std::min(begin + FastMathChunkSize, n);
+        size_t i = begin;
+        const __m128 alpha4 = _mm_set1_ps(alpha);
+        const __m128 beta4 = _mm_set1_ps(beta);
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 val = _mm_mul_ps(OP::Compute4(_mm_loadu_ps(a + i)), alpha4);
+            if (beta != 0)
+                val = _mm_add_ps(val, _mm_mul_ps(beta4, _mm_loadu_ps(c + i)));
+            _mm_storeu_ps(c + i, val);
+        }
+        for (; i < end; i++)
+        {
+            float val = OP::Compute(a[i]) * alpha;
+            if (beta != 0)
+                val += beta * c[i];
+            c[i] = val;
+        }
+    }
+}
+
+template <class ElemType>
+/*static*/ bool CPUFastMath<ElemType>::UnaryOp(ElementWiseOperator, ElemType, const ElemType*, ElemType, ElemType*, size_t)
+{
+    return false; // double precision always uses the exact functions
+}
+
+template <>
+/*static*/ bool CPUFastMath<float>::UnaryOp(ElementWiseOperator op, float beta, const float* a, float alpha, float* c, size_t n)
+{
+    switch (op)
+    {
+    case ElementWiseOperator::opSigmoid:
+        FastUnaryOp<FastSigmoidOp>(beta, a, alpha, c, n);
+        return true;
+    case ElementWiseOperator::opTanh:
+        FastUnaryOp<FastTanhOp>(beta, a, alpha, c, n);
+        return true;
+    case ElementWiseOperator::opExp:
+        FastUnaryOp<FastExpOp>(beta, a, alpha, c, n);
+        return true;
+    case ElementWiseOperator::opLog:
+        FastUnaryOp<FastLogOp>(beta, a, alpha, c, n);
+        return true;
+    default:
+        return false;
+    }
+}
+
+template class CPUFastMath<float>;
+template class CPUFastMath<double>;
+
+}}}
@@ -0,0 +1,45 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUFastMath.h : fast approximate transcendental functions for the CPU tensor ops
+//
+
+#pragma once
+
+#include "CommonMatrix.h"
+#include <string>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Which implementation of sigmoid, tanh, exp and log the CPU tensor ops use (config parameter mathFunctions).
+enum class CPUMathFunctions
+{
+    Exact, // the C library functions
+    Fast   // the approximations FastSigmoid() etc. in TensorOps.h, see there for their errors; single precision only
+};
+
+// The setting is process-wide, not per network: all networks in a process, including several models loaded
+// through the eval DLL, use the value set last. Setting it while tensor ops run on other threads is safe, but
+// those ops may then use either implementation.
+MATH_API void SetCPUMathFunctions(CPUMathFunctions functions);
+MATH_API CPUMathFunctions GetCPUMathFunctions();
+
+// parse the value of the mathFunctions config parameter: "exact" or "fast"
+MATH_API CPUMathFunctions ParseCPUMathFunctions(const std::wstring& name);
+
+// Unary tensor ops with the fast functions on contiguous arrays, for the common case of a Sigmoid, Tanh, Exp or Log
+// node applied to a whole minibatch. The float versions compute 4 elements at a time with SSE2, with the same
+// sequence of operations as the scalar functions in TensorOps.h, which are used for the remaining elements and by
+// the tensor ops in all other cases; depending on the compiler the two may differ in the last bit. The elements
+// are split between OpenMP threads.
+template <class ElemType>
+class MATH_API CPUFastMath
+{
+public:
+    // c = alpha * op(a) + beta * c for n elements; c is not read if beta is 0. a and c may be the same.
+    // Returns false without computing anything if there is no vectorized version of op for ElemType.
+    static bool UnaryOp(ElementWiseOperator op, ElemType beta, const ElemType* a, ElemType alpha, ElemType* c, size_t n);
+};
+
+}}}
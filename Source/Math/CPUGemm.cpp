@@ -0,0 +1,476 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUGemm.cpp : built-in matrix product used next to the external BLAS library
+//
+
+#include "stdafx.h"
+#include "CPUGemm.h"
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+static std::atomic<CPUGemmPolicy> s_gemmPolicy(CPUGemmPolicy::Blas);
+
+void SetCPUGemmPolicy(CPUGemmPolicy policy)
+{
+    s_gemmPolicy.store(policy);
+}
+
+CPUGemmPolicy GetCPUGemmPolicy()
+{
+    return s_gemmPolicy.load();
+}
+
+CPUGemmPolicy ParseCPUGemmPolicy(const std::wstring& name)
+{
+    if (name == L"blas")
+        return CPUGemmPolicy::Blas;
+    else if (name == L"auto")
+        return CPUGemmPolicy::Auto;
+    else if (name == L"native")
+        return CPUGemmPolicy::Native;
+    else
+        InvalidArgument("cpuGemm: '%ls' is not a valid value, use 'blas', 'auto' or 'native'.", name.c_str());
+}
+
+// Blocking of the packed path. The MR x NR accumulators of the micro-kernel have to fit into the SIMD registers,
+// a KC x NR panel of op(b) into L1 and an MC x KC block of op(a) into L2.
+template <class ElemType>
+struct GemmBlocking;
+
+template <>
+struct GemmBlocking<float>
+{
+    static const int MR = 8;
+    static const int NR = 4;
+    static const int KC = 256;
+    static const int MC = 128;
+    static const int NC = 2048;
+};
+
+template <>
+struct GemmBlocking<double>
+{
+    static const int MR = 4;
+    static const int NR = 4;
+    static const int KC = 256;
+    static const int MC = 64;
+    static const int NC = 2048;
+};
+
+// Shapes with any dimension up to this size, or with up to this many multiply-adds, go to the direct path;
+// packing does not pay off for them.
+static const int DirectMaxDim = 8;
+static const double DirectMaxWork = 32 * 32 * 32;
+
+// Number of rows of c a thread of the direct path works on at a time.
+static const int DirectRowBlock = 512;
+
+// Products with fewer multiply-adds than this are computed single-threaded.
+static const double ParallelWork = 1 << 16;
+
+// Batches of products up to this many multiply-adds each go to GemmBatch() under CPUGemmPolicy::Auto.
+static const double BatchItemMaxWork = 128.0 * 128 * 128;
+
+// Crossover between the native kernels and the BLAS library: the native kernels are used for products with at most
+// maxN columns of c and at most maxWork multiply-adds, the first matching row applies. Measured with GemmCrossoverTest
+// in MathPerformanceTests against single-threaded OpenBLAS; the packed path stays within 1.5x of it for large products
+// but does not beat it, so the table only selects the direct path. It has not been measured against MKL or ACML, which
+// is why Auto is not the default. Builds linked against reference BLAS are better off with CPUGemmPolicy::Native.
+struct GemmCrossover
+{
+    int maxN;
+    double maxWork;
+};
+
+static const GemmCrossover s_gemmCrossover[] =
+{
+    { 1, 1e12 },               // matrix-vector products, 1.7x faster than sgemm for 512 x 512
+    { 4, 4.0 * 1024 * 1024 },  // recurrent steps with a few sequences, e.g. 512 x 512 times 512 x 4
+};
+
+static inline int RoundUp(int value, int multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// c[i0 : i0 + rows, j0 : j0 + cols] *= beta, without reading c if beta is 0.
+template <class ElemType>
+static void ScaleBlock(ElemType beta, ElemType* c, int ldc, int i0, int rows, int j0, int cols)
+{
+    if (beta == 1)
+        return;
+
+    for (int j = j0; j < j0 + cols; j++)
+    {
+        ElemType* cj = c + (size_t) j * ldc;
+        if (beta == 0)
+        {
+            for (int i = i0; i < i0 + rows; i++)
+                cj[i] = 0;
+        }
+        else
+        {
+            for (int i = i0; i < i0 + rows; i++)
+                cj[i] *= beta;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// direct path
+// ---------------------------------------------------------------------------
+
+// Rows i0 .. i1 of c += alpha * a * op(b), as column updates: each column of a is read once per four columns of c.
+template <class ElemType>
+static void DirectColumnUpdates(bool transB, int i0, int i1, int n, int k, ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb, ElemType* c, int ldc)
+{
+    // strides of op(b) along k and along n
+    const size_t bk = transB ? ldb : 1;
+    const size_t bn = transB ? 1 : ldb;
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        ElemType* c0 = c + (size_t) j * ldc;
+        ElemType* c1 = c0 + ldc;
+        ElemType* c2 = c1 + ldc;
+        ElemType* c3 = c2 + ldc;
+        for (int p = 0; p < k; p++)
+        {
+            const ElemType* bp = b + p * bk + j * bn;
+            const ElemType b0 = alpha * bp[0];
+            const ElemType b1 = alpha * bp[bn];
+            const ElemType b2 = alpha * bp[2 * bn];
+            const ElemType b3 = alpha * bp[3 * bn];
+            const ElemType* ap = a + (size_t) p * lda;
+            for (int i = i0; i < i1; i++)
+            {
+                const ElemType x = ap[i];
+                c0[i] += x * b0;
+                c1[i] += x * b1;
+                c2[i] += x * b2;
+                c3[i] += x * b3;
+            }
+        }
+    }
+
+    for (; j < n; j++)
+    {
+        ElemType* c0 = c + (size_t) j * ldc;
+        for (int p = 0; p < k; p++)
+        {
+            const ElemType b0 = alpha * b[p * bk + j * bn];
+            const ElemType* ap = a + (size_t) p * lda;
+            for (int i = i0; i < i1; i++)
+                c0[i] += ap[i] * b0;
+        }
+    }
+}
+
+// Rows i0 .. i1 of c += alpha * a' * op(b), as dot products of the columns of a with four columns of op(b) at a time.
+template <class ElemType>
+static void DirectDotProducts(bool transB, int i0, int i1, int n, int k, ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb, ElemType* c, int ldc)
+{
+    const size_t bk = transB ? ldb : 1;
+    const size_t bn = transB ? 1 : ldb;
+
+    for (int i = i0; i < i1; i++)
+    {
+        const ElemType* ai = a + (size_t) i * lda;
+        int j = 0;
+        for (; j + 4 <= n; j += 4)
+        {
+            const ElemType* bj = b + j * bn;
+            ElemType s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            for (int p = 0; p < k; p++)
+            {
+                const ElemType x = ai[p];
+                const ElemType* bp = bj + p * bk;
+                s0 += x * bp[0];
+                s1 += x * bp[bn];
+                s2 += x * bp[2 * bn];
+                s3 += x * bp[3 * bn];
+            }
+            c[i + (size_t) j * ldc] += alpha * s0;
+            c[i + (size_t) (j + 1) * ldc] += alpha * s1;
+            c[i + (size_t) (j + 2) * ldc] += alpha * s2;
+            c[i + (size_t) (j + 3) * ldc] += alpha * s3;
+        }
+
+        for (; j < n; j++)
+        {
+            const ElemType* bj = b + j * bn;
+            ElemType s = 0;
+            for (int p = 0; p < k; p++)
+                s += ai[p] * bj[p * bk];
+            c[i + (size_t) j * ldc] += alpha * s;
+        }
+    }
+}
+
+template <class ElemType>
+static void GemmDirect(bool transA, bool transB, int m, int n, int k,
+                       ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb,
+                       ElemType beta, ElemType* c, int ldc, bool parallel)
+{
+    parallel = parallel && (double) m * n * k >= ParallelWork;
+    // with several threads, give each of them rows to work on, but not so few that the loop overhead dominates
+    int rowBlock = DirectRowBlock;
+    if (parallel)
+        rowBlock = std::min(DirectRowBlock, std::max(16, RoundUp((m + omp_get_max_threads() - 1) / omp_get_max_threads(), 16)));
+
+    auto rows = [&](int i0, int i1)
+    {
+        ScaleBlock(beta, c, ldc, i0, i1 - i0, 0, n);
+        if (transA)
+            DirectDotProducts(transB, i0, i1, n, k, alpha, a, lda, b, ldb, c, ldc);
+        else
+            DirectColumnUpdates(transB, i0, i1, n, k, alpha, a, lda, b, ldb, c, ldc);
+    };
+
+    const long numRowBlocks = (m + rowBlock - 1) / rowBlock;
+    if (!parallel || numRowBlocks == 1)
+    {
+        // not even entering a parallel region, its cost is comparable to that of a small product
+        for (int i0 = 0; i0 < m; i0 += rowBlock)
+            rows(i0, std::min(m, i0 + rowBlock));
+        return;
+    }
+
+#pragma omp parallel for
+    for (long ib = 0; ib < numRowBlocks; ib++)
+    {
+        const int i0 = (int) ib * rowBlock;
+        rows(i0, std::min(m, i0 + rowBlock));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// packed path
+// ---------------------------------------------------------------------------
+
+// Packs rows i0 .. i0 + mc, columns p0 .. p0 + kc of op(a) into panels of MR rows, stored column by column and padded with zeros.
+template <class ElemType>
+static void PackA(bool transA, const ElemType* a, int lda, int i0, int mc, int p0, int kc, ElemType* dst)
+{
+    const int MR = GemmBlocking<ElemType>::MR;
+    for (int ir = 0; ir < mc; ir += MR)
+    {
+        const int mr = std::min(MR, mc - ir);
+        for (int p = p0; p < p0 + kc; p++)
+        {
+            if (transA)
+            {
+                const ElemType* ap = a + p + (size_t) (i0 + ir) * lda;
+                for (int ii = 0; ii < mr; ii++)
+                    dst[ii] = ap[(size_t) ii * lda];
+            }
+            else
+            {
+                const ElemType* ap = a + (i0 + ir) + (size_t) p * lda;
+                for (int ii = 0; ii < mr; ii++)
+                    dst[ii] = ap[ii];
+            }
+            for (int ii = mr; ii < MR; ii++)
+                dst[ii] = 0;
+            dst += MR;
+        }
+    }
+}
+
+// Packs rows p0 .. p0 + kc, columns j0 .. j0 + nr of op(b) into a panel of NR columns, stored row by row and padded with zeros.
+template <class ElemType>
+static void PackB(bool transB, const ElemType* b, int ldb, int p0, int kc, int j0, int nr, ElemType* dst)
+{
+    const int NR = GemmBlocking<ElemType>::NR;
+    for (int p = p0; p < p0 + kc; p++)
+    {
+        for (int jj = 0; jj < nr; jj++)
+            dst[jj] = transB ? b[(j0 + jj) + (size_t) p * ldb] : b[p + (size_t) (j0 + jj) * ldb];
+        for (int jj = nr; jj < NR; jj++)
+            dst[jj] = 0;
+        dst += NR;
+    }
+}
+
+// c[0 : mr, 0 : nr] += alpha * ap * bp for an MR x kc panel of a and a kc x NR panel of b.
+// The accumulators have constant size, so that the compiler keeps them in SIMD registers.
+template <class ElemType>
+static void MicroKernel(int kc, const ElemType* ap, const ElemType* bp, ElemType alpha, ElemType* c, int ldc, int mr, int nr)
+{
+    const int MR = GemmBlocking<ElemType>::MR;
+    const int NR = GemmBlocking<ElemType>::NR;
+    ElemType acc[NR][MR];
+    for (int j = 0; j < NR; j++)
+        for (int i = 0; i < MR; i++)
+            acc[j][i] = 0;
+
+    for (int p = 0; p < kc; p++, ap += MR, bp += NR)
+    {
+        for (int j = 0; j < NR; j++)
+        {
+            const ElemType bv = bp[j];
+            for (int i = 0; i < MR; i++)
+                acc[j][i] += ap[i] * bv;
+        }
+    }
+
+    for (int j = 0; j < nr; j++)
+    {
+        ElemType* cj = c + (size_t) j * ldc;
+        for (int i = 0; i < mr; i++)
+            cj[i] += alpha * acc[j][i];
+    }
+}
+
+template <class ElemType>
+static void GemmPacked(bool transA, bool transB, int m, int n, int k,
+                       ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb,
+                       ElemType beta, ElemType* c, int ldc, bool parallel)
+{
+    typedef GemmBlocking<ElemType> Blocking;
+    // local copies, std::min takes its arguments by reference and the static members are not defined out of class
+    const int MR = Blocking::MR;
+    const int NR = Blocking::NR;
+    const int KC = Blocking::KC;
+    const int MC = Blocking::MC;
+    const int NC = Blocking::NC;
+
+    parallel = parallel && (double) m * n * k >= ParallelWork;
+    // the threads split the rows of c, so use smaller blocks of rows if there are not enough of them
+    int rowBlock = MC;
+    if (parallel)
+        rowBlock = std::min(MC, std::max(MR, RoundUp((m + omp_get_max_threads() - 1) / omp_get_max_threads(), MR)));
+    const long numRowBlocks = (m + rowBlock - 1) / rowBlock;
+
+    // the packing buffers are only as large as the blocks of this product
+    const int maxKC = std::min(KC, k);
+    std::vector<ElemType> bPack((size_t) maxKC * RoundUp(std::min(NC, n), NR));
+#pragma omp parallel if (parallel && numRowBlocks > 1)
+    {
+        std::vector<ElemType> aPack((size_t) maxKC * RoundUp(std::min(rowBlock, m), MR));
+        for (int jc = 0; jc < n; jc += NC)
+        {
+            const int nc = std::min(NC, n - jc);
+            const long numPanels = (nc + NR - 1) / NR;
+            for (int pc = 0; pc < k; pc += KC)
+            {
+                const int kc = std::min(KC, k - pc);
+#pragma omp for
+                for (long jp = 0; jp < numPanels; jp++)
+                    PackB(transB, b, ldb, pc, kc, jc + (int) jp * NR, std::min(NR, nc - (int) jp * NR), &bPack[jp * NR * kc]);
+
+#pragma omp for schedule(dynamic)
+                for (long ib = 0; ib < numRowBlocks; ib++)
+                {
+                    const int i0 = (int) ib * rowBlock;
+                    const int mc = std::min(rowBlock, m - i0);
+                    if (pc == 0)
+                        ScaleBlock(beta, c, ldc, i0, mc, jc, nc);
+                    PackA(transA, a, lda, i0, mc, pc, kc, aPack.data());
+                    for (int jr = 0; jr < nc; jr += NR)
+                    {
+                        for (int ir = 0; ir < mc; ir += MR)
+                        {
+                            MicroKernel(kc, &aPack[(size_t) ir * kc], &bPack[(size_t) jr * kc], alpha,
+                                        c + (i0 + ir) + (size_t) (jc + jr) * ldc, ldc, std::min(MR, mc - ir), std::min(NR, nc - jr));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// CPUGemm
+// ---------------------------------------------------------------------------
+
+template <class ElemType>
+void CPUGemm<ElemType>::GemmImpl(bool transA, bool transB, int m, int n, int k,
+                                 ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb,
+                                 ElemType beta, ElemType* c, int ldc, bool parallel)
+{
+    if (m <= 0 || n <= 0)
+        return;
+
+    if (m <= DirectMaxDim || n <= DirectMaxDim || k <= DirectMaxDim || (double) m * n * k <= DirectMaxWork)
+        GemmDirect(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, parallel);
+    else
+        GemmPacked(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, parallel);
+}
+
+template <class ElemType>
+void CPUGemm<ElemType>::Gemm(bool transA, bool transB, int m, int n, int k,
+                             ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb,
+                             ElemType beta, ElemType* c, int ldc)
+{
+    GemmImpl(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, /*parallel=*/true);
+}
+
+template <class ElemType>
+void CPUGemm<ElemType>::GemmBatch(bool transA, bool transB, int m, int n, int k,
+                                  ElemType alpha, const ElemType* const* a, int lda, const ElemType* const* b, int ldb,
+                                  ElemType beta, ElemType* const* c, int ldc, int batchSize)
+{
+    if (batchSize == 1)
+    {
+        GemmImpl(transA, transB, m, n, k, alpha, a[0], lda, b[0], ldb, beta, c[0], ldc, /*parallel=*/true);
+        return;
+    }
+
+#pragma omp parallel for if ((double) m * n * k * batchSize >= ParallelWork)
+    for (long i = 0; i < batchSize; i++)
+        GemmImpl(transA, transB, m, n, k, alpha, a[i], lda, b[i], ldb, beta, c[i], ldc, /*parallel=*/false);
+}
+
+template <class ElemType>
+bool CPUGemm<ElemType>::PreferNative(int m, int n, int k)
+{
+    const double work = (double) m * n * k;
+    for (const auto& crossover : s_gemmCrossover)
+    {
+        if (n <= crossover.maxN)
+            return work <= crossover.maxWork;
+    }
+    return false;
+}
+
+template <class ElemType>
+bool CPUGemm<ElemType>::UseNative(int m, int n, int k)
+{
+    switch (s_gemmPolicy.load())
+    {
+    case CPUGemmPolicy::Blas:
+        return false;
+    case CPUGemmPolicy::Native:
+        return true;
+    default:
+        return PreferNative(m, n, k);
+    }
+}
+
+template <class ElemType>
+bool CPUGemm<ElemType>::UseNativeBatch(int m, int n, int k)
+{
+    switch (s_gemmPolicy.load())
+    {
+    case CPUGemmPolicy::Blas:
+        return false;
+    case CPUGemmPolicy::Native:
+        return true;
+    default:
+        return PreferNative(m, n, k) || (double) m * n * k <= BatchItemMaxWork;
+    }
+}
+
+template class CPUGemm<float>;
+template class CPUGemm<double>;
+
+}}}
@@ -0,0 +1,72 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUGemm.h : built-in matrix product used next to the external BLAS library
+//
+
+#pragma once
+
+#include "CommonMatrix.h"
+#include <string>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Which implementation CPUMatrix::MultiplyAndWeightedAdd uses for dense products.
+enum class CPUGemmPolicy
+{
+    Auto,   // the native kernels for the shapes where they beat the BLAS library according to the crossover table, BLAS otherwise
+    Blas,   // always the BLAS library (the default)
+    Native  // always the native kernels
+};
+
+// The default is Blas, since the crossover table of Auto was only measured against OpenBLAS, not against the MKL or
+// ACML builds. Like mathFunctions, the setting is process-wide.
+MATH_API void SetCPUGemmPolicy(CPUGemmPolicy policy);
+MATH_API CPUGemmPolicy GetCPUGemmPolicy();
+
+// parse the value of the cpuGemm config parameter: "blas", "auto" or "native"
+MATH_API CPUGemmPolicy ParseCPUGemmPolicy(const std::wstring& name);
+
+// Native GEMM on column-major matrices: c = alpha * op(a) * op(b) + beta * c, where op(a) is m x k and op(b) is k x n.
+// The external BLAS library has a considerable fixed cost per call (argument checking, packing, thread startup) that
+// dominates for the small and skinny products of recurrent steps, e.g. 512 x 512 times 512 x 4, and reference BLAS builds
+// are slow for all shapes. There are two paths:
+//  - a direct path for shapes with a small dimension, which works on the operands in place without packing:
+//    column updates for op(a) = a and dot products for op(a) = a', four columns of c at a time,
+//  - a cache-blocked path for the rest, which packs panels of op(a) and op(b) into contiguous buffers and computes
+//    c in MR x NR tiles with a register-blocked micro-kernel the compiler vectorizes.
+// Both paths split the rows of c between OpenMP threads. As with BLAS, c is not read if beta is 0.
+template <class ElemType>
+class MATH_API CPUGemm
+{
+public:
+    static void Gemm(bool transA, bool transB, int m, int n, int k,
+                     ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb,
+                     ElemType beta, ElemType* c, int ldc);
+
+    // Same product for batchSize independent sets of operands of the same shape. The items are distributed
+    // between the threads, each computed single-threaded.
+    static void GemmBatch(bool transA, bool transB, int m, int n, int k,
+                          ElemType alpha, const ElemType* const* a, int lda, const ElemType* const* b, int ldb,
+                          ElemType beta, ElemType* const* c, int ldc, int batchSize);
+
+    // Whether the native kernels are expected to be faster than the BLAS library for the shape, according to
+    // the crossover table measured with GemmCrossoverTest in MathPerformanceTests.
+    static bool PreferNative(int m, int n, int k);
+
+    // Whether MultiplyAndWeightedAdd should use Gemm() for the shape under the current policy.
+    static bool UseNative(int m, int n, int k);
+
+    // Whether BatchMultiplyAndWeightedAdd should use GemmBatch() for products of the shape under the current policy.
+    // Besides the shapes for which Gemm() is preferred, this holds for all products small enough that splitting
+    // the batch between the threads is better than splitting each product.
+    static bool UseNativeBatch(int m, int n, int k);
+
+private:
+    static void GemmImpl(bool transA, bool transB, int m, int n, int k,
+                         ElemType alpha, const ElemType* a, int lda, const ElemType* b, int ldb,
+                         ElemType beta, ElemType* c, int ldc, bool parallel);
+};
+
+}}}
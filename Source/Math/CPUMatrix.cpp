@@ -10,6 +10,8 @@
 #include "File.h"
 
 #include "CPUMatrix.h"
+#include "CPUGemm.h"
+#include "CPUFastMath.h"
 #include "TensorOps.h"
 #include <assert.h>
 #include <stdexcept>
@@ -1113,6 +1115,8 @@ void CPUMatrix<ElemType>::AddGaussianRandomValue(const ElemType mean, const Elem
 
 //maskRate: percentage of values masked out (similar to dropout rate)
 //scaleValue: which scale value to set to the left ones (unmasked items).
+// The mask is drawn from the counter-based generator Philox4x32(), element i from word i % 4 of counter i / 4,
+// so it can be generated in parallel and does not depend on the number of threads.
 template <class ElemType>
 void CPUMatrix<ElemType>::SetUniformRandomMask(const ElemType maskRate, const ElemType scaleValue, RNGHandle& rngHandle)
 {
@@ -1122,32 +1126,108 @@ void CPUMatrix<ElemType>::SetUniformRandomMask(const ElemType maskRate, const El
     CPURNGHandle* cpuRNGHandle = dynamic_cast<CPURNGHandle*>(&rngHandle);
     assert(cpuRNGHandle != nullptr);
 
-    auto& us = *this;
-    std::uniform_real_distribution<ElemType> r(0, 1);
+    ElemType* bufPtr = Data();
+    long m = (long) GetNumElements();
+    long numBlocks = (m + 3) / 4;
+    const uint64_t firstCounter = cpuRNGHandle->ReserveCounters(numBlocks);
+    const uint64_t key = cpuRNGHandle->Key();
+    const uint64_t threshold = Philox4x32Threshold(maskRate);
 
-    long m = (long) GetNumRows(), n = (long) GetNumCols();
-    ElemType v;
+#pragma omp parallel for
+    for (long b = 0; b < numBlocks; b++)
+    {
+        uint32_t r[4];
+        Philox4x32(firstCounter + b, key, r);
+        long first = b * 4;
+        long count = min(m - first, 4L);
+        for (long k = 0; k < count; k++)
+        {
+            bufPtr[first + k] = r[k] < threshold ? 0 : scaleValue;
+        }
+    }
+}
+
+// Dropout with a bit-packed mask: this = a, with each element dropped with probability maskRate and the others scaled by scaleValue.
+// The decisions are kept in bitMask, bit i % 8 of byte i / 8 of a column set for a kept element i, for AddDropoutGradientOf().
+// Each byte of the mask is drawn from two counters of Philox4x32(), so the columns are generated in parallel
+// and the result does not depend on the number of threads.
+template <class ElemType>
+CPUMatrix<ElemType>& CPUMatrix<ElemType>::AssignDropoutOf(const CPUMatrix<ElemType>& a, const ElemType maskRate, const ElemType scaleValue, RNGHandle& rngHandle, CPUMatrix<char>& bitMask)
+{
+    if (a.IsEmpty())
+        LogicError("AssignDropoutOf: Matrix a is empty.");
+
+    CPURNGHandle* cpuRNGHandle = dynamic_cast<CPURNGHandle*>(&rngHandle);
+    assert(cpuRNGHandle != nullptr);
+
+    const long m = (long) a.GetNumRows(), n = (long) a.GetNumCols();
+    const long bytesPerColumn = (m + 7) / 8;
+    if (this != &a)
+        RequireSize(m, n);
+    if (bitMask.GetNumRows() != bytesPerColumn || bitMask.GetNumCols() != n)
+        bitMask.RequireSize(bytesPerColumn, n);
+
+    const uint64_t firstCounter = cpuRNGHandle->ReserveCounters(2 * (uint64_t) bytesPerColumn * n);
+    const uint64_t key = cpuRNGHandle->Key();
+    const uint64_t threshold = Philox4x32Threshold(maskRate);
+    const ElemType* aPtr = a.Data();
+    ElemType* usPtr = Data();
+    char* maskPtr = bitMask.Data();
+
+#pragma omp parallel for
     for (long j = 0; j < n; j++)
     {
-        // four-way unrolling
-        for (long i = 0; i < (m & ~3); i += 4)
+        for (long byte = 0; byte < bytesPerColumn; byte++)
         {
-            v = r(cpuRNGHandle->Generator());
-            us(i, j) = v <= maskRate ? 0 : scaleValue;
-            v = r(cpuRNGHandle->Generator());
-            us(i + 1, j) = v <= maskRate ? 0 : scaleValue;
-            v = r(cpuRNGHandle->Generator());
-            us(i + 2, j) = v <= maskRate ? 0 : scaleValue;
-            v = r(cpuRNGHandle->Generator());
-            us(i + 3, j) = v <= maskRate ? 0 : scaleValue;
+            uint32_t r[8];
+            uint64_t counter = firstCounter + 2 * ((uint64_t) j * bytesPerColumn + byte);
+            Philox4x32(counter, key, r);
+            Philox4x32(counter + 1, key, r + 4);
+
+            long first = j * m + byte * 8;
+            long count = min(m - byte * 8, 8L);
+            unsigned int bits = 0;
+            for (long k = 0; k < count; k++)
+            {
+                unsigned int keep = r[k] >= threshold;
+                bits |= keep << k;
+                usPtr[first + k] = keep ? aPtr[first + k] * scaleValue : 0;
+            }
+            maskPtr[j * bytesPerColumn + byte] = (char) bits;
         }
-        // handle remaining stuffs
-        for (long i = m & ~3; i < m; i++)
+    }
+    return *this;
+}
+
+// this += gradient, masked and scaled as by the AssignDropoutOf() call that has produced bitMask.
+template <class ElemType>
+CPUMatrix<ElemType>& CPUMatrix<ElemType>::AddDropoutGradientOf(const CPUMatrix<ElemType>& gradient, const ElemType scaleValue, const CPUMatrix<char>& bitMask)
+{
+    if (gradient.IsEmpty())
+        LogicError("AddDropoutGradientOf: Matrix is empty.");
+
+    const long m = (long) GetNumRows(), n = (long) GetNumCols();
+    const long bytesPerColumn = (m + 7) / 8;
+    if (gradient.GetNumRows() != m || gradient.GetNumCols() != n)
+        InvalidArgument("AddDropoutGradientOf: The input matrix dimensions do not match.");
+    if (bitMask.GetNumRows() != bytesPerColumn || bitMask.GetNumCols() != n)
+        InvalidArgument("AddDropoutGradientOf: The mask does not match the matrix dimensions.");
+
+    const ElemType* gradientPtr = gradient.Data();
+    ElemType* usPtr = Data();
+    const unsigned char* maskPtr = (const unsigned char*) bitMask.Data();
+
+#pragma omp parallel for
+    for (long j = 0; j < n; j++)
+    {
+        const unsigned char* columnMask = maskPtr + j * bytesPerColumn;
+        for (long i = 0; i < m; i++)
         {
-            v = r(cpuRNGHandle->Generator());
-            us(i, j) = v <= maskRate ? 0 : scaleValue;
+            if ((columnMask[i >> 3] >> (i & 7)) & 1)
+                usPtr[j * m + i] += gradientPtr[j * m + i] * scaleValue;
         }
     }
+    return *this;
 }
 
 template <class ElemType>
@@ -2302,6 +2382,79 @@ CPUMatrix<ElemType>& CPUMatrix<ElemType>::AssignLogSoftmaxOf(const CPUMatrix<Ele
     return *this;
 }
 
+// [this] = column-wise softmax of a, logSumExp(0, j) = log(sum(exp(a(:, j))))
+// The first pass computes the maximum and the sum of exponentials relative to it at the same time, rescaling the sum when
+// the maximum grows; the second pass writes the result.
+template <class ElemType>
+CPUMatrix<ElemType>& CPUMatrix<ElemType>::AssignColumnSoftmaxOf(const CPUMatrix<ElemType>& a, CPUMatrix<ElemType>& logSumExp)
+{
+    if (a.IsEmpty())
+        LogicError("AssignColumnSoftmaxOf: Matrix a is empty.");
+
+    auto& us = *this;
+    if (this != &a)
+        RequireSize(a.GetNumRows(), a.GetNumCols());
+    logSumExp.RequireSize(1, a.GetNumCols());
+
+#pragma omp parallel for
+    foreach_column (j, a)
+    {
+        ElemType maxV = a(0, j);
+        double sum = 0;
+        foreach_row (i, a)
+        {
+            ElemType v = a(i, j);
+            if (v > maxV)
+            {
+                sum = sum * exp(maxV - v) + 1;
+                maxV = v;
+            }
+            else
+                sum += exp(v - maxV);
+        }
+        ElemType logSum = maxV + (ElemType) log(sum);
+        foreach_row (i, us)
+            us(i, j) = exp(a(i, j) - logSum);
+        logSumExp(0, j) = logSum;
+    }
+
+    return *this;
+}
+
+// softmax = column-wise softmax of input, returns -sum(labels .* log(softmax)) for CrossEntropyWithSoftmaxNode
+// Instead of writing out log(softmax), each label is multiplied with log(softmax(i, j)) = input(i, j) - logSumExp(0, j).
+// Zero labels are skipped, so that columns without labels, such as gaps in the minibatch, do not contribute even if
+// their inputs are not finite.
+template <class ElemType>
+ElemType CPUMatrix<ElemType>::SoftmaxAndCrossEntropy(const CPUMatrix<ElemType>& labels, const CPUMatrix<ElemType>& input, CPUMatrix<ElemType>& softmax)
+{
+    if (labels.GetNumRows() != input.GetNumRows() || labels.GetNumCols() != input.GetNumCols())
+        InvalidArgument("SoftmaxAndCrossEntropy: The dimensions of labels and input must match.");
+
+    CPUMatrix<ElemType> logSumExp;
+    softmax.AssignColumnSoftmaxOf(input, logSumExp);
+
+    // sum up per column first, so that the result does not depend on the number of threads
+    vector<double> criteria(input.GetNumCols());
+#pragma omp parallel for
+    foreach_column (j, input)
+    {
+        double criterion = 0;
+        foreach_row (i, input)
+        {
+            ElemType label = labels(i, j);
+            if (label != 0)
+                criterion -= label * (input(i, j) - logSumExp(0, j));
+        }
+        criteria[j] = criterion;
+    }
+
+    double criterion = 0;
+    for (double columnCriterion : criteria)
+        criterion += columnCriterion;
+    return (ElemType) criterion;
+}
+
 //[this]=hardmax([this])
 //the max element is 1 else is 0
 template <class ElemType>
@@ -4500,6 +4653,13 @@ void CPUMatrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix
 
     ldc = (int) c.GetNumRows();
 
+    // small and skinny products, for which the overhead of the BLAS call dominates
+    if (CPUGemm<ElemType>::UseNative(m, n, k))
+    {
+        CPUGemm<ElemType>::Gemm(transposeA, transposeB, m, n, k, alpha, a.Data(), lda, b.Data(), ldb, beta, c.Data(), ldc);
+        return;
+    }
+
     if (sizeof(ElemType) == sizeof(double))
     {
 #ifdef USE_ACML
@@ -4519,6 +4679,72 @@ void CPUMatrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix
     }
 }
 
+/// <summary>Batched matrix-matrix multiply with col-major matrices: c_i = alpha * op(a_i) * op(b_i) + beta * c_i for each of the offsetsC.size() products</summary>
+/// <param name="alpha">Scalar</param>
+/// <param name="a">Input matrix holding the a_i, a_i starts at element offsetsA[i] and is m x k (k x m if transposed)</param>
+/// <param name="transposeA">Whether the a_i are transposed</param>
+/// <param name="b">Input matrix holding the b_i, b_i starts at element offsetsB[i] and is k x n (n x k if transposed)</param>
+/// <param name="transposeB">Whether the b_i are transposed</param>
+/// <param name="beta">Scalar</param>
+/// <param name="c">Resulting matrix holding the m x n matrices c_i, c_i starts at element offsetsC[i]; user is responsible for allocating this</param>
+template <class ElemType>
+void CPUMatrix<ElemType>::BatchMultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix<ElemType>& a, const bool transposeA, const std::vector<size_t>& offsetsA,
+                                                      const CPUMatrix<ElemType>& b, const bool transposeB, const std::vector<size_t>& offsetsB,
+                                                      ElemType beta, CPUMatrix<ElemType>& c, const std::vector<size_t>& offsetsC, size_t m, size_t n, size_t k)
+{
+    const size_t batchSize = offsetsC.size();
+    if (batchSize == 0 || m == 0 || n == 0)
+        return;
+
+    const int lda = (int) (transposeA ? k : m);
+    const int ldb = (int) (transposeB ? n : k);
+    const int ldc = (int) m;
+    std::vector<const ElemType*> aPtrs(batchSize), bPtrs(batchSize);
+    std::vector<ElemType*> cPtrs(batchSize);
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        aPtrs[i] = a.Data() + offsetsA[i];
+        bPtrs[i] = b.Data() + offsetsB[i];
+        cPtrs[i] = c.Data() + offsetsC[i];
+    }
+
+    // small products are better split between the threads than each product
+    if (CPUGemm<ElemType>::UseNativeBatch((int) m, (int) n, (int) k))
+    {
+        CPUGemm<ElemType>::GemmBatch(transposeA, transposeB, (int) m, (int) n, (int) k, alpha, aPtrs.data(), lda, bPtrs.data(), ldb, beta, cPtrs.data(), ldc, (int) batchSize);
+        return;
+    }
+
+#if defined(USE_MKL) && defined(INTEL_MKL_VERSION) && INTEL_MKL_VERSION >= 110300 // ?gemm_batch() appeared in MKL 11.3
+    const CBLAS_TRANSPOSE mklTransA = transposeA ? CblasTrans : CblasNoTrans;
+    const CBLAS_TRANSPOSE mklTransB = transposeB ? CblasTrans : CblasNoTrans;
+    const MKL_INT mklM = (MKL_INT) m, mklN = (MKL_INT) n, mklK = (MKL_INT) k;
+    const MKL_INT mklLda = lda, mklLdb = ldb, mklLdc = ldc;
+    const MKL_INT groupSize = (MKL_INT) batchSize;
+    if (sizeof(ElemType) == sizeof(double))
+    {
+        const double alphaD = alpha, betaD = beta;
+        cblas_dgemm_batch(CblasColMajor, &mklTransA, &mklTransB, &mklM, &mklN, &mklK, &alphaD, reinterpret_cast<const double**>(aPtrs.data()), &mklLda,
+                          reinterpret_cast<const double**>(bPtrs.data()), &mklLdb, &betaD, reinterpret_cast<double**>(cPtrs.data()), &mklLdc, 1, &groupSize);
+    }
+    else
+    {
+        const float alphaF = (float) alpha, betaF = (float) beta;
+        cblas_sgemm_batch(CblasColMajor, &mklTransA, &mklTransB, &mklM, &mklN, &mklK, &alphaF, reinterpret_cast<const float**>(aPtrs.data()), &mklLda,
+                          reinterpret_cast<const float**>(bPtrs.data()), &mklLdb, &betaF, reinterpret_cast<float**>(cPtrs.data()), &mklLdc, 1, &groupSize);
+    }
+#else
+    // large products: one after the other, each using the threads of the BLAS library
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        CPUMatrix<ElemType> ai(transposeA ? k : m, transposeA ? m : k, const_cast<ElemType*>(aPtrs[i]), matrixFlagDontOwnBuffer);
+        CPUMatrix<ElemType> bi(transposeB ? n : k, transposeB ? k : n, const_cast<ElemType*>(bPtrs[i]), matrixFlagDontOwnBuffer);
+        CPUMatrix<ElemType> ci(m, n, cPtrs[i], matrixFlagDontOwnBuffer);
+        MultiplyAndWeightedAdd(alpha, ai, transposeA, bi, transposeB, beta, ci);
+    }
+#endif
+}
+
 template <class ElemType>
 void CPUMatrix<ElemType>::Multiply1x1AndWeightedAdd(ElemType alpha, const CPUMatrix<ElemType>& a, const CPUMatrix<ElemType>& b,
                                                     ElemType beta, CPUMatrix<ElemType>& c)
@@ -5995,20 +6221,32 @@ int CPUMatrix<ElemType>::SetNumThreads(int numThreads)
 // function to compute the value for a given output location (perform reduction if needed)
 // -----------------------------------------------------------------------
 
-// perform loop over reduction index m
-// This function is declared inside a wrapper struct to allow partial specialization (m = -1).
+// Reductions over many elements, e.g. the gradient of a bias, which sums over the whole minibatch, are split into chunks that
+// are summed up in parallel. The chunks only depend on the dimensions, and their partial sums are added up in order, so the
+// result does not depend on the number of threads.
+static const size_t TensorOpMinParallelReductionSize = 32768; // elements reduced into one output value
+static const size_t TensorOpReductionChunkSize = 8192;
+static const int TensorOpMaxReductionChunks = 64;
+
 template <class ElemType, typename OPFN, size_t N, int m>
-struct TensorOpReduction
+struct TensorOpReduction;
+
+// sum over the range [begin, end) of reduction index m
+// This function is declared inside a wrapper struct to allow partial specialization (m = 0).
+template <class ElemType, typename OPFN, size_t N, int m>
+struct TensorOpReductionRange
 {
-    // reduction case (non-reduction case is specialized)
-    static inline ElemType Loop(array<ElemType*, N> pointers, const OPFN& opfn,
-                                const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    static inline double Sum(array<ElemType*, N> pointers, const OPFN& opfn, size_t begin, size_t end,
+                             const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
     {
         array<ptrdiff_t, N - 1> strides;   // N-1 because last one is the result pointer, which is unused in reduction
         for (size_t i = 0; i < N - 1; i++) // N = a small constant, this will be unrolled
+        {
             strides[i] = reducingStrides[i][(size_t) m];
+            pointers[i] += begin * strides[i];
+        }
         double /*ElemType*/ aggregate = 0;
-        for (size_t dim = reducingOpDims[(size_t) m]; dim-- > 0;)
+        for (size_t dim = end - begin; dim-- > 0;)
         {
             // need to descend into one loop deeper
             aggregate += TensorOpReduction<ElemType, OPFN, N, m - 1>::Loop(pointers, opfn, reducingOpDims, reducingStrides);
@@ -6016,7 +6254,97 @@ struct TensorOpReduction
             for (size_t i = 0; i < N - 1; i++)
                 pointers[i] += strides[i]; // note: last pointer (result) is unused and untouched here
         }
-        return (ElemType) aggregate;
+        return aggregate;
+    }
+};
+
+// innermost reduction index
+// If all inputs are contiguous along it, e.g. when summing a row-major vector, four partial sums are kept, which
+// the compiler can keep in SIMD registers. They are added up at the end.
+template <class ElemType, typename OPFN, size_t N>
+struct TensorOpReductionRange<ElemType, OPFN, N, 0>
+{
+    static inline double Sum(array<ElemType*, N> pointers, const OPFN& opfn, size_t begin, size_t end,
+                             const SmallVector<size_t>&, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        bool contiguous = true;
+        array<ptrdiff_t, N - 1> strides;
+        for (size_t i = 0; i < N - 1; i++)
+        {
+            strides[i] = reducingStrides[i][0];
+            contiguous &= strides[i] == 1;
+            pointers[i] += begin * strides[i];
+        }
+        size_t dims = end - begin;
+        if (!contiguous)
+        {
+            double aggregate = 0;
+            for (size_t dim = dims; dim-- > 0;)
+            {
+                aggregate += opfn(pointers);
+                for (size_t i = 0; i < N - 1; i++)
+                    pointers[i] += strides[i];
+            }
+            return aggregate;
+        }
+
+        double aggregate0 = 0, aggregate1 = 0, aggregate2 = 0, aggregate3 = 0;
+        size_t j = 0;
+        for (; j + 4 <= dims; j += 4)
+        {
+            array<ElemType*, N> p0 = pointers, p1 = pointers, p2 = pointers, p3 = pointers;
+            for (size_t i = 0; i < N - 1; i++)
+            {
+                p0[i] += j;
+                p1[i] += j + 1;
+                p2[i] += j + 2;
+                p3[i] += j + 3;
+            }
+            aggregate0 += opfn(p0);
+            aggregate1 += opfn(p1);
+            aggregate2 += opfn(p2);
+            aggregate3 += opfn(p3);
+        }
+        for (; j < dims; j++)
+        {
+            array<ElemType*, N> p = pointers;
+            for (size_t i = 0; i < N - 1; i++)
+                p[i] += j;
+            aggregate0 += opfn(p);
+        }
+        return (aggregate0 + aggregate1) + (aggregate2 + aggregate3);
+    }
+};
+
+// perform loop over reduction index m
+// This function is declared inside a wrapper struct to allow partial specialization (m = -1).
+template <class ElemType, typename OPFN, size_t N, int m>
+struct TensorOpReduction
+{
+    // reduction case (non-reduction case is specialized)
+    static inline ElemType Loop(array<ElemType*, N> pointers, const OPFN& opfn,
+                                const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        size_t dims = reducingOpDims[(size_t) m];
+        if ((size_t) m + 1 == reducingOpDims.size() && dims > 1) // outermost reduction index: split large reductions into chunks
+        {
+            size_t reductionSize = 1;
+            for (size_t i = 0; i < reducingOpDims.size(); i++)
+                reductionSize *= reducingOpDims[i];
+            if (reductionSize >= TensorOpMinParallelReductionSize)
+            {
+                int numChunks = (int) min(min(dims, reductionSize / TensorOpReductionChunkSize), (size_t) TensorOpMaxReductionChunks);
+                double partials[TensorOpMaxReductionChunks];
+#pragma omp parallel for if (!omp_in_parallel())
+                for (int chunk = 0; chunk < numChunks; chunk++)
+                    partials[chunk] = TensorOpReductionRange<ElemType, OPFN, N, m>::Sum(pointers, opfn, dims * chunk / numChunks, dims * (chunk + 1) / numChunks, reducingOpDims, reducingStrides);
+                double aggregate = 0;
+                for (int chunk = 0; chunk < numChunks; chunk++)
+                    aggregate += partials[chunk];
+                return (ElemType) aggregate;
+            }
+        }
+        return (ElemType) TensorOpReductionRange<ElemType, OPFN, N, m>::Sum(pointers, opfn, 0, dims, reducingOpDims, reducingStrides);
     }
 };
 
@@ -6138,6 +6466,98 @@ struct TensorOpIteration<ElemType, OPFN, N, vectorizable, m, -1>
     }
 };
 
+// reduction along a non-contiguous index into contiguous outputs, e.g. the gradient of a bias [H] from a minibatch [H x T]
+// Reducing each output separately would read the inputs with stride H. Instead, blocks of outputs are accumulated
+// together while the inputs are read row by row. The blocks are computed in parallel.
+static const size_t TensorOpReductionBlockSize = 64;
+
+template <class ElemType, typename OPFN, size_t N>
+static void TensorOpBlockedReduction(ElemType beta, const array<ElemType*, N>& pointers, ElemType alpha, const OPFN& opfn,
+                                     size_t numOutputs, size_t reductionDim, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+{
+    int numBlocks = (int) ((numOutputs + TensorOpReductionBlockSize - 1) / TensorOpReductionBlockSize);
+#pragma omp parallel for if (numOutputs * reductionDim >= TensorOpMinParallelReductionSize)
+    for (int block = 0; block < numBlocks; block++)
+    {
+        size_t begin = block * TensorOpReductionBlockSize;
+        size_t end = min(begin + TensorOpReductionBlockSize, numOutputs);
+        double aggregates[TensorOpReductionBlockSize] = {0};
+        array<ElemType*, N> row = pointers;
+        for (size_t dim = 0; dim < reductionDim; dim++)
+        {
+            array<ElemType*, N> p = row;
+            for (size_t j = begin; j < end; j++)
+            {
+                for (size_t i = 0; i < N - 1; i++)
+                    p[i] = row[i] + j;
+                aggregates[j - begin] += opfn(p);
+            }
+            for (size_t i = 0; i < N - 1; i++)
+                row[i] += reducingStrides[i][0];
+        }
+        ElemType* pout = pointers.back();
+        for (size_t j = begin; j < end; j++)
+        {
+            ElemType val = (ElemType) aggregates[j - begin] * alpha;
+            if (beta != 0)
+                val += beta * pout[j];
+            pout[j] = val;
+        }
+    }
+}
+
+// perform loop over the outermost regular index k of a reduction in parallel
+// Outputs are computed independently of each other, so this does not change the result. Without reduction, only the
+// innermost loop is parallelized (see above).
+template <class ElemType, typename OPFN, size_t N, int m, int k>
+struct TensorOpReductionIteration
+{
+    static inline void Loop(ElemType beta, array<ElemType*, N> pointers, ElemType alpha, const OPFN& opfn,
+                            const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                            const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        size_t work = 1;
+        for (size_t i = 0; i < regularOpDims.size(); i++)
+            work *= regularOpDims[i];
+        for (size_t i = 0; i < reducingOpDims.size(); i++)
+            work *= reducingOpDims[i];
+        if (k == 0 && m == 0 && regularOpDims[0] >= TensorOpReductionBlockSize &&
+            reducingOpDims[0] < TensorOpMinParallelReductionSize) // (longer reductions are split into chunks instead)
+        {
+            bool contiguous = true;
+            for (size_t i = 0; i < N; i++)
+                contiguous &= regularStrides[i][0] == 1;
+            if (contiguous)
+                return TensorOpBlockedReduction(beta, pointers, alpha, opfn, regularOpDims[0], reducingOpDims[0], reducingStrides);
+        }
+
+        int dims = (int) regularOpDims[(size_t) k];
+        if (dims < omp_get_max_threads() || work < TensorOpMinParallelReductionSize)
+            return TensorOpIteration<ElemType, OPFN, N, false /*vectorizable*/, m, k>::Loop(beta, pointers, alpha, opfn, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+
+#pragma omp parallel for
+        for (int dim = 0; dim < dims; dim++)
+        {
+            array<ElemType*, N> p;
+            for (size_t i = 0; i < N; i++)
+                p[i] = pointers[i] + dim * regularStrides[i][(size_t) k];
+            TensorOpIteration<ElemType, OPFN, N, false /*vectorizable*/, m, k - 1>::Loop(beta, p, alpha, opfn, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        }
+    }
+};
+
+// reduction to a scalar: only the reduction itself can be parallelized
+template <class ElemType, typename OPFN, size_t N, int m>
+struct TensorOpReductionIteration<ElemType, OPFN, N, m, -1>
+{
+    static inline void Loop(ElemType beta, array<ElemType*, N> pointers, ElemType alpha, const OPFN& opfn,
+                            const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                            const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        TensorOpIteration<ElemType, OPFN, N, false /*vectorizable*/, m, -1>::Loop(beta, pointers, alpha, opfn, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    }
+};
+
 // -----------------------------------------------------------------------
 // map runtime parameters N to template parameters
 // -----------------------------------------------------------------------
@@ -6152,9 +6572,9 @@ static void TensorOpWithRegularLoop(ElemType beta, const array<ElemType*, N>& po
     switch (dims)
     {
     case 2:
-        return TensorOpIteration<ElemType, OPFN, N, false /*vectorizable*/, 1, k>::Loop(beta, pointers, alpha, opfn, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        return TensorOpReductionIteration<ElemType, OPFN, N, 1, k>::Loop(beta, pointers, alpha, opfn, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     case 1:
-        return TensorOpIteration<ElemType, OPFN, N, false /*vectorizable*/, 0, k>::Loop(beta, pointers, alpha, opfn, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        return TensorOpReductionIteration<ElemType, OPFN, N, 0, k>::Loop(beta, pointers, alpha, opfn, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     case 0:
     {
         // if all leading dimensions are 1, we can let the compiler do some unrolling
@@ -6223,7 +6643,28 @@ void CPUMatrix<ElemType>::TensorOp(ElemType beta, const CPUMatrix<ElemType>& a,
                               },                                                       \
                               offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides)
 
+#define CaseFastUnaryTensorOp(oper)                                                    \
+    case ElementWiseOperator::op##oper:                                                \
+        return TensorOpWithFn(beta, pointers, alpha, [](const array<ElemType*, 2>& pp) \
+                              {                                                        \
+                                  return OpFast##oper((*(pp[0])));                     \
+                              },                                                       \
+                              offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides)
+
     array<ElemType*, 2> pointers = {a.Data(), Data()};
+    if (GetCPUMathFunctions() == CPUMathFunctions::Fast)
+    {
+        // a contiguous element-wise op, e.g. a Sigmoid node over the whole minibatch, can use the SSE versions
+        if (reducingOpDims.size() == 0 && regularOpDims.size() == 1 && regularStrides[0][0] == 1 && regularStrides[1][0] == 1 &&
+            CPUFastMath<ElemType>::UnaryOp(op, beta, pointers[0] + offsets[0], alpha, pointers[1] + offsets[1], regularOpDims[0]))
+            return;
+        switch (op)
+        {
+            ForAllFastUnaryOps(CaseFastUnaryTensorOp);
+        default:
+            break; // no fast version, use the exact one
+        }
+    }
     switch (op)
     {
         ForAllUnaryOps(CaseUnaryTensorOp);
@@ -6251,7 +6692,24 @@ void CPUMatrix<ElemType>::TensorOp(ElemType beta, const CPUMatrix<ElemType>& a,
                               },                                                       \
                               offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides)
 
+#define CaseFastBinaryTensorOp(oper)                                                   \
+    case ElementWiseOperator::op##oper:                                                \
+        return TensorOpWithFn(beta, pointers, alpha, [](const array<ElemType*, 3>& pp) \
+                              {                                                        \
+                                  return OpFast##oper((*(pp[0])), (*(pp[1])));         \
+                              },                                                       \
+                              offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides)
+
     array<ElemType*, 3> pointers = {a.Data(), b.Data(), Data()};
+    if (GetCPUMathFunctions() == CPUMathFunctions::Fast)
+    {
+        switch (op)
+        {
+            ForAllFastBinaryOps(CaseFastBinaryTensorOp);
+        default:
+            break; // no fast version, use the exact one
+        }
+    }
     switch (op)
     {
         ForAllBinaryOps(CaseBinaryTensorOp);
@@ -6279,7 +6737,24 @@ void CPUMatrix<ElemType>::TensorOp(ElemType beta, const CPUMatrix<ElemType>& a,
                               },                                                       \
                               offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides)
 
+#define CaseFastTernaryTensorOp(oper)                                                      \
+    case ElementWiseOperator::op##oper:                                                    \
+        return TensorOpWithFn(beta, pointers, alpha, [](const array<ElemType*, 4>& pp)     \
+                              {                                                            \
+                                  return OpFast##oper((*(pp[0])), (*(pp[1])), (*(pp[2]))); \
+                              },                                                           \
+                              offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides)
+
     array<ElemType*, 4> pointers = {a.Data(), b.Data(), c.Data(), Data()};
+    if (GetCPUMathFunctions() == CPUMathFunctions::Fast)
+    {
+        switch (op)
+        {
+            ForAllFastTernaryOps(CaseFastTernaryTensorOp);
+        default:
+            break; // no fast version, use the exact one
+        }
+    }
     switch (op)
     {
         ForAllTernaryOps(CaseTernaryTensorOp);
@@ -150,6 +150,10 @@ public:
     void SetUniformRandomMask(const ElemType maskRate, const ElemType scaleValue, RNGHandle& rngHandle);
     void AddGaussianRandomValue(const ElemType mean, const ElemType sigma, unsigned long seed = USE_TIME_BASED_SEED);
 
+    // dropout with a bit-packed mask, one bit per element and (rows + 7) / 8 bytes per column
+    CPUMatrix<ElemType>& AssignDropoutOf(const CPUMatrix<ElemType>& a, const ElemType maskRate, const ElemType scaleValue, RNGHandle& rngHandle, CPUMatrix<char>& bitMask);
+    CPUMatrix<ElemType>& AddDropoutGradientOf(const CPUMatrix<ElemType>& gradient, const ElemType scaleValue, const CPUMatrix<char>& bitMask);
+
     CPUMatrix<ElemType> Transpose();
     CPUMatrix<ElemType>& AssignTransposeOf(const CPUMatrix<ElemType>& a);
 
@@ -217,6 +221,8 @@ public:
 
     CPUMatrix<ElemType>& InplaceLogSoftmax(const bool isColWise);
     CPUMatrix<ElemType>& AssignLogSoftmaxOf(const CPUMatrix<ElemType>& a, const bool isColWise);
+    // column-wise softmax in two passes over a; logSumExp receives log(sum(exp(a(:,j)))) for each column j
+    CPUMatrix<ElemType>& AssignColumnSoftmaxOf(const CPUMatrix<ElemType>& a, CPUMatrix<ElemType>& logSumExp);
 
     CPUMatrix<ElemType>& InplaceHardmax(const bool isColWise);
     CPUMatrix<ElemType>& AssignHardmaxOf(const CPUMatrix<ElemType>& a, const bool isColWise);
@@ -384,6 +390,9 @@ public:
     static void SVD(const CPUMatrix<ElemType>& A, CPUMatrix<ElemType>& SIGMA, CPUMatrix<ElemType>& U, CPUMatrix<ElemType>& VT, CPUMatrix<ElemType>& W);
 
     static void MultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix<ElemType>& a, const bool transposeA, const CPUMatrix<ElemType>& b, const bool transposeB, ElemType beta, CPUMatrix<ElemType>& c);
+    static void BatchMultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix<ElemType>& a, const bool transposeA, const std::vector<size_t>& offsetsA,
+                                            const CPUMatrix<ElemType>& b, const bool transposeB, const std::vector<size_t>& offsetsB,
+                                            ElemType beta, CPUMatrix<ElemType>& c, const std::vector<size_t>& offsetsC, size_t m, size_t n, size_t k);
     static void MultiplyAndAdd(const CPUMatrix<ElemType>& a, const bool transposeA, const CPUMatrix<ElemType>& b, const bool transposeB, CPUMatrix<ElemType>& c);
     static void Multiply(const CPUMatrix<ElemType>& a, const bool transposeA, const CPUMatrix<ElemType>& b, const bool transposeB, CPUMatrix<ElemType>& c);
     static void Multiply(const CPUMatrix<ElemType>& a, const CPUMatrix<ElemType>& b, CPUMatrix<ElemType>& c);
@@ -393,6 +402,9 @@ public:
     static void AddScaledDifference(const ElemType alpha, const CPUMatrix<ElemType>& a, const CPUMatrix<ElemType>& b, CPUMatrix<ElemType>& c);
     static void AssignScaledDifference(const ElemType alpha, const CPUMatrix<ElemType>& a, const CPUMatrix<ElemType>& b, CPUMatrix<ElemType>& c);
     static void AddScaledDifference(const CPUMatrix<ElemType>& alpha, const CPUMatrix<ElemType>& a, const CPUMatrix<ElemType>& b, CPUMatrix<ElemType>& c);    // alpha must be 1X1
+
+    // softmax = column-wise softmax of input; returns -sum(labels .* log(softmax))
+    static ElemType SoftmaxAndCrossEntropy(const CPUMatrix<ElemType>& labels, const CPUMatrix<ElemType>& input, CPUMatrix<ElemType>& softmax);
     static void AssignScaledDifference(const CPUMatrix<ElemType>& alpha, const CPUMatrix<ElemType>& a, const CPUMatrix<ElemType>& b, CPUMatrix<ElemType>& c); // alpha must be 1X1
 
     static void AddElementToElement(ElemType beta, const CPUMatrix<ElemType>& a, const size_t ai, const size_t aj, CPUMatrix<ElemType>& c, const size_t ci, const size_t cj);
@@ -11,7 +11,7 @@
 namespace Microsoft { namespace MSR { namespace CNTK {
 
 CPURNGHandle::CPURNGHandle(int deviceId, unsigned long seed)
-    : RNGHandle(deviceId)
+    : RNGHandle(deviceId), m_key(seed), m_nextCounter(0)
 {
 #ifdef _MSC_VER // TODO: check if available under GCC/Linux
     m_generator.reset(new std::ranlux64_base_01());
@@ -10,14 +10,60 @@
 #include "RNGHandle.h"
 #include <memory>
 #include <random>
+#include <stdint.h>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
+// Philox4x32-10 counter-based random number generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11).
+// Maps a counter and a key to four random 32-bit words. Unlike with a sequential engine, the numbers for any counter can be
+// computed on their own, so a random stream can be generated by any number of threads with the same result.
+inline void Philox4x32(uint64_t counter, uint64_t key, uint32_t result[4])
+{
+    uint32_t c0 = (uint32_t) counter, c1 = (uint32_t) (counter >> 32), c2 = 0, c3 = 0;
+    uint32_t k0 = (uint32_t) key, k1 = (uint32_t) (key >> 32);
+    for (int round = 0; round < 10; round++)
+    {
+        uint64_t p0 = (uint64_t) 0xD2511F53 * c0;
+        uint64_t p1 = (uint64_t) 0xCD9E8D57 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+
+// Threshold for random 32-bit words below which an event of the given probability happens.
+inline uint64_t Philox4x32Threshold(double probability)
+{
+    return probability <= 0 ? 0 : probability >= 1 ? ((uint64_t) 1 << 32) : (uint64_t) (probability * 4294967296.0);
+}
+
 class CPURNGHandle : public RNGHandle
 {
 public:
     CPURNGHandle(int deviceId, unsigned long seed);
 
+    // Key of the counter-based generator Philox4x32().
+    uint64_t Key() const
+    {
+        return m_key;
+    }
+
+    // Reserves n counters for Philox4x32() and returns the first one. Each call gets counters that have not
+    // been used before, so that subsequent draws from the handle are independent.
+    uint64_t ReserveCounters(uint64_t n)
+    {
+        uint64_t first = m_nextCounter;
+        m_nextCounter += n;
+        return first;
+    }
+
 #ifdef _MSC_VER // TODO: check if available under GCC/Linux
     std::ranlux64_base_01& Generator()
     {
@@ -37,6 +83,9 @@ private:
     std::unique_ptr<std::default_random_engine> m_generator;
 #endif
 
+    uint64_t m_key;
+    uint64_t m_nextCounter;
+
 };
 
 }}}
@@ -505,6 +505,23 @@ void CPUSparseMatrix<ElemType>::SetMatrixFromCSCFormat(const CPUSPARSE_INDEX_TYP
     memcpy(NzValues(), h_Val, sizeof(ElemType)*nz);
 }
 
+template <class ElemType>
+void CPUSparseMatrix<ElemType>::PrepareCSCFormatBuffers(const size_t nz, const size_t numRows, const size_t numCols,
+                                                        CPUSPARSE_INDEX_TYPE*& h_CSCCol, CPUSPARSE_INDEX_TYPE*& h_Row, ElemType*& h_Val)
+{
+    if (!OwnBuffer())
+        LogicError("Cannot modify since the buffer is managed externally.");
+
+    SetFormat(matrixFormatSparseCSC);
+    RequireSizeAndAllocate(numRows, numCols, nz, true, false);
+
+    // RowLocation and NzValues are offset by the first column start, so it has to be valid before they are taken.
+    h_CSCCol = ColLocation();
+    h_CSCCol[0] = 0;
+    h_Row = RowLocation();
+    h_Val = NzValues();
+}
+
 template <class ElemType>
 ElemType* CPUSparseMatrix<ElemType>::Data() const
 {
@@ -659,6 +676,117 @@ void CPUSparseMatrix<ElemType>::Reset()
     SetBlockIdShift(0);
 }
 
+// c(:, o) += alpha * sum of a(:, index[p]) * value[p] over p in [starts[o], starts[o + 1]), for the columns o in [firstColumn, endColumn).
+// The inner loop runs over the dense rows and applies four nonzeros per pass, so that a column of c is loaded and stored a quarter as often.
+template <class ElemType>
+static void AddDenseTimesSparseColumns(const ElemType alpha, const ElemType* a, const size_t lda, const size_t numRows,
+                                       const CPUSPARSE_INDEX_TYPE* starts, const CPUSPARSE_INDEX_TYPE* index, const ElemType* value,
+                                       ElemType* c, const size_t ldc, const size_t firstColumn, const size_t endColumn)
+{
+    for (size_t o = firstColumn; o < endColumn; o++)
+    {
+        ElemType* cColumn = c + o * ldc;
+        size_t p = starts[o];
+        const size_t end = starts[o + 1];
+        for (; p + 4 <= end; p += 4)
+        {
+            const ElemType* a0 = a + index[p] * lda;
+            const ElemType* a1 = a + index[p + 1] * lda;
+            const ElemType* a2 = a + index[p + 2] * lda;
+            const ElemType* a3 = a + index[p + 3] * lda;
+            const ElemType v0 = alpha * value[p];
+            const ElemType v1 = alpha * value[p + 1];
+            const ElemType v2 = alpha * value[p + 2];
+            const ElemType v3 = alpha * value[p + 3];
+            for (size_t h = 0; h < numRows; h++)
+            {
+                cColumn[h] += v0 * a0[h] + v1 * a1[h] + v2 * a2[h] + v3 * a3[h];
+            }
+        }
+        for (; p < end; p++)
+        {
+            const ElemType* a0 = a + index[p] * lda;
+            const ElemType v0 = alpha * value[p];
+            for (size_t h = 0; h < numRows; h++)
+            {
+                cColumn[h] += v0 * a0[h];
+            }
+        }
+    }
+}
+
+// Returns the first column of part 'part' out of 'numParts' ranges of columns with about the same number of nonzeros each.
+static size_t BalancedColumnBoundary(const CPUSPARSE_INDEX_TYPE* starts, const size_t numColumns, const size_t part, const size_t numParts)
+{
+    if (part >= numParts)
+        return numColumns;
+
+    double nnz = (double) (starts[numColumns] - starts[0]);
+    CPUSPARSE_INDEX_TYPE target = starts[0] + (CPUSPARSE_INDEX_TYPE) (nnz * part / numParts);
+    return lower_bound(starts, starts + numColumns, target) - starts;
+}
+
+// Parallel version of AddDenseTimesSparseColumns() over all numColumns columns. Every thread gets a range of columns of c
+// with about the same number of nonzeros, so each column is written by exactly one thread.
+template <class ElemType>
+static void ParallelAddDenseTimesSparseColumns(const ElemType alpha, const ElemType* a, const size_t lda, const size_t numRows,
+                                               const CPUSPARSE_INDEX_TYPE* starts, const CPUSPARSE_INDEX_TYPE* index, const ElemType* value,
+                                               ElemType* c, const size_t ldc, const size_t numColumns)
+{
+    // small products are not worth starting the threads
+    const size_t work = (size_t) (starts[numColumns] - starts[0]) * numRows;
+    if (work < 65536 || omp_get_max_threads() == 1)
+    {
+        AddDenseTimesSparseColumns(alpha, a, lda, numRows, starts, index, value, c, ldc, 0, numColumns);
+        return;
+    }
+
+#pragma omp parallel
+    {
+        const size_t numParts = omp_get_num_threads();
+        const size_t part = omp_get_thread_num();
+        AddDenseTimesSparseColumns(alpha, a, lda, numRows, starts, index, value, c, ldc,
+                                   BalancedColumnBoundary(starts, numColumns, part, numParts),
+                                   BalancedColumnBoundary(starts, numColumns, part + 1, numParts));
+    }
+}
+
+// Transposes the nonzeros of a CSC matrix into rows keyed by rowKey[row], for
+// ParallelAddDenseTimesSparseColumns() to write each output column of a product with the transposed matrix from one thread.
+// Within a row, the nonzeros stay in the order of their columns.
+template <class ElemType>
+static void TransposeCSCNonzeros(const CPUSparseMatrix<ElemType>& a, const vector<CPUSPARSE_INDEX_TYPE>& rowKey, const size_t numKeys,
+                                 vector<CPUSPARSE_INDEX_TYPE>& starts, vector<CPUSPARSE_INDEX_TYPE>& columns, vector<ElemType>& values)
+{
+    const CPUSPARSE_INDEX_TYPE* colStarts = a.SecondaryIndexLocation();
+    const CPUSPARSE_INDEX_TYPE* rows = a.MajorIndexLocation();
+    const ElemType* nzValues = a.Buffer();
+    const size_t numCols = a.GetNumCols();
+
+    starts.assign(numKeys + 1, 0);
+    for (size_t p = colStarts[0]; p < colStarts[numCols]; p++)
+    {
+        starts[rowKey[rows[p]] + 1]++;
+    }
+    for (size_t key = 0; key < numKeys; key++)
+    {
+        starts[key + 1] += starts[key];
+    }
+
+    columns.resize(starts[numKeys]);
+    values.resize(starts[numKeys]);
+    vector<CPUSPARSE_INDEX_TYPE> next(starts.begin(), starts.end() - 1);
+    for (size_t j = 0; j < numCols; j++)
+    {
+        for (size_t p = colStarts[j]; p < colStarts[j + 1]; p++)
+        {
+            CPUSPARSE_INDEX_TYPE q = next[rowKey[rows[p]]]++;
+            columns[q] = (CPUSPARSE_INDEX_TYPE) j;
+            values[q] = nzValues[p];
+        }
+    }
+}
+
 // c = alpha*op(lhs) * op(rhs) + beta*c
 // dense x sparse = dense
 template <class ElemType>
@@ -704,39 +832,25 @@ void CPUSparseMatrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const CPU
 
     if (!transposeA && !transposeB)
     {
-        for (size_t j = 0; j < rhs.GetNumCols(); j++)
-        {
-            size_t start = rhs.SecondaryIndexLocation()[j]; // ColLocation
-            size_t end = rhs.SecondaryIndexLocation()[j + 1];
-            for (size_t p = start; p < end; p++)
-            {
-                size_t i = rhs.MajorIndexLocation()[p]; // RowLocation
-                ElemType val = rhs.Buffer()[p];
-
-                for (size_t h = 0; h < lhs.GetNumRows(); h++)
-                {
-                    c(h, j) += alpha * lhs(h, i) * val;
-                }
-            }
-        }
+        // c(:, j) += alpha * lhs(:, i) * rhs(i, j) over the nonzeros of column j
+        ParallelAddDenseTimesSparseColumns(alpha, lhs.Data(), lhs.GetNumRows(), lhs.GetNumRows(),
+                                           rhs.SecondaryIndexLocation(), rhs.MajorIndexLocation(), rhs.Buffer(),
+                                           c.Data(), c.GetNumRows(), rhs.GetNumCols());
     }
     else if (!transposeA && transposeB)
     {
-        for (size_t j = 0; j < rhs.GetNumCols(); j++)
+        // c(:, i) += alpha * lhs(:, j) * rhs(i, j) over the nonzeros of row i, which are gathered by transposing rhs
+        vector<CPUSPARSE_INDEX_TYPE> rowKey(rhs.GetNumRows());
+        for (size_t i = 0; i < rowKey.size(); i++)
         {
-            size_t start = rhs.SecondaryIndexLocation()[j];
-            size_t end = rhs.SecondaryIndexLocation()[j + 1];
-
-            for (size_t p = start; p < end; p++)
-            {
-                size_t i = rhs.MajorIndexLocation()[p];
-                ElemType val = rhs.Buffer()[p];
-                for (size_t h = 0; h < lhs.GetNumRows(); h++)
-                {
-                    c(h, i) += alpha * lhs(h, j) * val;
-                }
-            }
+            rowKey[i] = (CPUSPARSE_INDEX_TYPE) i;
         }
+        vector<CPUSPARSE_INDEX_TYPE> rowStarts, columns;
+        vector<ElemType> values;
+        TransposeCSCNonzeros(rhs, rowKey, rhs.GetNumRows(), rowStarts, columns, values);
+        ParallelAddDenseTimesSparseColumns(alpha, lhs.Data(), lhs.GetNumRows(), lhs.GetNumRows(),
+                                           rowStarts.data(), columns.data(), values.data(),
+                                           c.Data(), c.GetNumRows(), rhs.GetNumRows());
     }
     else if (transposeA && !transposeB)
     {
@@ -789,7 +903,8 @@ void CPUSparseMatrix<ElemType>::MultiplyAndAdd(ElemType alpha, const CPUMatrix<E
         c.SetFormat(matrixFormatSparseBlockCol);
         c.RequireSizeAndAllocate(m, n, m * min(n, rhs.NzCount()), true, false);
 
-        map<size_t, size_t> w2Id;
+        // number the blocks in the order their words (rows of rhs) first appear
+        vector<CPUSPARSE_INDEX_TYPE> w2Id(rhs.GetNumRows(), -1);
         for (size_t j = 0; j < rhs.GetNumCols(); j++)
         { // j ranges over batches
             size_t start = rhs.SecondaryIndexLocation()[j];
@@ -798,39 +913,27 @@ void CPUSparseMatrix<ElemType>::MultiplyAndAdd(ElemType alpha, const CPUMatrix<E
             for (size_t p = start; p < end; p++)
             {
                 size_t i = rhs.MajorIndexLocation()[p]; // i ranges over words
-                ElemType val = rhs.Buffer()[p];  // 1 for(i, j)
-
-                bool first = true;
-                if (w2Id.find(i) == w2Id.end())
+                if (w2Id[i] < 0)
                 {
-                    size_t id = w2Id.size();
-                    w2Id[i] = id;
+                    w2Id[i] = (CPUSPARSE_INDEX_TYPE) c.GetBlockSize();
                     c.GetBlockIds()[c.GetBlockSize()] = i;
                     c.SetBlockSize(c.GetBlockSize() + 1);
                 }
-                else
-                {
-                    first = false;
-                }
-                size_t pos = w2Id[i] * lhs.GetNumRows();
-                for (size_t h = 0; h < lhs.GetNumRows(); h++)
-                { // h range over hidden layer
-                    if (first == true)
-                    {
-                        c.Buffer()[pos] = alpha * lhs(h, j) * val;
-                    }
-                    else
-                    {
-                        c.Buffer()[pos] += alpha * lhs(h, j) * val;
-                    }
-                    pos++;
-                }
             }
         }
         if (c.GetBlockSize() * m > c.GetSizeAllocated())
         {
             LogicError("Sparse matrix is unexpectedly out of range.");
         }
+
+        // block w2Id[i] = alpha * sum of lhs(:, j) * rhs(i, j) over the nonzeros of word i, the blocks are computed in parallel
+        vector<CPUSPARSE_INDEX_TYPE> blockStarts, columns;
+        vector<ElemType> values;
+        TransposeCSCNonzeros(rhs, w2Id, c.GetBlockSize(), blockStarts, columns, values);
+        memset(c.Buffer(), 0, sizeof(ElemType) * c.GetBlockSize() * m);
+        ParallelAddDenseTimesSparseColumns(alpha, lhs.Data(), lhs.GetNumRows(), lhs.GetNumRows(),
+                                           blockStarts.data(), columns.data(), values.data(),
+                                           c.Buffer(), m, c.GetBlockSize());
     }
     else if (transposeA && !transposeB)
     {
@@ -858,8 +961,10 @@ void CPUSparseMatrix<ElemType>::ScaleAndAdd(const ElemType alpha, const CPUSpars
 
     if (lhs.GetFormat() == MatrixFormat::matrixFormatSparseCSC || lhs.GetFormat() == MatrixFormat::matrixFormatSparseCSR)
     {
-        size_t col_num = (lhs.GetFormat() == MatrixFormat::matrixFormatSparseCSC) ? lhs.GetNumCols() : lhs.GetNumRows();
-        for (size_t j = 0; j < col_num; j++)
+        // each j updates a different column (CSC) or row (CSR) of rhs
+        long col_num = (long) ((lhs.GetFormat() == MatrixFormat::matrixFormatSparseCSC) ? lhs.GetNumCols() : lhs.GetNumRows());
+#pragma omp parallel for
+        for (long j = 0; j < col_num; j++)
         {
             size_t start = lhs.SecondaryIndexLocation()[j];
             size_t end = lhs.SecondaryIndexLocation()[j + 1];
@@ -875,7 +980,9 @@ void CPUSparseMatrix<ElemType>::ScaleAndAdd(const ElemType alpha, const CPUSpars
     }
     else if (lhs.GetFormat() == MatrixFormat::matrixFormatSparseBlockCol || lhs.GetFormat() == MatrixFormat::matrixFormatSparseBlockRow)
     {
-        for (size_t j = 0; j < lhs.GetBlockSize(); j++)
+        // the blocks have distinct ids, so each updates a different column (row) of rhs
+#pragma omp parallel for
+        for (long j = 0; j < (long) lhs.GetBlockSize(); j++)
         {
             size_t i = lhs.GetBlockIds()[j] - lhs.GetBlockIdShift();
             size_t len = (lhs.GetFormat() == MatrixFormat::matrixFormatSparseBlockCol) ? lhs.GetNumRows() : lhs.GetNumCols();
@@ -896,6 +1003,52 @@ void CPUSparseMatrix<ElemType>::ScaleAndAdd(const ElemType alpha, const CPUSpars
     }
 }
 
+// c += alpha * (a - b), e.g. the gradient of CrossEntropyWithSoftmaxNode with sparse labels b
+template <class ElemType>
+/*static*/ void CPUSparseMatrix<ElemType>::AddScaledDifference(const ElemType alpha, const CPUMatrix<ElemType>& a, const CPUSparseMatrix<ElemType>& b, CPUMatrix<ElemType>& c)
+{
+    if (a.GetNumRows() != b.GetNumRows() || a.GetNumCols() != b.GetNumCols())
+        InvalidArgument("CPUSparseMatrix::AddScaledDifference: The dimensions of a and b must match.");
+
+    CPUMatrix<ElemType>::ScaleAndAdd(alpha, a, c);
+    ScaleAndAdd(-alpha, b, c);
+}
+
+// softmax = column-wise softmax of input, returns -sum(labels .* log(softmax)) for CrossEntropyWithSoftmaxNode
+// Only the non-zero labels are visited, each multiplied with log(softmax(i, j)) = input(i, j) - logSumExp(0, j).
+template <class ElemType>
+/*static*/ ElemType CPUSparseMatrix<ElemType>::SoftmaxAndCrossEntropy(const CPUSparseMatrix<ElemType>& labels, const CPUMatrix<ElemType>& input, CPUMatrix<ElemType>& softmax)
+{
+    if (labels.GetNumRows() != input.GetNumRows() || labels.GetNumCols() != input.GetNumCols())
+        InvalidArgument("CPUSparseMatrix::SoftmaxAndCrossEntropy: The dimensions of labels and input must match.");
+    if (labels.GetFormat() != MatrixFormat::matrixFormatSparseCSC)
+        NOT_IMPLEMENTED;
+
+    CPUMatrix<ElemType> logSumExp;
+    softmax.AssignColumnSoftmaxOf(input, logSumExp);
+
+    // sum up per column first, so that the result does not depend on the number of threads
+    vector<double> criteria(input.GetNumCols());
+#pragma omp parallel for
+    for (long j = 0; j < (long) labels.GetNumCols(); j++)
+    {
+        double criterion = 0;
+        size_t start = labels.SecondaryIndexLocation()[j];
+        size_t end = labels.SecondaryIndexLocation()[j + 1];
+        for (size_t p = start; p < end; p++)
+        {
+            size_t i = labels.MajorIndexLocation()[p];
+            criterion -= labels.Buffer()[p] * (input(i, j) - logSumExp(0, j));
+        }
+        criteria[j] = criterion;
+    }
+
+    double criterion = 0;
+    for (double columnCriterion : criteria)
+        criterion += columnCriterion;
+    return (ElemType) criterion;
+}
+
 template <class ElemType>
 /*static*/ bool CPUSparseMatrix<ElemType>::AreEqual(const CPUSparseMatrix<ElemType>& a, const CPUSparseMatrix<ElemType>& b, const ElemType threshold)
 {
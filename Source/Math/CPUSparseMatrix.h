@@ -116,6 +116,11 @@ public:
     void SetMatrixFromCSCFormat(const CPUSPARSE_INDEX_TYPE* h_CSCCol, const CPUSPARSE_INDEX_TYPE* h_Row, const ElemType* h_Val,
                                 const size_t nz, const size_t numRows, const size_t numCols);
 
+    // Sizes the matrix for nz elements in the CSC format and returns its column starts, row indices and values,
+    // so that they can be written in place instead of being copied by SetMatrixFromCSCFormat().
+    void PrepareCSCFormatBuffers(const size_t nz, const size_t numRows, const size_t numCols,
+                                 CPUSPARSE_INDEX_TYPE*& h_CSCCol, CPUSPARSE_INDEX_TYPE*& h_Row, ElemType*& h_Val);
+
     static void MultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix<ElemType>& lhs, const bool transposeA,
                                        const CPUSparseMatrix<ElemType>& rhs, const bool transposeB, ElemType beta, CPUMatrix<ElemType>& c);
 
@@ -137,11 +142,11 @@ public:
     {
         NOT_IMPLEMENTED;
     }
-    static void AddScaledDifference(const ElemType /*alpha*/, const CPUMatrix<ElemType>& /*a*/, const CPUSparseMatrix<ElemType>& /*b*/, CPUMatrix<ElemType>& /*c*/,
-                                    bool /*bDefaultZero*/)
-    {
-        NOT_IMPLEMENTED;
-    }
+    // c += alpha * (a - b)
+    static void AddScaledDifference(const ElemType alpha, const CPUMatrix<ElemType>& a, const CPUSparseMatrix<ElemType>& b, CPUMatrix<ElemType>& c);
+
+    // softmax = column-wise softmax of input; returns -sum(labels .* log(softmax)), reading only the non-zero labels
+    static ElemType SoftmaxAndCrossEntropy(const CPUSparseMatrix<ElemType>& labels, const CPUMatrix<ElemType>& input, CPUMatrix<ElemType>& softmax);
 
     int GetComputeDeviceId() const
     {
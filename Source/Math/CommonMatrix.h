@@ -90,13 +90,18 @@ enum ElementWiseOperator
     opElementwiseProductWithCosDerivative, opElementwiseProductWithSinDerivative,
     opElementwiseProductWithAbsDerivative, opElementwiseProductWithSqrtDerivative,
     opElementwiseProductWithReciprocalDerivative, opSqrOfDifference,
+    // binary ops for fused element-wise nodes (f(a + b))
+    opSigmoidOfSum, opTanhOfSum, opLinearRectifierOfSum,
     // binary ops for indexing
     // opIndex,
     // ternary
     opCond /*a ? b : c*/,
     opClip, /*clip a within interval b..c*/
     opElementwiseProductWithLogSumDerivative,
-    opCopyIfEqual
+    opCopyIfEqual,
+    // ternary ops for fused element-wise nodes (f(a + b) * c and the derivatives of f(b + c))
+    opSigmoidOfSumTimes, opTanhOfSumTimes,
+    opElementwiseProductWithSigmoidDerivativeOfSum, opElementwiseProductWithTanhDerivativeOfSum
     // Note: not all that's implemented in CNTK ComputationNodes has an opcode yet.
 };
 
@@ -151,13 +156,20 @@ enum ElementWiseOperator
     Macro(ElementwiseProductWithReciprocalDerivative);                \
     Macro(ElementwiseProductWithSqrtDerivative);                      \
     Macro(SqrOfDifference);                                           \
+    Macro(SigmoidOfSum);                                              \
+    Macro(TanhOfSum);                                                 \
+    Macro(LinearRectifierOfSum);                                      \
     //Macro(Index);
 
-#define ForAllTernaryOps(Macro)                         \
-    Macro(Cond);                                        \
-    Macro(CopyIfEqual);                                 \
-    Macro(Clip);                                        \
-    Macro(ElementwiseProductWithLogSumDerivative);      
+#define ForAllTernaryOps(Macro)                          \
+    Macro(Cond);                                         \
+    Macro(CopyIfEqual);                                  \
+    Macro(Clip);                                         \
+    Macro(ElementwiseProductWithLogSumDerivative);       \
+    Macro(SigmoidOfSumTimes);                            \
+    Macro(TanhOfSumTimes);                               \
+    Macro(ElementwiseProductWithSigmoidDerivativeOfSum); \
+    Macro(ElementwiseProductWithTanhDerivativeOfSum);
 
 // -----------------------------------------------------------------------
 // various enums to describe
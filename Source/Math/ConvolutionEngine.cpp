@@ -6,6 +6,8 @@
 #include "stdafx.h"
 #include "ConvolutionEngine.h"
 #include "CuDnnFactories.h"
+#include "CPUConvolution.h"
+#include "TensorView.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -29,6 +31,40 @@ void ConvolutionEngine<ElemType>::Forward(const Mat& in, const Mat& kernel, Mat&
     ForwardCore(in, kernel, out, workspace);
 }
 
+template <class ElemType>
+void ConvolutionEngine<ElemType>::ForwardWithBias(const Mat& in, const Mat& kernel, const Mat& bias, bool relu, Mat& out, Mat& workspace)
+{
+    const auto& g = *m_geometry;
+    assert(g.InputShape().GetNumElements() == in.GetNumRows());
+    assert(g.OutputShape().GetNumElements() == out.GetNumRows());
+    size_t batchSize = in.GetNumCols();
+    assert(batchSize == out.GetNumCols());
+    assert(g.KernelShape().GetNumElements() * g.KernelCount() == kernel.GetNumElements());
+    assert(g.MapCount().GetNumElements() == bias.GetNumElements());
+#ifdef NDEBUG
+    UNUSED(g);
+    UNUSED(batchSize);
+#endif
+
+    EnsureCompatible();
+    EnsureConvolutionInitialized();
+    ForwardWithBiasCore(in, kernel, bias, relu, out, workspace);
+}
+
+// Engines that do not fuse the bias and the ReLU into the convolution apply them to the output, which is
+// a [W'H' x K] block per sample as the maps are along the last dimension.
+template <class ElemType>
+void ConvolutionEngine<ElemType>::ForwardWithBiasCore(const Mat& in, const Mat& kernel, const Mat& bias, bool relu, Mat& out, Mat& workspace)
+{
+    ForwardCore(in, kernel, out, workspace);
+
+    size_t mapCount = bias.GetNumElements();
+    TensorView<ElemType> outView(std::make_shared<Mat>(out.AsReference()), TensorShape(out.GetNumRows() / mapCount, mapCount, out.GetNumCols()));
+    outView.AddCopyOf(TensorView<ElemType>(std::make_shared<Mat>(bias.AsReference()), TensorShape(1, mapCount, 1)));
+    if (relu)
+        outView.AssignLinearRectifierOf(outView);
+}
+
 template <class ElemType>
 void ConvolutionEngine<ElemType>::BackwardData(const Mat& srcGrad, const Mat& kernel, Mat& grad, Mat& workspace)
 {
@@ -813,6 +849,115 @@ public:
     }
 };
 
+//------------------------------------------------------------------
+// Direct convolution engine implementation.
+// This engine computes forward 2D convolutions with full sharing on the CPU
+// using the native kernels of CPUConvolution: blocked direct convolution and,
+// if selected with SetCPUConvolutionAlgorithm, Winograd minimal filtering for
+// 3x3 kernels with stride 1. Bias and ReLU of ForwardWithBias are fused into
+// writing the output. Create() picks it over GEMM only for large outputs.
+// Uses GEMM engine for backward passes and reference engine for pooling.
+//------------------------------------------------------------------
+template <class ElemType>
+class DirectConvolutionEngine : public GemmConvolutionEngine<ElemType>
+{
+public:
+    using Base = GemmConvolutionEngine<ElemType>;
+    using typename Base::Mat;
+
+public:
+    DirectConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind)
+        : Base(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind)
+    {
+        if (!GetShape(*geometry, m_shape))
+            LogicError("Direct convolution engine does not support this convolution configuration. Geometry: %s", ((string)*geometry).c_str());
+    }
+
+protected:
+    using Base::IsGpu;
+
+    using Base::m_geometry;
+    using Base::m_deviceId;
+    using Base::m_imageLayout;
+
+    void EnsureCompatible() override
+    {
+        if (m_imageLayout != ImageLayoutKind::CHW)
+            LogicError("Direct convolution engine supports only CHW/cudnn layout.");
+        if (IsGpu(m_deviceId))
+            LogicError("Direct convolution engine supports only CPU device.");
+    }
+
+    void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& /*workspace*/) override
+    {
+        CPUConvolution<ElemType>::Forward(m_shape, in.Data(), (int)in.GetNumCols(), kernel.Data(), nullptr, false, out.Data());
+    }
+
+    void ForwardWithBiasCore(const Mat& in, const Mat& kernel, const Mat& bias, bool relu, Mat& out, Mat& /*workspace*/) override
+    {
+        CPUConvolution<ElemType>::Forward(m_shape, in.Data(), (int)in.GetNumCols(), kernel.Data(), bias.Data(), relu, out.Data());
+    }
+
+public:
+    static bool IsSupported(DEVICEID_TYPE deviceId, ConvolveGeometryPtr geometry, PoolKind poolKind)
+    {
+        CPUConvolution2DShape shape;
+        return deviceId < 0 && poolKind == PoolKind::None && GetShape(*geometry, shape);
+    }
+
+    static bool IsFasterThanGemm(ConvolveGeometryPtr geometry)
+    {
+        CPUConvolution2DShape shape;
+        return GetShape(*geometry, shape) && CPUConvolution<ElemType>::IsFasterThanGemm(shape);
+    }
+
+private:
+    // Describes the geometry for CPUConvolution. This requires a WHC input with full sharing, kernels that cover
+    // all C input channels and the output maps along the last dimension; returns false for other geometries.
+    static bool GetShape(const ConvolveGeometry& g, CPUConvolution2DShape& shape)
+    {
+        const auto& inT = g.InputShape();
+        const auto& kernT = g.KernelShape();
+        const auto& outT = g.OutputShape();
+        if (inT.GetRank() != 3 || find(begin(g.Sharing()), end(g.Sharing()), false) != end(g.Sharing()))
+            return false;
+        if (kernT[2] != inT[2] || g.GetMapCount(0) != 1 || g.GetMapCount(1) != 1 || outT[2] != g.GetMapCount(2) || GetFirstInputCell(g, 2) != 0)
+            return false;
+
+        shape.m_inW = (int)inT[0];
+        shape.m_inH = (int)inT[1];
+        shape.m_inC = (int)inT[2];
+        shape.m_kernelW = (int)kernT[0];
+        shape.m_kernelH = (int)kernT[1];
+        shape.m_outW = (int)outT[0];
+        shape.m_outH = (int)outT[1];
+        shape.m_outC = (int)outT[2];
+        shape.m_strideW = (int)g.GetStride(0);
+        shape.m_strideH = (int)g.GetStride(1);
+        shape.m_firstW = GetFirstInputCell(g, 0);
+        shape.m_firstH = GetFirstInputCell(g, 1);
+        return true;
+    }
+
+    // Input cell under the first kernel tap of the first output cell in a dimension, negative with padding.
+    // Follows the computation of the kernel start in the ConvolveGeometry ctor.
+    static int GetFirstInputCell(const ConvolveGeometry& g, size_t dim)
+    {
+        int kernel = (int)g.KernelShape()[dim];
+        int outPerMap = (int)(g.OutputShape()[dim] / g.GetMapCount(dim));
+        int cells = (outPerMap - 1) * (int)g.GetStride(dim) + 1;
+        int extra = (int)g.InputShape()[dim] - cells;
+        int lo = g.GetAutoPad(dim) ? 0 : (int)g.LowerPad()[g.LowerPad().size() == 1 ? 0 : dim];
+        int hi = g.GetAutoPad(dim) ? 0 : (int)g.UpperPad()[g.UpperPad().size() == 1 ? 0 : dim];
+        int left = (kernel - 1) / 2;
+        int start = lo != 0 || hi != 0 ? left - lo : extra / 2;
+        return start - left;
+    }
+
+private:
+    CPUConvolution2DShape m_shape;
+};
+
 template <class ElemType>
 std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId,
                                                                                  ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind,
@@ -841,7 +986,16 @@ std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create
         return CuDnnConvolutionEngineFactory<ElemType>::Create(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind);
     }
 
-    if (isEnabled(ConvolutionEngineKind::Gemm) && GemmConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
+    // Direct is picked over GEMM only where it is faster, unless GEMM is disabled or SetCPUConvolutionAlgorithm() opted into it.
+    bool gemmSupported = isEnabled(ConvolutionEngineKind::Gemm) && GemmConvolutionEngine<ElemType>::IsSupported(deviceId, geometry);
+    if (isEnabled(ConvolutionEngineKind::Direct) && DirectConvolutionEngine<ElemType>::IsSupported(deviceId, geometry, poolKind) &&
+        (!gemmSupported || DirectConvolutionEngine<ElemType>::IsFasterThanGemm(geometry)))
+    {
+        fprintf(stderr, "\nUsing direct convolution engine for geometry: %s.\n", engStr.c_str());
+        return std::make_unique<DirectConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind);
+    }
+
+    if (gemmSupported)
     {
         fprintf(stderr, "\nUsing GEMM convolution engine for geometry: %s.\n", engStr.c_str());
         return std::make_unique<GemmConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind);
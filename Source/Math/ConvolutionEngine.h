@@ -22,8 +22,9 @@ enum class ConvolutionEngineKind
     CuDnn     = 1 << 1, // cuDNN, works only for 2D/3D convos with full sharing.
     Legacy    = 1 << 2, // Legacy, for backwards compatibility. REVIEW alexeyk: implement sparse version and remove Legacy altogether.
     Gemm      = 1 << 3, // Uses convolution unrolling+GEMM technique. Works only for convos with full sharing.
+    Direct    = 1 << 4, // Native CPU kernels (blocked direct and Winograd), works only for 2D convos with full sharing on CPU.
 
-    All       = Reference | CuDnn | Legacy | Gemm
+    All       = Reference | CuDnn | Legacy | Gemm | Direct
 };
 
 enum class PoolKind
@@ -47,6 +48,10 @@ public:
 
     void Forward(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace);
 
+    // Forward followed by adding bias (a column vector with a value per output map) and, if relu is true, a ReLU.
+    // Engines that can fuse these into the convolution do so, the others apply them to the output afterwards.
+    void ForwardWithBias(const Mat& in, const Mat& kernel, const Mat& bias, bool relu, Mat& out, Mat& workspace);
+
     void BackwardData(const Mat& srcGrad, const Mat& kernel, Mat& grad, Mat& workspace);
 
     void BackwardKernel(const Mat& srcGrad, const Mat& in, Mat& kernelGrad, bool allowReuse, Mat& workspace);
@@ -81,6 +86,8 @@ protected:
 
     virtual void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) = 0;
 
+    virtual void ForwardWithBiasCore(const Mat& in, const Mat& kernel, const Mat& bias, bool relu, Mat& out, Mat& workspace);
+
     virtual void BackwardDataCore(const Mat& srcGrad, const Mat& kernel, Mat& grad, Mat& workspace) = 0;
 
     virtual void BackwardKernelCore(const Mat& srcGrad, const Mat& in, Mat& kernelGrad, bool allowReuse, Mat& workspace) = 0;
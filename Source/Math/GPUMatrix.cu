@@ -3230,6 +3230,26 @@ void GPUMatrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const GPUMatrix
     c.m_numCols = n;
 }
 
+// batched GEMM, issued as a sequence of cublas calls on the same stream
+template <class ElemType>
+void GPUMatrix<ElemType>::BatchMultiplyAndWeightedAdd(ElemType alpha, const GPUMatrix<ElemType>& a, const bool transposeA, const std::vector<size_t>& offsetsA,
+                                                      const GPUMatrix<ElemType>& b, const bool transposeB, const std::vector<size_t>& offsetsB,
+                                                      ElemType beta, GPUMatrix<ElemType>& c, const std::vector<size_t>& offsetsC, size_t m, size_t n, size_t k)
+{
+    a.PrepareDevice();
+    if ((a.GetComputeDeviceId() != b.GetComputeDeviceId()) || (b.GetComputeDeviceId() != c.GetComputeDeviceId())) // different GPUs
+        InvalidArgument("All matrices must be on the same GPU");
+
+    cublasHandle_t cuHandle = GetCublasHandle(b.GetComputeDeviceId());
+    cublasOperation_t transA = transposeA ? CUBLAS_OP_T : CUBLAS_OP_N;
+    cublasOperation_t transB = transposeB ? CUBLAS_OP_T : CUBLAS_OP_N;
+    const int lda = (int) (transposeA ? k : m);
+    const int ldb = (int) (transposeB ? n : k);
+    const int ldc = (int) m;
+    for (size_t i = 0; i < offsetsC.size(); i++)
+        CUBLAS_CALL(cublas_gemm(cuHandle, transA, transB, (int) m, (int) n, (int) k, &alpha, a.Data() + offsetsA[i], lda, b.Data() + offsetsB[i], ldb, &beta, c.Data() + offsetsC[i], ldc));
+}
+
 template <class ElemType>
 void GPUMatrix<ElemType>::Multiply1x1AndWeightedAdd(ElemType alpha, const GPUMatrix<ElemType>& a, const GPUMatrix<ElemType>& b, ElemType beta, GPUMatrix<ElemType>& c)
 {
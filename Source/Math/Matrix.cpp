@@ -1303,6 +1303,17 @@ void Matrix<ElemType>::SetMatrixFromCSCFormat(const CPUSPARSE_INDEX_TYPE* h_CSCC
         { m_GPUSparseMatrix->SetMatrixFromCSCFormat(h_CSCCol, h_Row, h_Val, nz, numRows, numCols); });
 }
 
+template <class ElemType>
+bool Matrix<ElemType>::TryPrepareCSCFormatBuffers(const size_t nz, const size_t numRows, const size_t numCols,
+                                                  CPUSPARSE_INDEX_TYPE*& h_CSCCol, CPUSPARSE_INDEX_TYPE*& h_Row, ElemType*& h_Val)
+{
+    if (GetMatrixType() != MatrixType::SPARSE || GetCurrentMatrixLocation() != CurrentDataLocation::CPU)
+        return false;
+
+    m_CPUSparseMatrix->PrepareCSCFormatBuffers(nz, numRows, numCols, h_CSCCol, h_Row, h_Val);
+    return true;
+}
+
 template <class ElemType>
 void Matrix<ElemType>::SetDiagonalValue(const ElemType v)
 {
@@ -1427,6 +1438,51 @@ void Matrix<ElemType>::SetUniformRandomMask(const ElemType maskRate, const ElemT
                             NOT_IMPLEMENTED);
 }
 
+// Dropout with a bit-packed mask, see CPUMatrix::AssignDropoutOf(). Only implemented on the CPU; on the GPU,
+// a full mask is drawn by SetUniformRandomMask() instead.
+template <class ElemType>
+Matrix<ElemType>& Matrix<ElemType>::AssignDropoutOf(const Matrix<ElemType>& a, const ElemType maskRate, const ElemType scaleValue, RNGHandle& rngHandle, Matrix<char>& bitMask)
+{
+    if (a.IsEmpty())
+        LogicError("AssignDropoutOf: Matrix is empty.");
+
+    if (bitMask.GetDeviceId() != CPUDEVICE)
+        RuntimeError("AssignDropoutOf: The mask must be on the CPU.");
+
+    DecideAndMoveToRightDevice(a, *this);
+    SwitchToMatrixType(a.GetMatrixType(), a.GetFormat(), false);
+
+    DISPATCH_MATRIX_ON_FLAG(this,
+                            this,
+                            m_CPUMatrix->AssignDropoutOf(*a.m_CPUMatrix, maskRate, scaleValue, rngHandle, *bitMask.m_CPUMatrix),
+                            NOT_IMPLEMENTED,
+                            NOT_IMPLEMENTED,
+                            NOT_IMPLEMENTED);
+
+    return *this;
+}
+
+template <class ElemType>
+Matrix<ElemType>& Matrix<ElemType>::AddDropoutGradientOf(const Matrix<ElemType>& gradient, const ElemType scaleValue, const Matrix<char>& bitMask)
+{
+    if (gradient.IsEmpty())
+        LogicError("AddDropoutGradientOf: Matrix is empty.");
+
+    if (bitMask.GetDeviceId() != CPUDEVICE)
+        RuntimeError("AddDropoutGradientOf: The mask must be on the CPU.");
+
+    DecideAndMoveToRightDevice(*this, gradient);
+
+    DISPATCH_MATRIX_ON_FLAG(this,
+                            nullptr,
+                            m_CPUMatrix->AddDropoutGradientOf(*gradient.m_CPUMatrix, scaleValue, *bitMask.m_CPUMatrix),
+                            NOT_IMPLEMENTED,
+                            NOT_IMPLEMENTED,
+                            NOT_IMPLEMENTED);
+
+    return *this;
+}
+
 template <class ElemType>
 void Matrix<ElemType>::NormalGrad(Matrix<ElemType>& gradients,
                                   Matrix<ElemType>& functionValues,
@@ -4422,6 +4478,72 @@ void Matrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const Matrix<ElemT
     }
 }
 
+// c_i = alpha * op(a_i) * op(b_i) + beta * c_i for each of the offsetsC.size() products, see Matrix.h
+template <class ElemType>
+/*static*/ void Matrix<ElemType>::BatchMultiplyAndWeightedAdd(ElemType alpha, const Matrix<ElemType>& a, const bool transposeA, const std::vector<size_t>& offsetsA,
+                                                              const Matrix<ElemType>& b, const bool transposeB, const std::vector<size_t>& offsetsB,
+                                                              ElemType beta, Matrix<ElemType>& c, const std::vector<size_t>& offsetsC, size_t m, size_t n, size_t k)
+{
+    const size_t batchSize = offsetsC.size();
+    if (offsetsA.size() != batchSize || offsetsB.size() != batchSize)
+        InvalidArgument("BatchMultiplyAndWeightedAdd: The numbers of offsets of a (%d), b (%d) and c (%d) must match.", (int) offsetsA.size(), (int) offsetsB.size(), (int) batchSize);
+    if (a.GetMatrixType() != MatrixType::DENSE || b.GetMatrixType() != MatrixType::DENSE || c.GetMatrixType() != MatrixType::DENSE)
+        NOT_IMPLEMENTED;
+
+    // each matrix of the batch has to lie within its storage
+    auto verifyOffsets = [](const Matrix<ElemType>& x, const std::vector<size_t>& offsets, size_t itemSize, char name)
+    {
+        for (size_t offset : offsets)
+        {
+            if (offset + itemSize > x.GetNumElements())
+                InvalidArgument("BatchMultiplyAndWeightedAdd: A matrix of %d elements at offset %d does not fit into %c with %d elements.", (int) itemSize, (int) offset, name, (int) x.GetNumElements());
+        }
+    };
+    verifyOffsets(a, offsetsA, m * k, 'a');
+    verifyOffsets(b, offsetsB, k * n, 'b');
+    verifyOffsets(c, offsetsC, m * n, 'c');
+
+    DecideAndMoveToRightDevice(a, b, c);
+
+    DISPATCH_MATRIX_ON_FLAG(&c,
+                            nullptr,
+                            CPUMatrix<ElemType>::BatchMultiplyAndWeightedAdd(alpha, *a.m_CPUMatrix, transposeA, offsetsA, *b.m_CPUMatrix, transposeB, offsetsB, beta, *c.m_CPUMatrix, offsetsC, m, n, k),
+                            GPUMatrix<ElemType>::BatchMultiplyAndWeightedAdd(alpha, *a.m_GPUMatrix, transposeA, offsetsA, *b.m_GPUMatrix, transposeB, offsetsB, beta, *c.m_GPUMatrix, offsetsC, m, n, k),
+                            NOT_IMPLEMENTED,
+                            NOT_IMPLEMENTED);
+}
+
+// batched product where a, b and c hold batchSize matrices each, side by side
+template <class ElemType>
+/*static*/ void Matrix<ElemType>::BatchMultiplyAndWeightedAdd(ElemType alpha, const Matrix<ElemType>& a, const bool transposeA, const Matrix<ElemType>& b, const bool transposeB,
+                                                              ElemType beta, Matrix<ElemType>& c, size_t batchSize)
+{
+    if (batchSize == 0 || a.GetNumCols() % batchSize != 0 || b.GetNumCols() % batchSize != 0)
+        InvalidArgument("BatchMultiplyAndWeightedAdd: The numbers of columns of a (%d) and b (%d) must be multiples of the batch size %d.", (int) a.GetNumCols(), (int) b.GetNumCols(), (int) batchSize);
+
+    const size_t colsA = a.GetNumCols() / batchSize;
+    const size_t colsB = b.GetNumCols() / batchSize;
+    const size_t m = transposeA ? colsA : a.GetNumRows();
+    const size_t k = transposeA ? a.GetNumRows() : colsA;
+    const size_t n = transposeB ? b.GetNumRows() : colsB;
+    if (k != (transposeB ? colsB : b.GetNumRows()))
+        InvalidArgument("BatchMultiplyAndWeightedAdd: The inner dimensions of a and b must match.");
+
+    if (beta == 0)
+        c.Resize(m, n * batchSize);
+    else
+        c.VerifySize(m, n * batchSize); // Can't resize if beta != 0
+
+    std::vector<size_t> offsetsA(batchSize), offsetsB(batchSize), offsetsC(batchSize);
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        offsetsA[i] = i * m * k;
+        offsetsB[i] = i * k * n;
+        offsetsC[i] = i * m * n;
+    }
+    BatchMultiplyAndWeightedAdd(alpha, a, transposeA, offsetsA, b, transposeB, offsetsB, beta, c, offsetsC, m, n, k);
+}
+
 template <class ElemType>
 /*static*/ void Matrix<ElemType>::Multiply1x1AndWeightedAdd(ElemType alpha, const Matrix<ElemType>& a, const Matrix<ElemType>& b, ElemType beta, Matrix<ElemType>& c)
 {
@@ -4662,6 +4784,14 @@ void Matrix<ElemType>::AddScaledDifference(const Matrix<ElemType>& alpha, const
     DecideAndMoveToRightDevice(c, a, b);
     alpha._transferToDevice(c.GetDeviceId());
 
+    // sparse b, e.g. the labels of CrossEntropyWithSoftmaxNode: c += alpha * a, then subtract alpha * b at its non-zeros
+    if (c.GetCurrentMatrixLocation() == CurrentDataLocation::CPU && b.GetMatrixType() == MatrixType::SPARSE &&
+        a.GetMatrixType() == MatrixType::DENSE && c.GetMatrixType() == MatrixType::DENSE && alpha.GetMatrixType() == MatrixType::DENSE)
+    {
+        CPUSparseMatrix<ElemType>::AddScaledDifference(alpha.Get00Element(), *a.m_CPUMatrix, *b.m_CPUSparseMatrix, *c.m_CPUMatrix);
+        return;
+    }
+
     if (!(a.GetMatrixType() == b.GetMatrixType() && a.GetMatrixType() == c.GetMatrixType() && a.GetMatrixType() == alpha.GetMatrixType()))
         NOT_IMPLEMENTED;
 
@@ -4673,6 +4803,25 @@ void Matrix<ElemType>::AddScaledDifference(const Matrix<ElemType>& alpha, const
                             NOT_IMPLEMENTED);
 }
 
+/// <summary>softmax = column-wise softmax of input, returns -sum(labels .* log(softmax))</summary>
+/// Computes the softmax and the cross entropy criterion in one go, without materializing log(softmax).
+/// <param name="labels">Dense or sparse CSC matrix with the same dimensions as input</param>
+/// <param name="input">Dense input matrix</param>
+/// <param name="softmax">Resulting softmax of input, resized as needed</param>
+template <class ElemType>
+ElemType Matrix<ElemType>::SoftmaxAndCrossEntropy(const Matrix<ElemType>& labels, const Matrix<ElemType>& input, Matrix<ElemType>& softmax)
+{
+    DecideAndMoveToRightDevice(input, labels, softmax);
+    if (input.GetCurrentMatrixLocation() != CurrentDataLocation::CPU || input.GetMatrixType() != MatrixType::DENSE)
+        NOT_IMPLEMENTED;
+    softmax.SwitchToMatrixType(MatrixType::DENSE, matrixFormatDense, false);
+
+    if (labels.GetMatrixType() == MatrixType::SPARSE)
+        return CPUSparseMatrix<ElemType>::SoftmaxAndCrossEntropy(*labels.m_CPUSparseMatrix, *input.m_CPUMatrix, *softmax.m_CPUMatrix);
+    else
+        return CPUMatrix<ElemType>::SoftmaxAndCrossEntropy(*labels.m_CPUMatrix, *input.m_CPUMatrix, *softmax.m_CPUMatrix);
+}
+
 /// <summary> c = alpha * (a-b)</summary>
 /// if a, b, c  must have same dim
 /// <param name="alpha">Scalar</param>
@@ -257,6 +257,11 @@ public:
     }
     void SetMatrixFromCSCFormat(const CPUSPARSE_INDEX_TYPE* h_CSCCol, const CPUSPARSE_INDEX_TYPE* h_Row, const ElemType* h_Val,
                                 const size_t nz, const size_t numRows, const size_t numCols);
+    // If this is a sparse matrix on the CPU, sizes it for nz elements in the CSC format and returns its column starts,
+    // row indices and values to be filled in place by the caller. Returns false for any other matrix, which has to be
+    // set with SetMatrixFromCSCFormat() instead.
+    bool TryPrepareCSCFormatBuffers(const size_t nz, const size_t numRows, const size_t numCols,
+                                    CPUSPARSE_INDEX_TYPE*& h_CSCCol, CPUSPARSE_INDEX_TYPE*& h_Row, ElemType*& h_Val);
 
     void MaskColumnsValue(const Matrix<char>& columnsMask, ElemType val);
 
@@ -269,6 +274,8 @@ public:
     void SetUniformRandomValue(const ElemType low, const ElemType high, unsigned long seed = USE_TIME_BASED_SEED);
     void SetGaussianRandomValue(const ElemType mean, const ElemType sigma, unsigned long seed = USE_TIME_BASED_SEED);
     void SetUniformRandomMask(const ElemType maskRate, const ElemType scaleValue, RNGHandle& rngHandle);
+    Matrix<ElemType>& AssignDropoutOf(const Matrix<ElemType>& a, const ElemType maskRate, const ElemType scaleValue, RNGHandle& rngHandle, Matrix<char>& bitMask);
+    Matrix<ElemType>& AddDropoutGradientOf(const Matrix<ElemType>& gradient, const ElemType scaleValue, const Matrix<char>& bitMask);
     void AddGaussianRandomValue(const ElemType mean, const ElemType sigma, unsigned long seed = USE_TIME_BASED_SEED);
     Matrix<ElemType>& AssignNoiseContrastiveEstimation(const Matrix<ElemType>& a, const Matrix<ElemType>& b, const Matrix<ElemType>& c, const Matrix<ElemType>& bias, Matrix<ElemType>& tmp);
 
@@ -518,6 +525,13 @@ public:
     static void SVD(const Matrix<ElemType>& A, Matrix<ElemType>& SIGMA, Matrix<ElemType>& U, Matrix<ElemType>& VT, Matrix<ElemType>& W);
 
     static void MultiplyAndWeightedAdd(ElemType alpha, const Matrix<ElemType>& a, const bool transposeA, const Matrix<ElemType>& b, const bool transposeB, ElemType beta, Matrix<ElemType>& c); // SGEMM
+    // batched SGEMM: c_i = alpha * op(a_i) * op(b_i) + beta * c_i for i < offsetsC.size(), where op(a_i) is m x k, op(b_i) is k x n and c_i is m x n,
+    // and x_i is the dense column-major matrix that starts at element offsetsX[i] of x. Offsets of a and b may repeat to share an operand; the c_i must not overlap.
+    static void BatchMultiplyAndWeightedAdd(ElemType alpha, const Matrix<ElemType>& a, const bool transposeA, const std::vector<size_t>& offsetsA,
+                                            const Matrix<ElemType>& b, const bool transposeB, const std::vector<size_t>& offsetsB,
+                                            ElemType beta, Matrix<ElemType>& c, const std::vector<size_t>& offsetsC, size_t m, size_t n, size_t k);
+    // same for a, b and c that hold batchSize matrices each, as consecutive blocks of columns of equal width
+    static void BatchMultiplyAndWeightedAdd(ElemType alpha, const Matrix<ElemType>& a, const bool transposeA, const Matrix<ElemType>& b, const bool transposeB, ElemType beta, Matrix<ElemType>& c, size_t batchSize);
     static void MultiplyAndAdd(const Matrix<ElemType>& a, const bool transposeA, const Matrix<ElemType>& b, const bool transposeB, Matrix<ElemType>& c);
     static void Multiply(const Matrix<ElemType>& a, const bool transposeA, const Matrix<ElemType>& b, const bool transposeB, Matrix<ElemType>& c);
     static void Multiply(const Matrix<ElemType>& a, const Matrix<ElemType>& b, Matrix<ElemType>& c);
@@ -530,6 +544,8 @@ public:
     static void AssignScaledDifference(const ElemType alpha, const Matrix<ElemType>& a, const Matrix<ElemType>& b, Matrix<ElemType>& c);
     static void AddScaledDifference(const Matrix<ElemType>& alpha, const Matrix<ElemType>& a, const Matrix<ElemType>& b, Matrix<ElemType>& c); // c += alpha * (a - b)
     static void AssignScaledDifference(const Matrix<ElemType>& alpha, const Matrix<ElemType>& a, const Matrix<ElemType>& b, Matrix<ElemType>& c);
+    // softmax = column-wise softmax of input, returns -sum(labels .* log(softmax)); labels may be sparse. CPU only.
+    static ElemType SoftmaxAndCrossEntropy(const Matrix<ElemType>& labels, const Matrix<ElemType>& input, Matrix<ElemType>& softmax);
 
     static void AddElementToElement(const Matrix<ElemType>& a, const size_t ai, const size_t aj, Matrix<ElemType>& c, const size_t ci, const size_t cj);
     // static void AddLogElementToElement(const Matrix<ElemType>& a, const size_t ai, const size_t aj, Matrix<ElemType>& c, const size_t ci, const size_t cj);
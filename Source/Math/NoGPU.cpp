@@ -1842,6 +1842,12 @@ void GPUMatrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const GPUMatrix
 {
 }
 template <class ElemType>
+void GPUMatrix<ElemType>::BatchMultiplyAndWeightedAdd(ElemType alpha, const GPUMatrix<ElemType>& /*a*/, const bool transposeA, const std::vector<size_t>& offsetsA,
+                                                      const GPUMatrix<ElemType>& /*b*/, const bool transposeB, const std::vector<size_t>& offsetsB,
+                                                      ElemType beta, GPUMatrix<ElemType>& c, const std::vector<size_t>& offsetsC, size_t m, size_t n, size_t k)
+{
+}
+template <class ElemType>
 void GPUMatrix<ElemType>::Multiply1x1AndWeightedAdd(ElemType alpha, const GPUMatrix<ElemType>& lhs, const GPUMatrix<ElemType>& rhs, ElemType beta, GPUMatrix<ElemType>& c)
 {
 }
@@ -158,6 +158,142 @@ DECL ElemType LogAdd(ElemType x, ElemType y)
     }
 }
 
+// -----------------------------------------------------------------------
+// fast approximations of the transcendental functions
+//
+// The CPU tensor ops use these instead of the C library functions under CPUMathFunctions::Fast (CPUFastMath.h).
+// They are branch-free polynomial and rational approximations in single precision (Cephes for exp and log,
+// a 13/6 rational function for tanh); the double versions are the exact functions. Maximum errors against the
+// double precision functions:
+//  - FastExp:     relative 1e-7. Inputs are clamped to [-87, 88], so the result is neither 0 nor inf.
+//  - FastLog:     relative 1e-7, absolute 4e-6 for positive normal numbers. +inf and NaN are returned unchanged.
+//  - FastTanh:    absolute 4e-7
+//  - FastSigmoid: absolute 2e-7, computed as (1 + tanh(z / 2)) / 2
+// CPUFastMath computes the same operations on 4 elements at a time; its results may differ in the last bit.
+// -----------------------------------------------------------------------
+
+DECL float FastExp(float x)
+{
+    // exp(x) = 2^n * exp(r) with r = x - n * log(2) in [-log(2)/2, log(2)/2]
+    float xx = x < -87.0f ? -87.0f : (x > 88.0f ? 88.0f : x);
+    float t = xx * 1.44269504088896341f;
+    int n = (int) (t + (t >= 0 ? 0.5f : -0.5f));
+    float fn = (float) n;
+    float r = xx - fn * 0.693359375f;
+    r = r - fn * -2.12194440e-4f;
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1;
+    union { int i; float f; } scale;
+    scale.i = (n + 127) << 23;
+    return p * scale.f;
+}
+
+DECL float FastLog(float x)
+{
+    // log(x) = e * log(2) + log(m) with m in [sqrt(1/2), sqrt(2))
+    union { float f; int i; } u;
+    u.f = x;
+    bool infOrNaN = ((u.i >> 23) & 0xff) == 0xff;
+    int e = ((u.i >> 23) & 0xff) - 127;
+    u.i = (u.i & 0x007fffff) | 0x3f800000; // mantissa in [1, 2)
+    bool big = u.f > 1.41421356237f;
+    float m = big ? u.f * 0.5f : u.f;
+    float fe = (float) (big ? e + 1 : e);
+    float f = m - 1;
+    float z = f * f;
+    float y = 7.0376836292e-2f;
+    y = y * f - 1.1514610310e-1f;
+    y = y * f + 1.1676998740e-1f;
+    y = y * f - 1.2420140846e-1f;
+    y = y * f + 1.4249322787e-1f;
+    y = y * f - 1.6668057665e-1f;
+    y = y * f + 2.0000714765e-1f;
+    y = y * f - 2.4999993993e-1f;
+    y = y * f + 3.3333331174e-1f;
+    y = y * f * z;
+    y = y + fe * -2.12194440e-4f;
+    y = y - 0.5f * z;
+    float result = f + y + fe * 0.693359375f;
+    return infOrNaN ? x : result;
+}
+
+DECL float FastTanh(float x)
+{
+    // beyond the clamp value tanh(x) rounds to +-1
+    float xx = x < -7.90531110763549805f ? -7.90531110763549805f : (x > 7.90531110763549805f ? 7.90531110763549805f : x);
+    float x2 = xx * xx;
+    float p = -2.76076847742355e-16f;
+    p = p * x2 + 2.00018790482477e-13f;
+    p = p * x2 - 8.60467152213735e-11f;
+    p = p * x2 + 5.12229709037114e-08f;
+    p = p * x2 + 1.48572235717979e-05f;
+    p = p * x2 + 6.37261928875436e-04f;
+    p = p * x2 + 4.89352455891786e-03f;
+    p = p * xx;
+    float q = 1.19825839466702e-06f;
+    q = q * x2 + 1.18534705686654e-04f;
+    q = q * x2 + 2.26843463243900e-03f;
+    q = q * x2 + 4.89352518554385e-03f;
+    return p / q;
+}
+
+DECL float FastSigmoid(float z)
+{
+    return 0.5f + 0.5f * FastTanh(0.5f * z);
+}
+
+DECL double FastExp(double x)
+{
+    return exp_(x);
+}
+
+DECL double FastLog(double x)
+{
+    return log_(x);
+}
+
+DECL double FastTanh(double x)
+{
+    return tanh_(x);
+}
+
+DECL double FastSigmoid(double z)
+{
+    return Sigmoid(z);
+}
+
+template <class ElemType>
+DECL ElemType FastClippedLog(ElemType z)
+{
+    return z < EPS_IN_LOG ? LOG_OF_EPS_IN_LOG : FastLog(z);
+}
+
+template <typename ElemType>
+DECL ElemType FastLogAdd(ElemType x, ElemType y)
+{
+    if (x < y)
+    {
+        ElemType temp = x;
+        x = y;
+        y = temp;
+    }
+    ElemType diff = y - x;
+    if (diff < (ElemType) MINLOGEXP)
+    {
+        return (x < (ElemType) LSMALL) ? (ElemType) LZERO : x;
+    }
+    else
+    {
+        ElemType z = FastExp(diff);
+        return x + FastLog((ElemType) 1.0 + z);
+    }
+}
+
 // IndexElement reindexes a tensor along one dimension.
 // For the indexed dimension, the tensor op is prepared by setting 'a' to be broadcasting along the indexed dimension.
 // I.e. pa = &a points to the first element (as if index == 0).
@@ -245,6 +381,9 @@ DefBinaryOp(ElementwiseProductWithAbsDerivative, a * Sgn(b)); // note: b = input
 DefBinaryOp(ElementwiseProductWithReciprocalDerivative, a * -Sqr(b)); // b = output
 DefBinaryOp(ElementwiseProductWithSqrtDerivative, a / (2 * b)); // b = output; d/dx sqrt(x) = 1/(2 * sqrt(x)) --> note this is the same as ElementwiseQuotient w a constant; if more show up like this we should add more template params
 DefBinaryOp(SqrOfDifference, Sqr(a - b));
+DefBinaryOp(SigmoidOfSum, Sigmoid(a + b)); // fused element-wise nodes: f(a + b) without storing the sum
+DefBinaryOp(TanhOfSum, tanh_(a + b));
+DefBinaryOp(LinearRectifierOfSum, a + b > 0 ? a + b : 0);
 //DefBinaryOp(Index, IndexElement(a, b, i));  // note: this one uses the third argument
 
 #pragma pop_macro("DefBinaryOp")
@@ -261,8 +400,81 @@ DefTernaryOp(Cond, a ? b : c);
 DefTernaryOp(CopyIfEqual, a == b ? c : 0); // CopyIfEqual(a,b)(c) -- if a==b copy c, otherwise 0; used for gradient of clip, min, max, etc.
 DefTernaryOp(Clip, c < a ? a : (c > b ? b : c)); // Clip(min,max)(data) => a=min, b=max, c=data
 DefTernaryOp(ElementwiseProductWithLogSumDerivative, a * Sigmoid(c - b));
+DefTernaryOp(SigmoidOfSumTimes, Sigmoid(a + b) * c); // fused element-wise nodes: f(a + b) * c
+DefTernaryOp(TanhOfSumTimes, tanh_(a + b) * c);
+DefTernaryOp(ElementwiseProductWithSigmoidDerivativeOfSum, a * (Sigmoid(b + c) * (1 - Sigmoid(b + c)))); // note: b + c = input of the sigmoid
+DefTernaryOp(ElementwiseProductWithTanhDerivativeOfSum, a * (1 - Sqr(tanh_(b + c))));
 
 #pragma pop_macro("DefTernaryOp")
+
+// -----------------------------------------------------------------------
+// versions of the ops that use the fast transcendental functions
+//
+// The CPU tensor ops use OpFast<op>() instead of Op<op>() for these ops under CPUMathFunctions::Fast.
+// Each must compute the same as the op of the same name, up to the approximation.
+// -----------------------------------------------------------------------
+
+#define ForAllFastUnaryOps(Macro) \
+    Macro(Sigmoid);               \
+    Macro(Tanh);                  \
+    Macro(Exp);                   \
+    Macro(Log);
+
+#define ForAllFastBinaryOps(Macro)                        \
+    Macro(LogSum);                                        \
+    Macro(ElementwiseProductWithLogDerivativeFromOutput); \
+    Macro(SigmoidOfSum);                                  \
+    Macro(TanhOfSum);
+
+#define ForAllFastTernaryOps(Macro)                      \
+    Macro(ElementwiseProductWithLogSumDerivative);       \
+    Macro(SigmoidOfSumTimes);                            \
+    Macro(TanhOfSumTimes);                               \
+    Macro(ElementwiseProductWithSigmoidDerivativeOfSum); \
+    Macro(ElementwiseProductWithTanhDerivativeOfSum);
+
+#pragma push_macro("DefFastUnaryOp")
+#define DefFastUnaryOp(op, expr)         \
+    template <class ElemType>            \
+    DECL ElemType OpFast##op(ElemType a) \
+    {                                    \
+        return expr;                     \
+    }
+
+DefFastUnaryOp(Sigmoid, FastSigmoid(a));
+DefFastUnaryOp(Tanh, FastTanh(a));
+DefFastUnaryOp(Exp, FastExp(a));
+DefFastUnaryOp(Log, FastClippedLog(a));
+#pragma pop_macro("DefFastUnaryOp")
+
+#pragma push_macro("DefFastBinaryOp")
+#define DefFastBinaryOp(op, expr)                    \
+    template <class ElemType>                        \
+    DECL ElemType OpFast##op(ElemType a, ElemType b) \
+    {                                                \
+        return expr;                                 \
+    }
+
+DefFastBinaryOp(LogSum, FastLogAdd(a, b));
+DefFastBinaryOp(ElementwiseProductWithLogDerivativeFromOutput, a* FastExp(-b));
+DefFastBinaryOp(SigmoidOfSum, FastSigmoid(a + b));
+DefFastBinaryOp(TanhOfSum, FastTanh(a + b));
+#pragma pop_macro("DefFastBinaryOp")
+
+#pragma push_macro("DefFastTernaryOp")
+#define DefFastTernaryOp(op, expr)                               \
+    template <class ElemType>                                    \
+    DECL ElemType OpFast##op(ElemType a, ElemType b, ElemType c) \
+    {                                                            \
+        return expr;                                             \
+    }
+
+DefFastTernaryOp(ElementwiseProductWithLogSumDerivative, a * FastSigmoid(c - b));
+DefFastTernaryOp(SigmoidOfSumTimes, FastSigmoid(a + b) * c);
+DefFastTernaryOp(TanhOfSumTimes, FastTanh(a + b) * c);
+DefFastTernaryOp(ElementwiseProductWithSigmoidDerivativeOfSum, a * (FastSigmoid(b + c) * (1 - FastSigmoid(b + c))));
+DefFastTernaryOp(ElementwiseProductWithTanhDerivativeOfSum, a * (1 - Sqr(FastTanh(b + c))));
+#pragma pop_macro("DefFastTernaryOp")
 }}}
 #pragma pop_macro("DECL")
 #pragma pop_macro("TENSOR_OPS_DECL")
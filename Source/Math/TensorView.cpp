@@ -337,6 +337,41 @@ static void FlattenToMatrix(TensorShape& shape, bool trans, size_t splitPoint)
     assert(shape.GetRank() == 2);
 }
 
+// whether FlattenToMatrix() can flatten the shape
+static bool CanFlattenToMatrix(const TensorShape& shape, bool trans, size_t splitPoint)
+{
+    if (trans)
+        splitPoint = shape.GetRank() - splitPoint;
+    for (size_t k = 1; k < shape.GetRank(); k++)
+        if (k != splitPoint && !shape.CanFlatten(k))
+            return false;
+    return true;
+}
+
+// offsets in the storage object of the matrices of a batched product, for each index of the batch dimensions batchDims,
+// which are the dimensions of 'shape' from firstBatchDim on. A dimension of 1 repeats the same matrix.
+static vector<size_t> GetBatchOffsets(const TensorShape& shape, size_t firstBatchDim, const vector<size_t>& batchDims)
+{
+    size_t batchSize = 1;
+    for (let dim : batchDims)
+        batchSize *= dim;
+    vector<size_t> offsets(batchSize);
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        ptrdiff_t offset = shape.GetOffset();
+        size_t rest = i;
+        for (size_t d = 0; d < batchDims.size(); d++)
+        {
+            let index = (ptrdiff_t) (rest % batchDims[d]);
+            rest /= batchDims[d];
+            if (shape.GetDimPadded(firstBatchDim + d) != 1)
+                offset += index * shape.GetStrides()[firstBatchDim + d];
+        }
+        offsets[i] = (size_t) offset;
+    }
+    return offsets;
+}
+
 // convert tensor into a Matrix object
 template <class ElemType>
 shared_ptr<Matrix<ElemType>> TensorView<ElemType>::AsMatrix() const
@@ -392,6 +427,14 @@ void TensorView<ElemType>::DoMatrixProductOf(ElemType beta, bool transC, const T
     if (numReducedDims * 2 != removedDims)
         InvalidArgument("DoMatrixProductOf: Ranks %s mismatch.", MatrixProductFormat(shapeA, transA, shapeB, transB, shapeC, transC).c_str());
     let firstReducedDim = shapeA.GetRank() - numReducedDims;
+    // Output dimensions with gaps, e.g. the frames of one sequence of a minibatch, cannot be flattened into a single GEMM.
+    // Such products are computed as a batch of GEMMs instead, one for each matrix of b and c.
+    if (!transB && !transC && numReducedDims > 0 && firstReducedDim > 0 &&
+        (!CanFlattenToMatrix(shapeB, transB, numReducedDims) || !CanFlattenToMatrix(shapeC, transC, firstReducedDim)))
+    {
+        DoMatrixProductOfSlices(beta, a, transA, b, alpha, numReducedDims);
+        return;
+    }
     // flatten. This updates shapeA etc.
     FlattenToMatrix(shapeA, transA, firstReducedDim);
     FlattenToMatrix(shapeB, transB, numReducedDims);
@@ -415,6 +458,118 @@ void TensorView<ElemType>::DoMatrixProductOf(ElemType beta, bool transC, const T
         Matrix<ElemType>::MultiplyAndWeightedAdd(alpha, *B, !transB, *A, !transA, beta, *C);
 }
 
+// c = a * b where a flattens into a matrix, and b and c flatten into matrices in their leading dimensions, but not into one
+// matrix each: [I x J] * [J x S x T] -> [I x S x T], where S and T or only T have gaps. Computed as one GEMM of a with each
+// [J x S] (or [J x 1]) matrix of b.
+template <class ElemType>
+void TensorView<ElemType>::DoMatrixProductOfSlices(ElemType beta, const TensorView& a, bool transA, const TensorView& b, ElemType alpha, size_t numReducedDims)
+{
+    auto shapeA = a.m_shape;
+    let& shapeB = b.m_shape;
+    let& shapeC =   m_shape;
+    let numOutputDims = shapeA.GetRank() - numReducedDims;
+    FlattenToMatrix(shapeA, transA, numOutputDims);
+    let m = shapeA[transA];
+    let k = shapeA[1 - transA];
+
+    // size of the matrix dimension formed by the leading dimensions of a shape, which must be dense
+    auto flattenedSize = [](const TensorShape& shape, size_t numDims)
+    {
+        if (shape[0] != 1 && shape.GetStrides()[0] != 1)
+            InvalidArgument("DoMatrixProductOf: Shape [%s] is not dense at dimension 0.", string(shape).c_str());
+        size_t size = shape[0];
+        for (size_t d = 1; d < numDims; d++)
+        {
+            if (!shape.CanFlatten(d))
+                InvalidArgument("DoMatrixProductOf: Shape [%s] is not dense at dimension %d.", string(shape).c_str(), (int)d);
+            size *= shape[d];
+        }
+        return size;
+    };
+    if (shapeA[0] != 1 && shapeA.GetStrides()[0] != 1)
+        InvalidArgument("DoMatrixProductOf: Shape [%s] is not dense at dimension 0.", string(a.m_shape).c_str());
+    if (flattenedSize(shapeB, numReducedDims) != k || flattenedSize(shapeC, numOutputDims) != m ||
+        shapeB.GetRank() - numReducedDims != shapeC.GetRank() - numOutputDims)
+        InvalidArgument("DoMatrixProductOf: Flattened tensor dimensions %s mismatch.", MatrixProductFormat(a.m_shape, transA, shapeB, false, shapeC, false).c_str());
+
+    vector<size_t> batchDims;
+    for (size_t d = numReducedDims; d < shapeB.GetRank(); d++)
+    {
+        if (shapeB[d] != shapeC[numOutputDims + d - numReducedDims])
+            InvalidArgument("DoMatrixProductOf: Tensor dimensions %s mismatch.", MatrixProductFormat(a.m_shape, transA, shapeB, false, shapeC, false).c_str());
+        batchDims.push_back(shapeB[d]);
+    }
+    // the first remaining dimension forms the columns of the matrices if it has no gap in both b and c
+    size_t n = 1;
+    size_t numColumnDims = 0;
+    if (!batchDims.empty() && shapeB.CanFlatten(numReducedDims) && shapeC.CanFlatten(numOutputDims))
+    {
+        n = batchDims.front();
+        numColumnDims = 1;
+        batchDims.erase(batchDims.begin());
+    }
+
+    let offsetsB = GetBatchOffsets(shapeB, numReducedDims + numColumnDims, batchDims);
+    let offsetsC = GetBatchOffsets(shapeC, numOutputDims + numColumnDims, batchDims);
+    vector<size_t> offsetsA(offsetsB.size(), (size_t) shapeA.GetOffset()); // the same a for all products
+
+    // being a matrix product, the output cannot be in-place
+    if (&a == this || &b == this)
+        LogicError("DoMatrixProductOf: The output must not be an input.");
+    Matrix<ElemType>::BatchMultiplyAndWeightedAdd(alpha, a.GetSOB(), transA, offsetsA, b.GetSOB(), false, offsetsB, beta, GetSOB(), offsetsC, m, n, k);
+}
+
+// -------------------------------------------------------------------
+// batched matrix product -- GEMM for each index of the trailing dimensions
+// -------------------------------------------------------------------
+
+template <class ElemType>
+void TensorView<ElemType>::DoBatchMatrixProductOf(ElemType beta, const TensorView& a, bool transA, const TensorView& b, bool transB, ElemType alpha)
+{
+    // the trailing dimensions of a and b are either those of c or 1, i.e. a and b may have lower rank
+    let& shapeC = m_shape;
+    let rank = shapeC.GetRank();
+    let& shapeA = a.m_shape;
+    let& shapeB = b.m_shape;
+    if (rank < 2 || shapeA.GetRank() < 2 || shapeA.GetRank() > rank || shapeB.GetRank() < 2 || shapeB.GetRank() > rank)
+        InvalidArgument("DoBatchMatrixProductOf: Ranks %s mismatch.", MatrixProductFormat(shapeA, transA, shapeB, transB, shapeC, false).c_str());
+
+    let m = shapeC[0];
+    let n = shapeC[1];
+    let k = shapeA[1 - transA];
+    if (shapeA[transA] != m || shapeB[1 - transB] != n || shapeB[transB] != k)
+        InvalidArgument("DoBatchMatrixProductOf: Matrix dimensions %s mismatch.", MatrixProductFormat(shapeA, transA, shapeB, transB, shapeC, false).c_str());
+    auto verifyDense = [](const TensorShape& shape)
+    {
+        if ((shape[0] != 1 && shape.GetStrides()[0] != 1) || !shape.CanFlatten(1))
+            InvalidArgument("DoBatchMatrixProductOf: Shape [%s] is not a dense matrix in its first two dimensions.", string(shape).c_str());
+    };
+    verifyDense(shapeA);
+    verifyDense(shapeB);
+    verifyDense(shapeC);
+
+    for (size_t d = 2; d < rank; d++)
+    {
+        if ((shapeA.GetDimPadded(d) != shapeC[d] && shapeA.GetDimPadded(d) != 1) || (shapeB.GetDimPadded(d) != shapeC[d] && shapeB.GetDimPadded(d) != 1))
+            InvalidArgument("DoBatchMatrixProductOf: Batch dimensions %s mismatch.", MatrixProductFormat(shapeA, transA, shapeB, transB, shapeC, false).c_str());
+        if (shapeC[d] != 1 && shapeC.GetStrides()[d] == 0)
+            InvalidArgument("DoBatchMatrixProductOf: Output [%s] must not broadcast.", string(shapeC).c_str());
+    }
+
+    // offsets of the matrices in the storage objects; a dimension of 1 in a or b repeats the same matrix
+    vector<size_t> batchDims;
+    for (size_t d = 2; d < rank; d++)
+        batchDims.push_back(shapeC[d]);
+    let offsetsA = GetBatchOffsets(shapeA, 2, batchDims);
+    let offsetsB = GetBatchOffsets(shapeB, 2, batchDims);
+    let offsetsC = GetBatchOffsets(shapeC, 2, batchDims);
+
+    // being a matrix product, the output cannot be in-place
+    if (&a == this || &b == this)
+        LogicError("DoBatchMatrixProductOf: The output must not be an input.");
+    Matrix<ElemType>::BatchMultiplyAndWeightedAdd(alpha, a.GetSOB(), transA, offsetsA, b.GetSOB(), transB, offsetsB, beta, GetSOB(), offsetsC, m, n, k);
+}
+
 template class TensorView<float>;
 template class TensorView<double>;
 
@@ -130,7 +130,8 @@ public:
     // Result goes into 'this', and can optionally be added to the existing value.
     // [I x J x K x L] * [K x L x M x N] -> [I x J x M x N] reducing over (K,L)
     // Reduction range is inferred from tensor ranks.
-    // [I x J], [K x L], and [M x N] must each be dense.
+    // [I x J], [K x L], and [M x N] must each be dense. If [M x N] is not dense in b or c (and neither is transposed),
+    // this is done as a batch of GEMMs over M and N instead.
     // Being a matrix product, the output cannot be in-place.
     // If beta == 0, c is not read out, i.e. it can be uninitialized or contain NaNs.
     // -------------------------------------------------------------------
@@ -139,9 +140,22 @@ public:
     void AssignMatrixProductOf(               bool transC, const TensorView& a, bool transA, const TensorView& b, bool transB, ElemType alpha = 1.0f) { DoMatrixProductOf(0,    transC, a, transA, b, transB, alpha); }
     void AddMatrixProductOf   (               bool transC, const TensorView& a, bool transA, const TensorView& b, bool transB, ElemType alpha = 1.0f) { DoMatrixProductOf(1.0f, transC, a, transA, b, transB, alpha); }
 
+    // -------------------------------------------------------------------
+    // batched matrix product -- one GEMM for each index of the trailing dimensions
+    // [I x J x S x T] * [J x K x S x T] -> [I x K x S x T], an independent product for each (s,t)
+    // The leading two dimensions form the matrices, which must be dense. Trailing dimensions of a and b
+    // may be 1 to use the same matrix in all products, e.g. [I x J] * [J x K x S] -> [I x K x S].
+    // -------------------------------------------------------------------
+
+    void DoBatchMatrixProductOf    (ElemType beta, const TensorView& a, bool transA, const TensorView& b, bool transB, ElemType alpha);
+    void AssignBatchMatrixProductOf(               const TensorView& a, bool transA, const TensorView& b, bool transB, ElemType alpha = 1.0f) { DoBatchMatrixProductOf(0,    a, transA, b, transB, alpha); }
+    void AddBatchMatrixProductOf   (               const TensorView& a, bool transA, const TensorView& b, bool transB, ElemType alpha = 1.0f) { DoBatchMatrixProductOf(1.0f, a, transA, b, transB, alpha); }
+
     shared_ptr<Matrix<ElemType>> AsMatrix() const;
 
 private:
+    void DoMatrixProductOfSlices(ElemType beta, const TensorView& a, bool transA, const TensorView& b, ElemType alpha, size_t numReducedDims);
+
     // -------------------------------------------------------------------
     // accessors
     // -------------------------------------------------------------------
@@ -4,6 +4,8 @@
 //
 
 #include "stdafx.h"
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
 #include "CNTKTextFormatReader.h"
 #include "Config.h"
 #include "TextConfigHelper.h"
@@ -24,6 +26,7 @@ CNTKTextFormatReader::CNTKTextFormatReader(MemoryProviderPtr provider,
     m_provider(provider)
 {
     TextConfigHelper configHelper(config);
+    m_traceLevel = configHelper.GetTraceLevel();
 
     try
     {
@@ -38,15 +41,18 @@ CNTKTextFormatReader::CNTKTextFormatReader(MemoryProviderPtr provider,
 
         if (configHelper.ShouldKeepDataInMemory()) 
         {
-            m_deserializer = shared_ptr<IDataDeserializer>(new ChunkCache(m_deserializer));
+            m_chunkCache = make_shared<ChunkCache>(m_deserializer, configHelper.GetCacheSize());
+            m_deserializer = m_chunkCache;
         }
 
+        // Verbosity is a general config parameter, not specific to the text format reader.
+        int verbosity = config(L"verbosity", 0);
         size_t window = configHelper.GetRandomizationWindow();
         if (window > 0)
         {
-            // Verbosity is a general config parameter, not specific to the text format reader.
-            int verbosity = config(L"verbosity", 0);
-            m_randomizer = make_shared<BlockRandomizer>(verbosity, window, m_deserializer);
+            m_randomizer = make_shared<BlockRandomizer>(verbosity, window, m_deserializer,
+                BlockRandomizer::DecimationMode::chunk, false /* useLegacyRandomization */, false /* multithreadedGetNextSequences */,
+                configHelper.GetBucketSize());
         }
         else
         {
@@ -65,7 +71,8 @@ CNTKTextFormatReader::CNTKTextFormatReader(MemoryProviderPtr provider,
         m_packer = std::make_shared<SequencePacker>(
             m_provider,
             m_randomizer,
-            GetStreamDescriptions());
+            GetStreamDescriptions(),
+            verbosity);
         }
     }
     catch (const std::runtime_error& e)
@@ -86,6 +93,15 @@ void CNTKTextFormatReader::StartEpoch(const EpochConfiguration& config)
         RuntimeError("Epoch size cannot be 0.");
     }
 
+    if (m_chunkCache && m_traceLevel >= 2) // info
+    {
+        fprintf(stderr, "CNTKTextFormatReader: chunk cache hits %" PRIu64 ", misses %" PRIu64 ", evictions %" PRIu64 ", %" PRIu64 " bytes in memory\n",
+            m_chunkCache->GetHitCount(),
+            m_chunkCache->GetMissCount(),
+            m_chunkCache->GetEvictionCount(),
+            m_chunkCache->GetSizeInBytes());
+    }
+
     m_randomizer->StartEpoch(config);
     m_packer->StartEpoch(config);
 }
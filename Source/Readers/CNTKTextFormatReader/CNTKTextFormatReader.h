@@ -9,6 +9,7 @@
 #include "Reader.h"
 #include "Packer.h"
 #include "SequenceEnumerator.h"
+#include "ChunkCache.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -33,6 +34,11 @@ public:
 private:
     IDataDeserializerPtr m_deserializer;
 
+    // Chunk cache (if enabled), a proxy around the text parser.
+    std::shared_ptr<ChunkCache> m_chunkCache;
+
+    unsigned int m_traceLevel;
+
     // Randomizer.
     SequenceEnumeratorPtr m_randomizer;
 
@@ -146,7 +146,9 @@ TextConfigHelper::TextConfigHelper(const ConfigParameters& config)
     m_traceLevel = config(L"traceLevel", 1);
     m_chunkSizeBytes = config(L"chunkSizeInBytes", 32 * 1024 * 1024); // 32 MB by default
     m_keepDataInMemory = config(L"keepDataInMemory", false);
+    m_cacheSizeBytes = config(L"cacheSizeInBytes", 0); // unbounded by default
     m_frameMode = config(L"frameMode", false);
+    m_bucketSizeInSamples = config(L"bucketSizeInSamples", 0);
 }
 
 }}}
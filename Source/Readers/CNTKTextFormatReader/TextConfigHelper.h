@@ -37,6 +37,10 @@ public:
 
     bool ShouldKeepDataInMemory() const { return m_keepDataInMemory; }
 
+    size_t GetCacheSize() const { return m_cacheSizeBytes; }
+
+    size_t GetBucketSize() const { return m_bucketSizeInSamples; }
+
     bool IsInFrameMode() const { return m_frameMode; }
 
     ElementType GetElementType() const { return m_elementType; }
@@ -52,8 +56,10 @@ private:
     unsigned int m_maxErrors;
     unsigned int m_traceLevel;
     size_t m_chunkSizeBytes; // chunks size in bytes
-    bool m_keepDataInMemory; // if true the whole dataset is kept in memory
+    bool m_keepDataInMemory; // if true the dataset is kept in memory
+    size_t m_cacheSizeBytes; // memory budget for the in-memory data (0 = unbounded, the whole dataset is kept)
     bool m_frameMode; // if true, the maximum expected sequence length in the dataset is one sample.
+    size_t m_bucketSizeInSamples; // if not 0, the randomizer groups sequences of similar length into buckets of this size.
 };
 
 } } }
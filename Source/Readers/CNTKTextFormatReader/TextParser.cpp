@@ -37,9 +37,19 @@ public:
     // Gets sequences by id.
     void GetSequence(size_t sequenceId, std::vector<SequenceDataPtr>& result) override;
 
+    // Gets the amount of memory occupied by the parsed sequence data.
+    size_t GetSizeInBytes() const override { return m_sizeInBytes; }
+
+    // Adds a loaded sequence to the chunk, creating the sequence data
+    // (views over the input stream buffers) that are handed out by GetSequence.
+    void AddSequence(size_t sequenceId, SequenceBuffer&& sequence);
+
     // A map from sequence ids to the sequence data.
     std::map<size_t, SequenceBuffer> m_sequenceMap;
 
+    // total size of all sequence buffers in bytes
+    size_t m_sizeInBytes;
+
     // chunk id (copied from the descriptor)
     size_t m_id;
 
@@ -227,6 +237,7 @@ void TextParser<ElemType>::GetSequencesForChunk(size_t chunkId, std::vector<Sequ
 
 template <class ElemType>
 TextParser<ElemType>::TextDataChunk::TextDataChunk(const ChunkDescriptor& descriptor, TextParser* parser) :
+    m_sizeInBytes(0),
     m_parser(parser)
 {
     m_id = descriptor.m_id;
@@ -239,36 +250,51 @@ void TextParser<ElemType>::TextDataChunk::GetSequence(size_t sequenceId, std::ve
     assert(it != m_sequenceMap.end());
     result.reserve(m_parser->m_streamInfos.size());
     const auto& sequenceData = it->second;
+
+    // The sequence data is owned by the chunk, handing it out through aliasing
+    // pointers, so that no allocations are required per sequence.
+    ChunkPtr self = shared_from_this();
     for (size_t j = 0; j < m_parser->m_streamInfos.size(); ++j)
     {
-        InputStreamBuffer* input = sequenceData[j].get();
+        result.push_back(SequenceDataPtr(self, sequenceData[j]->m_sequenceData.get()));
+    }
+}
+
+template <class ElemType>
+void TextParser<ElemType>::TextDataChunk::AddSequence(size_t sequenceId, SequenceBuffer&& sequence)
+{
+    for (size_t j = 0; j < m_parser->m_streamInfos.size(); ++j)
+    {
+        InputStreamBuffer* input = sequence[j].get();
         const StreamInfo& stream = m_parser->m_streamInfos[j];
-        SequenceDataPtr data;
+        m_sizeInBytes += input->m_buffer.capacity() * sizeof(ElemType);
+
         if (stream.m_type == StorageType::dense)
         {
-            auto denseData = make_shared<DenseSequenceData>();
+            auto denseData = make_unique<DenseSequenceData>();
             denseData->m_sampleLayout = m_parser->m_streams[j]->m_sampleLayout;
-            data = denseData;
+            input->m_sequenceData = std::move(denseData);
         }
         else
         {
-            auto sparseData = make_shared<SparseSequenceData>();
+            auto sparseData = make_unique<SparseSequenceData>();
             SparseInputStreamBuffer* sparseInput = static_cast<SparseInputStreamBuffer*>(input);
             sparseData->m_indices = sparseInput->m_indices.data();
-            sparseData->m_nnzCounts.reserve(sparseInput->m_nnzCounts.size());
-            copy(sparseInput->m_nnzCounts.begin(), sparseInput->m_nnzCounts.end(),
-                back_inserter(sparseData->m_nnzCounts));
+            sparseData->m_nnzCounts = sparseInput->m_nnzCounts.data();
             sparseData->m_totalNnzCount = sparseInput->m_totalNnzCount;
             assert(input->m_numberOfSamples == sparseInput->m_nnzCounts.size());
-            data = sparseData;
+            input->m_sequenceData = std::move(sparseData);
+            m_sizeInBytes += (sparseInput->m_indices.capacity() + sparseInput->m_nnzCounts.capacity()) * sizeof(IndexType);
         }
 
+        SequenceDataBase* data = input->m_sequenceData.get();
         data->m_data = input->m_buffer.data();
         data->m_numberOfSamples = input->m_numberOfSamples;
-        data->m_chunk = shared_from_this();
         data->m_id = sequenceId;
-        result.push_back(data);
+        m_sizeInBytes += sizeof(*data);
     }
+
+    m_sequenceMap.insert(make_pair(sequenceId, std::move(sequence)));
 }
 
 template <class ElemType>
@@ -295,9 +321,7 @@ void TextParser<ElemType>::LoadChunk(TextChunkPtr& chunk, const ChunkDescriptor&
 {
     for (const auto& sequenceDescriptor : descriptor.m_sequences)
     {
-        chunk->m_sequenceMap.insert(make_pair(
-            sequenceDescriptor.m_id,
-            LoadSequence(sequenceDescriptor)));
+        chunk->AddSequence(sequenceDescriptor.m_id, LoadSequence(sequenceDescriptor));
     }
 }
 
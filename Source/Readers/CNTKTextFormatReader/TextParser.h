@@ -50,6 +50,9 @@ private:
 
         size_t m_numberOfSamples = 0;
         std::vector<ElemType> m_buffer;
+
+        // Sequence data (a view over the buffer) handed out by the chunk.
+        std::unique_ptr<SequenceDataBase> m_sequenceData;
     };
 
     struct DenseInputStreamBuffer : InputStreamBuffer
@@ -77,7 +77,7 @@ CompositeDataReader::CompositeDataReader(const ConfigParameters& config, MemoryP
         deserializer = std::make_shared<Bundler>(config, deserializer, m_deserializers, cleanse);
     }
 
-    int verbosity = config(L"verbosity", 0);
+    m_verbosity = config(L"verbosity", 0);
 
     // Pick up the randomizer.
     bool randomize = config(L"randomize", false);
@@ -91,7 +91,9 @@ CompositeDataReader::CompositeDataReader(const ConfigParameters& config, MemoryP
         size_t randomizationWindow = config(L"randomizationWindow", requestDataSize);
         // By default using STL random number generator.
         bool useLegacyRandomization = config(L"useLegacyRandomization", false);
-        m_sequenceEnumerator = std::make_shared<BlockRandomizer>(verbosity, randomizationWindow, deserializer, BlockRandomizer::DecimationMode::chunk, useLegacyRandomization, multiThreadedDeserialization);
+        // By default not grouping sequences by length, otherwise it is recommended to set the bucket size to the minibatch size.
+        size_t bucketSizeInSamples = config(L"bucketSizeInSamples", 0);
+        m_sequenceEnumerator = std::make_shared<BlockRandomizer>(m_verbosity, randomizationWindow, deserializer, BlockRandomizer::DecimationMode::chunk, useLegacyRandomization, multiThreadedDeserialization, bucketSizeInSamples);
     }
     else
     {
@@ -260,7 +262,8 @@ void CompositeDataReader::StartEpoch(const EpochConfiguration& cfg)
         m_packer = std::make_shared<SequencePacker>(
             m_provider,
             m_sequenceEnumerator,
-            m_streams);
+            m_streams,
+            m_verbosity);
         break;
     case PackingMode::truncated:
     {
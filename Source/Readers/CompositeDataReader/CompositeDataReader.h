@@ -127,6 +127,9 @@ private:
 
     // Truncation length for BPTT mode.
     size_t m_truncationLength;
+
+    // Verbosity of the randomizer and the packer.
+    int m_verbosity;
 };
 
 }}}
@@ -172,6 +172,11 @@ vector<wstring> ConfigHelper::GetMlfPaths() const
     return result;
 }
 
+wstring ConfigHelper::GetMlfCachePath() const
+{
+    return m_config(L"mlfCacheFile", L"");
+}
+
 size_t ConfigHelper::GetRandomizationWindow()
 {
     size_t result = randomizeAuto;
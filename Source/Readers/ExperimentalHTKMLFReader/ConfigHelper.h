@@ -49,6 +49,9 @@ public:
     // Gets mlf file paths from the configuraiton.
     std::vector<std::wstring> GetMlfPaths() const;
 
+    // Gets path of the compiled label cache for the mlf files, empty if the cache is not used.
+    std::wstring GetMlfCachePath() const;
+
     // Gets utterance paths from the configuration.
     std::vector<std::wstring> GetSequencePaths();
 
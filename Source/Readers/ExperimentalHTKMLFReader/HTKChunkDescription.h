@@ -7,6 +7,8 @@
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <future>
+#include <exception>
 #include "DataDeserializer.h"
 #include "../HTKMLFReader/htkfeatio.h"
 #include "UtteranceDescription.h"
@@ -101,7 +103,8 @@ public:
     // Pages-in the data for this chunk.
     // this function supports retrying since we read from the unreliable network, i.e. do not return in a broken state
     // We pass in the feature info variables to check that that data being read has expected properties.
-    void RequireData(const string& featureKind, size_t featureDimension, unsigned int samplePeriod, int verbosity = 0) const
+    // Utterances are split into numberOfThreads consecutive ranges that are read in parallel, each with its own reader.
+    void RequireData(const string& featureKind, size_t featureDimension, unsigned int samplePeriod, int verbosity = 0, size_t numberOfThreads = 1) const
     {
         if (GetNumberOfUtterances() == 0)
         {
@@ -115,26 +118,76 @@ public:
 
         try
         {
-            // feature reader (we reinstantiate it for each block, i.e. we reopen the file actually)
-            // if this is the first feature read ever, we explicitly open the first file to get the information such as feature dimension
-            msra::asr::htkfeatreader reader;
-
-            // read all utterances; if they are in the same archive, htkfeatreader will be efficient in not closing the file
             m_frames.resize(featureDimension, m_totalFrames);
-            foreach_index(i, m_utterances)
+
+            // read a consecutive range of utterances; if they are in the same archive, htkfeatreader will be efficient in not closing the file
+            auto readUtterances = [&](size_t begin, size_t end)
+            {
+                // feature reader (we reinstantiate it for each block, i.e. we reopen the file actually)
+                msra::asr::htkfeatreader reader;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    // read features for this file
+                    auto framesWrapper = GetUtteranceFrames(i);
+                    reader.read(m_utterances[i].GetPath(), featureKind, samplePeriod, framesWrapper);
+                }
+            };
+
+            const size_t numberOfUtterances = m_utterances.size();
+            numberOfThreads = std::max<size_t>(1, std::min(numberOfThreads, numberOfUtterances));
+            if (numberOfThreads == 1)
+            {
+                readUtterances(0, numberOfUtterances);
+            }
+            else
             {
-                // read features for this file
-                auto framesWrapper = GetUtteranceFrames(i);
-                reader.read(m_utterances[i].GetPath(), featureKind, samplePeriod, framesWrapper);
+                // The first range is read on the calling thread. Utterances write into disjoint columns of m_frames.
+                std::vector<std::future<void>> workers;
+                workers.reserve(numberOfThreads - 1);
+                for (size_t t = 1; t < numberOfThreads; ++t)
+                {
+                    workers.push_back(std::async(std::launch::async, readUtterances,
+                        t * numberOfUtterances / numberOfThreads, (t + 1) * numberOfUtterances / numberOfThreads));
+                }
+
+                // All workers must finish before the frames can be released, so we only rethrow the first failure at the end.
+                std::exception_ptr failure;
+                try
+                {
+                    readUtterances(0, numberOfUtterances / numberOfThreads);
+                }
+                catch (...)
+                {
+                    failure = std::current_exception();
+                }
+
+                for (auto& worker : workers)
+                {
+                    try
+                    {
+                        worker.get();
+                    }
+                    catch (...)
+                    {
+                        if (!failure)
+                            failure = std::current_exception();
+                    }
+                }
+
+                if (failure)
+                {
+                    std::rethrow_exception(failure);
+                }
             }
 
             if (verbosity)
             {
-                fprintf(stderr, "HTKChunkDescription::RequireData: read physical chunk %" PRIu64 " (%" PRIu64 " utterances, %" PRIu64 " frames, %" PRIu64 " bytes)\n",
+                fprintf(stderr, "HTKChunkDescription::RequireData: read physical chunk %" PRIu64 " (%" PRIu64 " utterances, %" PRIu64 " frames, %" PRIu64 " bytes, %" PRIu64 " threads)\n",
                         m_chunkId,
                         m_utterances.size(),
                         m_totalFrames,
-                        sizeof(float) * m_frames.rows() * m_frames.cols());
+                        sizeof(float) * m_frames.rows() * m_frames.cols(),
+                        numberOfThreads);
             }
         }
         catch (...)
@@ -171,12 +224,11 @@ public:
         m_frames.resize(0, 0);
     }
 
-    private:
-        // test if data is in memory at the moment
-        bool IsInRam() const
-        {
-            return !m_frames.empty();
-        }
+    // test if data is in memory at the moment
+    bool IsInRam() const
+    {
+        return !m_frames.empty();
+    }
 };
 
 }}}
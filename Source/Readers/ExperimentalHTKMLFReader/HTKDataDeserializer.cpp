@@ -8,6 +8,7 @@
 #include "ConfigHelper.h"
 #include "Basics.h"
 #include <numeric>
+#include <thread>
 
 // TODO: This will be removed when dependency on old code is eliminated.
 // Currently this fixes the linking.
@@ -22,6 +23,12 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
 using namespace std;
 
+// Reading a chunk is dominated by opening many small files, so a few threads are enough to hide the latency.
+static size_t DefaultNumberOfReadThreads()
+{
+    return max<size_t>(1, min<size_t>(thread::hardware_concurrency(), 4));
+}
+
 HTKDataDeserializer::HTKDataDeserializer(
     CorpusDescriptorPtr corpus,
     const ConfigParameters& cfg,
@@ -34,6 +41,7 @@ HTKDataDeserializer::HTKDataDeserializer(
     m_frameMode = (ConfigValue)cfg("frameMode", "true");
 
     m_verbosity = cfg(L"verbosity", 0);
+    m_numberOfReadThreads = cfg(L"readThreads", DefaultNumberOfReadThreads());
 
     argvector<ConfigValue> inputs = cfg("input");
     if (inputs.size() != 1)
@@ -76,6 +84,7 @@ HTKDataDeserializer::HTKDataDeserializer(
     config.CheckFeatureType();
 
     m_verbosity = feature(L"verbosity", 0);
+    m_numberOfReadThreads = feature(L"readThreads", DefaultNumberOfReadThreads());
 
     auto context = config.GetContextWindow();
     m_elementType = config.GetElementType();
@@ -176,6 +185,8 @@ void HTKDataDeserializer::InitializeChunkDescriptions(ConfigHelper& config)
         currentChunk.Add(move(utterances[i]));
     }
 
+    m_loadedChunks.resize(m_chunks.size());
+
     fprintf(stderr,
         "HTKDataDeserializer::HTKDataDeserializer: %d utterances grouped into %d chunks, av. chunk size: %.1f utterances, %.1f frames\n",
         (int)utterances.size(),
@@ -310,7 +321,7 @@ public:
         // making several attempts
         msra::util::attempt(5, [&]()
         {
-            chunkDescription.RequireData(m_parent->m_featureKind, m_parent->m_ioFeatureDimension, m_parent->m_samplePeriod, m_parent->m_verbosity);
+            chunkDescription.RequireData(m_parent->m_featureKind, m_parent->m_ioFeatureDimension, m_parent->m_samplePeriod, m_parent->m_verbosity, m_parent->m_numberOfReadThreads);
         });
     }
 
@@ -336,9 +347,52 @@ private:
 // Gets a data chunk with the specified chunk id.
 ChunkPtr HTKDataDeserializer::GetChunk(size_t chunkId)
 {
-    return make_shared<HTKChunk>(this, chunkId);
+    ChunkPtr chunk;
+    if (m_prefetchedChunkId == chunkId)
+    {
+        m_prefetchedChunkId = SIZE_MAX;
+        try
+        {
+            chunk = m_prefetchedChunk.get();
+        }
+        catch (const exception& e)
+        {
+            // The chunk is loaded again below, so that a persistent failure is reported at the point of use.
+            fprintf(stderr, "HTKDataDeserializer::GetChunk: prefetch of chunk %" PRIu64 " failed (%s), reading it synchronously\n", chunkId, e.what());
+        }
+    }
+
+    if (!chunk)
+    {
+        chunk = make_shared<HTKChunk>(this, chunkId);
+    }
+
+    m_loadedChunks[chunkId] = chunk;
+    return chunk;
 };
 
+// Loads the chunk on a background thread.
+// Only a single chunk is prefetched at a time, an unclaimed prefetched chunk is released when the next one is requested.
+void HTKDataDeserializer::PrefetchChunk(size_t chunkId)
+{
+    if (m_prefetchedChunkId == chunkId || !m_loadedChunks[chunkId].expired())
+    {
+        return;
+    }
+
+    if (m_prefetchedChunk.valid())
+    {
+        // Waits for the previous load, the chunk is released if nobody has claimed it.
+        m_prefetchedChunk = future<ChunkPtr>();
+    }
+
+    m_prefetchedChunkId = chunkId;
+    m_prefetchedChunk = async(launch::async, [this, chunkId]() -> ChunkPtr
+    {
+        return make_shared<HTKChunk>(this, chunkId);
+    });
+}
+
 // A matrix that stores all samples of a sequence without padding (differently from ssematrix).
 // The number of columns equals the number of samples in the sequence.
 // The number of rows equals the size of the feature vector of a sample (= dimensions).
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <future>
 #include "DataDeserializerBase.h"
 #include "Config.h"
 #include "CorpusDescriptor.h"
@@ -34,6 +35,9 @@ public:
     // Retrieves data for a chunk.
     virtual ChunkPtr GetChunk(size_t chunkId) override;
 
+    // Starts loading the chunk in the background, the following GetChunk for it picks up the result.
+    virtual void PrefetchChunk(size_t chunkId) override;
+
     // Gets sequence description by its key.
     virtual void GetSequenceDescriptionByKey(const KeyType&, SequenceDescription&) override;
 
@@ -84,6 +88,21 @@ private:
     unsigned int m_samplePeriod = 0;
     size_t m_ioFeatureDimension = 0;
     std::string m_featureKind;
+
+    // Number of threads used to read utterances of a chunk in parallel.
+    size_t m_numberOfReadThreads;
+
+    // Chunks handed out by GetChunk, used to skip the prefetch of a chunk that is still in memory.
+    // The background load writes the frames of a chunk description, so PrefetchChunk must not look at those;
+    // whether a weak pointer has expired can be checked while another thread drops the last reference.
+    std::vector<std::weak_ptr<Chunk>> m_loadedChunks;
+
+    // Chunk that is currently being loaded in the background and its id (SIZE_MAX if none).
+    // Prefetch and GetChunk are called from the thread that drives the randomizer, the background
+    // thread only constructs the chunk and hands it over through the future.
+    // Declared after m_chunks on purpose: a pending load has to finish before chunk descriptions are destroyed.
+    size_t m_prefetchedChunkId = SIZE_MAX;
+    std::future<ChunkPtr> m_prefetchedChunk;
 };
 
 typedef std::shared_ptr<HTKDataDeserializer> HTKDataDeserializerPtr;
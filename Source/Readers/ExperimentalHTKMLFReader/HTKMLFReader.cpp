@@ -150,7 +150,7 @@ HTKMLFReader::HTKMLFReader(MemoryProviderPtr provider,
         m_packer = std::make_shared<FramePacker>(m_provider, m_randomizer, m_streams);
         break;
     case PackingMode::sequence:
-        m_packer = std::make_shared<SequencePacker>(m_provider, m_randomizer, m_streams);
+        m_packer = std::make_shared<SequencePacker>(m_provider, m_randomizer, m_streams, verbosity);
         break;
     case PackingMode::truncated:
         m_packer = std::make_shared<TruncatedBPTTPacker>(m_provider, m_randomizer, m_streams);
@@ -8,6 +8,7 @@
 #include <inttypes.h>
 #include <limits>
 #include "MLFDataDeserializer.h"
+#include "MLFLabelCache.h"
 #include "ConfigHelper.h"
 #include "../HTKMLFReader/htkfeatio.h"
 #include "../HTKMLFReader/msra_mgram.h"
@@ -21,6 +22,7 @@ using namespace std;
 
 static float s_oneFloat = 1.0;
 static double s_oneDouble = 1.0;
+static IndexType s_oneIndex = 1;
 
 // Currently we only have a single mlf chunk that contains a vector of all labels.
 // TODO: In the future MLF should be converted to a more compact format that is amenable to chunking.
@@ -37,12 +39,6 @@ public:
     }
 };
 
-// Inner class for an utterance.
-struct MLFUtterance : SequenceDescription
-{
-    size_t m_sequenceStart;
-};
-
 MLFDataDeserializer::MLFDataDeserializer(CorpusDescriptorPtr corpus, const ConfigParameters& cfg, bool primary)
 {
     // TODO: This should be read in one place, potentially given by SGD.
@@ -102,26 +98,14 @@ void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus
     // TODO: Similarly to the old reader, currently we assume all Mlfs will have same root name (key)
     // restrict MLF reader to these files--will make stuff much faster without having to use shortened input files
 
-    // TODO: currently we do not use symbol and word tables.
-    const msra::lm::CSymbolSet* wordTable = nullptr;
-    unordered_map<const char*, int>* symbolTable = nullptr;
     vector<wstring> mlfPaths = config.GetMlfPaths();
+    wstring cachePath = config.GetMlfCachePath();
 
     // TODO: Currently we still use the old IO module. This will be refactored later.
     const double htkTimeToFrame = 100000.0; // default is 10ms
-    msra::asr::htkmlfreader<msra::asr::htkmlfentry, msra::lattices::lattice::htkmlfwordsequence> labels(mlfPaths, set<wstring>(), stateListPath, wordTable, symbolTable, htkTimeToFrame);
-
-    // Make sure 'msra::asr::htkmlfreader' type has a move constructor
-    static_assert(
-        is_move_constructible<
-        msra::asr::htkmlfreader<msra::asr::htkmlfentry,
-        msra::lattices::lattice::htkmlfwordsequence >> ::value,
-        "Type 'msra::asr::htkmlfreader' should be move constructible!");
 
     m_elementType = config.GetElementType();
 
-    MLFUtterance description;
-    description.m_isValid = true;
     size_t numClasses = 0;
     size_t totalFrames = 0;
 
@@ -129,60 +113,95 @@ void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus
 
     // TODO resize m_keyToSequence with number of IDs from string registry
 
-    for (const auto& l : labels)
+    if (!cachePath.empty())
     {
-        // Currently the string registry contains only utterances described in scp.
-        // So here we skip all others.
-        size_t id = 0;
-        if (!stringRegistry.TryGet(l.first, id))
-            continue;
-
-        description.m_key.m_sequence = id;
-
-        const auto& utterance = l.second;
-        description.m_sequenceStart = m_classIds.size();
-        description.m_isValid = true;
-        size_t numberOfFrames = 0;
-
-        foreach_index(i, utterance)
+        // Labels come from the compiled cache, only utterances known to the string registry are looked up.
+        MLFLabelCache labels(cachePath, mlfPaths, stateListPath, htkTimeToFrame);
+        for (size_t id = 0; id < stringRegistry.Size(); ++id)
         {
-            const auto& timespan = utterance[i];
-            if ((i == 0 && timespan.firstframe != 0) ||
-                (i > 0 && utterance[i - 1].firstframe + utterance[i - 1].numframes != timespan.firstframe))
-            {
-                RuntimeError("Labels are not in the consecutive order MLF in label set: %ls", l.first.c_str());
-            }
+            size_t utterance = labels.Find(msra::strfun::utf8(stringRegistry[id]));
+            if (utterance == SIZE_MAX)
+                continue;
 
-            if (timespan.classid >= dimension)
+            size_t numberOfRuns = 0;
+            const MLFLabelCache::Run* runs = labels.GetRuns(utterance, numberOfRuns);
+            for (size_t i = 0; i < numberOfRuns; ++i)
             {
-                RuntimeError("Class id %d exceeds the model output dimension %d.", (int)timespan.classid, (int)dimension);
+                if (runs[i].m_classId >= dimension)
+                {
+                    RuntimeError("Class id %d exceeds the model output dimension %d.", (int)runs[i].m_classId, (int)dimension);
+                }
+
+                if (runs[i].m_classId != static_cast<msra::dbn::CLASSIDTYPE>(runs[i].m_classId))
+                {
+                    RuntimeError("CLASSIDTYPE has too few bits");
+                }
+
+                numClasses = max(numClasses, (size_t)(1u + runs[i].m_classId));
+                for (size_t t = 0; t < runs[i].m_numberOfFrames; t++)
+                {
+                    m_classIds.push_back(static_cast<msra::dbn::CLASSIDTYPE>(runs[i].m_classId));
+                }
             }
 
-            if (timespan.classid != static_cast<msra::dbn::CLASSIDTYPE>(timespan.classid))
-            {
-                RuntimeError("CLASSIDTYPE has too few bits");
-            }
+            AddUtterance(id, labels.GetNumberOfFrames(utterance), totalFrames);
+        }
+    }
+    else
+    {
+        // TODO: currently we do not use symbol and word tables.
+        const msra::lm::CSymbolSet* wordTable = nullptr;
+        unordered_map<const char*, int>* symbolTable = nullptr;
+        msra::asr::htkmlfreader<msra::asr::htkmlfentry, msra::lattices::lattice::htkmlfwordsequence> labels(mlfPaths, set<wstring>(), stateListPath, wordTable, symbolTable, htkTimeToFrame);
+
+        // Make sure 'msra::asr::htkmlfreader' type has a move constructor
+        static_assert(
+            is_move_constructible<
+            msra::asr::htkmlfreader<msra::asr::htkmlfentry,
+            msra::lattices::lattice::htkmlfwordsequence >> ::value,
+            "Type 'msra::asr::htkmlfreader' should be move constructible!");
+
+        for (const auto& l : labels)
+        {
+            // Currently the string registry contains only utterances described in scp.
+            // So here we skip all others.
+            size_t id = 0;
+            if (!stringRegistry.TryGet(l.first, id))
+                continue;
 
-            numClasses = max(numClasses, (size_t)(1u + timespan.classid));
+            const auto& utterance = l.second;
+            size_t numberOfFrames = 0;
 
-            for (size_t t = timespan.firstframe; t < timespan.firstframe + timespan.numframes; t++)
+            foreach_index(i, utterance)
             {
-                m_classIds.push_back(timespan.classid);
-                numberOfFrames++;
+                const auto& timespan = utterance[i];
+                if ((i == 0 && timespan.firstframe != 0) ||
+                    (i > 0 && utterance[i - 1].firstframe + utterance[i - 1].numframes != timespan.firstframe))
+                {
+                    RuntimeError("Labels are not in the consecutive order MLF in label set: %ls", l.first.c_str());
+                }
+
+                if (timespan.classid >= dimension)
+                {
+                    RuntimeError("Class id %d exceeds the model output dimension %d.", (int)timespan.classid, (int)dimension);
+                }
+
+                if (timespan.classid != static_cast<msra::dbn::CLASSIDTYPE>(timespan.classid))
+                {
+                    RuntimeError("CLASSIDTYPE has too few bits");
+                }
+
+                numClasses = max(numClasses, (size_t)(1u + timespan.classid));
+
+                for (size_t t = timespan.firstframe; t < timespan.firstframe + timespan.numframes; t++)
+                {
+                    m_classIds.push_back(timespan.classid);
+                    numberOfFrames++;
+                }
             }
-        }
 
-        description.m_numberOfSamples = numberOfFrames;
-        m_utteranceIndex.push_back(totalFrames);
-        totalFrames += numberOfFrames;
-
-        if (m_keyToSequence.size() <= description.m_key.m_sequence)
-        {
-            m_keyToSequence.resize(description.m_key.m_sequence + 1, SIZE_MAX);
+            AddUtterance(id, numberOfFrames, totalFrames);
         }
-        assert(m_keyToSequence[description.m_key.m_sequence] == SIZE_MAX);
-        m_keyToSequence[description.m_key.m_sequence] = m_utteranceIndex.size() - 1;
-        m_numberOfSequences++;
     }
     m_utteranceIndex.push_back(totalFrames);
 
@@ -201,8 +220,7 @@ void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus
         SparseSequenceDataPtr category = make_shared<SparseSequenceData>();
         m_categoryIndices.push_back(static_cast<IndexType>(i));
         category->m_indices = &(m_categoryIndices[i]);
-        category->m_nnzCounts.resize(1);
-        category->m_nnzCounts[0] = 1;
+        category->m_nnzCounts = &s_oneIndex;
         category->m_totalNnzCount = 1;
         category->m_numberOfSamples = 1;
         if (m_elementType == ElementType::tfloat)
@@ -218,6 +236,21 @@ void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus
     }
 }
 
+// Registers an utterance whose labels have just been appended to m_classIds.
+void MLFDataDeserializer::AddUtterance(size_t id, size_t numberOfFrames, size_t& totalFrames)
+{
+    m_utteranceIndex.push_back(totalFrames);
+    totalFrames += numberOfFrames;
+
+    if (m_keyToSequence.size() <= id)
+    {
+        m_keyToSequence.resize(id + 1, SIZE_MAX);
+    }
+    assert(m_keyToSequence[id] == SIZE_MAX);
+    m_keyToSequence[id] = m_utteranceIndex.size() - 1;
+    m_numberOfSequences++;
+}
+
 void MLFDataDeserializer::InitializeStream(const wstring& name, size_t dimension)
 {
     // Initializing stream description - a single stream of MLF data.
@@ -263,10 +296,12 @@ template <class ElemType>
 struct MLFSequenceData : SparseSequenceData
 {
     vector<ElemType> m_values;
+    vector<IndexType> m_nnzCountValues;
     unique_ptr<IndexType[]> m_indicesPtr;
 
     MLFSequenceData(size_t numberOfSamples) :
         m_values(numberOfSamples, 1),
+        m_nnzCountValues(numberOfSamples, static_cast<IndexType>(1)),
         m_indicesPtr(new IndexType[numberOfSamples])
     {
         if (numberOfSamples > numeric_limits<IndexType>::max())
@@ -276,7 +311,7 @@ struct MLFSequenceData : SparseSequenceData
                 numberOfSamples, (size_t)numeric_limits<IndexType>::max());
         }
 
-        m_nnzCounts.resize(numberOfSamples, static_cast<IndexType>(1));
+        m_nnzCounts = m_nnzCountValues.data();
         m_numberOfSamples = numberOfSamples;
         m_totalNnzCount = static_cast<IndexType>(numberOfSamples);
         m_indices = m_indicesPtr.get();
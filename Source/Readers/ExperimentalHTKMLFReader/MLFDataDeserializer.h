@@ -43,6 +43,7 @@ private:
 
     void InitializeChunkDescriptions(CorpusDescriptorPtr corpus, const ConfigHelper& config, const std::wstring& stateListPath, size_t dimension);
     void InitializeStream(const std::wstring& name, size_t dimension);
+    void AddUtterance(size_t id, size_t numberOfFrames, size_t& totalFrames);
 
     void GetSequenceById(size_t sequenceId, std::vector<SequenceDataPtr>& result);
 
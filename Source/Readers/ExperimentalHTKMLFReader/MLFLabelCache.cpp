@@ -0,0 +1,323 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <limits>
+#include "MLFLabelCache.h"
+#include "../HTKMLFReader/htkfeatio.h"
+#include "../HTKMLFReader/msra_mgram.h"
+#include "latticearchive.h"
+
+#undef max // max is defined in minwindef.h
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+using namespace std;
+
+static const char s_magic[8] = { 'M', 'L', 'F', 'C', 'A', 'C', 'H', 'E' };
+static const uint32_t s_byteOrderMark = 0x01020304;
+static const uint32_t s_version = 1;
+
+// Layout of the cache file, all offsets are in bytes from the beginning of the file and 8-byte aligned.
+struct MLFLabelCache::Header
+{
+    char m_magic[8];
+    uint32_t m_byteOrder;
+    uint32_t m_version;
+    uint64_t m_numberOfUtterances;
+    uint64_t m_numberOfRuns;
+    uint64_t m_hashTableSize;    // power of two
+    uint64_t m_utterancesOffset; // Utterance[m_numberOfUtterances]
+    uint64_t m_runsOffset;       // Run[m_numberOfRuns]
+    uint64_t m_hashTableOffset;  // uint32_t[m_hashTableSize], utterance index + 1, 0 for an empty slot
+    uint64_t m_keysOffset;       // 0-terminated UTF-8 keys
+    uint64_t m_sourcesOffset;    // 0-terminated description of the sources
+    uint64_t m_fileSize;
+};
+
+struct MLFLabelCache::Utterance
+{
+    uint64_t m_firstRun;
+    uint64_t m_keyOffset; // relative to m_keysOffset
+    uint32_t m_numberOfRuns;
+    uint32_t m_numberOfFrames;
+};
+
+MLFLabelCache::MLFLabelCache(const wstring& cachePath, const vector<wstring>& mlfPaths, const wstring& stateListPath, double htkTimeToFrame)
+    : m_header(nullptr), m_utterances(nullptr), m_runs(nullptr), m_hashTable(nullptr), m_keys(nullptr)
+{
+    string sources = DescribeSources(mlfPaths, stateListPath, htkTimeToFrame);
+    if (TryOpen(cachePath, mlfPaths, stateListPath, sources))
+    {
+        fprintf(stderr, "MLFLabelCache: using label cache '%ls' with %" PRIu64 " utterances\n", cachePath.c_str(), GetNumberOfUtterances());
+        return;
+    }
+
+    fprintf(stderr, "MLFLabelCache: label cache '%ls' is missing or stale, compiling it from %d MLF file(s)\n", cachePath.c_str(), (int)mlfPaths.size());
+    Build(cachePath, mlfPaths, stateListPath, htkTimeToFrame, sources);
+    if (!TryOpen(cachePath, mlfPaths, stateListPath, sources))
+    {
+        RuntimeError("MLFLabelCache: cannot open the label cache '%ls' after compiling it.", cachePath.c_str());
+    }
+}
+
+string MLFLabelCache::DescribeSources(const vector<wstring>& mlfPaths, const wstring& stateListPath, double htkTimeToFrame)
+{
+    string result;
+    for (const auto& path : mlfPaths)
+    {
+        result += msra::strfun::strprintf("mlf %" PRId64 " %s\n", filesize64(path.c_str()), msra::strfun::utf8(path).c_str());
+    }
+
+    if (!stateListPath.empty())
+    {
+        result += msra::strfun::strprintf("statelist %" PRId64 " %s\n", filesize64(stateListPath.c_str()), msra::strfun::utf8(stateListPath).c_str());
+    }
+
+    result += msra::strfun::strprintf("htktimetoframe %.1f\n", htkTimeToFrame);
+    return result;
+}
+
+bool MLFLabelCache::TryOpen(const wstring& cachePath, const vector<wstring>& mlfPaths, const wstring& stateListPath, const string& sources)
+{
+    if (!fexists(cachePath))
+    {
+        return false;
+    }
+
+    // The cache has to be at least as new as all its sources.
+    for (const auto& path : mlfPaths)
+    {
+        if (!msra::files::fuptodate(cachePath, path))
+        {
+            return false;
+        }
+    }
+
+    if (!stateListPath.empty() && !msra::files::fuptodate(cachePath, stateListPath))
+    {
+        return false;
+    }
+
+    unique_ptr<msra::files::mappedfile> file(new msra::files::mappedfile(cachePath));
+    const char* data = file->data();
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (file->size() < sizeof(Header) ||
+        memcmp(header->m_magic, s_magic, sizeof(s_magic)) != 0 ||
+        header->m_byteOrder != s_byteOrderMark ||
+        header->m_version != s_version ||
+        header->m_fileSize != file->size() ||
+        header->m_sourcesOffset >= header->m_fileSize ||
+        data[header->m_fileSize - 1] != 0)
+    {
+        fprintf(stderr, "MLFLabelCache: ignoring label cache '%ls' with unexpected format.\n", cachePath.c_str());
+        return false;
+    }
+
+    if (sources != data + header->m_sourcesOffset)
+    {
+        return false;
+    }
+
+    m_header = header;
+    m_utterances = reinterpret_cast<const Utterance*>(data + header->m_utterancesOffset);
+    m_runs = reinterpret_cast<const Run*>(data + header->m_runsOffset);
+    m_hashTable = reinterpret_cast<const uint32_t*>(data + header->m_hashTableOffset);
+    m_keys = data + header->m_keysOffset;
+    m_file = move(file);
+    return true;
+}
+
+// FNV-1a hash of a 0-terminated string.
+uint64_t MLFLabelCache::Hash(const char* key)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (; *key; key++)
+    {
+        hash ^= (unsigned char)*key;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Appends padding to align the end of the buffer to 8 bytes and returns the new size.
+static uint64_t Align(vector<char>& buffer)
+{
+    buffer.resize((buffer.size() + 7) / 8 * 8, 0);
+    return buffer.size();
+}
+
+template <class T>
+static uint64_t Append(vector<char>& buffer, const T* data, size_t count)
+{
+    uint64_t offset = Align(buffer);
+    const char* bytes = reinterpret_cast<const char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+    return offset;
+}
+
+// Moves the file over the cache in one step. renameOrDie() cannot be used here, since it deletes the target
+// first, so a concurrent reader could find no cache at all.
+static bool ReplaceCacheFile(const wstring& from, const wstring& to)
+{
+#ifdef _WIN32
+    return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(wtocharpath(from).c_str(), wtocharpath(to).c_str()) == 0;
+#endif
+}
+
+void MLFLabelCache::Build(const wstring& cachePath, const vector<wstring>& mlfPaths, const wstring& stateListPath, double htkTimeToFrame, const string& sources)
+{
+    // TODO: currently we do not use symbol and word tables.
+    const msra::lm::CSymbolSet* wordTable = nullptr;
+    unordered_map<const char*, int>* symbolTable = nullptr;
+    msra::asr::htkmlfreader<msra::asr::htkmlfentry, msra::lattices::lattice::htkmlfwordsequence> labels(mlfPaths, set<wstring>(), stateListPath, wordTable, symbolTable, htkTimeToFrame);
+
+    vector<Utterance> utterances;
+    vector<Run> runs;
+    string keys;
+    utterances.reserve(labels.size());
+    for (const auto& l : labels)
+    {
+        const auto& utterance = l.second;
+        Utterance u;
+        u.m_firstRun = runs.size();
+        u.m_keyOffset = keys.size();
+        u.m_numberOfRuns = 0;
+        u.m_numberOfFrames = 0;
+
+        foreach_index(i, utterance)
+        {
+            const auto& timespan = utterance[i];
+            if ((i == 0 && timespan.firstframe != 0) ||
+                (i > 0 && utterance[i - 1].firstframe + utterance[i - 1].numframes != timespan.firstframe))
+            {
+                RuntimeError("Labels are not in the consecutive order MLF in label set: %ls", l.first.c_str());
+            }
+
+            if (timespan.classid > numeric_limits<uint32_t>::max())
+            {
+                RuntimeError("MLFLabelCache: class id %" PRIu64 " does not fit into the label cache.", (size_t)timespan.classid);
+            }
+
+            // Merging adjacent runs of the same state.
+            if (u.m_numberOfRuns > 0 && runs.back().m_classId == timespan.classid)
+            {
+                runs.back().m_numberOfFrames += timespan.numframes;
+            }
+            else
+            {
+                runs.push_back(Run{ (uint32_t)timespan.classid, (uint32_t)timespan.numframes });
+                u.m_numberOfRuns++;
+            }
+            u.m_numberOfFrames += timespan.numframes;
+        }
+
+        keys += msra::strfun::utf8(l.first);
+        keys.push_back(0);
+        utterances.push_back(u);
+    }
+
+    if (utterances.size() >= numeric_limits<uint32_t>::max())
+    {
+        RuntimeError("MLFLabelCache: too many utterances (%" PRIu64 ") for the label cache.", utterances.size());
+    }
+
+    // Hash table with linear probing, at most half full.
+    uint64_t hashTableSize = 1;
+    while (hashTableSize < 2 * utterances.size())
+    {
+        hashTableSize *= 2;
+    }
+
+    vector<uint32_t> hashTable(hashTableSize, 0);
+    for (size_t i = 0; i < utterances.size(); ++i)
+    {
+        uint64_t slot = Hash(keys.c_str() + utterances[i].m_keyOffset) & (hashTableSize - 1);
+        while (hashTable[slot] != 0)
+        {
+            slot = (slot + 1) & (hashTableSize - 1);
+        }
+        hashTable[slot] = (uint32_t)(i + 1);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, s_magic, sizeof(s_magic));
+    header.m_byteOrder = s_byteOrderMark;
+    header.m_version = s_version;
+    header.m_numberOfUtterances = utterances.size();
+    header.m_numberOfRuns = runs.size();
+    header.m_hashTableSize = hashTableSize;
+
+    vector<char> buffer(sizeof(Header));
+    header.m_utterancesOffset = Append(buffer, utterances.data(), utterances.size());
+    header.m_runsOffset = Append(buffer, runs.data(), runs.size());
+    header.m_hashTableOffset = Append(buffer, hashTable.data(), hashTable.size());
+    header.m_keysOffset = Append(buffer, keys.data(), keys.size());
+    header.m_sourcesOffset = Append(buffer, sources.c_str(), sources.size() + 1);
+    header.m_fileSize = buffer.size();
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // Several processes may compile the same cache at once, so each writes its own temporary file
+    // and atomically renames it at the end.
+    wstring tmpPath = cachePath + msra::strfun::wstrprintf(L".%d$$", (int)GetCurrentProcessId());
+    {
+        auto_file_ptr f(fopenOrDie(tmpPath, L"wb"));
+        fwriteOrDie(buffer.data(), 1, buffer.size(), f);
+        fflushOrDie(f);
+    }
+
+    if (!ReplaceCacheFile(tmpPath, cachePath))
+    {
+        // Another process may have compiled the cache and mapped it meanwhile, the caller opens that one if it is valid.
+        fprintf(stderr, "MLFLabelCache: could not replace '%ls', keeping the existing label cache\n", cachePath.c_str());
+        unlinkOrDie(tmpPath);
+        return;
+    }
+
+    fprintf(stderr, "MLFLabelCache: compiled %" PRIu64 " utterances with %" PRIu64 " runs into '%ls' (%" PRIu64 " bytes)\n",
+            utterances.size(), runs.size(), cachePath.c_str(), buffer.size());
+}
+
+size_t MLFLabelCache::GetNumberOfUtterances() const
+{
+    return (size_t)m_header->m_numberOfUtterances;
+}
+
+size_t MLFLabelCache::Find(const string& key) const
+{
+    const uint64_t mask = m_header->m_hashTableSize - 1;
+    for (uint64_t slot = Hash(key.c_str()) & mask; m_hashTable[slot] != 0; slot = (slot + 1) & mask)
+    {
+        size_t utterance = m_hashTable[slot] - 1;
+        if (key == GetKey(utterance))
+        {
+            return utterance;
+        }
+    }
+    return SIZE_MAX;
+}
+
+const char* MLFLabelCache::GetKey(size_t utterance) const
+{
+    return m_keys + m_utterances[utterance].m_keyOffset;
+}
+
+size_t MLFLabelCache::GetNumberOfFrames(size_t utterance) const
+{
+    return m_utterances[utterance].m_numberOfFrames;
+}
+
+const MLFLabelCache::Run* MLFLabelCache::GetRuns(size_t utterance, size_t& numberOfRuns) const
+{
+    numberOfRuns = m_utterances[utterance].m_numberOfRuns;
+    return m_runs + m_utterances[utterance].m_firstRun;
+}
+
+}}}
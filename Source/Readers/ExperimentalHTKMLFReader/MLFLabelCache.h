@@ -0,0 +1,80 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "fileutil.h"
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Class represents a compiled binary form of MLF label files.
+// Parsing large text MLFs at startup is expensive, so the labels are compiled once into a cache file
+// that is memory-mapped on subsequent runs. The cache contains:
+//  - a table of utterances, each with its key and a range of runs,
+//  - run-length encoded state sequences (class id and number of frames per run),
+//  - an open addressing hash table for looking up utterances by key.
+// The cache remembers the MLF files, the state list and their sizes it was compiled from. It is rebuilt
+// if any of them has changed or is newer than the cache.
+// All data are stored in the native byte order; the cache is rejected and rebuilt on a machine with a different one.
+class MLFLabelCache
+{
+public:
+    // A run of frames with the same class id.
+    struct Run
+    {
+        uint32_t m_classId;
+        uint32_t m_numberOfFrames;
+    };
+
+    // Opens the cache, compiling it first from the MLF files if it does not exist or is stale.
+    MLFLabelCache(const std::wstring& cachePath, const std::vector<std::wstring>& mlfPaths, const std::wstring& stateListPath, double htkTimeToFrame);
+
+    // Gets number of utterances in the cache.
+    size_t GetNumberOfUtterances() const;
+
+    // Finds an utterance by its key, returns SIZE_MAX if the key is not in the cache.
+    size_t Find(const std::string& key) const;
+
+    // Gets the key of an utterance.
+    const char* GetKey(size_t utterance) const;
+
+    // Gets number of frames of an utterance.
+    size_t GetNumberOfFrames(size_t utterance) const;
+
+    // Gets the runs of an utterance, the runs cover all frames of the utterance consecutively.
+    const Run* GetRuns(size_t utterance, size_t& numberOfRuns) const;
+
+private:
+    DISABLE_COPY_AND_MOVE(MLFLabelCache);
+
+    struct Header;
+    struct Utterance;
+
+    // Describes the sources the cache is built from, used to detect a stale cache.
+    static std::string DescribeSources(const std::vector<std::wstring>& mlfPaths, const std::wstring& stateListPath, double htkTimeToFrame);
+
+    // Parses the MLF files and writes the cache.
+    static void Build(const std::wstring& cachePath, const std::vector<std::wstring>& mlfPaths, const std::wstring& stateListPath, double htkTimeToFrame, const std::string& sources);
+
+    // Maps the cache if it exists and has been built from the given sources.
+    bool TryOpen(const std::wstring& cachePath, const std::vector<std::wstring>& mlfPaths, const std::wstring& stateListPath, const std::string& sources);
+
+    static uint64_t Hash(const char* key);
+
+    std::unique_ptr<msra::files::mappedfile> m_file;
+    const Header* m_header;
+    const Utterance* m_utterances;
+    const Run* m_runs;
+    const uint32_t* m_hashTable;
+    const char* m_keys;
+};
+
+typedef std::shared_ptr<MLFLabelCache> MLFLabelCachePtr;
+
+}}}
@@ -108,6 +108,7 @@ void HTKMLFReader<ElemType>::PrepareForTrainingOrTesting(const ConfigRecordType&
 {
     vector<wstring> scriptpaths;
     vector<wstring> RootPathInScripts;
+    vector<wstring> packedArchives;
     wstring RootPathInLatticeTocs;
     vector<wstring> mlfpaths;
     vector<vector<wstring>> mlfpathsmulti;
@@ -188,6 +189,7 @@ void HTKMLFReader<ElemType>::PrepareForTrainingOrTesting(const ConfigRecordType&
         m_featureNameToIdMap[featureNames[i]] = iFeat;
         scriptpaths.push_back(thisFeature(L"scpFile"));
         RootPathInScripts.push_back(thisFeature(L"prefixPathInSCP", L""));
+        packedArchives.push_back(thisFeature(L"packedArchive", L""));
         m_featureNameToDimMap[featureNames[i]] = m_featDims[i];
 
         m_featuresBufferMultiIO.push_back(nullptr);
@@ -433,6 +435,10 @@ void HTKMLFReader<ElemType>::PrepareForTrainingOrTesting(const ConfigRecordType&
                 ExpandDotDotDot(entry, scriptpath, scpdircached);
         }
 
+        // read the features from a single memory-mapped archive, packing it first if it is missing or stale
+        if (!packedArchives[i].empty())
+            filelist = msra::asr::packedfeatarchive::packscript(filelist, packedArchives[i], scriptpath);
+
         infilesmulti.push_back(std::move(filelist));
     }
 
@@ -518,10 +524,12 @@ void HTKMLFReader<ElemType>::PrepareForTrainingOrTesting(const ConfigRecordType&
 
         // now get the frame source. This has better randomization and doesn't create temp files
         bool minimizeReaderMemoryFootprint = readerConfig(L"minimizeReaderMemoryFootprint", true);
+        // in frame mode, randomize frames by an implicit permutation instead of a per-frame table (for very large corpora)
+        bool compactFrameRandomization = readerConfig(L"compactFrameRandomization", false);
         m_frameSource.reset(new msra::dbn::minibatchutterancesourcemulti(infilesmulti, labelsmulti, m_featDims, m_labelDims, 
                                                                          numContextLeft, numContextRight, randomize, 
                                                                          *m_lattices, m_latticeMap, m_frameMode, 
-                                                                         minimizeReaderMemoryFootprint, m_expandToUtt));
+                                                                         minimizeReaderMemoryFootprint, m_expandToUtt, compactFrameRandomization));
         m_frameSource->setverbosity(m_verbosity);
     }
     else if (EqualCI(readMethod, L"rollingWindow"))
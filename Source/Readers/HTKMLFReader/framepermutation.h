@@ -0,0 +1,123 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// framepermutation.h -- implicit frame permutation for the compact frame randomization of the utterance source
+//
+
+#pragma once
+
+#include "Basics.h" // for LogicError()
+#include <algorithm>
+#include <vector>
+
+namespace msra { namespace dbn {
+
+// ---------------------------------------------------------------------------
+// framepermutation -- permutes frame positions without a per-frame table
+// The sweep is partitioned into blocks of consecutive randomized chunks such that each chunk of a block
+// lies within the randomization window of every chunk of the same block. Frame positions of a block are
+// then mapped bijectively onto frames of the same block by a keyed Feistel network (with cycle walking
+// to restrict the power-of-two domain to the number of frames in the block).
+// This keeps the window admissibility by construction, at the price of mixing frames over blocks
+// that are somewhat smaller than the randomization window.
+// ---------------------------------------------------------------------------
+class framepermutation
+{
+    struct permutationblock
+    {
+        size_t ts;              // first frame position of the block (global)
+        size_t numframes;       // number of frames in the block
+        unsigned int halfbits;  // Feistel domain is 2^(2*halfbits) >= numframes
+        unsigned long long key; // permutation key, derived from the sweep seed
+    };
+    std::vector<permutationblock> m_blocks; // [block index]
+    std::vector<size_t> m_chunktoblock;     // [randomized chunk index] -> block index
+
+    // mixing function (splitmix64 finalizer) used for Feistel round functions and block keys
+    static unsigned long long mix(unsigned long long x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // bijection of [0, numframes) of a block: a 4-round Feistel network on 2*halfbits bits, cycle-walking until the result is in range
+    static size_t permute(const permutationblock& block, size_t j)
+    {
+        const unsigned long long mask = (1ull << block.halfbits) - 1;
+        unsigned long long x = j;
+        do
+        {
+            unsigned long long l = x >> block.halfbits;
+            unsigned long long r = x & mask;
+            for (unsigned long long round = 0; round < 4; round++)
+            {
+                unsigned long long f = mix(r ^ (block.key + round * 0x632be59bd9b4e019ull)) & mask;
+                unsigned long long newr = l ^ f;
+                l = r;
+                r = newr;
+            }
+            x = (l << block.halfbits) | r;
+        } while (x >= block.numframes); // at most 4x domain, so few iterations on average
+        return (size_t) x;
+    }
+
+public:
+    // partition the sweep into blocks within which any frame may go to any position
+    // CHUNK is the randomized chunk of the utterance source, with windowbegin, windowend, globalts and globalte()
+    template <class CHUNK>
+    void reset(const std::vector<CHUNK>& chunks, unsigned int randSeed)
+    {
+        m_blocks.clear();
+        m_chunktoblock.resize(chunks.size());
+        size_t b = 0;
+        while (b < chunks.size())
+        {
+            // grow the block [b, e) while all of its chunks stay within the windows of all of its chunks
+            size_t maxwindowbegin = chunks[b].windowbegin;
+            size_t minwindowend = chunks[b].windowend;
+            size_t e = b + 1;
+            while (e < chunks.size() && std::max(maxwindowbegin, (size_t) chunks[e].windowbegin) <= b && std::min(minwindowend, (size_t) chunks[e].windowend) > e)
+            {
+                maxwindowbegin = std::max(maxwindowbegin, (size_t) chunks[e].windowbegin);
+                minwindowend = std::min(minwindowend, (size_t) chunks[e].windowend);
+                e++;
+            }
+            if (maxwindowbegin > b || minwindowend < e)
+                LogicError("framepermutation: chunk window does not contain its own chunk");
+
+            permutationblock block;
+            block.ts = chunks[b].globalts;
+            block.numframes = chunks[e - 1].globalte() - block.ts;
+            block.halfbits = 1;
+            while ((1ull << (2 * block.halfbits)) < block.numframes)
+                block.halfbits++;
+            block.key = mix(((unsigned long long) randSeed << 32) + m_blocks.size());
+            for (size_t i = b; i < e; i++)
+                m_chunktoblock[i] = m_blocks.size();
+            m_blocks.push_back(block);
+            b = e;
+        }
+    }
+
+    // the frame position whose frame is returned at position 'globalts', which lies in randomized chunk 'chunkindex'
+    size_t permutedposition(size_t globalts, size_t chunkindex) const
+    {
+        const auto& block = m_blocks[m_chunktoblock[chunkindex]];
+        return block.ts + permute(block, globalts - block.ts);
+    }
+
+    size_t numblocks() const
+    {
+        return m_blocks.size();
+    }
+
+    // memory used for the permutation, for logging
+    size_t bytesused() const
+    {
+        return m_blocks.size() * sizeof(permutationblock) + m_chunktoblock.size() * sizeof(size_t);
+    }
+};
+} }
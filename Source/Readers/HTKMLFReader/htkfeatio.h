@@ -21,6 +21,9 @@
 #include <wchar.h>
 #include "simplesenonehmm.h"
 #include <array>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "minibatchsourcehelpers.h"
 
 namespace msra { namespace asr {
@@ -304,6 +307,188 @@ public:
     }
 };
 
+// ===========================================================================
+// packedfeatarchive -- indexed container for many utterances of one feature kind
+//
+// Frames of all utterances are stored back to back as native-endian floats, so
+// that readers can memory-map the file and copy frames without any per-utterance
+// file open, byte swapping or decompression. Feature kind, dimension and period
+// are parsed once at conversion time and kept in the file header; an index at
+// the end of the file maps utterance keys to their frame ranges.
+//
+// Script files refer to utterances with the regular archive syntax
+// key=path.pfa[s,e], where [s,e] is the frame range inside the packed archive.
+// packscript() converts the entries of an HTK script into a packed archive and
+// returns such entries; the HTKMLFReader does this for a feature that has a
+// 'packedArchive' path configured.
+// ===========================================================================
+
+class packedfeatarchive
+{
+    static const unsigned int byteordermark = 0x01020304;
+    static const unsigned int currentversion = 1;
+    static const size_t dataalignment = 64;
+
+    struct fileheader
+    {
+        char magic[8];           // "PFEATARC"
+        unsigned int byteorder;  // byteordermark in the byte order of the writer
+        unsigned int version;    // format version
+        unsigned int featdim;    // feature dimension
+        unsigned int featperiod; // sampling period
+        char featkind[64];       // 0-terminated HTK feature-kind string
+        uint64_t numframes;      // total number of frames in the archive
+        uint64_t numutterances;  // number of index entries
+        uint64_t dataoffset;     // byte offset of the first frame
+        uint64_t indexoffset;    // byte offset of the index: entries followed by the 0-terminated keys
+    };
+
+    struct indexentry
+    {
+        uint64_t firstframe;
+        uint64_t numframes;
+        uint64_t keyoffset; // offset of the key relative to the end of the index entries
+    };
+
+    std::unique_ptr<msra::files::mappedfile> file;
+    const fileheader* header;
+    const float* frames;
+    const indexentry* entries;
+    const char* keys;
+
+    // key -> index entry, built on first lookup
+    mutable std::unordered_map<std::string, size_t> keytoentry;
+    mutable std::mutex keytoentrylock;
+
+    // Process-wide cache of opened archives, so that all readers share a single mapping per file.
+    // This is a class template only to allow defining the static members in this header.
+    template <class T>
+    struct cache
+    {
+        static std::mutex lock;
+        static std::map<std::wstring, std::shared_ptr<const T>> archives;
+    };
+
+    static void fail(const wstring& path, const char* what)
+    {
+        RuntimeError("packedfeatarchive: %s in '%ls'", what, path.c_str());
+    }
+
+    packedfeatarchive(const wstring& path)
+        : file(new msra::files::mappedfile(path))
+    {
+        const char* p = file->data();
+        const size_t n = file->size();
+        if (n < sizeof(fileheader) || memcmp(p, "PFEATARC", 8) != 0)
+            fail(path, "not a packed feature archive");
+        header = (const fileheader*) p;
+        if (header->byteorder != byteordermark)
+            fail(path, "archive was written on a machine with a different byte order");
+        if (header->version != currentversion)
+            fail(path, "unsupported format version");
+        if (header->featkind[sizeof(header->featkind) - 1] != 0)
+            fail(path, "malformed feature kind");
+        if (header->dataoffset % sizeof(float) != 0 || header->indexoffset % sizeof(uint64_t) != 0 ||
+            header->dataoffset + header->numframes * header->featdim * sizeof(float) > header->indexoffset ||
+            header->indexoffset + header->numutterances * sizeof(indexentry) > n)
+            fail(path, "archive is truncated or corrupted");
+        frames = (const float*) (p + header->dataoffset);
+        entries = (const indexentry*) (p + header->indexoffset);
+        keys = (const char*) (entries + header->numutterances);
+        if (header->numutterances > 0 && p[n - 1] != 0)
+            fail(path, "archive is truncated or corrupted");
+    }
+
+public:
+    // test whether a physical path refers to a packed archive (by extension, like the idx format)
+    static bool ispackedpath(const wstring& path)
+    {
+        const wstring extension(L".pfa");
+        return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+    }
+
+    // get the archive for a path; the file is mapped once per process and stays mapped
+    static std::shared_ptr<const packedfeatarchive> open(const wstring& path)
+    {
+        std::lock_guard<std::mutex> guard(cache<packedfeatarchive>::lock);
+        auto& archive = cache<packedfeatarchive>::archives[path];
+        if (!archive)
+            archive.reset(new packedfeatarchive(path));
+        return archive;
+    }
+
+    // convert the utterances of HTK script entries into a packed archive; returns script entries that refer to it
+    static vector<wstring> pack(const vector<wstring>& entries, const wstring& archivepath);
+
+    // same as pack(), but reuses the archive if it is newer than the script file and holds the same utterances
+    static vector<wstring> packscript(const vector<wstring>& entries, const wstring& archivepath, const wstring& scppath);
+
+    string featkind() const
+    {
+        return header->featkind;
+    }
+    size_t featdim() const
+    {
+        return header->featdim;
+    }
+    unsigned int featperiod() const
+    {
+        return header->featperiod;
+    }
+    size_t numframes() const
+    {
+        return (size_t) header->numframes;
+    }
+    size_t numutterances() const
+    {
+        return (size_t) header->numutterances;
+    }
+
+    // get a frame by its index inside the archive
+    const float* frame(size_t t) const
+    {
+        assert(t < numframes());
+        return frames + t * header->featdim;
+    }
+
+    // access to the index
+    const char* key(size_t i) const
+    {
+        return keys + entries[i].keyoffset;
+    }
+    size_t firstframe(size_t i) const
+    {
+        return (size_t) entries[i].firstframe;
+    }
+    size_t numframes(size_t i) const
+    {
+        return (size_t) entries[i].numframes;
+    }
+
+    // look up the frame range of an utterance by key; returns false if not found
+    bool find(const string& k, size_t& ts, size_t& numframes) const
+    {
+        std::lock_guard<std::mutex> guard(keytoentrylock);
+        if (keytoentry.empty())
+        {
+            keytoentry.reserve(numutterances());
+            for (size_t i = 0; i < numutterances(); i++)
+                keytoentry[key(i)] = i;
+        }
+        auto iter = keytoentry.find(k);
+        if (iter == keytoentry.end())
+            return false;
+        ts = firstframe(iter->second);
+        numframes = this->numframes(iter->second);
+        return true;
+    }
+};
+
+template <class T>
+std::mutex packedfeatarchive::cache<T>::lock;
+template <class T>
+std::map<std::wstring, std::shared_ptr<const T>> packedfeatarchive::cache<T>::archives;
+
 // ===========================================================================
 // htkfeatreader -- read HTK feature file, with archive support
 //
@@ -335,6 +520,9 @@ class htkfeatreader : protected htkfeatio
     size_t numframes;                    // number of samples for current logical file
     size_t energyElements;               // how many energy elements to add if addEnergy is true
 
+    std::shared_ptr<const packedfeatarchive> packed; // set if the current physical file is a packed archive (f is NULL then)
+    size_t packedstart;                              // frame index inside the packed archive of the current logical file
+
 public:
     // parser for complex a=b[s,e] syntax
     struct parsedpath
@@ -360,6 +548,7 @@ public:
         size_t s, e;         // first and last frame inside the archive file; (0, INT_MAX) if not given
         bool isarchive;      // true if archive (range specified)
         bool isidxformat;    // support reading of features in idxformat as well (it's a hack, but different format's are not supported yet)
+        bool ispacked;       // physical file is a packedfeatarchive; s and e index into its frames
         void malformed(const wstring& path) const
         {
             RuntimeError("parsedpath: malformed path '%ls'", path.c_str());
@@ -422,6 +611,8 @@ public:
                 }
             }
 
+            ispacked = packedfeatarchive::ispackedpath(archivepath);
+
             auto iter = archivePathStringMap.find(archivepath);
             if (iter != archivePathStringMap.end())
             {
@@ -466,6 +657,12 @@ private:
     // This is different from the logical (virtual) path name in the case of an archive.
     void openphysical(const parsedpath& ppath)
     {
+        if (ppath.ispacked)
+        {
+            openpacked(ppath);
+            return;
+        }
+
         wstring physpath = ppath.physicallocation();
         // auto_file_ptr f = fopenOrDie (physpath, L"rbS");
         auto_file_ptr f(fopenOrDie(physpath, L"rb")); // removed 'S' for now, as we mostly run local anyway, and this will speed up debugging
@@ -569,10 +766,31 @@ private:
         this->b.swap(b);
         this->vecbytesize = H.sampsize;
         this->hascrcc = hascrcc;
+        this->packed.reset();
+    }
+    // open a packed archive; the header is already parsed, and data are shared through the process-wide mapping
+    void openpacked(const parsedpath& ppath)
+    {
+        wstring physpath = ppath.physicallocation();
+        auto archive = packedfeatarchive::open(physpath);
+        setkind(archive->featkind(), archive->featdim(), archive->featperiod(), ppath); // this checks consistency
+        this->f = NULL;
+        this->physicalpath.swap(physpath);
+        this->physicaldatastart = 0;
+        this->physicalframes = archive->numframes();
+        this->isidxformat = false;
+        this->needbyteswapping = false;
+        this->compressed = false;
+        this->a.clear();
+        this->b.clear();
+        this->vecbytesize = archive->featdim() * sizeof(float);
+        this->hascrcc = false;
+        this->packed = archive;
     }
     void close() // force close the open file --use this in case of read failure
     {
         f = NULL; // assigning a new FILE* to f will close the old FILE* if any
+        packed.reset();
         physicalpath.clear();
     }
 
@@ -581,6 +799,7 @@ public:
     {
         addEnergy = false;
         energyElements = 0;
+        packedstart = 0;
     }
 
     // helper to create a parsed-path object
@@ -596,7 +815,7 @@ public:
     size_t open(const parsedpath& ppath)
     {
         // do not reopen the file if it is the same; use fsetpos() instead
-        if (f == NULL || ppath.physicallocation() != physicalpath)
+        if ((f == NULL && !packed) || ppath.physicallocation() != physicalpath)
             openphysical(ppath);
 
         if (ppath.isarchive) // reading a sub-range from an archive
@@ -606,8 +825,13 @@ public:
             if (ppath.e >= physicalframes)
                 RuntimeError("open: end frame exceeds archive's total number of frames %d in '%ls'", (int)physicalframes, ((wstring)ppath).c_str());
 
-            int64_t dataoffset = physicaldatastart + ppath.s * vecbytesize;
-            fsetpos(f, dataoffset); // we assume fsetpos(), which is our own, is smart to not flush the read buffer
+            if (packed)
+                packedstart = ppath.s;
+            else
+            {
+                int64_t dataoffset = physicaldatastart + ppath.s * vecbytesize;
+                fsetpos(f, dataoffset); // we assume fsetpos(), which is our own, is smart to not flush the read buffer
+            }
             curframe = 0;
             numframes = ppath.e + 1 - ppath.s;
         }
@@ -615,7 +839,10 @@ public:
         {
             curframe = 0;
             numframes = physicalframes;
-            assert(fgetpos(f) == physicaldatastart);
+            if (packed)
+                packedstart = 0;
+            else
+                assert(fgetpos(f) == physicaldatastart);
         }
         return numframes;
     }
@@ -648,7 +875,12 @@ public:
     {
         if (curframe >= numframes)
             RuntimeError("htkfeatreader:attempted to read beyond end");
-        if (!compressed && !isidxformat) // not compressed--the easy one
+        if (packed) // packed archive--native floats, just copy from the mapping
+        {
+            const float* frame = packed->frame(packedstart + curframe);
+            v.assign(frame, frame + featdim);
+        }
+        else if (!compressed && !isidxformat) // not compressed--the easy one
         {
             freadOrDie(v, featdim, f);
             if (needbyteswapping)
@@ -769,6 +1001,124 @@ public:
     }
 };
 
+// ---------------------------------------------------------------------------
+// packedfeatarchive::pack() -- convert HTK script entries into a packed archive
+// Input entries may use any syntax htkfeatreader understands; the returned entries
+// keep the logical paths and refer to frame ranges inside the new archive.
+// ---------------------------------------------------------------------------
+
+inline vector<wstring> packedfeatarchive::pack(const vector<wstring>& entries, const wstring& archivepath)
+{
+    if (!ispackedpath(archivepath))
+        RuntimeError("packedfeatarchive::pack: archive path '%ls' must have the extension .pfa", archivepath.c_str());
+
+    fprintf(stderr, "packedfeatarchive::pack: packing %d utterances into '%ls'\n", (int) entries.size(), archivepath.c_str());
+
+    // write to a tmp file first to ensure we don't leave broken files that would confuse make mode
+    wstring tmppath = archivepath + msra::strfun::wstrprintf(L".%d$$", (int) GetCurrentProcessId());
+    auto_file_ptr f(fopenOrDie(tmppath, L"wb"));
+
+    fileheader H;
+    memset(&H, 0, sizeof(H));
+    memcpy(H.magic, "PFEATARC", 8);
+    H.byteorder = byteordermark;
+    H.version = currentversion;
+    H.dataoffset = (sizeof(H) + dataalignment - 1) / dataalignment * dataalignment;
+    fwriteOrDie(&H, sizeof(H), 1, f); // placeholder, rewritten at the end
+    vector<char> padding(dataalignment, 0);
+    fwriteOrDie(padding.data(), 1, H.dataoffset - sizeof(H), f);
+
+    // copy all utterances; the reader validates that they all have the same feature kind
+    htkfeatreader reader;
+    vector<indexentry> index;
+    string keypool;
+    vector<wstring> packedentries;
+    vector<float> v;
+    string featkind;
+    size_t featdim = 0;
+    unsigned int featperiod = 0;
+    for (const wstring& entry : entries)
+    {
+        htkfeatreader::parsedpath ppath(entry);
+        reader.getinfo(ppath, featkind, featdim, featperiod);
+
+        indexentry e;
+        e.firstframe = H.numframes;
+        e.numframes = 0;
+        e.keyoffset = keypool.size();
+        while (reader)
+        {
+            reader.read(v);
+            fwriteOrDie(v.data(), sizeof(float), v.size(), f);
+            e.numframes++;
+        }
+        if (e.numframes == 0)
+            RuntimeError("packedfeatarchive::pack: utterance '%ls' has no frames", entry.c_str());
+        H.numframes += e.numframes;
+
+        const wstring logicalpath = ppath;
+        keypool += msra::strfun::utf8(logicalpath);
+        keypool.push_back(0);
+        index.push_back(e);
+        packedentries.push_back(logicalpath + L"=" + archivepath + L"[" + std::to_wstring(e.firstframe) + L"," + std::to_wstring(e.firstframe + e.numframes - 1) + L"]");
+    }
+
+    if (index.empty())
+        RuntimeError("packedfeatarchive::pack: no utterances to pack into '%ls'", archivepath.c_str());
+    if (featkind.size() >= sizeof(H.featkind))
+        RuntimeError("packedfeatarchive::pack: feature kind '%s' is too long", featkind.c_str());
+
+    // write the index behind the data, aligned for direct access through the mapping
+    uint64_t pos = H.dataoffset + H.numframes * featdim * sizeof(float);
+    H.indexoffset = (pos + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+    fwriteOrDie(padding.data(), 1, (size_t) (H.indexoffset - pos), f);
+    fwriteOrDie(index.data(), sizeof(indexentry), index.size(), f);
+    fwriteOrDie(keypool.data(), 1, keypool.size(), f);
+
+    // now that everything is known, write the final header
+    H.featdim = (unsigned int) featdim;
+    H.featperiod = featperiod;
+    memcpy(H.featkind, featkind.c_str(), featkind.size() + 1);
+    H.numutterances = index.size();
+    fseekOrDie(f, 0);
+    fwriteOrDie(&H, sizeof(H), 1, f);
+    fflushOrDie(f);
+    f = NULL; // this triggers an fclose() on auto_file_ptr
+
+    // readers that open the archive from now on must map the new file
+    {
+        std::lock_guard<std::mutex> guard(cache<packedfeatarchive>::lock);
+        cache<packedfeatarchive>::archives.erase(archivepath);
+    }
+    renameOrDie(tmppath, archivepath);
+
+    fprintf(stderr, "packedfeatarchive::pack: %d utterances, %d frames of %d-dimensional '%s' written\n",
+            (int) index.size(), (int) H.numframes, (int) featdim, featkind.c_str());
+    return packedentries;
+}
+
+inline vector<wstring> packedfeatarchive::packscript(const vector<wstring>& entries, const wstring& archivepath, const wstring& scppath)
+{
+    if (fexists(archivepath) && msra::files::fuptodate(archivepath, scppath))
+    {
+        // not opened through the cache, so that a stale archive is not kept mapped while it is rebuilt
+        packedfeatarchive archive(archivepath);
+        bool same = archive.numutterances() == entries.size();
+        for (size_t i = 0; same && i < entries.size(); i++)
+            same = msra::strfun::utf8((wstring) htkfeatreader::parsedpath(entries[i])) == archive.key(i);
+        if (same)
+        {
+            fprintf(stderr, "packedfeatarchive::packscript: using packed archive '%ls' with %d utterances\n", archivepath.c_str(), (int) entries.size());
+            vector<wstring> packedentries;
+            packedentries.reserve(entries.size());
+            for (size_t i = 0; i < entries.size(); i++)
+                packedentries.push_back(msra::strfun::utf16(archive.key(i)) + L"=" + archivepath + L"[" + std::to_wstring(archive.firstframe(i)) + L"," + std::to_wstring(archive.firstframe(i) + archive.numframes(i) - 1) + L"]");
+            return packedentries;
+        }
+    }
+    return pack(entries, archivepath);
+}
+
 struct htkmlfentry
 {
     unsigned int firstframe; // range [firstframe,firstframe+numframes)
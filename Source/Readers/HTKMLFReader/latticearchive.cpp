@@ -402,8 +402,9 @@ void lattice::dedup()
 // We support two special output path syntaxs:
 //  - empty ("") -> don't output, just check the format
 //  - dash ("-") -> dump lattice to stdout instead
-/*static*/ void archive::convert(const std::wstring &intocpath, const std::wstring &intocpath2, const std::wstring &outpath,
-                                 const msra::asr::simplesenonehmm &hset)
+// 'compact' writes the V3 format instead of V2.
+static void convertarchive(const std::wstring &intocpath, const std::wstring &intocpath2, const std::wstring &outpath,
+                           const msra::asr::simplesenonehmm &hset, bool compact)
 {
     const auto &modelsymmap = hset.getsymmap();
 
@@ -490,7 +491,7 @@ void lattice::dedup()
         {
             // write to archive
             uint64_t offset = fgetpos(f);
-            L.fwrite(f);
+            L.fwrite(f, compact);
             fflushOrDie(f);
 
             // write reference to TOC file   --note: TOC file is a headerless UTF8 file; so don't use fprintf %ls format (default code page)
@@ -524,6 +525,18 @@ void lattice::dedup()
     fprintf(stderr, "converted %d lattices\n", toclines.size());
 }
 
+/*static*/ void archive::convert(const std::wstring &intocpath, const std::wstring &intocpath2, const std::wstring &outpath,
+                                 const msra::asr::simplesenonehmm &hset)
+{
+    convertarchive(intocpath, intocpath2, outpath, hset, false);
+}
+
+/*static*/ void archive::compact(const std::wstring &intocpath, const std::wstring &outpath,
+                                 const msra::asr::simplesenonehmm &hset)
+{
+    convertarchive(intocpath, L"", outpath, hset, true);
+}
+
 // ---------------------------------------------------------------------------
 // reading lattices from external formats (HTK lat, MLF)
 // ---------------------------------------------------------------------------
@@ -12,6 +12,7 @@
 #include "latticearchive.h" // for reading HTK phoneme lattices (MMI training)
 #include "minibatchsourcehelpers.h"
 #include "minibatchiterator.h"
+#include "framepermutation.h"
 #include "unordered_set"
 
 namespace msra { namespace dbn {
@@ -419,6 +420,11 @@ class minibatchutterancesourcemulti : public minibatchsource
         // Only used when m_minimizeMemoryFootprint is false
         biggrowablevector<frameref> m_randomizedframerefs;
 
+        // When true frames are not randomized by swapping framerefs, but by an implicit permutation
+        // that is computed on the fly, so no per-frame table is stored at all (see framepermutation.h).
+        const bool m_compact;
+        framepermutation m_permutation;
+
         // A rolling windows of chunks of framerefs used for randomization in frame mode
         // Along with each frameref, we also store the chunk index of the original frame
         // at that index before randomization, to be used for determining the chunk range
@@ -430,14 +436,14 @@ class minibatchutterancesourcemulti : public minibatchsource
         size_t m_nextFramePosNotYetRandomized;
 
     public:
-        framerandomizer(const std::vector<std::vector<chunk>>& randomizedChunks, bool minimizeMemoryFootprint)
-            : m_randomizedChunks(randomizedChunks), m_minimizeMemoryFootprint(minimizeMemoryFootprint), m_currentRangeBeginChunkIdx(0), m_currentRangeEndChunkIdx(0), m_nextFramePosNotYetRandomized(0)
+        framerandomizer(const std::vector<std::vector<chunk>>& randomizedChunks, bool minimizeMemoryFootprint, bool compact)
+            : m_randomizedChunks(randomizedChunks), m_minimizeMemoryFootprint(minimizeMemoryFootprint), m_compact(compact), m_currentRangeBeginChunkIdx(0), m_currentRangeEndChunkIdx(0), m_nextFramePosNotYetRandomized(0)
         {
         }
 
         void randomizeFrameRange(size_t globalts, size_t globalte)
         {
-            if (m_nextFramePosNotYetRandomized == m_randomizedChunks[0].back().globalte())
+            if (m_compact || m_nextFramePosNotYetRandomized == m_randomizedChunks[0].back().globalte())
                 return;
 
             assert(m_nextFramePosNotYetRandomized >= m_randomizedChunks[0][0].globalts);
@@ -501,11 +507,11 @@ class minibatchutterancesourcemulti : public minibatchsource
                     //  - Both may have been swapped before.
                     //  - Both must stay within the randomization window of their respective position.
                     // check admissibility of where the element at 'tswap' gets swapped to 't' (range = [windowbegin,windowend))
-                    size_t tswapchunkindex = randomizedframeref(tswap).chunkindex;
+                    size_t tswapchunkindex = framerefentry(tswap).chunkindex;
                     if (tswapchunkindex < chunkWindowBegin || tswapchunkindex >= chunkWindowEnd)
                         continue;
                     // check admissibility of where the element at t gets swapped to (which is frame position 'tswap')
-                    const size_t sourcechunkindex = randomizedframeref(t).chunkindex;
+                    const size_t sourcechunkindex = framerefentry(t).chunkindex;
                     size_t targetchunkindex = ttochunk(tswap); // chunk associated with this frame position defines value range
                     const auto &targetchunk = m_randomizedChunks[0][targetchunkindex];
                     const size_t targetwindowbegin = targetchunk.windowbegin;
@@ -513,13 +519,13 @@ class minibatchutterancesourcemulti : public minibatchsource
                     if (sourcechunkindex < targetwindowbegin || sourcechunkindex >= targetwindowend)
                         continue;
                     // admissible--swap the two
-                    ::swap(randomizedframeref(t), randomizedframeref(tswap));
+                    ::swap(framerefentry(t), framerefentry(tswap));
 
                     // do a post-check if we got it right  --we seem not to
                     if (isframepositionvalid(t) && isframepositionvalid(tswap))
                         break;
                     // not valid: swap them back and try again  --we actually discovered a bug in the code above
-                    ::swap(randomizedframeref(t), randomizedframeref(tswap));
+                    ::swap(framerefentry(t), framerefentry(tswap));
                     fprintf(stderr, "randomizeFrameRange: BUGBUG --invalid swapping condition detected\n");
                 }
             }
@@ -534,7 +540,7 @@ class minibatchutterancesourcemulti : public minibatchsource
                 const size_t poswindowbegin = chunk.windowbegin;
                 const size_t poswindowend = chunk.windowend;
 
-                const size_t randomizedchunkindex = randomizedframeref(t).chunkindex;
+                const size_t randomizedchunkindex = framerefentry(t).chunkindex;
                 if (randomizedchunkindex < poswindowbegin || randomizedchunkindex >= poswindowend)
                     LogicError("randomizeFrameRange: nope, you got frame randomization wrong, dude");
             }
@@ -545,7 +551,17 @@ class minibatchutterancesourcemulti : public minibatchsource
             srand(randSeed);
             size_t sweepts = m_randomizedChunks[0][0].globalts;
             size_t totalFrames = m_randomizedChunks[0].back().globalte() - sweepts;
-            if (m_minimizeMemoryFootprint)
+            if (m_compact)
+            {
+                m_permutation.reset(m_randomizedChunks[0], randSeed);
+                m_nextFramePosNotYetRandomized = m_randomizedChunks[0].back().globalte();
+                m_currentRangeBeginChunkIdx = 0;
+                m_currentRangeEndChunkIdx = m_randomizedChunks[0].size();
+
+                fprintf(stderr, "framerandomizer: implicit frame permutation over %d blocks of %d chunks, %.6f bytes per frame\n",
+                        (int)m_permutation.numblocks(), (int)m_randomizedChunks[0].size(), m_permutation.bytesused() / (double)max(totalFrames, (size_t)1));
+            }
+            else if (m_minimizeMemoryFootprint)
             {
                 m_randomizedframerefsWindow.clear();
                 m_currentRangeBeginChunkIdx = m_randomizedChunks[0][0].windowbegin;
@@ -658,11 +674,24 @@ class minibatchutterancesourcemulti : public minibatchsource
                 m_nextFramePosNotYetRandomized = m_randomizedChunks[0].back().globalte();
                 m_currentRangeBeginChunkIdx = 0;
                 m_currentRangeEndChunkIdx = m_randomizedChunks[0].size();
+
+                fprintf(stderr, "framerandomizer: frame table for %d frames, %d bytes per frame\n", (int)totalFrames, (int)sizeof(frameref));
             }
         }
 
-        frameref& randomizedframeref(size_t globalts)
+        // get the (chunk, utterance, frame) that is returned at a given frame position
+        frameref randomizedframeref(size_t globalts)
         {
+            if (m_compact)
+                return permutedframeref(globalts);
+            else
+                return framerefentry(globalts);
+        }
+
+    private:
+        frameref& framerefentry(size_t globalts)
+        {
+            assert(!m_compact);
             if (m_minimizeMemoryFootprint)
                 return randomizedframeentry(globalts).second;
             else
@@ -672,7 +701,17 @@ class minibatchutterancesourcemulti : public minibatchsource
             }
         }
 
-    private:
+        frameref permutedframeref(size_t globalts)
+        {
+            assert(m_compact);
+            const size_t t = m_permutation.permutedposition(globalts, chunkIdx(globalts));
+            const size_t i = chunkIdx(t);
+            const auto& chunkdata = m_randomizedChunks[0][i].getchunkdata();
+            const size_t offset = t - m_randomizedChunks[0][i].globalts;
+            const size_t k = std::upper_bound(chunkdata.firstframes.begin(), chunkdata.firstframes.end(), offset) - chunkdata.firstframes.begin() - 1;
+            return frameref(i, k, offset - chunkdata.firstframes[k]);
+        }
+
         void addRandomizedFramesForChunk(size_t chunkIdx)
         {
             assert(m_minimizeMemoryFootprint);
@@ -742,7 +781,7 @@ class minibatchutterancesourcemulti : public minibatchsource
             // Chunk implies that if we are at position 't', we are guaranteed to have chunks [poswindowbegin, poswindowend) in RAM.
 
             // now see if the randomized location is within that window
-            const size_t actualchunkindexforpos = randomizedframeref(t).chunkindex; // where this frame pos has been mapped to
+            const size_t actualchunkindexforpos = framerefentry(t).chunkindex; // where this frame pos has been mapped to
             return actualchunkindexforpos >= poswindowbegin && actualchunkindexforpos < poswindowend;
             // We only need to test the chunk index. Utterance and frame can be randomized within a chunk as we want, as long it is in RAM.
         }
@@ -868,8 +907,8 @@ public:
     // This mode requires utterances with time stamps.
     minibatchutterancesourcemulti(const std::vector<std::vector<wstring>> &infiles, const std::vector<map<wstring, std::vector<msra::asr::htkmlfentry>>> &labels,
                                   std::vector<size_t> vdim, std::vector<size_t> udim, std::vector<size_t> leftcontext, std::vector<size_t> rightcontext, size_t randomizationrange,
-                                  const latticesource &lattices, const map<wstring, msra::lattices::lattice::htkmlfwordsequence> &allwordtranscripts, const bool framemode, bool minimizeMemoryFootprint, std::vector<bool> expandToUtt)
-                                  : vdim(vdim), leftcontext(leftcontext), rightcontext(rightcontext), sampperiod(0), featdim(0), randomizationrange(randomizationrange), currentsweep(SIZE_MAX), lattices(lattices), allwordtranscripts(allwordtranscripts), framemode(framemode), chunksinram(0), timegetbatch(0), verbosity(2), m_generatePhoneBoundaries(!lattices.empty()), m_frameRandomizer(randomizedchunks, minimizeMemoryFootprint), expandToUtt(expandToUtt)
+                                  const latticesource &lattices, const map<wstring, msra::lattices::lattice::htkmlfwordsequence> &allwordtranscripts, const bool framemode, bool minimizeMemoryFootprint, std::vector<bool> expandToUtt, bool compactFrameRandomization = false)
+                                  : vdim(vdim), leftcontext(leftcontext), rightcontext(rightcontext), sampperiod(0), featdim(0), randomizationrange(randomizationrange), currentsweep(SIZE_MAX), lattices(lattices), allwordtranscripts(allwordtranscripts), framemode(framemode), chunksinram(0), timegetbatch(0), verbosity(2), m_generatePhoneBoundaries(!lattices.empty()), m_frameRandomizer(randomizedchunks, minimizeMemoryFootprint, compactFrameRandomization), expandToUtt(expandToUtt)
     // [v-hansu] change framemode (lattices.empty()) into framemode (false) to run utterance mode without lattice
     // you also need to change another line, search : [v-hansu] comment out to run utterance mode without lattice
     {
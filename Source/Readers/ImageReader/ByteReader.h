@@ -24,7 +24,20 @@ public:
     virtual void Register(size_t seqId, const std::string& path) = 0;
     virtual cv::Mat Read(size_t seqId, const std::string& path, bool grayscale) = 0;
 
+    // Allows JPEG images to be downscaled by 2, 4 or 8 while decoding, as long as
+    // the shorter side of the decoded image stays at least minSide pixels. 0 disables it.
+    void SetReducedDecodeSize(int minSide)
+    {
+        m_reducedDecodeSize = minSide;
+    }
+
     DISABLE_COPY_AND_MOVE(ByteReader);
+
+protected:
+    // Decodes an image from the memory buffer, taking the reduced decode size into account.
+    cv::Mat Decode(const unsigned char* data, size_t size, bool grayscale) const;
+
+    int m_reducedDecodeSize = 0;
 };
 
 class FileByteReader : public ByteReader
@@ -35,10 +48,14 @@ public:
 };
 
 #ifdef USE_ZIP
+// Reads images from a zip archive. The archive is memory mapped: stored entries are decoded
+// directly from the mapping, deflated entries are decompressed with zlib into a buffer
+// that is reused by the thread. Other entries are read through libzip.
 class ZipByteReader : public ByteReader
 {
 public:
     ZipByteReader(const std::string& zipPath);
+    ~ZipByteReader();
 
     void Register(size_t seqId, const std::string& path) override;
     cv::Mat Read(size_t seqId, const std::string& path, bool grayscale) override;
@@ -47,10 +64,33 @@ private:
     using ZipPtr = std::unique_ptr<zip_t, void(*)(zip_t*)>;
     ZipPtr OpenZip();
 
+    struct Entry
+    {
+        zip_uint64_t m_index;
+        zip_uint64_t m_size;
+        zip_uint64_t m_compressedSize;
+        zip_uint16_t m_method;
+        // Start of the entry data in the mapped archive, nullptr if the entry has to be read through libzip.
+        const unsigned char* m_data;
+    };
+
+    // Gets the start of the entry data in the mapped archive, or nullptr if it cannot be located.
+    const unsigned char* GetEntryData(zip_uint64_t index, zip_uint64_t compressedSize) const;
+
+    cv::Mat ReadFromZip(size_t seqId, const std::string& path, const Entry& entry, bool grayscale);
+
+    class MappedArchive;
+    class Inflater;
+
     std::string m_zipPath;
     conc_stack<ZipPtr> m_zips;
-    std::unordered_map<size_t, std::pair<zip_uint64_t, zip_uint64_t>> m_seqIdToIndex;
+    std::unordered_map<size_t, Entry> m_seqIdToEntry;
     conc_stack<std::vector<unsigned char>> m_workspace;
+    conc_stack<std::unique_ptr<Inflater>> m_inflaters;
+
+    std::unique_ptr<MappedArchive> m_archive;
+    // Offsets of the local file headers, indexed by the entry index.
+    std::vector<zip_uint64_t> m_localHeaderOffsets;
 };
 #endif
 
@@ -4,6 +4,8 @@
 //
 
 #include "stdafx.h"
+#include <algorithm>
+#include <cmath>
 #include "ImageConfigHelper.h"
 #include "StringUtil.h"
 #include "ConfigUtil.h"
@@ -95,6 +97,21 @@ ImageConfigHelper::ImageConfigHelper(const ConfigParameters& config)
     m_cpuThreadCount = config(L"numCPUThreads", 0);
 
     m_cropType = ParseCropType(featureSection(L"cropType", ""));
+
+    // JPEG images can be decoded at a reduced size as long as the smallest crop still
+    // covers the requested width and height.
+    m_reducedDecodeSize = 0;
+    if (featureSection(L"reducedSizeDecode", false))
+    {
+        floatargvector cropRatio = featureSection(L"cropRatio", "1.0");
+        double minCropRatio = std::min(cropRatio[0], cropRatio[1]);
+        if (minCropRatio <= 0)
+        {
+            RuntimeError("Invalid cropRatio value, must be > 0.");
+        }
+
+        m_reducedDecodeSize = static_cast<size_t>(std::ceil(std::max(w, h) / minCropRatio));
+    }
 }
 
 std::vector<StreamDescriptionPtr> ImageConfigHelper::GetStreams() const
@@ -68,6 +68,13 @@ public:
         return m_cropType == CropType::MultiView10;
     }
 
+    // Gets the shorter side an image needs to have to cover the network input after cropping,
+    // or 0 if images should always be decoded at full size.
+    size_t GetReducedDecodeSize() const
+    {
+        return m_reducedDecodeSize;
+    }
+
     static CropType ParseCropType(const std::string &src);
 
 private:
@@ -81,6 +88,7 @@ private:
     bool m_randomize;
     bool m_grayscale;
     CropType m_cropType;
+    size_t m_reducedDecodeSize;
 };
 
 typedef std::shared_ptr<ImageConfigHelper> ImageConfigHelperPtr;
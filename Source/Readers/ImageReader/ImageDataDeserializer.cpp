@@ -32,7 +32,7 @@ template <class TElement>
 class TypedLabelGenerator : public ImageDataDeserializer::LabelGenerator
 {
 public:
-    TypedLabelGenerator(size_t labelDimension) : m_value(1), m_indices(labelDimension)
+    TypedLabelGenerator(size_t labelDimension) : m_value(1), m_nnzCount(1), m_indices(labelDimension)
     {
         if (labelDimension > numeric_limits<IndexType>::max())
         {
@@ -44,8 +44,7 @@ public:
 
     virtual void CreateLabelFor(size_t classId, SparseSequenceData& data) override
     {
-        data.m_nnzCounts.resize(1);
-        data.m_nnzCounts[0] = 1;
+        data.m_nnzCounts = &m_nnzCount;
         data.m_totalNnzCount = 1;
         data.m_data = &m_value;
         data.m_indices = &(m_indices[classId]);
@@ -53,15 +52,10 @@ public:
 
 private:
     TElement m_value;
+    IndexType m_nnzCount;
     vector<IndexType> m_indices;
 };
 
-// Used to keep track of the image. Accessed only using DenseSequenceData interface.
-struct DeserializedImage : DenseSequenceData
-{
-    cv::Mat m_image;
-};
-
 // For image, chunks correspond to a single image.
 class ImageDataDeserializer::ImageChunk : public Chunk, public std::enable_shared_from_this<ImageChunk>
 {
@@ -90,7 +84,7 @@ public:
 
         // Convert element type.
         int dataType = m_parent.m_featureElementType == ElementType::tfloat ? CV_32F : CV_64F;
-        if (cvImage.type() != CV_MAKETYPE(dataType, cvImage.channels()))
+        if (m_parent.m_convertToElementType && cvImage.type() != CV_MAKETYPE(dataType, cvImage.channels()))
         {
             cvImage.convertTo(cvImage, dataType);
         }
@@ -120,6 +114,7 @@ public:
 // A new constructor to support new compositional configuration,
 // that allows composition of deserializers and transforms on inputs.
 ImageDataDeserializer::ImageDataDeserializer(CorpusDescriptorPtr corpus, const ConfigParameters& config)
+    : m_convertToElementType(true)
 {
     ConfigParameters inputs = config("input");
     std::vector<std::string> featureNames = GetSectionsWithParameter("ImageDataDeserializer", inputs, "transforms");
@@ -170,7 +165,8 @@ ImageDataDeserializer::ImageDataDeserializer(CorpusDescriptorPtr corpus, const C
 
 // TODO: Should be removed at some point.
 // Supports old type of ImageReader configuration.
-ImageDataDeserializer::ImageDataDeserializer(const ConfigParameters& config)
+ImageDataDeserializer::ImageDataDeserializer(const ConfigParameters& config, bool convertToElementType)
+    : m_convertToElementType(convertToElementType)
 {
     ImageConfigHelper configHelper(config);
     m_streams = configHelper.GetStreams();
@@ -203,6 +199,20 @@ ImageDataDeserializer::ImageDataDeserializer(const ConfigParameters& config)
     }
 
     CreateSequenceDescriptions(std::make_shared<CorpusDescriptor>(), configHelper.GetMapPath(), labelDimension, configHelper.IsMultiViewCrop());
+
+    int reducedDecodeSize = static_cast<int>(configHelper.GetReducedDecodeSize());
+    if (reducedDecodeSize > 0)
+    {
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 1)
+        m_defaultReader.SetReducedDecodeSize(reducedDecodeSize);
+        for (auto& r : m_readers)
+        {
+            r.second->SetReducedDecodeSize(reducedDecodeSize);
+        }
+#else
+        fprintf(stderr, "WARNING: reducedSizeDecode requires OpenCV 3.1 or later, images are decoded at full size.\n");
+#endif
+    }
 }
 
 // Descriptions of chunks exposed by the image reader.
@@ -355,7 +365,114 @@ cv::Mat FileByteReader::Read(size_t, const std::string& path, bool grayscale)
 {
     assert(!path.empty());
 
-    return cv::imread(path, grayscale ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+    if (m_reducedDecodeSize == 0)
+    {
+        return cv::imread(path, grayscale ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+    }
+
+    // The size of the image has to be known before decoding, so read the whole file.
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (contents.empty())
+    {
+        return cv::Mat();
+    }
+
+    return Decode(contents.data(), contents.size(), grayscale);
+}
+
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 1)
+// Gets dimensions of a JPEG image by walking its markers up to the frame header.
+// Returns false if the data is not a JPEG image.
+static bool TryGetJpegSize(const unsigned char* data, size_t size, int& width, int& height)
+{
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+    {
+        return false;
+    }
+
+    size_t pos = 2;
+    while (pos + 4 <= size)
+    {
+        if (data[pos] != 0xFF)
+        {
+            return false;
+        }
+
+        unsigned char marker = data[pos + 1];
+        if (marker == 0xFF)
+        {
+            // Fill byte.
+            pos++;
+            continue;
+        }
+
+        if (marker == 0x01 || (0xD0 <= marker && marker <= 0xD8))
+        {
+            // Markers without a segment.
+            pos += 2;
+            continue;
+        }
+
+        if (marker == 0xD9 || marker == 0xDA)
+        {
+            // End of image or start of scan before the frame header.
+            return false;
+        }
+
+        size_t length = (data[pos + 2] << 8) | data[pos + 3];
+        if (length < 2)
+        {
+            return false;
+        }
+
+        // Start of frame markers, except DHT (C4), JPG (C8) and DAC (CC).
+        if (0xC0 <= marker && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+        {
+            if (pos + 9 > size)
+            {
+                return false;
+            }
+
+            height = (data[pos + 5] << 8) | data[pos + 6];
+            width = (data[pos + 7] << 8) | data[pos + 8];
+            return width > 0 && height > 0;
+        }
+
+        pos += 2 + length;
+    }
+
+    return false;
+}
+#endif
+
+cv::Mat ByteReader::Decode(const unsigned char* data, size_t size, bool grayscale) const
+{
+    int flags = grayscale ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 1)
+    // The JPEG decoder can downscale by 2, 4 or 8 during decoding, which is much
+    // cheaper than decoding the full image and downscaling it afterwards.
+    int width, height;
+    if (m_reducedDecodeSize > 0 && TryGetJpegSize(data, size, width, height))
+    {
+        int shorterSide = std::min(width, height);
+        if (shorterSide >= 8 * m_reducedDecodeSize)
+        {
+            flags = grayscale ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+        }
+        else if (shorterSide >= 4 * m_reducedDecodeSize)
+        {
+            flags = grayscale ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+        }
+        else if (shorterSide >= 2 * m_reducedDecodeSize)
+        {
+            flags = grayscale ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+        }
+    }
+#endif
+
+    return cv::imdecode(cv::Mat(1, (int)size, CV_8UC1, const_cast<unsigned char*>(data)), flags);
 }
 
 static SequenceDescription s_invalidSequence{0, 0, 0, false};
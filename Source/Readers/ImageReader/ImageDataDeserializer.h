@@ -13,6 +13,13 @@
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
+// Decoded image as returned by the deserializer. Accessed using the DenseSequenceData interface,
+// or, by the image transformers, directly as an OpenCV matrix.
+struct DeserializedImage : DenseSequenceData
+{
+    cv::Mat m_image;
+};
+
 // Image data deserializer based on the OpenCV library.
 // The deserializer currently supports two output streams only: a feature and a label stream.
 // All sequences consist only of a single sample (image/label).
@@ -26,7 +33,9 @@ public:
     ImageDataDeserializer(CorpusDescriptorPtr corpus, const ConfigParameters& config);
 
     // TODO: This constructor should be deprecated in the future. Compositional config should be used instead.
-    explicit ImageDataDeserializer(const ConfigParameters& config);
+    // If convertToElementType is false, images are returned in their decoded (8 bit) element type and
+    // the conversion to the element type of the feature stream is left to the transformers.
+    explicit ImageDataDeserializer(const ConfigParameters& config, bool convertToElementType = true);
 
     // Gets sequences by specified ids. Order of returned sequences corresponds to the order of provided ids.
     virtual ChunkPtr GetChunk(size_t chunkId) override;
@@ -70,6 +79,9 @@ private:
     // whether images shall be loaded in grayscale 
     bool m_grayscale;
 
+    // Whether decoded images are converted to the element type of the feature stream.
+    bool m_convertToElementType;
+
     // Not using nocase_compare here as it's not correct on Linux.
     using PathReaderMap = std::unordered_map<std::string, std::shared_ptr<ByteReader>>;
     void RegisterByteReader(size_t seqId, const std::string& path, PathReaderMap& knownReaders);
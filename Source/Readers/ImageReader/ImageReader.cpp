@@ -39,7 +39,8 @@ ImageReader::ImageReader(MemoryProviderPtr provider,
         omp_set_num_threads(threadCount);
     }
 
-    auto deserializer = std::make_shared<ImageDataDeserializer>(config);
+    // Images are converted to the element type of the feature stream by the transformer after cropping.
+    auto deserializer = std::make_shared<ImageDataDeserializer>(config, false /* convertToElementType */);
 
     SequenceEnumeratorPtr randomizer;
     // Request multi-threaded randomizer operation to speed up CPU-intensive image-decoding and transformations.
@@ -59,17 +60,10 @@ ImageReader::ImageReader(MemoryProviderPtr provider,
     std::wstring featureName = m_streams[configHelper.GetFeatureStreamId()]->m_name;
     ConfigParameters featureStream = config(featureName);
 
+    // Crop, scale, color, intensity, mean and transpose are applied by a single transformer
+    // to avoid intermediate copies of the image.
     std::vector<Transformation> transformations;
-    transformations.push_back(Transformation{ std::make_shared<CropTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<ScaleTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<ColorTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<IntensityTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<MeanTransformer>(featureStream), featureName });
-
-    if (configHelper.GetDataFormat() == CHW)
-    {
-        transformations.push_back(Transformation{ std::make_shared<TransposeTransformer>(featureStream), featureName });
-    }
+    transformations.push_back(Transformation{ std::make_shared<FusedImageTransformer>(featureStream, configHelper.GetDataFormat()), featureName });
 
     m_sequenceEnumerator = std::make_shared<TransformController>(transformations, randomizer);
 
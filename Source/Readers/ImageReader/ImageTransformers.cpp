@@ -12,6 +12,7 @@
 #include "ConcStack.h"
 #include "StringUtil.h"
 #include "ElementTypeUtils.h"
+#include "ImageDataDeserializer.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK 
 {
@@ -648,4 +649,144 @@ void ColorTransformer::Apply(cv::Mat &mat)
     m_rngs.push(std::move(rng));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FusedImageTransformer::FusedImageTransformer(const ConfigParameters& config, ImageLayoutKind outputLayout)
+    : m_crop(config), m_scale(config), m_color(config), m_intensity(config), m_mean(config),
+      m_outputLayout(outputLayout), m_imageElementType(0)
+{
+    m_transformers = { &m_crop, &m_scale, &m_color, &m_intensity };
+}
+
+void FusedImageTransformer::StartEpoch(const EpochConfiguration& config)
+{
+    for (auto t : m_transformers)
+    {
+        t->StartEpoch(config);
+    }
+
+    m_mean.StartEpoch(config);
+}
+
+// The method describes how input stream is transformed to the output stream. Called once per applied stream.
+StreamDescription FusedImageTransformer::Transform(const StreamDescription& inputStream)
+{
+    m_inputStream = inputStream;
+
+    StreamDescription stream = inputStream;
+    for (auto t : m_transformers)
+    {
+        stream = t->Transform(stream);
+    }
+
+    stream = m_mean.Transform(stream);
+    m_imageElementType = m_mean.m_imageElementType;
+
+    // The mean is subtracted element by element, so bring it to the element type of the stream once.
+    cv::Mat& meanImage = m_mean.m_meanImg;
+    if (!meanImage.empty() && meanImage.depth() != m_imageElementType)
+    {
+        meanImage.convertTo(meanImage, m_imageElementType);
+    }
+
+    ImageDimensions dimensions(*stream.m_sampleLayout, HWC);
+    m_outputStream = stream;
+    m_outputStream.m_sampleLayout = std::make_shared<TensorShape>(dimensions.AsTensorShape(m_outputLayout));
+    return m_outputStream;
+}
+
+// Transforms a single sequence. Called once per sequence.
+SequenceDataPtr FusedImageTransformer::Transform(SequenceDataPtr sequence)
+{
+    const auto& inputSequence = static_cast<const DenseSequenceData&>(*sequence);
+
+    // Images coming from the deserializer can still be in their decoded element type,
+    // otherwise the sequence data is in the element type of the stream.
+    cv::Mat image;
+    auto decodedImage = dynamic_cast<const DeserializedImage*>(sequence.get());
+    if (decodedImage != nullptr)
+    {
+        image = decodedImage->m_image;
+    }
+    else
+    {
+        ImageDimensions dimensions(*inputSequence.m_sampleLayout, HWC);
+        int type = CV_MAKETYPE(m_imageElementType, static_cast<int>(dimensions.m_numChannels));
+        image = cv::Mat(static_cast<int>(dimensions.m_height), static_cast<int>(dimensions.m_width), type, inputSequence.m_data);
+    }
+
+    // Crop first, so that only the cropped region is converted.
+    assert(m_transformers.front() == &m_crop);
+    m_transformers.front()->Apply(sequence->m_id, image);
+    if (image.depth() != m_imageElementType)
+    {
+        image.convertTo(image, m_imageElementType);
+    }
+
+    for (size_t i = 1; i < m_transformers.size(); ++i)
+    {
+        m_transformers[i]->Apply(sequence->m_id, image);
+    }
+
+    if (!image.isContinuous())
+    {
+        image = image.clone();
+    }
+    assert(image.isContinuous());
+
+    auto result = std::make_shared<DenseSequenceWithBuffer>();
+    size_t count = m_outputStream.m_sampleLayout->GetNumElements();
+    assert(count == image.total() * image.channels());
+    result->m_buffer.resize(count * GetSizeByType(m_inputStream.m_elementType));
+
+    if (m_imageElementType == CV_64F)
+    {
+        CopyToOutput(image, reinterpret_cast<double*>(result->m_buffer.data()));
+    }
+    else
+    {
+        assert(m_imageElementType == CV_32F);
+        CopyToOutput(image, reinterpret_cast<float*>(result->m_buffer.data()));
+    }
+
+    result->m_sampleLayout = m_outputStream.m_sampleLayout;
+    result->m_data = result->m_buffer.data();
+    result->m_numberOfSamples = inputSequence.m_numberOfSamples;
+    return result;
+}
+
+template <class TElement>
+void FusedImageTransformer::CopyToOutput(const cv::Mat& image, TElement* output) const
+{
+    // Same as MeanTransformer, only subtract the mean if it matches the size of the image.
+    const cv::Mat& meanImage = m_mean.m_meanImg;
+    bool subtractMean = !meanImage.empty() && meanImage.size() == image.size();
+    assert(!subtractMean || (meanImage.channels() == image.channels() && meanImage.isContinuous()));
+
+    const TElement* src = image.ptr<TElement>();
+    const TElement* mean = subtractMean ? meanImage.ptr<TElement>() : nullptr;
+    size_t pixelCount = image.total();
+    size_t channelCount = image.channels();
+
+    if (m_outputLayout == CHW)
+    {
+        for (size_t ipixel = 0; ipixel < pixelCount; ipixel++)
+        {
+            for (size_t ichannel = 0; ichannel < channelCount; ichannel++)
+            {
+                size_t isrc = ipixel * channelCount + ichannel;
+                output[ichannel * pixelCount + ipixel] = subtractMean ? src[isrc] - mean[isrc] : src[isrc];
+            }
+        }
+    }
+    else
+    {
+        size_t count = pixelCount * channelCount;
+        for (size_t i = 0; i < count; i++)
+        {
+            output[i] = subtractMean ? src[i] - mean[i] : src[i];
+        }
+    }
+}
+
 }}}
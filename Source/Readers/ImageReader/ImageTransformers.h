@@ -47,6 +47,8 @@ protected:
     // The only function that should be redefined by the inherited classes.
     virtual void Apply(size_t id, cv::Mat &from) = 0;
 
+    friend class FusedImageTransformer;
+
 protected:
     StreamDescription m_inputStream;
     StreamDescription m_outputStream;
@@ -121,6 +123,8 @@ private:
     void Apply(size_t id, cv::Mat &mat) override;
 
     cv::Mat m_meanImg;
+
+    friend class FusedImageTransformer;
 };
 
 // Transpose transformation from HWC to CHW (note: row-major notation).
@@ -196,4 +200,42 @@ private:
     conc_stack<std::unique_ptr<cv::Mat>> m_hsvTemp;
 };
 
+// Crop, scale, color, intensity and mean transformations followed by the output layout conversion,
+// applied in one go. Produces the same result as the chain of the individual transformers without
+// the intermediate copies: cropping only takes a view of the decoded image, so only the cropped region
+// is converted to the element type of the stream, and the mean is subtracted while the result is
+// written to the output buffer in the requested layout (HWC or CHW).
+class FusedImageTransformer : public Transformer
+{
+public:
+    FusedImageTransformer(const ConfigParameters& config, ImageLayoutKind outputLayout);
+
+    void StartEpoch(const EpochConfiguration& config) override;
+
+    // Transformation of the stream.
+    StreamDescription Transform(const StreamDescription& inputStream) override;
+
+    // Transformation of the sequence.
+    SequenceDataPtr Transform(SequenceDataPtr sequence) override;
+
+private:
+    // Subtracts the mean image and writes the result in the output layout.
+    template <class TElement>
+    void CopyToOutput(const cv::Mat& image, TElement* output) const;
+
+    CropTransformer m_crop;
+    ScaleTransformer m_scale;
+    ColorTransformer m_color;
+    IntensityTransformer m_intensity;
+    MeanTransformer m_mean;
+
+    // Transformers applied to the image before the mean subtraction, in order.
+    std::vector<ImageTransformerBase*> m_transformers;
+
+    ImageLayoutKind m_outputLayout;
+    StreamDescription m_inputStream;
+    StreamDescription m_outputStream;
+    int m_imageElementType;
+};
+
 }}}
@@ -9,6 +9,16 @@
 
 #ifdef USE_ZIP
 
+#include <cstring>
+#include <limits>
+#include <zlib.h>
+#ifndef __WINDOWS__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace Microsoft { namespace MSR { namespace CNTK {
 
 std::string GetZipError(int err)
@@ -20,12 +30,234 @@ std::string GetZipError(int err)
     return errS;
 }
 
+// Read-only memory mapping of the whole zip archive.
+class ZipByteReader::MappedArchive
+{
+public:
+    explicit MappedArchive(const std::string& path)
+        : m_data(nullptr), m_size(0)
+    {
+#ifdef __WINDOWS__
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE)
+            RuntimeError("Could not open %s, error %x", path.c_str(), GetLastError());
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(m_file, &size);
+        m_size = static_cast<size_t>(size.QuadPart);
+        m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_mapping == NULL)
+            RuntimeError("Could not memory map %s, error %x", path.c_str(), GetLastError());
+
+        m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr)
+            RuntimeError("Could not memory map %s, error %x", path.c_str(), GetLastError());
+#else
+        m_file = open(path.c_str(), O_RDONLY);
+        if (m_file == -1)
+            RuntimeError("Could not open %s", path.c_str());
+
+        struct stat sb;
+        if (fstat(m_file, &sb) == -1)
+            RuntimeError("Could not retrieve file size of %s", path.c_str());
+        m_size = sb.st_size;
+
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+        if (data == MAP_FAILED)
+            RuntimeError("Could not memory map %s", path.c_str());
+        m_data = static_cast<const unsigned char*>(data);
+#endif
+    }
+
+    ~MappedArchive()
+    {
+#ifdef __WINDOWS__
+        if (m_data != nullptr)
+            UnmapViewOfFile(m_data);
+        if (m_mapping != NULL)
+            CloseHandle(m_mapping);
+        CloseHandle(m_file);
+#else
+        if (m_data != nullptr)
+            munmap(const_cast<unsigned char*>(m_data), m_size);
+        close(m_file);
+#endif
+    }
+
+    const unsigned char* Data() const
+    {
+        return m_data;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+    DISABLE_COPY_AND_MOVE(MappedArchive);
+
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+#ifdef __WINDOWS__
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_file;
+#endif
+};
+
+// Raw deflate decompressor. The zlib stream and the output buffer are reused between calls.
+class ZipByteReader::Inflater
+{
+public:
+    Inflater()
+    {
+        memset(&m_stream, 0, sizeof(m_stream));
+        if (inflateInit2(&m_stream, -MAX_WBITS) != Z_OK)
+            RuntimeError("Failed to initialize zlib decompression.");
+    }
+
+    ~Inflater()
+    {
+        inflateEnd(&m_stream);
+    }
+
+    // Decompresses the entry, the returned buffer is valid until the next call.
+    const std::vector<unsigned char>& Inflate(const unsigned char* data, zip_uint64_t compressedSize, zip_uint64_t size, const std::string& path)
+    {
+        if (m_buffer.size() < size)
+            m_buffer.resize(size);
+
+        int err = inflateReset(&m_stream);
+        if (err == Z_OK)
+        {
+            m_stream.next_in = const_cast<Bytef*>(data);
+            m_stream.avail_in = static_cast<uInt>(compressedSize);
+            m_stream.next_out = m_buffer.data();
+            m_stream.avail_out = static_cast<uInt>(size);
+            err = inflate(&m_stream, Z_FINISH);
+        }
+
+        if (err != Z_STREAM_END || m_stream.total_out != size)
+            RuntimeError("Failed to decompress %s from the zip file, zlib error: %d", path.c_str(), err);
+
+        return m_buffer;
+    }
+
+    DISABLE_COPY_AND_MOVE(Inflater);
+
+private:
+    z_stream m_stream;
+    std::vector<unsigned char> m_buffer;
+};
+
+static zip_uint16_t ReadUInt16(const unsigned char* p)
+{
+    return static_cast<zip_uint16_t>(p[0] | (p[1] << 8));
+}
+
+static zip_uint32_t ReadUInt32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<zip_uint32_t>(p[3]) << 24);
+}
+
+static zip_uint64_t ReadUInt64(const unsigned char* p)
+{
+    return ReadUInt32(p) | (static_cast<zip_uint64_t>(ReadUInt32(p + 4)) << 32);
+}
+
+static const zip_uint64_t s_invalidOffset = std::numeric_limits<zip_uint64_t>::max();
+
+// Collects offsets of the local file headers from the central directory. Entries are listed
+// in the order of their libzip indices. Returns an empty vector if the central directory cannot be parsed,
+// all entries are then read through libzip.
+static std::vector<zip_uint64_t> ReadLocalHeaderOffsets(const unsigned char* data, size_t size)
+{
+    std::vector<zip_uint64_t> offsets;
+
+    // The end of central directory record is at the end of the archive, followed by a comment of at most 64K.
+    const size_t endRecordSize = 22;
+    if (size < endRecordSize)
+        return offsets;
+
+    size_t endRecord = size - endRecordSize;
+    size_t minEndRecord = endRecord > 0xFFFF ? endRecord - 0xFFFF : 0;
+    while (ReadUInt32(data + endRecord) != 0x06054b50)
+    {
+        if (endRecord == minEndRecord)
+            return offsets;
+        endRecord--;
+    }
+
+    zip_uint64_t entryCount = ReadUInt16(data + endRecord + 10);
+    zip_uint64_t directoryOffset = ReadUInt32(data + endRecord + 16);
+
+    // Zip64 archives keep the actual values in the zip64 end of central directory record.
+    const size_t locatorSize = 20;
+    if ((entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF) &&
+        endRecord >= locatorSize && ReadUInt32(data + endRecord - locatorSize) == 0x07064b50)
+    {
+        zip_uint64_t endRecord64 = ReadUInt64(data + endRecord - locatorSize + 8);
+        if (size < 56 || endRecord64 > size - 56 || ReadUInt32(data + endRecord64) != 0x06064b50)
+            return offsets;
+        entryCount = ReadUInt64(data + endRecord64 + 32);
+        directoryOffset = ReadUInt64(data + endRecord64 + 48);
+    }
+
+    const size_t headerSize = 46;
+    offsets.reserve(std::min<zip_uint64_t>(entryCount, size / headerSize));
+    zip_uint64_t pos = directoryOffset;
+    for (zip_uint64_t i = 0; i < entryCount; ++i)
+    {
+        if (size < headerSize || pos > size - headerSize || ReadUInt32(data + pos) != 0x02014b50)
+            return std::vector<zip_uint64_t>();
+
+        zip_uint64_t nameLength = ReadUInt16(data + pos + 28);
+        zip_uint64_t extraLength = ReadUInt16(data + pos + 30);
+        zip_uint64_t commentLength = ReadUInt16(data + pos + 32);
+        zip_uint64_t offset = ReadUInt32(data + pos + 42);
+        if (offset == 0xFFFFFFFF)
+        {
+            // The offset is in the zip64 extra field, after the sizes that do not fit into 32 bits.
+            offset = s_invalidOffset;
+            zip_uint64_t extra = pos + headerSize + nameLength;
+            zip_uint64_t extraEnd = extra + extraLength;
+            while (extraEnd <= size && extra + 4 <= extraEnd)
+            {
+                zip_uint64_t fieldLength = ReadUInt16(data + extra + 2);
+                if (ReadUInt16(data + extra) == 0x0001)
+                {
+                    zip_uint64_t field = extra + 4;
+                    if (ReadUInt32(data + pos + 24) == 0xFFFFFFFF)
+                        field += 8;
+                    if (ReadUInt32(data + pos + 20) == 0xFFFFFFFF)
+                        field += 8;
+                    if (field + 8 <= extra + 4 + fieldLength && field + 8 <= extraEnd)
+                        offset = ReadUInt64(data + field);
+                    break;
+                }
+                extra += 4 + fieldLength;
+            }
+        }
+
+        offsets.push_back(offset);
+        pos += headerSize + nameLength + extraLength + commentLength;
+    }
+
+    return offsets;
+}
+
 ZipByteReader::ZipByteReader(const std::string& zipPath)
     : m_zipPath(zipPath)
 {
     assert(!m_zipPath.empty());
 }
 
+ZipByteReader::~ZipByteReader()
+{
+}
+
 ZipByteReader::ZipPtr ZipByteReader::OpenZip()
 {
     int err = ZIP_ER_OK;
@@ -52,19 +284,84 @@ void ZipByteReader::Register(size_t seqId, const std::string& path)
     int err = zip_stat(zipFile.get(), path.c_str(), 0, &stat);
     if (ZIP_ER_OK != err)
         RuntimeError("Failed to get file info of %s, zip library error: %s", path.c_str(), GetZipError(err).c_str());
-    m_seqIdToIndex[seqId] = std::make_pair(stat.index, stat.size);
     m_zips.push(std::move(zipFile));
+
+    // Registration happens on a single thread before any reads, so the archive is mapped here.
+    if (!m_archive)
+    {
+        m_archive = std::make_unique<MappedArchive>(m_zipPath);
+        m_localHeaderOffsets = ReadLocalHeaderOffsets(m_archive->Data(), m_archive->Size());
+    }
+
+    Entry entry;
+    entry.m_index = stat.index;
+    entry.m_size = stat.size;
+    entry.m_compressedSize = stat.comp_size;
+    entry.m_method = stat.comp_method;
+    entry.m_data = nullptr;
+
+    // Only unencrypted stored or deflated entries are read directly from the mapping.
+    const zip_uint64_t requiredFields = ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_COMP_METHOD | ZIP_STAT_ENCRYPTION_METHOD;
+    if ((stat.valid & requiredFields) == requiredFields &&
+        stat.encryption_method == ZIP_EM_NONE &&
+        (stat.comp_method == ZIP_CM_STORE || stat.comp_method == ZIP_CM_DEFLATE) &&
+        stat.size <= std::numeric_limits<uInt>::max() &&
+        stat.comp_size <= std::numeric_limits<uInt>::max())
+    {
+        entry.m_data = GetEntryData(stat.index, stat.comp_size);
+    }
+
+    m_seqIdToEntry[seqId] = entry;
+}
+
+const unsigned char* ZipByteReader::GetEntryData(zip_uint64_t index, zip_uint64_t compressedSize) const
+{
+    if (index >= m_localHeaderOffsets.size())
+        return nullptr;
+
+    const unsigned char* data = m_archive->Data();
+    size_t size = m_archive->Size();
+    zip_uint64_t offset = m_localHeaderOffsets[index];
+
+    // The data follows the local file header, which has its own name and extra field lengths.
+    const size_t headerSize = 30;
+    if (offset == s_invalidOffset || size < headerSize || offset > size - headerSize || ReadUInt32(data + offset) != 0x04034b50)
+        return nullptr;
+
+    zip_uint64_t start = offset + headerSize + ReadUInt16(data + offset + 26) + ReadUInt16(data + offset + 28);
+    if (start > size || size - start < compressedSize)
+        return nullptr;
+
+    return data + start;
 }
 
 cv::Mat ZipByteReader::Read(size_t seqId, const std::string& path, bool grayscale)
 {
     // Find index of the file in .zip file.
-    auto r = m_seqIdToIndex.find(seqId);
-    if (r == m_seqIdToIndex.end())
+    auto r = m_seqIdToEntry.find(seqId);
+    if (r == m_seqIdToEntry.end())
         RuntimeError("Could not find file %s in the zip file, sequence id = %lu", path.c_str(), (long)seqId);
 
-    zip_uint64_t index = std::get<0>((*r).second);
-    zip_uint64_t size = std::get<1>((*r).second);
+    const Entry& entry = r->second;
+    if (entry.m_data == nullptr)
+        return ReadFromZip(seqId, path, entry, grayscale);
+
+    // Stored entries are decoded straight from the mapping, without locking or copying.
+    if (entry.m_method == ZIP_CM_STORE)
+        return Decode(entry.m_data, entry.m_size, grayscale);
+
+    assert(entry.m_method == ZIP_CM_DEFLATE);
+    auto inflater = m_inflaters.pop_or_create([]() { return std::make_unique<Inflater>(); });
+    const auto& contents = inflater->Inflate(entry.m_data, entry.m_compressedSize, entry.m_size, path);
+    cv::Mat img = Decode(contents.data(), entry.m_size, grayscale);
+    m_inflaters.push(std::move(inflater));
+    return img;
+}
+
+cv::Mat ZipByteReader::ReadFromZip(size_t seqId, const std::string& path, const Entry& entry, bool grayscale)
+{
+    zip_uint64_t index = entry.m_index;
+    zip_uint64_t size = entry.m_size;
 
     auto contents = m_workspace.pop_or_create([size]() { return vector<unsigned char>(size); });
     if (contents.size() < size)
@@ -99,8 +396,7 @@ cv::Mat ZipByteReader::Read(size_t seqId, const std::string& path, bool grayscal
     }
     m_zips.push(std::move(zipFile));
 
-    cv::Mat img; 
-    img = cv::imdecode(cv::Mat(1, (int)size, CV_8UC1, contents.data()), grayscale ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+    cv::Mat img = Decode(contents.data(), size, grayscale);
     assert(nullptr != img.data);
     m_workspace.push(std::move(contents));
     return img;
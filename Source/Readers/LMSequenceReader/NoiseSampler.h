@@ -0,0 +1,154 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// NoiseSampler.h - unigram noise sampler for noise contrastive estimation in the LMSequenceReader
+//
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Samples words from a unigram distribution for noise contrastive estimation.
+// Uses Walker's alias method (built with Vose's algorithm in O(V)), so drawing a sample is O(1)
+// independent of the vocabulary size: pick a column uniformly, then either keep it or take its alias.
+template <typename Count>
+class noiseSampler
+{
+    std::vector<double> m_prob, m_log_prob;
+    std::vector<double> m_aliasThreshold; // probability of keeping column i rather than taking its alias
+    std::vector<Count> m_alias;
+    std::uniform_int_distribution<Count> unif_int;
+    std::uniform_real_distribution<double> unif_real;
+    bool uniform_sampling;
+    double uniform_prob;
+    double uniform_log_prob;
+    std::mt19937 rng;
+
+    // mixing function (splitmix64 finalizer), used as a counter-based random number generator
+    static unsigned long long mix(unsigned long long x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    int lookup(Count column, double u) const
+    {
+        return (int) (u < m_aliasThreshold[column] ? column : m_alias[column]);
+    }
+
+public:
+    noiseSampler()
+    {
+    }
+    noiseSampler(const std::vector<double>& counts, bool xuniform_sampling = false)
+        : uniform_sampling(xuniform_sampling), rng(1234)
+    {
+        size_t k = counts.size();
+        uniform_prob = 1.0 / k;
+        uniform_log_prob = std::log(uniform_prob);
+        unif_int = std::uniform_int_distribution<Count>(0, (long) counts.size() - 1);
+
+        double total = 0;
+        for (size_t i = 0; i < k; i++)
+            total += counts[i];
+        m_prob.resize(k);
+        m_log_prob.resize(k);
+        for (size_t i = 0; i < k; i++)
+        {
+            m_prob[i] = counts[i] / total;
+            m_log_prob[i] = std::log(m_prob[i]);
+        }
+
+        // Vose's alias method: scale probabilities to mean 1 and pair each under-full column with an over-full one
+        m_aliasThreshold.resize(k);
+        m_alias.resize(k);
+        std::vector<Count> small, large;
+        for (size_t i = 0; i < k; i++)
+        {
+            m_aliasThreshold[i] = m_prob[i] * k;
+            m_alias[i] = (Count) i;
+            if (m_aliasThreshold[i] < 1.0)
+                small.push_back((Count) i);
+            else
+                large.push_back((Count) i);
+        }
+        while (!small.empty() && !large.empty())
+        {
+            Count s = small.back();
+            small.pop_back();
+            Count l = large.back();
+            m_alias[s] = l;
+            m_aliasThreshold[l] -= 1.0 - m_aliasThreshold[s];
+            if (m_aliasThreshold[l] < 1.0)
+            {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // whatever is left is 1 up to rounding
+        for (Count i : small)
+            m_aliasThreshold[i] = 1.0;
+        for (Count i : large)
+            m_aliasThreshold[i] = 1.0;
+    }
+    int size() const
+    {
+        return m_prob.size();
+    }
+    double prob(int i) const
+    {
+        if (uniform_sampling)
+            return uniform_prob;
+        else
+            return m_prob[i];
+    }
+    double logprob(int i) const
+    {
+        if (uniform_sampling)
+            return uniform_log_prob;
+        else
+            return m_log_prob[i];
+    }
+
+    template <typename Engine>
+    int sample(Engine& eng)
+    {
+        Count m = unif_int(eng);
+        if (uniform_sampling)
+            return (int) m;
+        return lookup(m, unif_real(eng));
+    }
+
+    int sample()
+    {
+        return sample(this->rng);
+    }
+
+    // Draws n samples into a preallocated buffer.
+    // Sample i of stream 'stream' only depends on (seed, stream, i), so the samples can be drawn in parallel
+    // and are reproducible independent of the number of threads.
+    void sample(int* samples, size_t n, unsigned long long seed, unsigned long long stream) const
+    {
+        const unsigned long long key = mix(mix(seed) ^ stream);
+        const unsigned long long k = m_prob.size();
+#pragma omp parallel for if (n > 4096)
+        for (long i = 0; i < (long) n; i++)
+        {
+            unsigned long long r = mix(key + (unsigned long long) i);
+            // upper 32 bits select the column, lower 32 bits give the uniform variate for the alias decision
+            Count column = (Count) (((r >> 32) * k) >> 32);
+            if (uniform_sampling)
+                samples[i] = (int) column;
+            else
+                samples[i] = lookup(column, (r & 0xffffffffull) * (1.0 / 4294967296.0));
+        }
+    }
+};
+
+}}}
@@ -20,6 +20,19 @@
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
+// The reader does not support distributed reading, so it is not told its rank. Under mpiexec the rank is in the
+// environment (OMPI_COMM_WORLD_RANK for Open MPI, PMI_RANK for MPICH and MS-MPI).
+static unsigned int GetMPIRank()
+{
+    for (const char* name : { "OMPI_COMM_WORLD_RANK", "PMI_RANK" })
+    {
+        const char* rank = getenv(name);
+        if (rank != nullptr)
+            return (unsigned int) atoi(rank);
+    }
+    return 0;
+}
+
 // add this to all 
 static void FailBecauseDeprecated(const char * fnName)
 {
@@ -604,10 +617,10 @@ void SequenceReader<ElemType>::ReadWord(char* word, FILE* fin)
 
 template <class ElemType>
 void SequenceReader<ElemType>::ReadClassInfo(const wstring& vocfile, int& classSize,
-                                             map<string, int>& word4idx,
-                                             map<int, string>& idx4word,
-                                             map<int, int>& idx4class,
-                                             map<int, size_t>& idx4cnt,
+                                             unordered_map<string, int>& word4idx,
+                                             vector<string>& idx4word,
+                                             vector<int>& idx4class,
+                                             vector<size_t>& idx4cnt,
                                              int nwords, // only used for a consistency check
                                              string mUnk,
                                              noiseSampler<long>& m_noiseSampler,
@@ -639,6 +652,14 @@ void SequenceReader<ElemType>::ReadClassInfo(const wstring& vocfile, int& classS
         strtmp = tokens[2];
         clsidx = stoi(tokens[3]);
 
+        if (b < 0)
+            RuntimeError("ReadClassInfo: invalid word index %d in word class file", b);
+        if ((size_t) b >= idx4word.size())
+        {
+            idx4cnt.resize(b + 1, 0);
+            idx4word.resize(b + 1);
+            idx4class.resize(b + 1, 0);
+        }
         idx4cnt[b] = cnt;
         word4idx[strtmp] = b;
         idx4word[b] = strtmp;
@@ -650,12 +671,11 @@ void SequenceReader<ElemType>::ReadClassInfo(const wstring& vocfile, int& classS
     classSize++;
 
     // Note: If users specify labelDim = 0 (->nwords) this will not fail. Later we will interpret this as "infer".
-    if (idx4class.size() < nwords)
-        RuntimeError("ReadClassInfo: The actual number of words %d is smaller than the specified vocabulary size %d. Check if labelDim is too large. ", (int) idx4class.size(), (int) nwords);
+    // idx4class is sized by the largest word id, which can exceed the number of words if ids are sparse, so count the words.
+    if (word4idx.size() < nwords)
+        RuntimeError("ReadClassInfo: The actual number of words %d is smaller than the specified vocabulary size %d. Check if labelDim is too large. ", (int) word4idx.size(), (int) nwords);
 
-    std::vector<double> counts(idx4cnt.size());
-    for (const auto& p : idx4cnt)
-        counts[p.first] = (double) p.second;
+    std::vector<double> counts(idx4cnt.begin(), idx4cnt.end());
     m_noiseSampler = noiseSampler<long>(counts);
 
     // check if unk is the same used in vocabulary file
@@ -906,6 +926,7 @@ void SequenceReader<ElemType>::StartMinibatchLoop(size_t mbSize, size_t epoch, s
     size_t epochSize = m_epochSize == requestDataSize ? 1000 : m_epochSize;
     m_epoch = epoch;
     m_mbStartSample = epoch * m_epochSize;
+    m_noiseSampleStream = (unsigned long long) epoch << 32;
 
     // allocate room for the data
     m_featureData.reserve(m_featureCount * epochSize);
@@ -1000,6 +1021,10 @@ void SequenceReader<ElemType>::GetLabelOutput(StreamMinibatchInputs& matrices,
     else if (readerMode == ReaderMode::Softmax)
         labels.Resize(1, actualmbsize);
 
+    size_t noiseStride = 0;
+    if (readerMode == ReaderMode::NCE)
+        noiseStride = DrawNoiseSamples(actualmbsize);
+
     for (size_t jSample = m_mbStartSample; j < actualmbsize; ++j, ++jSample)
     {
         // pick the right sample with randomization if desired
@@ -1012,14 +1037,14 @@ void SequenceReader<ElemType>::GetLabelOutput(StreamMinibatchInputs& matrices,
             labels.SetValue(1, j, (ElemType) m_noiseSampler.logprob(wrd));
             for (size_t noiseid = 0; noiseid < m_noiseSampleSize; noiseid++)
             {
-                int wid = m_noiseSampler.sample();
+                int wid = m_noiseSamples[j * noiseStride + noiseid];
                 labels.SetValue(2 * (noiseid + 1), j, (ElemType) wid);
                 labels.SetValue(2 * (noiseid + 1) + 1, j, -(ElemType) m_noiseSampler.logprob(wid));
             }
         }
         else if (readerMode == ReaderMode::Class)
         {
-            int clsidx = idx4class[wrd];
+            int clsidx = ClassOfWord(wrd);
             if (m_classSize > 0)
             {
                 labels.SetValue(1, j, (ElemType) clsidx);
@@ -1083,7 +1108,7 @@ void SequenceReader<ElemType>::GetInputToClass(StreamMinibatchInputs& matrices)
     m_id2classLocal->TransferFromDeviceToDevice(curDevId, CPUDEVICE, true, false, false);
     for (size_t j = 0; j < nwords; j++)
     {
-        int clsidx = idx4class[(int) j];
+        int clsidx = ClassOfWord(j);
         (*m_id2classLocal)(j, 0) = (float) clsidx;
     }
     m_id2classLocal->TransferFromDeviceToDevice(CPUDEVICE, curDevId, true, false, false);
@@ -1114,7 +1139,7 @@ void SequenceReader<ElemType>::GetClassInfo()
     int prvcls = -1;
     for (size_t j = 0; j < nwords; j++)
     {
-        clsidx = idx4class[(int) j];
+        clsidx = ClassOfWord(j);
         if (prvcls != clsidx && clsidx > prvcls)
         {
             if (prvcls >= 0)
@@ -1417,6 +1442,10 @@ void BatchSequenceReader<ElemType>::InitFromConfig(const ConfigRecordType& reade
     {
         readerMode = ReaderMode::NCE;
         m_noiseSampleSize = featureConfig(L"noise_number", 0);
+        m_shareNoiseSamples = featureConfig(L"shareNoiseSamples", false);
+        // ranks of a data-parallel run read the same minibatches, so they must not draw the same noise
+        int noiseSeed = featureConfig(L"noiseSeed", 1234);
+        m_noiseSeed = ((unsigned long long) GetMPIRank() << 32) | (unsigned int) noiseSeed;
     }
     else if (EqualCI(mode, L"softmax"))
         readerMode = ReaderMode::Softmax;
@@ -1654,6 +1683,7 @@ void BatchSequenceReader<ElemType>::StartMinibatchLoop(size_t mbSize, size_t epo
     size_t epochSize = m_epochSize == requestDataSize ? 1000 : m_epochSize;
     m_epoch = epoch;
     m_randomSeed = (unsigned int)m_epoch;
+    m_noiseSampleStream = (unsigned long long) epoch << 32; // the same noise after a restart from a checkpoint
     m_mbStartSample = epoch * m_epochSize;
     m_epochSamplesReturned = 0;     // counter to know when we returned one epoch
 
@@ -2108,6 +2138,10 @@ void BatchSequenceReader<ElemType>::GetLabelOutput(StreamMinibatchInputs& matric
 
     ElemType epsilon = (ElemType) 1e-6; // avoid all zero, although this is almost impossible.
 
+    size_t noiseStride = 0;
+    if (readerMode == ReaderMode::NCE)
+        noiseStride = DrawNoiseSamples(actualmbsize);
+
     for (size_t jSample = mbStartSample; j < actualmbsize; ++j, ++jSample)
     {
         // get the token
@@ -2122,14 +2156,14 @@ void BatchSequenceReader<ElemType>::GetLabelOutput(StreamMinibatchInputs& matric
             labels.SetValue(1, j, (ElemType) m_noiseSampler.logprob(wrd));
             for (size_t noiseid = 0; noiseid < m_noiseSampleSize; noiseid++)
             {
-                int wid = m_noiseSampler.sample();
+                int wid = m_noiseSamples[j * noiseStride + noiseid];
                 labels.SetValue(2 * (noiseid + 1), j, (ElemType) wid);
                 labels.SetValue(2 * (noiseid + 1) + 1, j, -(ElemType) m_noiseSampler.logprob(wid));
             }
         }
         else if (readerMode == ReaderMode::Class)
         {
-            int clsidx = idx4class[wrd];
+            int clsidx = ClassOfWord(wrd);
             if (m_classSize > 0)
             {
                 labels.SetValue(1, j, (ElemType) clsidx);
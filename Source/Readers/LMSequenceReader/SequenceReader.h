@@ -12,8 +12,10 @@
 #include "Config.h"
 #include "SequenceParser.h"
 #include "RandomOrdering.h"
+#include "NoiseSampler.h"
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <random>
 
@@ -42,71 +44,6 @@ enum ReaderMode
     None = 4, // some other type of label
 };
 
-template <typename Count>
-class noiseSampler
-{
-    std::vector<double> m_prob, m_log_prob;
-    std::uniform_int_distribution<Count> unif_int;
-    bool uniform_sampling;
-    double uniform_prob;
-    double uniform_log_prob;
-    std::piecewise_constant_distribution<double> d;
-    std::mt19937 rng;
-
-public:
-    noiseSampler()
-    {
-    }
-    noiseSampler(const std::vector<double>& counts, bool xuniform_sampling = false)
-        : uniform_sampling(xuniform_sampling), rng(1234)
-    {
-        size_t k = counts.size();
-        uniform_prob = 1.0 / k;
-        uniform_log_prob = std::log(uniform_prob);
-        std::vector<double> vn(counts.size() + 1);
-        for (int i = 0; i < vn.size(); i++)
-            vn[i] = i;
-        d = std::piecewise_constant_distribution<double>(vn.begin(), vn.end(), counts.begin());
-        unif_int = std::uniform_int_distribution<Count>(0, (long) counts.size() - 1);
-        m_prob = d.densities();
-        m_log_prob.resize(m_prob.size());
-        for (int i = 0; i < k; i++)
-            m_log_prob[i] = std::log(m_prob[i]);
-    }
-    int size() const
-    {
-        return m_prob.size();
-    }
-    double prob(int i) const
-    {
-        if (uniform_sampling)
-            return uniform_prob;
-        else
-            return m_prob[i];
-    }
-    double logprob(int i) const
-    {
-        if (uniform_sampling)
-            return uniform_log_prob;
-        else
-            return m_log_prob[i];
-    }
-
-    template <typename Engine>
-    int sample(Engine& eng)
-    {
-        int m = unif_int(eng);
-        if (uniform_sampling)
-            return m;
-        return (int) d(eng);
-    }
-
-    int sample()
-    {
-        return sample(this->rng);
-    }
-};
-
 // Note: This class is deprecated for standalone use, only used as a base for BatchSequenceReader which overrides most of the functions.
 template <class ElemType>
 class SequenceReader : public DataReaderBase
@@ -118,10 +55,10 @@ protected:
     bool m_idx2probRead;
 
 public:
-    map<string, int> word4idx;
-    map<int, string> idx4word;
-    map<int, int> idx4class;
-    map<int, size_t> idx4cnt;
+    unordered_map<string, int> word4idx;
+    vector<string> idx4word; // [word id]
+    vector<int> idx4class;   // [word id]
+    vector<size_t> idx4cnt;  // [word id]
     int nwords, dims, nsamps, nglen, nmefeats;
     Matrix<ElemType>* m_id2classLocal;  // CPU version
     Matrix<ElemType>* m_classInfoLocal; // CPU version
@@ -130,8 +67,27 @@ public:
     int m_classSize;
     map<int, vector<int>> class_words;
 
+    // class of a word; words without class information are in class 0
+    int ClassOfWord(size_t wrd) const
+    {
+        return wrd < idx4class.size() ? idx4class[wrd] : 0;
+    }
+
     int m_noiseSampleSize;
     noiseSampler<long> m_noiseSampler;
+    bool m_shareNoiseSamples = false;         // use the same noise samples for all words of a minibatch
+    unsigned long long m_noiseSeed = 1234;    // noiseSeed from the config, with the MPI rank in the upper 32 bits
+    unsigned long long m_noiseSampleStream = 0; // epoch in the upper 32 bits, minibatch within the epoch in the lower ones
+    std::vector<int> m_noiseSamples;          // buffer for the noise samples of a minibatch
+
+    // draws the noise samples for a minibatch of the given size into m_noiseSamples, returns the stride between words
+    size_t DrawNoiseSamples(size_t actualmbsize)
+    {
+        const size_t n = m_shareNoiseSamples ? m_noiseSampleSize : m_noiseSampleSize * actualmbsize;
+        m_noiseSamples.resize(n);
+        m_noiseSampler.sample(m_noiseSamples.data(), n, m_noiseSeed, m_noiseSampleStream++);
+        return m_shareNoiseSamples ? 0 : m_noiseSampleSize;
+    }
 
     ReaderMode readerMode;
     int eos_idx, unk_idx;
@@ -197,7 +153,7 @@ protected:
     {
         LabelKind type; // labels are categories, create mapping table
         std::map<LabelIdType, LabelType> mapIdToLabel;
-        std::map<LabelType, LabelIdType> mapLabelToId;
+        std::unordered_map<LabelType, LabelIdType> mapLabelToId; // looked up for every token
         LabelIdType numIds;        // maximum label ID we have encountered so far
         LabelIdType dim;           // maximum label ID we will ever see (used for array dimensions)
         std::string beginSequence; // starting sequence string (i.e. <s>)
@@ -238,10 +194,10 @@ public:
         InitFromConfig(config);
     }
     static void ReadClassInfo(const wstring& vocfile, int& classSize,
-                              map<string, int>& word4idx,
-                              map<int, string>& idx4word,
-                              map<int, int>& idx4class,
-                              map<int, size_t>& idx4cnt,
+                              unordered_map<string, int>& word4idx,
+                              vector<string>& idx4word,
+                              vector<int>& idx4class,
+                              vector<size_t>& idx4cnt,
                               int nwords,
                               string mUnk,
                               noiseSampler<long>& m_noiseSampler,
@@ -344,9 +300,15 @@ public:
     //using Base::m_featuresBufferRowIdx;
     using Base::m_sequence;
     using Base::idx4class;
+    using Base::ClassOfWord;
     using Base::m_indexer;
     using Base::m_noiseSampleSize;
     using Base::m_noiseSampler;
+    using Base::m_noiseSamples;
+    using Base::m_shareNoiseSamples;
+    using Base::m_noiseSeed;
+    using Base::m_noiseSampleStream;
+    using Base::DrawNoiseSamples;
     using Base::readerMode;
     using Base::GetIdFromLabel;
     using Base::GetInputToClass;
@@ -121,7 +121,7 @@ bool LMSequenceWriter<ElemType>::SaveData(size_t /*recordStart*/, const std::map
 }
 
 template <class ElemType>
-void LMSequenceWriter<ElemType>::Save(std::wstring& outputFile, const Matrix<ElemType>& outputData, const map<int, string>& idx2wrd, const int& nbest)
+void LMSequenceWriter<ElemType>::Save(std::wstring& outputFile, const Matrix<ElemType>& outputData, const vector<string>& idx2wrd, const int& nbest)
 {
     size_t nT = outputData.GetNumCols();
     size_t nD = min(idx2wrd.size(), outputData.GetNumRows());
@@ -173,13 +173,13 @@ void LMSequenceWriter<ElemType>::Save(std::wstring& outputFile, const Matrix<Ele
                 if (lv[i].second != 0)
                 {
                     int idx = (int) lv[i].first;
-                    string sRes = idx2wrd.find(idx)->second;
+                    string sRes = idx2wrd[idx];
                     fprintf(fp, "%s ", sRes.c_str());
                 }
             }
             else
             {
-                string sRes = idx2wrd.find(imax)->second;
+                string sRes = idx2wrd[imax];
                 fprintf(fp, "%s ", sRes.c_str());
                 fprintf(stderr, "%s ", sRes.c_str());
             }
@@ -22,10 +22,10 @@ private:
     std::vector<size_t> udims;
     int m_classSize;
     map<wstring, map<int, vector<int>>> class_words;
-    map<wstring, map<string, int>> word4idx;
-    map<wstring, map<int, string>> idx4word;
-    map<wstring, map<int, int>> idx4class;
-    map<wstring, map<int, size_t>> idx4cnt;
+    map<wstring, unordered_map<string, int>> word4idx;
+    map<wstring, vector<string>> idx4word;
+    map<wstring, vector<int>> idx4class;
+    map<wstring, vector<size_t>> idx4cnt;
     int nwords;
 
     map<wstring, string> mUnk; // unk symbol
@@ -36,7 +36,7 @@ private:
     map<wstring, int> nBests;
     bool compare_val(const ElemType& first, const ElemType& second);
 
-    void Save(std::wstring& outputFile, const Matrix<ElemType>& outputData, const map<int, string>& idx2wrd, const int& nbest = 1);
+    void Save(std::wstring& outputFile, const Matrix<ElemType>& outputData, const vector<string>& idx2wrd, const int& nbest = 1);
 
     void ReadLabelInfo(const wstring& vocfile,
                        map<string, int>& word4idx,
@@ -45,7 +45,7 @@ template class LUSequenceParser<double, std::string>;
 template class LUSequenceParser<double, std::wstring>;
 
 template <class NumType, class LabelType>
-long BatchLUSequenceParser<NumType, LabelType>::Parse(size_t recordsRequested, std::vector<long> *labels, std::vector<vector<long>> *input, std::vector<SequencePosition> *seqPos, const map<wstring, long> &inputlabel2id, const map<wstring, long> &outputlabel2id, bool canMultiplePassData)
+long BatchLUSequenceParser<NumType, LabelType>::Parse(size_t recordsRequested, std::vector<long> *labels, std::vector<vector<long>> *input, std::vector<SequencePosition> *seqPos, const unordered_map<wstring, long> &inputlabel2id, const unordered_map<wstring, long> &outputlabel2id, bool canMultiplePassData)
 {
     fprintf(stderr, "BatchLUSequenceParser: Parsing input data...\n");
 
@@ -97,25 +97,25 @@ long BatchLUSequenceParser<NumType, LabelType>::Parse(size_t recordsRequested, s
         vector<long> vtmp;
         for (size_t i = 0; i < vstr.size() - 1; i++)
         {
-            if (inputlabel2id.find(vstr[i]) == inputlabel2id.end())
+            auto found = inputlabel2id.find(vstr[i]);
+            if (found == inputlabel2id.end())
             {
-                if (inputlabel2id.find(mUnkStr) == inputlabel2id.end())
+                found = inputlabel2id.find(mUnkStr);
+                if (found == inputlabel2id.end())
                 {
                     LogicError("cannot find item %ls and unk str %ls in input label", vstr[i].c_str(), mUnkStr.c_str());
                 }
-                vtmp.push_back(inputlabel2id.find(mUnkStr)->second);
             }
-            else
-                vtmp.push_back(inputlabel2id.find(vstr[i])->second);
+            vtmp.push_back(found->second);
         }
-        if (outputlabel2id.find(vstr[vstr.size() - 1]) == outputlabel2id.end())
+        auto found = outputlabel2id.find(vstr[vstr.size() - 1]);
+        if (found == outputlabel2id.end())
         {
-            if (outputlabel2id.find(mUnkStr) == outputlabel2id.end())
+            found = outputlabel2id.find(mUnkStr);
+            if (found == outputlabel2id.end())
                 LogicError("cannot find item %ls and unk str %ls in output label", vstr[vstr.size() - 1].c_str(), mUnkStr.c_str());
-            labels->push_back(outputlabel2id.find(mUnkStr)->second);
         }
-        else
-            labels->push_back(outputlabel2id.find(vstr[vstr.size() - 1])->second);
+        labels->push_back(found->second);
         input->push_back(vtmp);
         if ((vstr[vstr.size() - 1] == m_endSequenceOut ||
              // below is for backward support
@@ -43,11 +43,11 @@ BatchLUSequenceReader<ElemType>::~BatchLUSequenceReader()
 
 template <class ElemType>
 void BatchLUSequenceReader<ElemType>::ReadLabelInfo(const wstring& vocfile,
-                                                    map<wstring, long>& word4idx,
+                                                    unordered_map<wstring, long>& word4idx,
                                                     bool readClass,
-                                                    map<wstring, long>& word4cls,
-                                                    map<long, wstring>& idx4word,
-                                                    map<long, long>& idx4class,
+                                                    unordered_map<wstring, long>& word4cls,
+                                                    vector<wstring>& idx4word,
+                                                    vector<long>& idx4class,
                                                     int& mNbrCls)
 {
     wifstream vin;
@@ -65,6 +65,8 @@ void BatchLUSequenceReader<ElemType>::ReadLabelInfo(const wstring& vocfile,
     int prevcls = -1;
 
     mNbrCls = 0;
+    idx4word.clear();
+    idx4class.clear();
     wstring strtmp;
     while (vin.good())
     {
@@ -78,24 +80,24 @@ void BatchLUSequenceReader<ElemType>::ReadLabelInfo(const wstring& vocfile,
             long cls = _wtoi(wordandcls[1].c_str());
             word4cls[wordandcls[0]] = cls;
 
-            idx4class[b] = cls;
+            idx4class.push_back(cls);
 
-            if (idx4class[b] != prevcls)
+            if (cls != prevcls)
             {
-                if (idx4class[b] < prevcls)
+                if (cls < prevcls)
                     LogicError("LUSequenceReader: the word list needs to be grouped into classes and the classes indices need to be ascending.");
-                prevcls = idx4class[b];
+                prevcls = cls;
             }
 
-            word4idx[wordandcls[0]] = b;
-            idx4word[b++] = wordandcls[0];
+            word4idx[wordandcls[0]] = b++;
+            idx4word.push_back(wordandcls[0]);
             if (mNbrCls < cls)
                 mNbrCls = cls;
         }
         else
         {
-            word4idx[strtmp] = b;
-            idx4word[b++] = strtmp;
+            word4idx[strtmp] = b++;
+            idx4word.push_back(strtmp);
         }
         this->nwords++;
     }
@@ -129,7 +131,7 @@ void BatchLUSequenceReader<ElemType>::GetClassInfo(LabelInfo& lblInfo)
     int prvcls = -1;
     for (size_t j = 0; j < this->nwords; j++)
     {
-        clsidx = lblInfo.idx4class[(long) j];
+        clsidx = lblInfo.idx4class[j];
         if (prvcls != clsidx)
         {
             if (prvcls >= 0)
@@ -271,28 +273,31 @@ void LUSequenceReader<ElemType>::LoadLabelFile(const std::wstring& filePath, std
 template <class ElemType>
 void LUSequenceReader<ElemType>::ChangeMaping(const map<LabelType, LabelType>& maplist,
                                               const LabelType& unkstr,
-                                              map<LabelType, LabelIdType>& word4idx)
+                                              unordered_map<LabelType, LabelIdType>& word4idx)
 {
-    auto punk = word4idx.find(unkstr);
+    // the mapping is looked up in the original ids, so the result does not depend on the iteration order
+    const unordered_map<LabelType, LabelIdType> original = word4idx;
+    auto punk = original.find(unkstr);
     for (auto ptr = word4idx.begin(); ptr != word4idx.end(); ptr++)
     {
-        LabelType wrd = ptr->first;
+        const LabelType& wrd = ptr->first;
         LabelIdType idx = -1;
-        if (maplist.find(wrd) != maplist.end())
+        auto pmap = maplist.find(wrd);
+        if (pmap != maplist.end())
         {
-            LabelType mpp = maplist.find(wrd)->second;
-            idx = word4idx[mpp];
+            auto pmapped = original.find(pmap->second);
+            idx = pmapped != original.end() ? pmapped->second : 0; // (0 is what the former map::operator[] gave for a missing word)
         }
         else
         {
-            if (punk == word4idx.end())
+            if (punk == original.end())
             {
                 RuntimeError("check unk list is missing ");
             }
             idx = punk->second;
         }
 
-        word4idx[wrd] = idx;
+        ptr->second = idx;
     }
 }
 
@@ -15,6 +15,7 @@
 #include "ScriptableObjects.h"
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
@@ -121,8 +122,8 @@ protected:
     struct LabelInfo
     {
         LabelKind type; // labels are categories, create mapping table
-        map<LabelType, LabelIdType> word4idx;
-        map<LabelIdType, LabelType> idx4word;
+        unordered_map<LabelType, LabelIdType> word4idx; // looked up for every token while parsing
+        vector<LabelType> idx4word;                     // [id]
         long dim;                // maximum label ID we will ever see (used for array dimensions)
         LabelType beginSequence; // starting sequence string (i.e. <s>)
         LabelType endSequence;   // ending sequence string (i.e. </s>)
@@ -140,8 +141,8 @@ protected:
         $ 26
         where the first column is the word and the second column is the class id, base 0
         */
-        map<wstring, long> word4cls;
-        map<long, long> idx4class;
+        unordered_map<wstring, long> word4cls;
+        vector<long> idx4class; // [id], only for the class mode
         Matrix<ElemType>* m_id2classLocal;  // CPU version
         Matrix<ElemType>* m_classInfoLocal; // CPU version
         int mNbrClasses;
@@ -172,7 +173,7 @@ public:
     void Init(const ScriptableObjects::IConfigRecord&){};
     void ChangeMaping(const map<LabelType, LabelType>& maplist,
                       const LabelType& unkstr,
-                      map<LabelType, LabelIdType>& word4idx);
+                      unordered_map<LabelType, LabelIdType>& word4idx);
 
     void Destroy(){};
 
@@ -330,11 +331,11 @@ public:
 public:
     void GetClassInfo(LabelInfo& lblInfo);
     void ReadLabelInfo(const wstring& vocfile,
-                       map<wstring, long>& word4idx,
+                       unordered_map<wstring, long>& word4idx,
                        bool readClass,
-                       map<wstring, long>& word4cls,
-                       map<long, wstring>& idx4word,
-                       map<long, long>& idx4class,
+                       unordered_map<wstring, long>& word4cls,
+                       vector<wstring>& idx4word,
+                       vector<long>& idx4class,
                        int& mNbrCls);
 
     template <class ConfigRecordType>
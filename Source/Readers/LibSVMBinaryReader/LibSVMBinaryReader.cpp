@@ -100,8 +100,8 @@ void DenseBinaryMatrix<ElemType>::AddValues(void* values, size_t numRows)
 }
 
 template <class ElemType>
-SparseBinaryMatrix<ElemType>::SparseBinaryMatrix(wstring name, int deviceId, size_t numRows, size_t numCols)
-    : BinaryMatrix<ElemType>(name, deviceId, numRows, numCols), m_rowIndices(nullptr), m_colIndices(nullptr), m_nnz(0), m_maxNNz(0)
+SparseBinaryMatrix<ElemType>::SparseBinaryMatrix(wstring name, int deviceId, size_t numRows, size_t numCols, bool assembleInPlace)
+    : BinaryMatrix<ElemType>(name, deviceId, numRows, numCols), m_rowIndices(nullptr), m_colIndices(nullptr), m_nnz(0), m_maxNNz(0), m_assembleInPlace(assembleInPlace)
 {
     // m_colIndices = (int32_t*)malloc(sizeof(int32_t)*(numRows + 1));
     m_colIndices = (int32_t*) CUDAPageLockedMemAllocator::Malloc(sizeof(int32_t) * (numRows + 1), deviceId);
@@ -191,6 +191,7 @@ void SparseBinaryMatrix<ElemType>::Clear()
 {
     m_numRows = 0;
     m_nnz = 0;
+    m_segments.clear();
 }
 
 template <class ElemType>
@@ -215,9 +216,55 @@ void SparseBinaryMatrix<ElemType>::AddRowIndices(void* rowIndices, size_t nnz)
     memcpy(m_rowIndices + this->m_nnz, rowIndices, sizeof(int32_t) * nnz);
 }
 
+template <class ElemType>
+void SparseBinaryMatrix<ElemType>::AddSegment(const ElemType* values, const int32_t* rowIndices, const int32_t* colIndices, size_t nnz, size_t numCols)
+{
+    m_segments.push_back(Segment{ values, rowIndices, colIndices, nnz, numCols, SegmentsNNz(), this->m_numRows });
+    this->m_numRows += numCols;
+}
+
+template <class ElemType>
+size_t SparseBinaryMatrix<ElemType>::SegmentsNNz() const
+{
+    return m_segments.empty() ? 0 : m_segments.back().m_firstNNz + m_segments.back().m_nnz;
+}
+
+// Writes the segments as a single CSC matrix, rebasing the column starts of each segment.
+template <class ElemType>
+void SparseBinaryMatrix<ElemType>::AssembleSegments(int32_t* colIndices, int32_t* rowIndices, ElemType* values) const
+{
+    colIndices[0] = 0;
+    for (const auto& segment : m_segments)
+    {
+        memcpy(values + segment.m_firstNNz, segment.m_values, sizeof(ElemType) * segment.m_nnz);
+        memcpy(rowIndices + segment.m_firstNNz, segment.m_rowIndices, sizeof(int32_t) * segment.m_nnz);
+        for (size_t c = 1; c <= segment.m_numCols; c++)
+        {
+            colIndices[segment.m_firstCol + c] = segment.m_colIndices[c] + (int32_t) segment.m_firstNNz;
+        }
+    }
+}
+
 template <class ElemType>
 void SparseBinaryMatrix<ElemType>::Fill(Matrix<ElemType>* matrix)
 {
+    if (m_assembleInPlace)
+    {
+        size_t nnz = SegmentsNNz();
+        int32_t* colIndices;
+        int32_t* rowIndices;
+        ElemType* values;
+        if (matrix->TryPrepareCSCFormatBuffers(nnz, this->m_maxNumCols, this->m_numRows, colIndices, rowIndices, values))
+        {
+            AssembleSegments(colIndices, rowIndices, values);
+            return;
+        }
+
+        // the destination cannot be written in place, so assemble into our own buffers and copy
+        ResizeArrays(nnz);
+        AssembleSegments(m_colIndices, m_rowIndices, this->m_values);
+        m_nnz = nnz;
+    }
     matrix->SetMatrixFromCSCFormat(m_colIndices, m_rowIndices, this->m_values, this->m_nnz, this->m_maxNumCols, this->m_numRows);
 #if DEBUG
     matrix->Print("testname");
@@ -226,10 +273,11 @@ void SparseBinaryMatrix<ElemType>::Fill(Matrix<ElemType>* matrix)
 
 template <class ElemType>
 SparseBinaryInput<ElemType>::SparseBinaryInput(std::wstring fileName)
-    : m_fileName(fileName), m_readOrder(nullptr), m_readOrderLength(0), m_randomize(false), m_tempValues(nullptr), m_tempValuesSize(0), m_offsets(nullptr), m_offsetsStart(0), m_startMB(0), m_endMB(0)
+    : m_fileName(fileName), m_readOrder(nullptr), m_readOrderLength(0), m_randomize(false), m_tempValues(nullptr), m_tempValuesSize(0), m_offsets(nullptr), m_offsetsStart(0), m_startMB(0), m_endMB(0), m_numReadThreads(1), m_readAhead(0)
 {
     std::string name = msra::strfun::utf8(m_fileName);
     m_inFile.open(name, ifstream::binary | ifstream::in);
+    m_dataToConsume.emplace_back(new BlockingQueue<void*>());
 }
 
 template <class ElemType>
@@ -339,6 +387,37 @@ void SparseBinaryInput<ElemType>::Init(std::map<std::wstring, std::wstring> rena
     m_maxMBSize = 0;
 }
 
+// SetMemoryMapping - Memory-map the file instead of reading minibatches into buffers, must be called after Init()
+// Sparse inputs on the CPU are then assembled straight from the mapping into the destination matrix.
+// memoryMap - true to map the whole file
+// numReadThreads - number of threads that bring the minibatches of a window into memory (only for memory-mapped files)
+// readAhead - number of minibatches each of these threads may bring in ahead of the consumer, 0 to fit the 1GB that
+//             the buffers of an unmapped file take
+template <class ElemType>
+void SparseBinaryInput<ElemType>::SetMemoryMapping(bool memoryMap, size_t numReadThreads, size_t readAhead)
+{
+    if (memoryMap)
+    {
+        m_mappedFile = make_shared<msra::files::mappedfile>(m_fileName);
+        m_numReadThreads = max(numReadThreads, (size_t) 1);
+        m_readAhead = readAhead;
+    }
+    else
+    {
+        m_mappedFile.reset();
+        m_numReadThreads = 1;
+        m_readAhead = 0;
+    }
+
+    m_dataToConsume.clear();
+    m_readSlots.clear();
+    for (size_t reader = 0; reader < m_numReadThreads; reader++)
+    {
+        m_dataToConsume.emplace_back(new BlockingQueue<void*>());
+        m_readSlots.emplace_back(new BlockingQueue<void*>());
+    }
+}
+
 template <class ElemType>
 bool SparseBinaryInput<ElemType>::Randomize()
 {
@@ -386,7 +465,8 @@ void SparseBinaryInput<ElemType>::ReadOffsets(size_t startMB, size_t numMBs)
     }
     else
     {
-        m_offsets[numMBs] = m_fileSize;
+        // offsets are relative to the start of the data
+        m_offsets[numMBs] = m_fileSize - m_dataStart;
     }
     m_startMB = startMB;
     m_endMB = startMB + numMBs;
@@ -444,7 +524,25 @@ void SparseBinaryInput<ElemType>::StartDistributedMinibatchLoop(size_t mbSize, s
         maxMBSize = max(maxMBSize, (size_t)(m_offsets[c + 1] - m_offsets[c]));
         // fprintf(stderr, "m_offsets[%lu] = %lu\n", c, m_offsets[c]);
     }
-    if (maxMBSize > m_maxMBSize)
+    size_t maxMem = 1024 * 1024 * 1024; // 1GB
+    if (m_mappedFile)
+    {
+        // a memory-mapped file is consumed in place, without buffers, but each read thread may only fault in
+        // as many minibatches ahead of the consumer as it holds slots
+        size_t readAhead = m_readAhead > 0 ? m_readAhead : max(maxMem / max(maxMBSize, (size_t) 1) / m_numReadThreads, (size_t) 1);
+        for (auto& slots : m_readSlots)
+        {
+            while (slots->size() > 0)
+            {
+                slots->pop();
+            }
+            for (size_t c = 0; c < readAhead; c++)
+            {
+                slots->push(nullptr);
+            }
+        }
+    }
+    else if (maxMBSize > m_maxMBSize)
     {
         m_maxMBSize = maxMBSize;
         while (m_dataToProduce.size() > 0)
@@ -453,7 +551,6 @@ void SparseBinaryInput<ElemType>::StartDistributedMinibatchLoop(size_t mbSize, s
         }
         // fprintf(stderr, "max mb size: %ld\n", m_maxMBSize);
 
-        size_t maxMem = 1024 * 1024 * 1024; // 1GB
         size_t maxPointers = maxMem / m_maxMBSize;
         for (size_t c = 0; c < maxPointers; c++)
         {
@@ -462,11 +559,14 @@ void SparseBinaryInput<ElemType>::StartDistributedMinibatchLoop(size_t mbSize, s
         }
     }
 
-    std::thread readData([this]
-                         {
-                             this->ReadMinibatches(m_readOrder, m_readOrderLength);
-                         });
-    readData.detach();
+    for (size_t reader = 0; reader < m_numReadThreads; reader++)
+    {
+        std::thread readData([this, reader]
+                             {
+                                 this->ReadMinibatches(m_readOrder, m_readOrderLength, reader);
+                             });
+        readData.detach();
+    }
 }
 template <class ElemType>
 void* SparseBinaryInput<ElemType>::GetTempDataPointer(size_t numBytes)
@@ -491,7 +591,9 @@ shared_ptr<BinaryMatrix<ElemType>> SparseBinaryInput<ElemType>::CreateMatrix(std
     // if (m_features.find(matName) != m_features.end()) {
     if (std::find(m_features.begin(), m_features.end(), matName) != m_features.end())
     {
-        retVal = make_shared<SparseBinaryMatrix<ElemType>>(matName, deviceId, m_mbSize, m_mappedNumCols[matName]);
+        // a GPU matrix is still staged in page-locked memory for the transfer
+        bool assembleInPlace = m_mappedFile && deviceId == CPUDEVICE;
+        retVal = make_shared<SparseBinaryMatrix<ElemType>>(matName, deviceId, m_mbSize, m_mappedNumCols[matName], assembleInPlace);
     }
     // else if (m_labels.find(matName) != m_labels.end()) {
     else if (std::find(m_labels.begin(), m_labels.end(), matName) != m_labels.end())
@@ -503,8 +605,32 @@ shared_ptr<BinaryMatrix<ElemType>> SparseBinaryInput<ElemType>::CreateMatrix(std
 }
 
 template <class ElemType>
-void SparseBinaryInput<ElemType>::ReadMinibatches(size_t* read_order, size_t numToRead)
+void SparseBinaryInput<ElemType>::ReadMinibatches(size_t* read_order, size_t numToRead, size_t reader)
 {
+    BlockingQueue<void*>& dataToConsume = *m_dataToConsume[reader];
+    if (m_mappedFile)
+    {
+        // Nothing is copied: the minibatches are handed out in place, and touching their pages here
+        // makes this thread rather than the consumer wait for the disk. The slots keep this from
+        // faulting in the whole window; the consumer returns one for each minibatch it is done with.
+        BlockingQueue<void*>& readSlots = *m_readSlots[reader];
+        const size_t pageSize = 4096;
+        volatile char touched = 0;
+        for (size_t c = reader; c < numToRead; c += m_numReadThreads)
+        {
+            readSlots.pop();
+            const char* begin = m_mappedFile->data() + m_dataStart + m_offsets[read_order[c]];
+            const char* end = m_mappedFile->data() + min((size_t)(m_dataStart + m_offsets[read_order[c] + 1]), m_mappedFile->size());
+            for (const char* p = begin; p < end; p += pageSize)
+            {
+                touched += *p;
+            }
+            dataToConsume.push(const_cast<char*>(begin)); // only read by the consumer
+        }
+        return;
+    }
+
+
 #if DEBUG
     marker_series series(L"Read Minibatches");
     // diagnostic::span span(series, L"Reading Data");
@@ -537,7 +663,7 @@ void SparseBinaryInput<ElemType>::ReadMinibatches(size_t* read_order, size_t num
         series.write_flag(_T("reading."));
 #endif
         m_inFile.read((char*) data_buffer, readSize);
-        m_dataToConsume.push(data_buffer);
+        dataToConsume.push(data_buffer);
 //fprintf(stderr, "done reading data %ld\n", c);
 #if DEBUG
         series.write_flag(_T("Done read, pushed buffer."));
@@ -593,11 +719,18 @@ size_t SparseBinaryInput<ElemType>::ReadMinibatch(void* data_buffer, std::map<st
         if (findMat != matrices.end())
         {
             auto mat = findMat->second;
-            mat->ResizeArrays(nnz);
-            mat->AddValues(vals, nnz);
-            mat->AddRowIndices(rowIndices, nnz);
-            mat->AddColIndices(colIndices, curMBSize + 1);
-            mat->UpdateNNz(nnz);
+            if (mat->AssemblesInPlace())
+            {
+                mat->AddSegment(vals, rowIndices, colIndices, nnz, curMBSize);
+            }
+            else
+            {
+                mat->ResizeArrays(nnz);
+                mat->AddValues(vals, nnz);
+                mat->AddRowIndices(rowIndices, nnz);
+                mat->AddColIndices(colIndices, curMBSize + 1);
+                mat->UpdateNNz(nnz);
+            }
 #ifdef DEBUG
             mat->Print("features");
 #endif
@@ -642,7 +775,7 @@ size_t SparseBinaryInput<ElemType>::FillMatrices(std::map<std::wstring, shared_p
     // while (curSize + m_microBatchSize <= m_mbSize && (data_buffer = m_dataToConsume.pop()) != nullptr) {
     while (curSize + m_microBatchSize <= m_mbSize && m_nextMB < m_epochSize)
     {
-        data_buffer = m_dataToConsume.pop();
+        data_buffer = m_dataToConsume[m_nextMB % m_numReadThreads]->pop();
         // clock_t in_w = clock();
         // start_w = in_w - start_w;
         // fprintf(stderr, "start read mb\tIt took me %d clicks (%f seconds).\n", start_w, ((float)start_w) / CLOCKS_PER_SEC);
@@ -650,8 +783,15 @@ size_t SparseBinaryInput<ElemType>::FillMatrices(std::map<std::wstring, shared_p
         // fprintf(stderr, "start read mb\n");
         curSize += ReadMinibatch(data_buffer, matrices);
         // fprintf(stderr, "end read mb\n");
+        if (m_mappedFile)
+        {
+            m_readSlots[m_nextMB % m_numReadThreads]->push(nullptr);
+        }
+        else
+        {
+            m_dataToProduce.push(data_buffer);
+        }
         m_nextMB++;
-        m_dataToProduce.push(data_buffer);
     }
     // fprintf(stderr, "end fill matrices\n");
     return curSize;
@@ -699,6 +839,14 @@ void LibSVMBinaryReader<ElemType>::InitFromConfig(const ConfigRecordType& reader
     m_dataInput = make_shared<SparseBinaryInput<ElemType>>(file);
     m_dataInput->Init(rename);
 
+    // optionally memory-map the file and read it with several threads
+    size_t readThreads = readerConfig(L"readThreads", (size_t) 1);
+    bool memoryMap = readerConfig(L"memoryMap", readThreads > 1);
+    if (readThreads > 1 && !memoryMap)
+        InvalidArgument("LibSVMBinaryReader: readThreads > 1 requires memoryMap=true.");
+    size_t readAhead = readerConfig(L"readAhead", (size_t) 0);
+    m_dataInput->SetMemoryMapping(memoryMap, readThreads, readAhead);
+
     m_mbSize = (size_t) readerConfig(L"minibatch", 0);
     if (m_mbSize > 0)
     {
@@ -9,8 +9,10 @@
 #include "DataReader.h"
 #include "DataWriter.h"
 #include "RandomOrdering.h"
+#include "fileutil.h"
 #include <string>
 #include <map>
+#include <memory>
 #include <vector>
 #include <random>
 #include <future>
@@ -84,6 +86,15 @@ public:
     }
     virtual void ResizeArrays(size_t) = 0;
     virtual void SetMaxRows(size_t maxRows) = 0;
+    // true if microbatches are added with AddSegment() and assembled directly in the destination matrix by Fill()
+    virtual bool AssemblesInPlace() const
+    {
+        return false;
+    }
+    virtual void AddSegment(const ElemType* /*values*/, const int32_t* /*rowIndices*/, const int32_t* /*colIndices*/, size_t /*nnz*/, size_t /*numCols*/)
+    {
+        NOT_IMPLEMENTED
+    }
 
 protected:
     wstring m_matrixName;
@@ -132,7 +143,7 @@ class SparseBinaryMatrix : public BinaryMatrix<ElemType>
     typedef BinaryMatrix<ElemType> Base;
     using Base::m_values; using Base::m_numRows; using Base::m_deviceID;
 public:
-    SparseBinaryMatrix(wstring name, int deviceID, size_t numRows, size_t numCols);
+    SparseBinaryMatrix(wstring name, int deviceID, size_t numRows, size_t numCols, bool assembleInPlace = false);
     // SparseBinaryMatrix(wstring name, size_t numRows, size_t numCols);
     virtual void Clear();
     virtual void Dispose();
@@ -146,12 +157,35 @@ public:
     }
     virtual void ResizeArrays(size_t newMaxNNz) override;
     virtual void SetMaxRows(size_t maxRows) override;
+    virtual bool AssemblesInPlace() const override
+    {
+        return m_assembleInPlace;
+    }
+    virtual void AddSegment(const ElemType* values, const int32_t* rowIndices, const int32_t* colIndices, size_t nnz, size_t numCols) override;
 
 protected:
+    // A microbatch of the input that stays where it has been read (in the memory-mapped file) until Fill().
+    struct Segment
+    {
+        const ElemType* m_values;
+        const int32_t* m_rowIndices;
+        const int32_t* m_colIndices; // numCols + 1 column starts relative to the segment
+        size_t m_nnz;
+        size_t m_numCols;
+        size_t m_firstNNz; // position of the segment in the assembled matrix
+        size_t m_firstCol;
+    };
+
+    size_t SegmentsNNz() const;
+    void AssembleSegments(int32_t* colIndices, int32_t* rowIndices, ElemType* values) const;
+
     int32_t* m_rowIndices;
     int32_t* m_colIndices;
     size_t m_nnz;
     size_t m_maxNNz;
+
+    bool m_assembleInPlace;
+    std::vector<Segment> m_segments;
 };
 
 template <class ElemType>
@@ -161,8 +195,9 @@ public:
     SparseBinaryInput(std::wstring fileName);
     ~SparseBinaryInput();
     void Init(std::map<std::wstring, std::wstring> rename);
+    void SetMemoryMapping(bool memoryMap, size_t numReadThreads, size_t readAhead);
     void StartDistributedMinibatchLoop(size_t mbSize, size_t subsetNum, size_t numSubsets);
-    void ReadMinibatches(size_t* read_order, size_t numToRead);
+    void ReadMinibatches(size_t* read_order, size_t numToRead, size_t reader);
     size_t ReadMinibatch(void* data_buffer, std::map<std::wstring, shared_ptr<BinaryMatrix<ElemType>>>& matrices);
     size_t FillMatrices(std::map<std::wstring, shared_ptr<BinaryMatrix<ElemType>>>& matrices);
     size_t GetMBSize()
@@ -187,6 +222,9 @@ private:
     ifstream m_inFile;
     std::wstring m_fileName;
     size_t m_fileSize;
+    std::shared_ptr<msra::files::mappedfile> m_mappedFile; // set if the file is memory-mapped instead of read into buffers
+    size_t m_numReadThreads;
+    size_t m_readAhead; // minibatches a read thread may fault in ahead of the consumer, 0 for the default
 
     size_t m_offsetsStart;
     int64_t* m_offsets;
@@ -231,7 +269,10 @@ private:
     int32_t sysGran;
 #endif
     BlockingQueue<void*> m_dataToProduce;
-    BlockingQueue<void*> m_dataToConsume;
+    // one queue per read thread, minibatch c of the window is read by thread c % m_numReadThreads
+    std::vector<std::unique_ptr<BlockingQueue<void*>>> m_dataToConsume;
+    // memory-mapped file only: the free read-ahead slots of each read thread, the values are not used
+    std::vector<std::unique_ptr<BlockingQueue<void*>>> m_readSlots;
 };
 
 template <class ElemType>
@@ -24,7 +24,8 @@ BlockRandomizer::BlockRandomizer(
     IDataDeserializerPtr deserializer,
     DecimationMode decimationMode,
     bool useLegacyRandomization,
-    bool multithreadedGetNextSequence)
+    bool multithreadedGetNextSequence,
+    size_t bucketSizeInSamples)
     : m_verbosity(verbosity),
       m_deserializer(deserializer),
       m_decimationMode(decimationMode),
@@ -40,7 +41,7 @@ BlockRandomizer::BlockRandomizer(
     assert(deserializer != nullptr);
 
     m_streams = m_deserializer->GetStreamDescriptions();
-    m_sequenceRandomizer = std::make_shared<SequenceRandomizer>(m_deserializer, m_chunkRandomizer);
+    m_sequenceRandomizer = std::make_shared<SequenceRandomizer>(m_deserializer, m_chunkRandomizer, bucketSizeInSamples);
 
     // Calculate total number of samples.
     m_sweepTotalNumberOfSamples = 0;
@@ -140,9 +141,10 @@ Sequences BlockRandomizer::GetNextSequences(size_t sampleCount)
 
     result.m_data.resize(m_streams.size(), std::vector<SequenceDataPtr>(decimated.size()));
 
-    auto process = [&](int i) -> void {
+    // The sequence vector is a scratch buffer reused between calls on the same thread.
+    auto process = [&](int i, std::vector<SequenceDataPtr>& sequence) -> void {
         const auto& description = decimated[i];
-        std::vector<SequenceDataPtr> sequence;
+        sequence.clear();
         auto it = m_chunks.find(description.m_chunk->m_chunkId);
         if (it == m_chunks.end())
         {
@@ -152,21 +154,26 @@ Sequences BlockRandomizer::GetNextSequences(size_t sampleCount)
         it->second->GetSequence(description.m_id, sequence);
         for (int j = 0; j < m_streams.size(); ++j)
         {
-            result.m_data[j][i] = sequence[j];
+            result.m_data[j][i] = std::move(sequence[j]);
         }
     };
 
     // TODO: This will be changed, when we move transformers under the randomizer, should not deal with multithreading here.
     if (m_multithreadedGetNextSequences)
     {
-#pragma omp parallel for schedule(dynamic)
-        for (int i = 0; i < decimated.size(); ++i)
-            process(i);
+#pragma omp parallel
+        {
+            std::vector<SequenceDataPtr> sequence;
+#pragma omp for schedule(dynamic)
+            for (int i = 0; i < decimated.size(); ++i)
+                process(i, sequence);
+        }
     }
     else
     {
+        std::vector<SequenceDataPtr> sequence;
         for (int i = 0; i < decimated.size(); ++i)
-            process(i);
+            process(i, sequence);
     }
 
     m_sequenceRandomizer->ReleaseChunks();
@@ -280,6 +287,18 @@ void BlockRandomizer::RetrieveDataChunks()
     // TODO diagnostics for paged out chunks?
     m_chunks.swap(chunks);
 
+    // Hinting the deserializer about the chunk that will enter the window next,
+    // so that it can be loaded in the background while the current window is consumed.
+    const auto& randomizedChunks = m_chunkRandomizer->GetRandomizedChunks();
+    for (size_t next = window.back().m_chunkId + 1; next < randomizedChunks.size(); ++next)
+    {
+        if (m_decimationMode != DecimationMode::chunk || next % m_config.m_numberOfWorkers == m_config.m_workerRank)
+        {
+            m_deserializer->PrefetchChunk(randomizedChunks[next].m_original->m_id);
+            break;
+        }
+    }
+
     if (m_verbosity >= Notification)
         fprintf(stderr, "BlockRandomizer::RetrieveDataChunks: %" PRIu64 " chunks paged-in from chunk window [%" PRIu64 "..%" PRIu64 "]\n",
                 m_chunks.size(),
@@ -23,7 +23,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 //         1) if a new sweep is entered, randomize chunk descriptions using ChunkRandomizer, also precalculate randomization windows for all
 //            chunk descriptions
 //         2) if a new chunk is entered, using SequenceRandomizer identify a window of chunks and requested their sequence descriptions from deserializer.
-//         3) randomize sequence descriptions inside the window
+//         3) randomize sequence descriptions inside the window, optionally grouping sequences
+//            of similar length into buckets (if bucketSizeInSamples is not 0) to reduce padding in minibatches
 //         4) return sequence descriptions not exceeding sampleCount/minibatch limit
 //         5) decimate sequence descriptions based on the worker rank
 //         6) request chunks of data based on decimated sequences and return sequence data
@@ -47,7 +48,8 @@ public:
         IDataDeserializerPtr deserializer,
         DecimationMode decimationMode = DecimationMode::chunk,
         bool useLegacyRandomization = false,
-        bool multithreadedGetNextSequences = false);
+        bool multithreadedGetNextSequences = false,
+        size_t bucketSizeInSamples = 0);
 
     // Starts a new epoch.
     virtual void StartEpoch(const EpochConfiguration& config) override;
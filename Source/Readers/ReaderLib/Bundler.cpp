@@ -286,4 +286,10 @@ ChunkPtr Bundler::GetChunk(size_t chunkId)
     return std::make_shared<BundlingChunk>(m_streams.size(), this, chunkId);
 }
 
+// Only the driving chunk is known upfront, secondary chunks are resolved by keys when the chunk is requested.
+void Bundler::PrefetchChunk(size_t chunkId)
+{
+    m_driver->PrefetchChunk(m_chunks[chunkId]->m_original->m_id);
+}
+
 }}}
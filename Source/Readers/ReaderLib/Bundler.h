@@ -28,6 +28,9 @@ public:
     // Gets a chunk with data.
     virtual ChunkPtr GetChunk(size_t chunkId) override;
 
+    // Forwards the prefetch hint to the driving deserializer.
+    virtual void PrefetchChunk(size_t chunkId) override;
+
 private:
     DISABLE_COPY_AND_MOVE(Bundler);
 
@@ -6,21 +6,105 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "ChunkCache.h"
+#include "ElementTypeUtils.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
+ChunkCache::ChunkCache(IDataDeserializerPtr deserializer, size_t maxSizeInBytes)
+    : m_deserializer(deserializer),
+      m_sampleSizeInBytes(0),
+      m_maxSizeInBytes(maxSizeInBytes),
+      m_sizeInBytes(0),
+      m_hitCount(0),
+      m_missCount(0),
+      m_evictionCount(0)
+{
+    for (const auto& stream : m_deserializer->GetStreamDescriptions())
+    {
+        size_t elementSize = GetSizeByType(stream->m_elementType);
+        if (stream->m_storageType == StorageType::dense && stream->m_sampleLayout)
+        {
+            m_sampleSizeInBytes += stream->m_sampleLayout->GetNumElements() * elementSize;
+        }
+        else
+        {
+            // The number of non-zero values is unknown upfront, assuming a single value per sample.
+            m_sampleSizeInBytes += elementSize + sizeof(IndexType);
+        }
+    }
+}
+
+ChunkDescriptions ChunkCache::GetChunkDescriptions()
+{
+    ChunkDescriptions descriptions = m_deserializer->GetChunkDescriptions();
+    for (const auto& description : descriptions)
+    {
+        m_chunkDescriptions[description->m_id] = description;
+    }
+    return descriptions;
+}
+
 ChunkPtr ChunkCache::GetChunk(size_t chunkId)
 {
     auto it = m_chunkMap.find(chunkId);
     if (it != m_chunkMap.end())
     {
-        return it->second;
+        m_hitCount++;
+        // Moving the chunk to the front of the usage list.
+        m_lruList.splice(m_lruList.begin(), m_lruList, it->second.m_lruPosition);
+        return it->second.m_chunk;
     }
- 
+
+    m_missCount++;
     ChunkPtr chunk = m_deserializer->GetChunk(chunkId);
-    m_chunkMap[chunkId] = chunk;
- 
+
+    size_t sizeInBytes = GetChunkSizeInBytes(chunkId, chunk);
+    if (m_maxSizeInBytes != 0)
+    {
+        if (sizeInBytes > m_maxSizeInBytes)
+        {
+            // The chunk does not fit into the cache at all, simply pass it through.
+            return chunk;
+        }
+
+        MakeRoom(sizeInBytes);
+    }
+
+    m_lruList.push_front(chunkId);
+    m_chunkMap[chunkId] = CacheEntry { chunk, sizeInBytes, m_lruList.begin() };
+    m_sizeInBytes += sizeInBytes;
+
     return chunk;
 }
 
-} } }
\ No newline at end of file
+size_t ChunkCache::GetChunkSizeInBytes(size_t chunkId, const ChunkPtr& chunk) const
+{
+    size_t sizeInBytes = chunk->GetSizeInBytes();
+    if (sizeInBytes != 0)
+    {
+        return sizeInBytes;
+    }
+
+    auto description = m_chunkDescriptions.find(chunkId);
+    if (description != m_chunkDescriptions.end())
+    {
+        return description->second->m_numberOfSamples * m_sampleSizeInBytes;
+    }
+
+    return 0;
+}
+
+void ChunkCache::MakeRoom(size_t sizeInBytes)
+{
+    while (!m_lruList.empty() && m_sizeInBytes + sizeInBytes > m_maxSizeInBytes)
+    {
+        auto victim = m_chunkMap.find(m_lruList.back());
+        assert(victim != m_chunkMap.end());
+        m_sizeInBytes -= victim->second.m_sizeInBytes;
+        m_chunkMap.erase(victim);
+        m_lruList.pop_back();
+        m_evictionCount++;
+    }
+}
+
+} } }
@@ -5,32 +5,33 @@
 
 #pragma once
 
+#include <list>
 #include <map>
 #include "DataDeserializer.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
-// A cache to store the complete dataset (all chunks) in memory. The caching can
+// A cache to store chunks of the dataset in memory. The caching can
 // be switched on/off by a boolean flag in the reader config section, independent 
-// of the randomization and chunking parameters. The caching should only be enabled 
-// when the whole dataset fits in memory.
+// of the randomization and chunking parameters.
+// The cache can either be unbounded (in which case it keeps all chunks it ever sees and
+// should only be enabled when the whole dataset fits in memory), or bounded by a memory
+// budget in bytes, in which case the least recently used chunks are evicted once the budget
+// is exceeded.
 // Implemented as a wrapping proxy around a deserializer that stores pointers to
-// all chunks it sees in an internal map.
+// the cached chunks in an internal map.
 class ChunkCache : public IDataDeserializer
 {
 public:
-
-    ChunkCache(IDataDeserializerPtr deserializer) : m_deserializer(deserializer) { }
+    // maxSizeInBytes specifies the memory budget of the cache, 0 means unbounded.
+    ChunkCache(IDataDeserializerPtr deserializer, size_t maxSizeInBytes = 0);
 
     virtual std::vector<StreamDescriptionPtr> GetStreamDescriptions() const override
     {
         return m_deserializer->GetStreamDescriptions();
     }
 
-    virtual ChunkDescriptions GetChunkDescriptions() override
-    {
-        return m_deserializer->GetChunkDescriptions();
-    }
+    virtual ChunkDescriptions GetChunkDescriptions() override;
 
     virtual void GetSequencesForChunk(size_t chunkId, std::vector<SequenceDescription>& descriptions) override
     {
@@ -43,14 +44,66 @@ public:
     }
 
     // Gets chunk data given its id.
-    virtual ChunkPtr GetChunk(size_t chunkId);
+    virtual ChunkPtr GetChunk(size_t chunkId) override;
+
+    // Forwards the prefetch hint to the underlying deserializer, unless the chunk is already cached.
+    virtual void PrefetchChunk(size_t chunkId) override
+    {
+        if (m_chunkMap.find(chunkId) == m_chunkMap.end())
+        {
+            m_deserializer->PrefetchChunk(chunkId);
+        }
+    }
+
+    // Number of chunk requests served from the cache.
+    size_t GetHitCount() const { return m_hitCount; }
+
+    // Number of chunk requests forwarded to the underlying deserializer.
+    size_t GetMissCount() const { return m_missCount; }
+
+    // Number of chunks evicted from the cache because of the memory budget.
+    size_t GetEvictionCount() const { return m_evictionCount; }
+
+    // Current (estimated) amount of memory occupied by the cached chunks.
+    size_t GetSizeInBytes() const { return m_sizeInBytes; }
 
 private:
-    // A map of currently loaded chunks
-    std::map<size_t, ChunkPtr> m_chunkMap;
+    struct CacheEntry
+    {
+        ChunkPtr m_chunk;
+        size_t m_sizeInBytes;
+        std::list<size_t>::iterator m_lruPosition;
+    };
+
+    // Gets the size of the chunk, either as reported by the chunk itself,
+    // or estimated from the chunk description and the stream descriptions.
+    size_t GetChunkSizeInBytes(size_t chunkId, const ChunkPtr& chunk) const;
+
+    // Evicts least recently used chunks till the requested amount of memory is available.
+    void MakeRoom(size_t sizeInBytes);
+
+    // A map of currently cached chunks.
+    std::map<size_t, CacheEntry> m_chunkMap;
+
+    // Chunk ids in the order of their usage, the most recently used chunk is at the front.
+    std::list<size_t> m_lruList;
+
     IDataDeserializerPtr m_deserializer;
 
+    // Chunk descriptions, used to estimate the size of chunks that do not report it.
+    std::map<size_t, ChunkDescriptionPtr> m_chunkDescriptions;
+
+    // Estimated size of a single sample (summed over all streams), used for chunks that do not report their size.
+    size_t m_sampleSizeInBytes;
+
+    size_t m_maxSizeInBytes;
+    size_t m_sizeInBytes;
+
+    size_t m_hitCount;
+    size_t m_missCount;
+    size_t m_evictionCount;
+
     DISABLE_COPY_AND_MOVE(ChunkCache);
 };
 
-} } }
\ No newline at end of file
+} } }
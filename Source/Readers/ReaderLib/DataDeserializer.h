@@ -61,11 +61,19 @@ struct SequenceDataBase
     size_t m_id;
     size_t m_numberOfSamples;      // Number of samples in the sequence
 
+    // The chunk the sequence data belongs to, keeps the chunk alive while the sequence is in use.
+    // Not needed when the sequence data is allocated together with the chunk and is returned
+    // through an aliasing shared pointer that already shares the ownership of the chunk
+    // (which avoids a heap allocation per sequence, see SequenceDataPtr below).
     ChunkPtr m_chunk;
     // A non-owned pointer. The actual size is provided for particular sequences,
     // i.e. see DenseSequenceData, or SparseSequenceData.
     void* m_data;
 };
+
+// Sequence data returned by chunks. The pointer can either own a separately allocated
+// sequence data object, or alias (i.e. std::shared_ptr<SequenceDataBase>(chunk, data))
+// a sequence data object that is owned by the chunk itself.
 typedef std::shared_ptr<SequenceDataBase> SequenceDataPtr;
 
 // Dense sequence. Should be returned by the deserializer for streams with storage type StorageType::dense.
@@ -84,8 +92,10 @@ typedef std::shared_ptr<DenseSequenceData> DenseSequenceDataPtr;
 // All samples in the sequence should have the same layout.
 struct SparseSequenceData : SequenceDataBase
 {
+    SparseSequenceData() : m_indices(nullptr), m_nnzCounts(nullptr), m_totalNnzCount(0) {}
+
     IndexType* m_indices; // an index for every value in the m_data array
-    std::vector<IndexType> m_nnzCounts; // nnz count for each sample in the sequence
+    IndexType* m_nnzCounts; // a non-owned array of nnz counts, one for each sample in the sequence (m_numberOfSamples values)
     IndexType m_totalNnzCount; // sum of all nzzCounts of all samples
     // Using IndexType for both properties above since the nnzCount should fit inside
     // the index type (in CSC format, the last value in the column index array == nnzCount)
@@ -114,6 +124,10 @@ public:
     // deallocated till all its sequences are released.
     virtual void GetSequence(size_t sequenceId, std::vector<SequenceDataPtr>& result) = 0;
 
+    // Gets the amount of memory occupied by the chunk data in bytes.
+    // Used for memory accounting (i.e. by the chunk cache), 0 means the size is not known.
+    virtual size_t GetSizeInBytes() const { return 0; }
+
     virtual ~Chunk() {};
 
 protected:
@@ -165,6 +179,11 @@ public:
     // Gets chunk data given its id.
     virtual ChunkPtr GetChunk(size_t chunkId) = 0;
 
+    // Hints that the chunk with the given id is going to be requested soon.
+    // Deserializers can use this to start loading the chunk in the background, so that
+    // the following GetChunk call does not block on IO. The default implementation does nothing.
+    virtual void PrefetchChunk(size_t /*chunkId*/) {}
+
     virtual ~IDataDeserializer() {};
 };
 
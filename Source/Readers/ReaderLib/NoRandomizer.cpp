@@ -188,8 +188,9 @@ Sequences NoRandomizer::GetNextSequences(size_t sampleCount)
         }
     }
 
-    auto process = [&](int i) -> void {
-        std::vector<SequenceDataPtr> sequence;
+    // The sequence vector is a scratch buffer reused between calls on the same thread.
+    auto process = [&](int i, std::vector<SequenceDataPtr>& sequence) -> void {
+        sequence.clear();
         const auto& sequenceDescription = descriptions[start + i];
 
         auto it = chunks.find(sequenceDescription.m_chunkId);
@@ -201,21 +202,26 @@ Sequences NoRandomizer::GetNextSequences(size_t sampleCount)
         it->second->GetSequence(sequenceDescription.m_id, sequence);
         for (int j = 0; j < m_streams.size(); ++j)
         {
-            result.m_data[j][i] = sequence[j];
+            result.m_data[j][i] = std::move(sequence[j]);
         }
     };
 
     // TODO: This will be changed, when we move transformers under the (no-) randomizer, should not deal with multithreading here.
     if (m_multithreadedGetNextSequences)
     {
-#pragma omp parallel for schedule(dynamic)
-        for (int i = 0; i < subsetSize; ++i)
-            process(i);
+#pragma omp parallel
+        {
+            std::vector<SequenceDataPtr> sequence;
+#pragma omp for schedule(dynamic)
+            for (int i = 0; i < subsetSize; ++i)
+                process(i, sequence);
+        }
     }
     else
     {
+        std::vector<SequenceDataPtr> sequence;
         for (int i = 0; i < subsetSize; ++i)
-            process(i);
+            process(i, sequence);
     }
 
     // Keep the last chunk for next time
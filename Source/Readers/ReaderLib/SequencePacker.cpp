@@ -16,7 +16,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
 MBLayoutPtr SequencePacker::CreateMBLayout(const StreamBatch& batch)
 {
-    vector<MBLayout::SequenceInfo> infos;
+    auto& infos = m_layoutSequenceInfos;
+    infos.clear();
     for (size_t index = 0; index < batch.size(); ++index)
     {
         MBLayout::SequenceInfo info;
@@ -27,15 +28,20 @@ MBLayoutPtr SequencePacker::CreateMBLayout(const StreamBatch& batch)
         infos.push_back(info);
     }
 
-    vector<pair<size_t, size_t>> placement;
-    vector<size_t> rowAllocations;
-
     // Creating the minibatch layout.
     MBLayoutPtr pMBLayout = make_shared<MBLayout>();
-    pMBLayout->InitAsPackedSequences(infos, placement, rowAllocations);
+    pMBLayout->InitAsPackedSequences(infos, m_placement, m_rowAllocations);
     return pMBLayout;
 }
 
+void SequencePacker::StartEpoch(const EpochConfiguration& config)
+{
+    PackerBase::StartEpoch(config);
+    m_numberOfPackedSamples = 0;
+    m_numberOfAllocatedSamples = 0;
+    m_paddingEfficiencyReported = false;
+}
+
 Minibatch SequencePacker::ReadMinibatch()
 {
     auto sequences = m_sequenceEnumerator->GetNextSequences(m_minibatchSize);
@@ -44,6 +50,10 @@ Minibatch SequencePacker::ReadMinibatch()
     Minibatch minibatch(sequences.m_endOfEpoch);
     if (batch.empty())
     {
+        if (minibatch.m_endOfEpoch)
+        {
+            PrintPaddingEfficiency();
+        }
         return minibatch;
     }
 
@@ -58,15 +68,48 @@ Minibatch SequencePacker::ReadMinibatch()
 
         auto& buffer = m_streamBuffers[streamIndex];
 
+        if (streamIndex == 0)
+        {
+            m_numberOfPackedSamples += pMBLayout->GetActualNumSamples();
+            m_numberOfAllocatedSamples += pMBLayout->GetNumCols();
+        }
+
         auto streamMinibatch = std::make_shared<StreamMinibatch>();
         streamMinibatch->m_data = buffer.m_data.get();
         streamMinibatch->m_layout = pMBLayout;
         minibatch.m_data.push_back(streamMinibatch);
     }
 
+    if (minibatch.m_endOfEpoch)
+    {
+        PrintPaddingEfficiency();
+    }
+
     return minibatch;
 }
 
+void SequencePacker::PrintPaddingEfficiency()
+{
+    if (m_verbosity < 1 || m_paddingEfficiencyReported)
+    {
+        return;
+    }
+
+    // Nothing to report if no gaps were allocated, i.e. in frame mode.
+    if (m_numberOfPackedSamples == m_numberOfAllocatedSamples)
+    {
+        return;
+    }
+
+    fprintf(stderr, "SequencePacker: padding efficiency for the epoch %.2f%% (%" PRIu64 " samples in %" PRIu64 " allocated columns)\n",
+        100.0 * GetPaddingEfficiency(),
+        m_numberOfPackedSamples,
+        m_numberOfAllocatedSamples);
+
+    // Making sure the efficiency is reported only once per epoch.
+    m_paddingEfficiencyReported = true;
+}
+
 MBLayoutPtr SequencePacker::PackDenseStream(const StreamBatch& batch, size_t streamIndex)
 {
     assert(m_outputStreamDescriptions[streamIndex]->m_storageType == StorageType::dense);
@@ -121,7 +164,7 @@ MBLayoutPtr SequencePacker::PackDenseStream(const StreamBatch& batch, size_t str
                 // TODO: make type casts members of the SparseSequenceData
                 SparseSequenceDataPtr sparseSequence = static_pointer_cast<SparseSequenceData>(sequence);
                 // make sure that the sequence meta-data is correct.
-                assert(numSamples == sparseSequence->m_nnzCounts.size());
+                assert(numSamples == sparseSequence->m_numberOfSamples);
                 PackSparseSampleAsDense(destination, sparseSequence, sampleIndex, sampleOffset, sampleSize, elementSize);
                 // move the offset by nnz count of the sample.
                 sampleOffset += sparseSequence->m_nnzCounts[sampleIndex];
@@ -188,13 +231,16 @@ MBLayoutPtr SequencePacker::PackSparseStream(const StreamBatch& batch, size_t st
     // column index for the current sample (= number of nnz value packed so far).
     IndexType columnOffset = 0;
     // a vector to store column index for each sample in the resulting (packed) matrix.
-    vector<IndexType> sparseColumnIndices;
+    auto& sparseColumnIndices = m_sparseColumnIndices;
+    sparseColumnIndices.clear();
     // a vector to keep track of the offsets into each input sequence,
     // there an offset is the number of nnz values packed so far. Current sample
     // values/indices start of the offset position in the sequence data/index array
-    vector<IndexType>  sequenceOffsets(batch.size(), 0); 
+    auto& sequenceOffsets = m_sequenceOffsets;
+    sequenceOffsets.assign(batch.size(), 0);
 
-    vector<MBLayout::SequenceInfo> sequenceInfos(pMBLayout->GetAllSequences());
+    auto& sequenceInfos = m_sortedSequenceInfos;
+    sequenceInfos.assign(pMBLayout->GetAllSequences().begin(), pMBLayout->GetAllSequences().end());
 
     // sort the vector in ascending order of the parallel sequence index.
     sort(sequenceInfos.begin(), sequenceInfos.end(),
@@ -17,14 +17,28 @@ public:
     SequencePacker(
         MemoryProviderPtr memoryProvider,
         SequenceEnumeratorPtr sequenceEnumerator,
-        const std::vector<StreamDescriptionPtr>& streams) :
-        PackerBase(memoryProvider, sequenceEnumerator, streams)
+        const std::vector<StreamDescriptionPtr>& streams,
+        int verbosity = 0) :
+        PackerBase(memoryProvider, sequenceEnumerator, streams),
+        m_verbosity(verbosity),
+        m_numberOfPackedSamples(0),
+        m_numberOfAllocatedSamples(0),
+        m_paddingEfficiencyReported(false)
     {
 
     }
 
+    virtual void StartEpoch(const EpochConfiguration& config) override;
+
     virtual Minibatch ReadMinibatch() override;
 
+    // Gets the padding efficiency of the current epoch: the number of real samples
+    // divided by the number of samples allocated in minibatch layouts (including gaps).
+    double GetPaddingEfficiency() const
+    {
+        return m_numberOfAllocatedSamples == 0 ? 1.0 : (double)m_numberOfPackedSamples / m_numberOfAllocatedSamples;
+    }
+
 protected:
     virtual MBLayoutPtr PackDenseStream(const StreamBatch& batch, size_t streamIndex);
 
@@ -33,6 +47,26 @@ protected:
     // Given a number of sequences, creates an MB layout that is used to guide
     // the actual packing.
     virtual MBLayoutPtr CreateMBLayout(const StreamBatch& batch);
+
+private:
+    // Prints the padding efficiency of the epoch.
+    void PrintPaddingEfficiency();
+
+    // Reader verbosity, same levels as in the BlockRandomizer; the padding efficiency is printed from 1 (notification) on.
+    int m_verbosity;
+
+    // Number of real and allocated samples (as computed from layouts of the first stream) in the current epoch.
+    size_t m_numberOfPackedSamples;
+    size_t m_numberOfAllocatedSamples;
+    bool m_paddingEfficiencyReported;
+
+    // Scratch buffers, reused between minibatches to avoid reallocating them for every minibatch.
+    std::vector<MBLayout::SequenceInfo> m_layoutSequenceInfos;
+    std::vector<std::pair<size_t, size_t>> m_placement;
+    std::vector<size_t> m_rowAllocations;
+    std::vector<MBLayout::SequenceInfo> m_sortedSequenceInfos;
+    std::vector<IndexType> m_sparseColumnIndices;
+    std::vector<IndexType> m_sequenceOffsets;
 };
 
 typedef std::shared_ptr<SequencePacker> SequencePackerPtr;
@@ -23,7 +23,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
     SequenceRandomizer::SequenceRandomizer(
         IDataDeserializerPtr deserializer,
-        ChunkRandomizerPtr chunkRandomizer)
+        ChunkRandomizerPtr chunkRandomizer,
+        size_t bucketSizeInSamples)
         : m_randomizedChunks(chunkRandomizer->GetRandomizedChunks()),
         m_chunkWindowBegin(0),
         m_randomizedWindowEnd(0),
@@ -32,7 +33,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         m_currentSequenceCursor(0),
         m_currentChunkCursor(0),
         m_currentSampleCursor(0),
-        m_deserializer(deserializer)
+        m_deserializer(deserializer),
+        m_bucketSizeInSamples(bucketSizeInSamples)
     {
         size_t max = 0;
         for (const auto& c : m_randomizedChunks)
@@ -213,6 +215,11 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         // Let's recalculate number of samples in the randomized chunks for efficient indexing in seek.
         size_t sampleCount = 0;
         size_t randomizedChunk = m_randomizedWindowEnd - m_chunkWindowBegin;
+        if (m_bucketSizeInSamples != 0)
+        {
+            BucketSequencesByLength(m_sequenceWindow[randomizedChunk]);
+        }
+
         for (size_t index = 0; index < m_sequenceWindow[randomizedChunk].size(); index++)
         {
             sampleCount += m_sequenceWindow[randomizedChunk][index].m_numberOfSamples;
@@ -230,6 +237,48 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         m_chunkWindowEnd = nextChunkWindowEnd;
     }
 
+    // Groups sequences of a fully randomized chunk into buckets of similar length, randomizing the order of buckets.
+    void SequenceRandomizer::BucketSequencesByLength(std::vector<RandomizedSequenceDescription>& sequences)
+    {
+        m_bufferSortedSequences.assign(sequences.begin(), sequences.end());
+        std::stable_sort(m_bufferSortedSequences.begin(), m_bufferSortedSequences.end(),
+            [](const RandomizedSequenceDescription& a, const RandomizedSequenceDescription& b)
+            {
+                return a.m_numberOfSamples < b.m_numberOfSamples;
+            });
+
+        // Split sorted sequences into buckets [begin, end) of at least m_bucketSizeInSamples samples.
+        m_bufferBuckets.clear();
+        size_t bucketBegin = 0;
+        size_t bucketSamples = 0;
+        for (size_t i = 0; i < m_bufferSortedSequences.size(); ++i)
+        {
+            bucketSamples += m_bufferSortedSequences[i].m_numberOfSamples;
+            if (bucketSamples >= m_bucketSizeInSamples || i + 1 == m_bufferSortedSequences.size())
+            {
+                m_bufferBuckets.push_back(std::make_pair(bucketBegin, i + 1));
+                bucketBegin = i + 1;
+                bucketSamples = 0;
+            }
+        }
+
+        // Randomize the order of buckets, using the same random generator as the rest of the sequence randomization.
+        for (size_t i = m_bufferBuckets.size(); i > 1; --i)
+        {
+            std::swap(m_bufferBuckets[i - 1], m_bufferBuckets[rand(0, i)]);
+        }
+
+        size_t position = 0;
+        for (const auto& bucket : m_bufferBuckets)
+        {
+            for (size_t i = bucket.first; i < bucket.second; ++i)
+            {
+                sequences[position++] = m_bufferSortedSequences[i];
+            }
+        }
+        assert(position == sequences.size());
+    }
+
     // Sets current cursor to the given sample offset.
     // If offset is in the middle of the sequence, the next sequence is picked up.
     // If there is no sequence, an offset outside the sweep is returned.
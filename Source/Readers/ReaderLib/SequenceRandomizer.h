@@ -31,9 +31,12 @@ struct RandomizedSequenceDescription
 class SequenceRandomizer
 {
 public:
+    // If bucketSizeInSamples is not 0, the sequences of each randomized chunk are grouped by length
+    // into buckets of (at least) the given number of samples, see BucketSequencesByLength.
     SequenceRandomizer(
         IDataDeserializerPtr deserializer,
-        ChunkRandomizerPtr chunkRandomizer);
+        ChunkRandomizerPtr chunkRandomizer,
+        size_t bucketSizeInSamples = 0);
 
     // Resets the current sweep according to the randomization seed provided.
     void Reset(size_t seed);
@@ -76,6 +79,12 @@ private:
     // Move the chunk cursor to the next chunk, randomizing more sequences if necessary.
     void MoveChunkCursor();
 
+    // Reorders sequences of a fully randomized chunk, so that sequences of similar length are adjacent:
+    // the sequences are sorted by length, split into buckets of m_bucketSizeInSamples samples,
+    // and the order of buckets is randomized. Because all sequence positions inside a randomized chunk
+    // share the same randomization window, the reordering does not violate the window constraints.
+    void BucketSequencesByLength(std::vector<RandomizedSequenceDescription>& sequences);
+
 private:
 
     IDataDeserializerPtr m_deserializer;
@@ -157,6 +166,13 @@ private:
 
     // Index of the last chunk in the window (exclusive).
     size_t m_chunkWindowEnd;
+
+    // Size of length buckets in samples, 0 if the bucketing is switched off.
+    size_t m_bucketSizeInSamples;
+
+    // Used only as buffers for bucketing without memory reallocation.
+    std::vector<RandomizedSequenceDescription> m_bufferSortedSequences;
+    std::vector<std::pair<size_t, size_t>> m_bufferBuckets;
 };
 
 typedef std::shared_ptr<SequenceRandomizer> SequenceRandomizerPtr;
@@ -73,6 +73,12 @@ public:
         return *m_indexedValues[id];
     }
 
+    // Gets number of registered values, ids are in range [0, Size()).
+    size_t Size() const
+    {
+        return m_indexedValues.size();
+    }
+
     // Checks whether the value exists.
     bool Contains(const TString& value) const
     {
@@ -278,7 +278,7 @@ void TruncatedBPTTPacker::PackSlot(size_t streamIndex, size_t slotIndex, size_t&
             assert(storageType == StorageType::sparse_csc);
             // TODO: make type casts members of the SparseSequenceData
             SparseSequenceDataPtr sparseSequence = static_pointer_cast<SparseSequenceData>(data);
-            assert(slot.m_sampleCursor < sparseSequence->m_nnzCounts.size());
+            assert(slot.m_sampleCursor < sparseSequence->m_numberOfSamples);
             PackSparseSampleAsDense(destination, sparseSequence, slot.m_sampleCursor, 
                 slot.m_sampleOffset, sampleSize, elementSize);
             slot.m_sampleOffset += sparseSequence->m_nnzCounts[slot.m_sampleCursor];
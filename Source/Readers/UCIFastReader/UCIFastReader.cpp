@@ -285,6 +285,13 @@ void UCIFastReader<ElemType>::InitFromConfig(const ConfigRecordType& readerConfi
 
     m_parser = make_shared<UCIParser<ElemType, LabelType>>(customDelimiter, customDecimalPoint);
 
+    // optionally memory-map the file and parse it with several threads
+    size_t parseThreads = readerConfig(L"parseThreads", (size_t) 1);
+    bool memoryMap = readerConfig(L"memoryMap", parseThreads > 1);
+    if (parseThreads > 1 && !memoryMap)
+        InvalidArgument("UCIFastReader: parseThreads > 1 requires memoryMap=true.");
+    m_parser->SetMemoryMapping(memoryMap, parseThreads);
+
     // See if the user wants caching
     m_cachingReader = NULL;
     m_cachingWriter = NULL;
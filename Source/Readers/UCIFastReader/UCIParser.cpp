@@ -7,6 +7,9 @@
 
 #include "stdafx.h"
 #include "Basics.h"
+#include <exception>
+#include <future>
+#include <iterator>
 #include "UCIParser.h"
 #include <stdexcept>
 #include <stdint.h>
@@ -263,6 +266,10 @@ void UCIParser<NumType, LabelType>::Init(char customDelimiter, char customDecima
     PrepareStartPosition(0);
     m_fileBuffer = NULL;
     m_pFile = NULL;
+    m_memoryMap = false;
+    m_numParseThreads = 1;
+    m_customDelimiter = customDelimiter;
+    m_customDecimalPoint = customDecimalPoint;
     m_stateTable = new DWORD[AllStateMax * 256];
     SetupStateTables(customDelimiter, customDecimalPoint);
 }
@@ -272,7 +279,8 @@ template <typename NumType, typename LabelType>
 UCIParser<NumType, LabelType>::~UCIParser()
 {
     delete m_stateTable;
-    delete m_fileBuffer;
+    if (!m_mappedFile) // a mapped buffer belongs to the mapping
+        delete m_fileBuffer;
     if (m_pFile)
         fclose(m_pFile);
 }
@@ -391,6 +399,16 @@ void UCIParser<NumType, LabelType>::ParseInit(LPCWSTR/*TODO: change to C++ type*
     if (m_pFile != NULL)
         UCIParser<NumType, LabelType>::~UCIParser();
 
+    if (m_memoryMap)
+    {
+        m_mappedFile = std::make_shared<msra::files::mappedfile>(fileName);
+        m_fileSize = m_mappedFile->size();
+        m_fileBuffer = (BYTE *) m_mappedFile->data();
+        m_bufferSize = m_mappedFile->size();
+        SetFilePosition(startPosition);
+        return;
+    }
+
     errno_t err = _wfopen_s(&m_pFile, fileName, L"rb");
     if (err)
         RuntimeError("UCIParser::ParseInit - error opening file %ls", fileName);
@@ -408,6 +426,9 @@ void UCIParser<NumType, LabelType>::ParseInit(LPCWSTR/*TODO: change to C++ type*
 template <typename NumType, typename LabelType>
 int64_t UCIParser<NumType, LabelType>::GetFilePosition()
 {
+    if (m_mappedFile)
+        return m_byteCounter;
+
     int64_t position = ftell64(m_pFile);
     if (position == -1L)
         RuntimeError("UCIParser::GetFilePosition - error retrieving file position in file");
@@ -421,6 +442,14 @@ int64_t UCIParser<NumType, LabelType>::GetFilePosition()
 template <typename NumType, typename LabelType>
 void UCIParser<NumType, LabelType>::SetFilePosition(int64_t position)
 {
+    if (m_mappedFile)
+    {
+        // the whole file is the buffer, nothing to read
+        PrepareStartPosition(position);
+        m_bufferStart = 0;
+        return;
+    }
+
     int rc = _fseeki64(m_pFile, position, SEEK_SET);
     if (rc)
         RuntimeError("UCIParser::SetFilePosition - error seeking in file");
@@ -507,6 +536,16 @@ void UCIParser<NumType, LabelType>::SetTraceLevel(int traceLevel)
     m_traceLevel = traceLevel;
 }
 
+// SetMemoryMapping - Memory-map the file instead of reading it through a buffer, must be called before ParseInit()
+// memoryMap - true to map the whole file
+// numThreads - number of threads that parse a request in parallel (only for memory-mapped files)
+template <typename NumType, typename LabelType>
+void UCIParser<NumType, LabelType>::SetMemoryMapping(bool memoryMap, size_t numThreads)
+{
+    m_memoryMap = memoryMap;
+    m_numParseThreads = std::max(numThreads, (size_t) 1);
+}
+
 // Parse - Parse the data
 // recordsRequested - number of records requested
 // numbers - pointer to vector to return the numbers (must be allocated)
@@ -518,6 +557,144 @@ long UCIParser<NumType, LabelType>::Parse(size_t recordsRequested, std::vector<N
     assert(numbers != NULL || m_dimFeatures == 0 || m_parseMode == ParseLineCount);
     assert(labels != NULL || m_dimLabels == 0 || m_parseMode == ParseLineCount);
 
+    if (m_mappedFile && m_numParseThreads > 1 && m_parseMode == ParseNormal && m_customDelimiter != '\n')
+        return ParseParallel(recordsRequested, numbers, labels);
+    return ParseRange(recordsRequested, m_fileSize, numbers, labels);
+}
+
+// ParseParallel - parse the requested records of a memory-mapped file with several threads
+// The records are split on line boundaries into consecutive pieces. Each piece but the last is parsed by a separate parser
+// on its own thread, the last one by this parser, so that it ends up in exactly the state a sequential parse would leave.
+// recordsRequested - number of records requested
+// numbers - pointer to vector to return the numbers (must be allocated)
+// labels - pointer to vector to return the labels (defaults to null)
+// returns - number of records actually read
+template <typename NumType, typename LabelType>
+long UCIParser<NumType, LabelType>::ParseParallel(size_t recordsRequested, std::vector<NumType> *numbers, std::vector<LabelType> *labels)
+{
+    // find the end of the requested records, a record ends with the first '\n' after anything else (as in the state machine)
+    const char *data = (const char *) m_fileBuffer;
+    const int64_t begin = m_byteCounter;
+    int64_t end = begin;
+    size_t recordCount = 0;
+    bool atEndOfLine = m_current_state == EndOfLine;
+    while (end < m_fileSize && recordCount < recordsRequested)
+    {
+        const bool isNewLine = data[end] == '\n';
+        if (isNewLine && !atEndOfLine)
+            recordCount++;
+        atEndOfLine = isNewLine;
+        end++;
+    }
+
+    // split into pieces that start right after a '\n', small requests are not worth the threads
+    const int64_t minBytesPerPiece = 64 * 1024;
+    const size_t numPieces = (size_t) std::max((int64_t) 1, min((int64_t) m_numParseThreads, (end - begin) / minBytesPerPiece));
+    if (numPieces == 1)
+        return ParseRange(recordsRequested, m_fileSize, numbers, labels);
+
+    std::vector<int64_t> pieceBegin(numPieces + 1);
+    pieceBegin[0] = begin;
+    for (size_t i = 1; i < numPieces; i++)
+    {
+        int64_t position = std::max(pieceBegin[i - 1], begin + (int64_t)((end - begin) * i / numPieces));
+        while (position < end && data[position - 1] != '\n')
+            position++;
+        pieceBegin[i] = position;
+    }
+    pieceBegin[numPieces] = end;
+
+    struct Piece
+    {
+        std::vector<NumType> numbers;
+        std::vector<LabelType> labels;
+        long recordCount;
+        int64_t numbersConverted;
+        int64_t labelsConverted;
+    };
+    std::vector<Piece> pieces(numPieces);
+    const ParseState firstState = m_current_state;
+
+    auto parsePiece = [&](size_t i)
+    {
+        UCIParser<NumType, LabelType> parser(m_customDelimiter, m_customDecimalPoint);
+        parser.m_parseMode = ParseNormal;
+        parser.m_traceLevel = 0;
+        parser.m_startLabels = m_startLabels;
+        parser.m_dimLabels = m_dimLabels;
+        parser.m_startFeatures = m_startFeatures;
+        parser.m_dimFeatures = m_dimFeatures;
+        parser.m_mappedFile = m_mappedFile;
+        parser.m_fileBuffer = m_fileBuffer;
+        parser.m_fileSize = m_fileSize;
+        parser.m_bufferSize = m_bufferSize;
+        parser.PrepareStartPosition(pieceBegin[i]);
+        parser.m_bufferStart = 0;
+        // all pieces but the first start on a new line
+        parser.m_current_state = i == 0 ? firstState : EndOfLine;
+
+        Piece &piece = pieces[i];
+        piece.recordCount = parser.ParseRange(SIZE_MAX, pieceBegin[i + 1], &piece.numbers, labels ? &piece.labels : NULL);
+        piece.numbersConverted = parser.m_totalNumbersConverted;
+        piece.labelsConverted = parser.m_totalLabelsConverted;
+    };
+
+    std::vector<std::future<void>> workers;
+    for (size_t i = 0; i + 1 < numPieces; i++)
+        workers.push_back(std::async(std::launch::async, parsePiece, i));
+
+    // the last piece continues with this parser
+    Piece &last = pieces.back();
+    m_current_state = EndOfLine;
+    m_byteCounter = pieceBegin[numPieces - 1];
+    PrepareStartNumber();
+    PrepareStartLine();
+    last.recordCount = ParseRange(SIZE_MAX, end, &last.numbers, labels ? &last.labels : NULL);
+
+    // wait for all workers before the first exception is passed on
+    std::exception_ptr error;
+    for (auto &worker : workers)
+    {
+        try
+        {
+            worker.get();
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+
+    long totalRecords = 0;
+    for (size_t i = 0; i < numPieces; i++)
+    {
+        if (numbers)
+            numbers->insert(numbers->end(), pieces[i].numbers.begin(), pieces[i].numbers.end());
+        if (labels)
+            labels->insert(labels->end(), std::make_move_iterator(pieces[i].labels.begin()), std::make_move_iterator(pieces[i].labels.end()));
+        totalRecords += pieces[i].recordCount;
+        if (i + 1 < numPieces)
+        {
+            m_totalNumbersConverted += pieces[i].numbersConverted;
+            m_totalLabelsConverted += pieces[i].labelsConverted;
+        }
+    }
+    assert((size_t) totalRecords == recordCount);
+    return totalRecords;
+}
+
+// ParseRange - run the state machine until recordsRequested records are read or endPosition is reached
+// recordsRequested - number of records requested
+// endPosition - file position at which to stop
+// numbers - pointer to vector to return the numbers
+// labels - pointer to vector to return the labels
+// returns - number of records actually read
+template <typename NumType, typename LabelType>
+long UCIParser<NumType, LabelType>::ParseRange(size_t recordsRequested, int64_t endPosition, std::vector<NumType> *numbers, std::vector<LabelType> *labels)
+{
     // transfer to member variables
     m_numbers = numbers;
     m_labels = labels;
@@ -525,7 +702,7 @@ long UCIParser<NumType, LabelType>::Parse(size_t recordsRequested, std::vector<N
     long TickStart = GetTickCount();
     long recordCount = 0;
     size_t bufferIndex = m_byteCounter - m_bufferStart;
-    while (m_byteCounter < m_fileSize && recordCount < recordsRequested)
+    while (m_byteCounter < endPosition && recordCount < recordsRequested)
     {
         // check to see if we need to update the buffer
         if (bufferIndex >= m_bufferSize)
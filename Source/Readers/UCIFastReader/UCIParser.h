@@ -11,6 +11,8 @@
 #include <assert.h>
 #include <stdint.h>
 #include <algorithm>
+#include <memory>
+#include "fileutil.h"
 
 #ifdef min
 #undef min
@@ -73,6 +75,8 @@ private:
 
     // state tables
     DWORD *m_stateTable;
+    char m_customDelimiter;
+    char m_customDecimalPoint;
 
     // numeric state machine variables
     double m_partialResult;
@@ -101,6 +105,11 @@ private:
     size_t m_bufferStart;
     size_t m_bufferSize;
 
+    // memory-mapped mode: the whole file is mapped, m_fileBuffer points into the mapping and m_bufferStart stays 0
+    bool m_memoryMap;
+    size_t m_numParseThreads; // number of threads for parsing in memory-mapped mode
+    std::shared_ptr<msra::files::mappedfile> m_mappedFile;
+
     // last label was a string (for last label processing)
     bool m_lastLabelIsString;
 
@@ -132,6 +141,12 @@ private:
     // returns - number of records read
     size_t UpdateBuffer();
 
+    // ParseRange - run the state machine until recordsRequested records are read or endPosition is reached
+    long ParseRange(size_t recordsRequested, int64_t endPosition, std::vector<NumType> *numbers, std::vector<LabelType> *labels);
+
+    // ParseParallel - parse the requested records of a memory-mapped file with several threads
+    long ParseParallel(size_t recordsRequested, std::vector<NumType> *numbers, std::vector<LabelType> *labels);
+
 public:
     // UCIParser constructor
     UCIParser(char customDelimiter, char customDecimalPoint);
@@ -164,6 +179,11 @@ public:
     // traceLevel - traceLevel, zero means no output, 1 epoch related output, > 1 all output
     void SetTraceLevel(int traceLevel);
 
+    // SetMemoryMapping - Memory-map the file instead of reading it through a buffer, must be called before ParseInit()
+    // memoryMap - true to map the whole file
+    // numThreads - number of threads that parse a request in parallel (only for memory-mapped files)
+    void SetMemoryMapping(bool memoryMap, size_t numThreads);
+
     // ParseInit - Initialize a parse of a file
     // fileName - path to the file to open
     // startFeatures - column (zero based) where features start
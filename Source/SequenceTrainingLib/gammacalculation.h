@@ -100,7 +100,6 @@ public:
     {
         // check total frame number to be added ?
         // int deviceid = loglikelihood.GetDeviceId();
-        size_t boundaryframenum;
         std::vector<size_t> validframes; // [s] cursor pointing to next utterance begin within a single parallel sequence [s]
         validframes.assign(samplesInRecurrentStep, 0);
         ElemType objectValue = 0.0;
@@ -126,12 +125,20 @@ public:
             assert(T == pMBLayout->GetNumTimeSteps());
         }
 
-        size_t mapi = 0; // parallel-sequence index for utterance [i]
-        // cal gamma for each utterance
+        // per-utterance positions within the minibatch, determined while copying the log-likelihoods
+        const size_t numutterances = lattices.size();
+        std::vector<size_t> uttts(numutterances);            // [i] first column of utterance [i] in pred and dengammas
+        std::vector<size_t> uttmapi(numutterances);          // [i] parallel-sequence index for utterance [i]
+        std::vector<size_t> uttvalidframes(numutterances);   // [i] first time step of utterance [i] within its parallel sequence
+        std::vector<double> numavlogps(numutterances);
+        std::vector<double> denavlogps(numutterances);
+
+        // copy the log-likelihoods of utterance [i] into pred
         size_t ts = 0;
-        for (size_t i = 0; i < lattices.size(); i++)
+        auto prepareutterance = [&](size_t i)
         {
             const size_t numframes = lattices[i]->getnumframes();
+            size_t mapi = 0;
 
             msra::dbn::matrixstripe predstripe(pred, ts, numframes);           // logLLs for this utterance
             msra::dbn::matrixstripe dengammasstripe(dengammas, ts, numframes); // denominator gammas
@@ -186,40 +193,58 @@ public:
                 }
             }
 
-            array_ref<size_t> uidsstripe(&uids[ts], numframes);
-
-            if (doreferencealign)
-            {
-                boundaryframenum = numframes;
-            }
-            else
-                boundaryframenum = 0;
-            array_ref<size_t> boundariesstripe(&boundaries[ts], boundaryframenum);
+            uttts[i] = ts;
+            uttmapi[i] = mapi;
+            uttvalidframes[i] = validframes[mapi];
 
             double numavlogp = 0;
             foreach_column (t, dengammasstripe) // we do not allocate memory for numgamma now, should be the same as numgammasstripe
             {
-                const size_t s = uidsstripe[t];
+                const size_t s = uids[ts + t];
                 numavlogp += predstripe(s, t) / amf;
             }
-            numavlogp /= numframes;
+            numavlogps[i] = numavlogp / numframes;
+
+            if (samplesInRecurrentStep > 1)
+                validframes[mapi] += numframes; // advance the cursor within the parallel sequence
+            ts += numframes;
+        };
+
+        // lattice forward-backward for utterance [i]; only touches the columns of utterance [i]
+        auto computeutterance = [&](size_t i)
+        {
+            const size_t numframes = lattices[i]->getnumframes();
+            msra::dbn::matrixstripe predstripe(pred, uttts[i], numframes);
+            msra::dbn::matrixstripe dengammasstripe(dengammas, uttts[i], numframes);
+            array_ref<size_t> uidsstripe(&uids[uttts[i]], numframes);
+            size_t boundaryframenum = doreferencealign ? numframes : 0;
+            array_ref<size_t> boundariesstripe(&boundaries[uttts[i]], boundaryframenum);
 
             // auto_timer dengammatimer;
-            double denavlogp = lattices[i]->second.forwardbackward(parallellattice,
-                                                                   (const msra::math::ssematrixbase&) predstripe, (const msra::asr::simplesenonehmm&) m_hset,
-                                                                   (msra::math::ssematrixbase&) dengammasstripe, (msra::math::ssematrixbase&) gammasbuffer /*empty, not used*/,
-                                                                   lmf, wp, amf, boostmmifactor, seqsMBRmode, uidsstripe, boundariesstripe);
-            objectValue += (ElemType)((numavlogp - denavlogp) * numframes);
+            denavlogps[i] = lattices[i]->second.forwardbackward(parallellattice,
+                                                                (const msra::math::ssematrixbase&) predstripe, (const msra::asr::simplesenonehmm&) m_hset,
+                                                                (msra::math::ssematrixbase&) dengammasstripe, (msra::math::ssematrixbase&) gammasbuffer /*empty, not used*/,
+                                                                lmf, wp, amf, boostmmifactor, seqsMBRmode, uidsstripe, boundariesstripe);
+        };
+
+        // copy the gammas of utterance [i] to gammafromlattice
+        auto finishutterance = [&](size_t i)
+        {
+            const size_t numframes = lattices[i]->getnumframes();
+            const size_t uttstart = uttts[i];
+            const size_t mapi = uttmapi[i];
+            objectValue += (ElemType)((numavlogps[i] - denavlogps[i]) * numframes);
 
             if (samplesInRecurrentStep == 1)
             {
-                tempmatrix = gammafromlattice.ColumnSlice(ts, numframes);
+                tempmatrix = gammafromlattice.ColumnSlice(uttstart, numframes);
             }
 
             // copy gamma to tempmatrix
             if (m_deviceid == CPUDEVICE)
             {
-                CopyFromSSEMatrixToCNTKMatrix(dengammas, numrows, numframes, tempmatrix, gammafromlattice.GetDeviceId());
+                msra::dbn::matrixstripe dengammasstripe(dengammas, uttstart, numframes);
+                CopyFromSSEMatrixToCNTKMatrix(dengammasstripe, numrows, numframes, tempmatrix, gammafromlattice.GetDeviceId());
             }
             else
                 parallellattice.getgamma(tempmatrix);
@@ -227,7 +252,7 @@ public:
             // set gamma for multi channel
             if (samplesInRecurrentStep > 1)
             {
-                Microsoft::MSR::CNTK::Matrix<ElemType> gammaFromLatticeForCurrentParallelUtterance = gammafromlattice.ColumnSlice(mapi + (validframes[mapi] * samplesInRecurrentStep), ((numframes - 1) * samplesInRecurrentStep) + 1);
+                Microsoft::MSR::CNTK::Matrix<ElemType> gammaFromLatticeForCurrentParallelUtterance = gammafromlattice.ColumnSlice(mapi + (uttvalidframes[i] * samplesInRecurrentStep), ((numframes - 1) * samplesInRecurrentStep) + 1);
                 gammaFromLatticeForCurrentParallelUtterance.CopyColumnsStrided(tempmatrix, numframes, 1, samplesInRecurrentStep);
             }
 
@@ -235,17 +260,38 @@ public:
             {
                 for (size_t nframe = 0; nframe < numframes; nframe++)
                 {
-                    size_t uid = uidsstripe[nframe];
+                    size_t uid = uids[uttstart + nframe];
                     if (samplesInRecurrentStep > 1)
-                        labels(uid, (nframe + validframes[mapi]) * samplesInRecurrentStep + mapi) = 1.0;
+                        labels(uid, (nframe + uttvalidframes[i]) * samplesInRecurrentStep + mapi) = 1.0;
                     else
-                        labels(uid, ts + nframe) = 1.0;
+                        labels(uid, uttstart + nframe) = 1.0;
                 }
             }
-            if (samplesInRecurrentStep > 1)
-                validframes[mapi] += numframes; // advance the cursor within the parallel sequence
-            fprintf(stderr, "dengamma value %f\n", denavlogp);
-            ts += numframes;
+            fprintf(stderr, "dengamma value %f\n", denavlogps[i]);
+        };
+
+        // cal gamma for each utterance
+        if (m_deviceid == CPUDEVICE && !parallellattice.enabled())
+        {
+            // On the CPU the lattices of a minibatch are independent of each other, so they are processed
+            // concurrently. Copying between CNTK and SSE matrices stays on this thread.
+            for (size_t i = 0; i < numutterances; i++)
+                prepareutterance(i);
+#pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < (int) numutterances; i++)
+                computeutterance(i);
+            for (size_t i = 0; i < numutterances; i++)
+                finishutterance(i);
+        }
+        else
+        {
+            // the GPU holds the log-likelihoods and gammas of one utterance at a time
+            for (size_t i = 0; i < numutterances; i++)
+            {
+                prepareutterance(i);
+                computeutterance(i);
+                finishutterance(i);
+            }
         }
         functionValues.SetValue(objectValue);
     }
@@ -131,6 +131,24 @@ static bool islogzero(FLOAT v)
     return v < LOGZERO / 2;
 } // is this number to be considered 0
 
+// logsum (v, n) -> log [ sum_i exp (v[i]) ]
+// Same as a chain of logadd() calls, but takes the max once and then sums the exp() terms in a plain scalar loop,
+// which saves the compare and log() per term. It is not vectorized: there is no SIMD exp() to call here.
+static double logsum(const double *v, size_t n)
+{
+    if (n == 0)
+        return LOGZERO;
+    double maxv = v[0];
+    for (size_t i = 1; i < n; i++)
+        maxv = max(maxv, v[i]);
+    if (maxv <= LOGZERO) // all are 0
+        return maxv;
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++)
+        sum += exp(v[i] - maxv);
+    return maxv + log(sum);
+}
+
 // ---------------------------------------------------------------------------
 // other helpers go here
 // ---------------------------------------------------------------------------
@@ -482,6 +500,95 @@ static bool islogzero(FLOAT v)
     return fwscore;
 }
 
+// ---------------------------------------------------------------------------
+// latticelayers -- lattice nodes grouped into topological layers
+//
+// A node's layer is its longest distance (in edges) from any node without
+// predecessors. All predecessors of a node are therefore in earlier layers and
+// all successors in later ones, so the nodes of one layer can be updated
+// concurrently, each gathering over its own incoming (forward) or outgoing
+// (backward) edges. This replaces the serial scatter over the edge list.
+// ---------------------------------------------------------------------------
+
+class latticelayers
+{
+    std::vector<size_t> layerbegin; // [l] first entry in layernodes of layer l; one extra entry at end
+    std::vector<size_t> layernodes; // node indices grouped by layer
+    std::vector<size_t> inbegin;    // [i] first entry in inedges of node i; one extra entry at end
+    std::vector<size_t> inedges;    // edge indices grouped by end node
+    std::vector<size_t> outbegin;   // [i] first entry in outedges of node i; one extra entry at end
+    std::vector<size_t> outedges;   // edge indices grouped by start node
+
+    // group the values 0..keys.size()-1 by key (counting sort): begin[k] is where group k starts in sorted
+    static void groupby(const std::vector<size_t> &keys, size_t numkeys, std::vector<size_t> &begin, std::vector<size_t> &sorted)
+    {
+        begin.assign(numkeys + 1, 0);
+        for (size_t k : keys)
+            begin[k + 1]++;
+        for (size_t k = 0; k < numkeys; k++)
+            begin[k + 1] += begin[k];
+        sorted.resize(keys.size());
+        std::vector<size_t> pos(begin.begin(), begin.end() - 1);
+        for (size_t i = 0; i < keys.size(); i++)
+            sorted[pos[keys[i]]++] = i;
+    }
+
+public:
+    // 'edges' must be sorted such that all incoming edges of a node come before its outgoing ones,
+    // which is what the serial forward/backward pass relies on as well.
+    template <class EDGES>
+    latticelayers(size_t numnodes, const EDGES &edges)
+    {
+        std::vector<size_t> edgeS(edges.size()), edgeE(edges.size());
+        std::vector<size_t> level(numnodes, 0);
+        size_t numlayers = numnodes > 0 ? 1 : 0;
+        for (size_t j = 0; j < edges.size(); j++)
+        {
+            edgeS[j] = edges[j].S;
+            edgeE[j] = edges[j].E;
+            level[edgeE[j]] = max(level[edgeE[j]], level[edgeS[j]] + 1);
+            numlayers = max(numlayers, level[edgeE[j]] + 1);
+        }
+        groupby(level, numlayers, layerbegin, layernodes);
+        groupby(edgeE, numnodes, inbegin, inedges);
+        groupby(edgeS, numnodes, outbegin, outedges);
+    }
+
+    // only worth spreading over threads if the layers are wide enough to amortize the barrier after each
+    bool parallelizable() const
+    {
+        const size_t numlayers = layerbegin.size() - 1;
+        return layernodes.size() >= 16 * numlayers && inedges.size() >= 1024;
+    }
+
+    // call f(i, inedges, numinedges, scratch) for all nodes i in forward order (by layer)
+    // or f(i, outedges, numoutedges, scratch) in backward order. Calls within a layer may run concurrently.
+    // 'scratch' is a per-thread pair of buffers for collecting terms for logsum().
+    template <class F>
+    void foreachnode(bool backward, F f) const
+    {
+        const std::vector<size_t> &begin = backward ? outbegin : inbegin;
+        const std::vector<size_t> &nodeedges = backward ? outedges : inedges;
+        const int numlayers = (int) layerbegin.size() - 1;
+#pragma omp parallel if (parallelizable())
+        {
+            std::vector<double> scratch[2];
+            for (int k = 0; k < numlayers; k++)
+            {
+                const size_t l = backward ? numlayers - 1 - k : k;
+                const int first = (int) layerbegin[l];
+                const int last = (int) layerbegin[l + 1];
+#pragma omp for schedule(static)
+                for (int m = first; m < last; m++) // implied barrier at the end: next layer depends on this one
+                {
+                    const size_t i = layernodes[m];
+                    f(i, nodeedges.data() + begin[i], begin[i + 1] - begin[i], scratch);
+                }
+            }
+        }
+    }
+};
+
 // ---------------------------------------------------------------------------
 // forwardbackwardlattice() -- lattice-level forward/backward
 //
@@ -517,6 +624,21 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
     logbetas.assign(nodes.size(), LOGZERO);
     logbetas.back() = 0.0f;
 
+    // The passes below gather over the incoming resp. outgoing edges of each node, one topological layer at a
+    // time, with the nodes of a layer spread over threads. Results match the serial edge-by-edge version up to
+    // the order of the additions.
+    const latticelayers layers(nodes.size(), edges);
+    const bool parallel = layers.parallelizable();
+
+    // per-edge scores; pruned edges have edgeacscores[j] == LOGZERO
+    std::vector<double> edgescores(edges.size());
+#pragma omp parallel for if (parallel)
+    foreach_index (j, edges)
+    {
+        const auto &e = edges[j];
+        edgescores[j] = (e.l * lmf + wp + edgeacscores[j]) / amf;
+    }
+
     // --- sMBR version
 
     if (sMBRmode)
@@ -528,28 +650,43 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
         std::vector<double> logaccbetas(nodes.size(), LOGZERO);  // [i] likewise
         std::vector<double> logframescorrectedge(edges.size());  // raw counts of correct frames in each edge
 
-        // forward pass
+#pragma omp parallel for if (parallel)
         foreach_index (j, edges)
         {
             if (islogzero(edgeacscores[j])) // indicates that this edge is pruned
                 continue;
             const auto &e = edges[j];
-            const double inscore = logalphas[e.S];
-            const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf;
-            const double pathscore = inscore + edgescore;
-            logadd(logalphas[e.E], pathscore);
-
             size_t ts = nodes[e.S].t;
             size_t te = nodes[e.E].t;
             size_t framescorrect = 0; // count raw number of correct frames
             for (size_t t = ts; t < te; t++)
                 framescorrect += (thisedgealignments[j][t - ts] == uids[t]);
             logframescorrectedge[j] = (framescorrect > 0) ? log((double) framescorrect) : LOGZERO; // remember for backward pass
-            double loginaccs = logaccalphas[e.S] - logalphas[e.S];
-            logadd(loginaccs, logframescorrectedge[j]);
-            double logpathacc = loginaccs + logalphas[e.S] + edgescore;
-            logadd(logaccalphas[e.E], logpathacc);
         }
+
+        // forward pass
+        layers.foreachnode(false, [&](size_t i, const size_t *inedges, size_t numinedges, std::vector<double> *scratch)
+        {
+            std::vector<double> &pathscores = scratch[0];
+            std::vector<double> &pathaccs = scratch[1];
+            pathscores.assign(1, logalphas[i]);
+            pathaccs.assign(1, logaccalphas[i]);
+            for (size_t k = 0; k < numinedges; k++)
+            {
+                const size_t j = inedges[k];
+                if (islogzero(edgeacscores[j])) // indicates that this edge is pruned
+                    continue;
+                const auto &e = edges[j];
+                const double pathscore = logalphas[e.S] + edgescores[j];
+                pathscores.push_back(pathscore);
+
+                double loginaccs = logaccalphas[e.S] - logalphas[e.S];
+                logadd(loginaccs, logframescorrectedge[j]);
+                pathaccs.push_back(loginaccs + pathscore);
+            }
+            logalphas[i] = logsum(pathscores.data(), pathscores.size());
+            logaccalphas[i] = logsum(pathaccs.data(), pathaccs.size());
+        });
         foreach_index (j, logaccalphas)
             logaccalphas[j] -= logalphas[j];
 
@@ -561,24 +698,40 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
             return LOGZERO; // failed, do not use resulting matrix
         }
 
-        // backward pass and computation of state-conditioned frames-correct count
-        for (size_t j = edges.size() - 1; j + 1 > 0; j--)
+        // backward pass
+        layers.foreachnode(true, [&](size_t i, const size_t *outedges, size_t numoutedges, std::vector<double> *scratch)
+        {
+            std::vector<double> &pathscores = scratch[0];
+            std::vector<double> &pathaccs = scratch[1];
+            pathscores.assign(1, logbetas[i]);
+            pathaccs.assign(1, logaccbetas[i]);
+            for (size_t k = 0; k < numoutedges; k++)
+            {
+                const size_t j = outedges[k];
+                if (islogzero(edgeacscores[j])) // indicates that this edge is pruned
+                    continue;
+                const auto &e = edges[j];
+                const double pathscore = logbetas[e.E] + edgescores[j];
+                pathscores.push_back(pathscore);
+
+                double loginaccs = logaccbetas[e.E] - logbetas[e.E];
+                logadd(loginaccs, logframescorrectedge[j]);
+                pathaccs.push_back(loginaccs + pathscore);
+            }
+            logbetas[i] = logsum(pathscores.data(), pathscores.size());
+            logaccbetas[i] = logsum(pathaccs.data(), pathaccs.size());
+        });
+
+        // computation of state-conditioned frames-correct count
+#pragma omp parallel for if (parallel)
+        foreach_index (j, edges)
         {
             if (islogzero(edgeacscores[j])) // indicates that this edge is pruned
                 continue;
             const auto &e = edges[j];
-            const double inscore = logbetas[e.E];
-            const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf;
-            const double pathscore = inscore + edgescore;
-            logadd(logbetas[e.S], pathscore);
-
-            double loginaccs = logaccbetas[e.E] - logbetas[e.E];
-            logadd(loginaccs, logframescorrectedge[j]);
-            double logpathacc = loginaccs + logbetas[e.E] + edgescore;
-            logadd(logaccbetas[e.S], logpathacc);
 
             // sum up to get final expected frames-correct count per state == per edge (since we assume hard state alignment)
-            double logpp = logalphas[e.S] + edgescore + logbetas[e.E] - totalfwscore;
+            double logpp = logalphas[e.S] + edgescores[j] + logbetas[e.E] - totalfwscore;
             if (logpp > 1e-2)
                 fprintf(stderr, "forwardbackward: WARNING: edge J=%d log posterior %.10f > 0\n", (int) j, (float) logpp);
             if (logpp > 0.0)
@@ -606,14 +759,18 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
     // --- MMI version
 
     // forward pass
-    foreach_index (j, edges)
+    // note: edgeacscores[j] == LOGZERO if edge was pruned, which makes its contribution vanish
+    layers.foreachnode(false, [&](size_t i, const size_t *inedges, size_t numinedges, std::vector<double> *scratch)
     {
-        const auto &e = edges[j];
-        const double inscore = logalphas[e.S];
-        const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf; // note: edgeacscores[j] == LOGZERO if edge was pruned
-        const double pathscore = inscore + edgescore;
-        logadd(logalphas[e.E], pathscore);
-    }
+        std::vector<double> &pathscores = scratch[0];
+        pathscores.assign(1, logalphas[i]);
+        for (size_t k = 0; k < numinedges; k++)
+        {
+            const size_t j = inedges[k];
+            pathscores.push_back(logalphas[edges[j].S] + edgescores[j]);
+        }
+        logalphas[i] = logsum(pathscores.data(), pathscores.size());
+    });
     const double totalfwscore = logalphas.back();
     if (islogzero(totalfwscore))
     {
@@ -622,17 +779,24 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
     }
 
     // backward pass
-    // this also computes the word posteriors on the fly, since we are at it
-    for (size_t j = edges.size() - 1; j + 1 > 0; j--)
+    layers.foreachnode(true, [&](size_t i, const size_t *outedges, size_t numoutedges, std::vector<double> *scratch)
     {
-        const auto &e = edges[j];
-        const double inscore = logbetas[e.E];
-        const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf;
-        const double pathscore = inscore + edgescore;
-        logadd(logbetas[e.S], pathscore);
+        std::vector<double> &pathscores = scratch[0];
+        pathscores.assign(1, logbetas[i]);
+        for (size_t k = 0; k < numoutedges; k++)
+        {
+            const size_t j = outedges[k];
+            pathscores.push_back(logbetas[edges[j].E] + edgescores[j]);
+        }
+        logbetas[i] = logsum(pathscores.data(), pathscores.size());
+    });
 
-        // compute lattice posteriors on the fly since we are at it
-        double logpp = logalphas[e.S] + edgescore + logbetas[e.E] - totalfwscore;
+    // lattice posteriors
+#pragma omp parallel for if (parallel)
+    foreach_index (j, edges)
+    {
+        const auto &e = edges[j];
+        double logpp = logalphas[e.S] + edgescores[j] + logbetas[e.E] - totalfwscore;
         if (logpp > 1e-2)
             fprintf(stderr, "forwardbackward: WARNING: edge J=%d log posterior %.10f > 0\n", (int) j, (float) logpp);
         if (logpp > 0.0)
@@ -952,6 +1116,9 @@ void lattice::forwardbackwardalign(parallelstate &parallelstate,
             parallelstate.getedgeacscores(edgeacscoresgpu);
             parallelstate.copyalignments(thisedgealignmentsgpu);
         }
+        // edges are aligned independently of each other, each writing only its own score, abcs and alignment;
+        // keep the order (and thus the log) deterministic when verifying
+#pragma omp parallel for schedule(dynamic) if (!cpuverification)
         foreach_index (j, edges)
         {
             const edgeinfowithscores &e = edges[j];
@@ -1338,6 +1505,21 @@ double lattice::forwardbackward(parallelstate &parallelstate, const msra::math::
                                 const bool sMBRmode, array_ref<size_t> uids, const_array_ref<size_t> bounds,
                                 const_array_ref<htkmlfwordsequence::word> transcript, const std::vector<float> &transcriptunigrams) const
 {
+    // lattices read on demand from a memory-mapped archive are decoded for the duration of this function only
+    struct decodedscope
+    {
+        const lattice &L;
+        decodedscope(const lattice &L)
+            : L(L)
+        {
+            L.ensuredecoded();
+        }
+        ~decodedscope()
+        {
+            L.releasedecoded();
+        }
+    } decodedlattice(*this);
+
     bool softalign = true;
     bool softalignstates = false;      // true if soft alignment within edges, currently we only support soft within edge in cpu mode
     bool softalignlattice = softalign; // w.r.t. whole lattice
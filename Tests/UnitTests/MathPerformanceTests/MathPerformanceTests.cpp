@@ -12,6 +12,9 @@
 #include <vector>
 #include "Matrix.h"
 #include "CPUMatrix.h"
+#include "CPUGemm.h"
+#include "CPUFastMath.h"
+#include "TensorView.h"
 #include "Sequences.h"
 using namespace Microsoft::MSR::CNTK;
 using namespace std;
@@ -216,6 +219,107 @@ void MultiplyAndWeightedAddTest(int n, int k, int m)
     std::cout << "Matrix in: " << 1.0 * (t_endG - t_startG) / CLOCKS_PER_SEC << " seconds" << endl;
 }
 
+// Times CPUMatrix::MultiplyAndWeightedAdd with the BLAS library and with the native kernels for shapes from recurrent steps
+// to large square products, for setting up the crossover table in CPUGemm.cpp.
+template <class ElemType>
+double TimeCPUGemm(CPUGemmPolicy policy, const CPUMatrix<ElemType>& A, const CPUMatrix<ElemType>& B, CPUMatrix<ElemType>& C)
+{
+    SetCPUGemmPolicy(policy);
+    const double work = (double) A.GetNumRows() * A.GetNumCols() * B.GetNumCols();
+    const int count = (int) std::max(3.0, 2e8 / work);
+    CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, C); // warm up
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i)
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, C);
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count() / count;
+}
+
+template <class ElemType>
+void GemmCrossoverTest()
+{
+    const int shapes[][3] = {
+        { 512, 1, 512 }, { 512, 4, 512 }, { 2048, 4, 512 }, { 512, 8, 512 }, { 512, 16, 512 }, { 1024, 16, 1024 }, { 512, 64, 512 },
+        { 16, 16, 16 }, { 32, 32, 32 }, { 64, 64, 64 }, { 128, 128, 128 }, { 256, 256, 256 }, { 512, 512, 512 } };
+
+    const CPUGemmPolicy policy = GetCPUGemmPolicy();
+    cout << "Testing CPUGemm crossover (" << (sizeof(ElemType) == sizeof(float) ? "float" : "double") << ")" << endl;
+    for (const auto& shape : shapes)
+    {
+        const int m = shape[0], n = shape[1], k = shape[2];
+        CPUMatrix<ElemType> A(m, k);
+        randomInitializeCPUMatrix<ElemType>(A);
+        CPUMatrix<ElemType> B(k, n);
+        randomInitializeCPUMatrix<ElemType>(B);
+        CPUMatrix<ElemType> C(m, n);
+
+        double blas = TimeCPUGemm(CPUGemmPolicy::Blas, A, B, C);
+        double native = TimeCPUGemm(CPUGemmPolicy::Native, A, B, C);
+        cout << m << "x" << k << " * " << k << "x" << n << ": BLAS " << blas * 1e6 << " us, native " << native * 1e6 << " us, "
+             << (native < blas ? "native" : "BLAS") << " is faster, table selects " << (CPUGemm<ElemType>::PreferNative(m, n, k) ? "native" : "BLAS") << endl;
+    }
+    SetCPUGemmPolicy(policy);
+}
+
+// Times a unary CPU tensor op over a whole matrix under the given math functions, and returns seconds per element.
+double TimeCPUTensorOp(CPUMathFunctions functions, ElementWiseOperator op, const TensorView<float>& in, TensorView<float>& out, size_t numElements)
+{
+    SetCPUMathFunctions(functions);
+    const int count = 20;
+    out.DoUnaryOpOf(0, in, 1, op, ElementWiseOperator::opSum); // warm up
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i)
+        out.DoUnaryOpOf(0, in, 1, op, ElementWiseOperator::opSum);
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count() / count / numElements;
+}
+
+// Compares the fast transcendental functions of the CPU tensor ops (CPUFastMath.h) with the exact ones, for the
+// accuracy over typical input ranges and the throughput on an LSTM-sized minibatch.
+void FastMathFunctionsTest()
+{
+    struct
+    {
+        const char* name;
+        ElementWiseOperator op;
+        float low, high;
+    } tests[] = {
+        { "Sigmoid", ElementWiseOperator::opSigmoid, -20, 20 },
+        { "Tanh", ElementWiseOperator::opTanh, -20, 20 },
+        { "Exp", ElementWiseOperator::opExp, -80, 80 },
+        { "Log", ElementWiseOperator::opLog, -69, 69 } }; // exp() of these, see below
+    const size_t rows = 4096, cols = 256;
+    const TensorShape shape(rows, cols);
+
+    cout << "Testing fast math functions (" << rows << "x" << cols << ", float)" << endl;
+    for (const auto& test : tests)
+    {
+        auto in = make_shared<Matrix<float>>(Matrix<float>::RandomUniform(rows, cols, CPUDEVICE, test.low, test.high, 1));
+        if (test.op == ElementWiseOperator::opLog) // spread the inputs over all exponents
+            in->InplaceExp();
+        auto exact = make_shared<Matrix<float>>(rows, cols, CPUDEVICE);
+        auto fast = make_shared<Matrix<float>>(rows, cols, CPUDEVICE);
+        TensorView<float> inView(in, shape), exactView(exact, shape), fastView(fast, shape);
+
+        double exactTime = TimeCPUTensorOp(CPUMathFunctions::Exact, test.op, inView, exactView, rows * cols);
+        double fastTime = TimeCPUTensorOp(CPUMathFunctions::Fast, test.op, inView, fastView, rows * cols);
+
+        double maxAbsError = 0, maxRelError = 0;
+        const float* pExact = exact->Data();
+        const float* pFast = fast->Data();
+        for (size_t i = 0; i < rows * cols; i++)
+        {
+            double error = fabs((double) pFast[i] - pExact[i]);
+            maxAbsError = std::max(maxAbsError, error);
+            if (pExact[i] != 0)
+                maxRelError = std::max(maxRelError, error / fabs(pExact[i]));
+        }
+        cout << test.name << ": exact " << exactTime * 1e9 << " ns, fast " << fastTime * 1e9 << " ns per element ("
+             << exactTime / fastTime << "x), max error " << maxAbsError << " absolute, " << maxRelError << " relative" << endl;
+    }
+    SetCPUMathFunctions(CPUMathFunctions::Exact);
+}
+
 template <class ElemType>
 void AddMultiplyAndInplaceSigmoidTest(int n, int k, int m)
 {
@@ -443,6 +547,11 @@ int wmain()
 
     TestOldRnnForwardPropSRP<float>();
 
+    GemmCrossoverTest<float>();
+    GemmCrossoverTest<double>();
+
+    FastMathFunctionsTest();
+
     // MandSTest<float>(100, 2);
 
     /*cout<<endl<<"********************Matrix SquareMultiplyAndWeightedAdd10TimesAvg TEST********************"<<endl;
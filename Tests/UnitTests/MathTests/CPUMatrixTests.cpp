@@ -4,6 +4,7 @@
 //
 #include "stdafx.h"
 #include "../../../Source/Math/CPUMatrix.h"
+#include "../../../Source/Math/CPUGemm.h"
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -898,6 +899,116 @@ BOOST_FIXTURE_TEST_CASE(CPUMatrixSeedingDouble, RandomSeedFixture)
     BOOST_CHECK(m1.IsEqualTo(m2));
 }
 
+BOOST_FIXTURE_TEST_CASE(CPUMatrixPhilox, RandomSeedFixture)
+{
+    // known answer of the reference implementation for a zero counter and key
+    uint32_t r[4];
+    Philox4x32(0, 0, r);
+    BOOST_CHECK_EQUAL(r[0], 0x6627e8d5u);
+    BOOST_CHECK_EQUAL(r[1], 0xe169c58du);
+    BOOST_CHECK_EQUAL(r[2], 0xbc57ac4cu);
+    BOOST_CHECK_EQUAL(r[3], 0x9b00dbd8u);
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUMatrixDropoutBitMask, RandomSeedFixture)
+{
+    const size_t m = 37;
+    const size_t n = 20;
+    const float rate = 0.3f;
+    const float scale = 1 / (1 - rate);
+    const unsigned long seed = 4711;
+
+    auto input = SMatrix::RandomUniform(m, n, 1, 2, IncrementCounter());
+    SMatrix output;
+    CPUMatrix<char> bitMask;
+    CPURNGHandle rng(CPUDEVICE, seed);
+    output.AssignDropoutOf(input, rate, scale, rng, bitMask);
+    BOOST_CHECK_EQUAL(bitMask.GetNumRows(), (m + 7) / 8);
+    BOOST_CHECK_EQUAL(bitMask.GetNumCols(), n);
+
+    // the same seed gives the same mask
+    SMatrix output1;
+    CPUMatrix<char> bitMask1;
+    CPURNGHandle rng1(CPUDEVICE, seed);
+    output1.AssignDropoutOf(input, rate, scale, rng1, bitMask1);
+    BOOST_CHECK(output.IsEqualTo(output1));
+
+    auto gradient = SMatrix::RandomUniform(m, n, 1, 2, IncrementCounter());
+    SMatrix inputGradient(m, n);
+    inputGradient.SetValue(1);
+    inputGradient.AddDropoutGradientOf(gradient, scale, bitMask);
+
+    size_t dropped = 0;
+    foreach_coord (i, j, output)
+    {
+        bool kept = ((unsigned char) bitMask(i / 8, j) >> (i % 8)) & 1;
+        dropped += kept ? 0 : 1;
+        BOOST_CHECK_CLOSE(output(i, j), kept ? input(i, j) * scale : 0, c_epsilonFloatE4);
+        BOOST_CHECK_CLOSE(inputGradient(i, j), kept ? 1 + gradient(i, j) * scale : 1, c_epsilonFloatE4);
+    }
+    BOOST_CHECK(dropped > m * n / 5 && dropped < m * n * 2 / 5);
+
+    // a second draw from the handle gives a different mask
+    output1.AssignDropoutOf(input, rate, scale, rng, bitMask1);
+    BOOST_CHECK(!output.IsEqualTo(output1));
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUMatrixNativeGemm, RandomSeedFixture)
+{
+    // shapes for the direct path (small or skinny) and for the packed path, with edges that are not multiples of the tiles
+    const size_t shapes[][3] = { { 3, 5, 2 }, { 37, 4, 300 }, { 513, 1, 65 }, { 6, 90, 70 }, { 45, 33, 11 }, { 131, 70, 520 } };
+    const CPUGemmPolicy policy = GetCPUGemmPolicy();
+    for (const auto& shape : shapes)
+    {
+        const size_t m = shape[0], n = shape[1], k = shape[2];
+        for (int transA = 0; transA < 2; transA++)
+        {
+            for (int transB = 0; transB < 2; transB++)
+            {
+                auto a = transA ? DMatrix::RandomUniform(k, m, -1, 1, IncrementCounter()) : DMatrix::RandomUniform(m, k, -1, 1, IncrementCounter());
+                auto b = transB ? DMatrix::RandomUniform(n, k, -1, 1, IncrementCounter()) : DMatrix::RandomUniform(k, n, -1, 1, IncrementCounter());
+                auto c = DMatrix::RandomUniform(m, n, -1, 1, IncrementCounter());
+                for (double beta : { 0.0, 0.5 })
+                {
+                    DMatrix expected(c);
+                    SetCPUGemmPolicy(CPUGemmPolicy::Blas);
+                    DMatrix::MultiplyAndWeightedAdd(0.7, a, transA != 0, b, transB != 0, beta, expected);
+
+                    DMatrix actual(c);
+                    SetCPUGemmPolicy(CPUGemmPolicy::Native);
+                    DMatrix::MultiplyAndWeightedAdd(0.7, a, transA != 0, b, transB != 0, beta, actual);
+                    BOOST_CHECK(actual.IsEqualTo(expected, 1e-10));
+                }
+            }
+        }
+    }
+    SetCPUGemmPolicy(policy);
+
+    // a batch gives the same results as the products one by one
+    const int batchSize = 5;
+    const int m = 20, n = 12, k = 30;
+    std::vector<SMatrix> as, bs, cs, expected;
+    std::vector<const float*> aPtrs, bPtrs;
+    std::vector<float*> cPtrs;
+    for (int i = 0; i < batchSize; i++)
+    {
+        as.push_back(SMatrix::RandomUniform(k, m, -1, 1, IncrementCounter()));
+        bs.push_back(SMatrix::RandomUniform(k, n, -1, 1, IncrementCounter()));
+        cs.push_back(SMatrix::RandomUniform(m, n, -1, 1, IncrementCounter()));
+        expected.push_back(cs.back());
+        CPUGemm<float>::Gemm(true, false, m, n, k, 2.0f, as[i].Data(), k, bs[i].Data(), k, 1.0f, expected[i].Data(), m);
+    }
+    for (int i = 0; i < batchSize; i++)
+    {
+        aPtrs.push_back(as[i].Data());
+        bPtrs.push_back(bs[i].Data());
+        cPtrs.push_back(cs[i].Data());
+    }
+    CPUGemm<float>::GemmBatch(true, false, m, n, k, 2.0f, aPtrs.data(), k, bPtrs.data(), k, 1.0f, cPtrs.data(), m, batchSize);
+    for (int i = 0; i < batchSize; i++)
+        BOOST_CHECK(cs[i].IsEqualTo(expected[i], c_epsilonFloatE5));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
 } } }
@@ -59,6 +59,139 @@ BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixCopyColumnSliceToDense, RandomSeedFixture
     BOOST_CHECK(dm1.IsEqualTo(dm2, c_epsilonFloatE4));
 }
 
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixPrepareCSCFormatBuffers, RandomSeedFixture)
+{
+    const size_t m = 100;
+    const size_t n = 50;
+    std::vector<CPUSPARSE_INDEX_TYPE> colStarts(1, 0);
+    std::vector<CPUSPARSE_INDEX_TYPE> rowIndices;
+    std::vector<double> values;
+    for (size_t col = 0; col < n; col++)
+    {
+        for (size_t row = col % 3; row < m; row += 7)
+        {
+            rowIndices.push_back((CPUSPARSE_INDEX_TYPE) row);
+            values.push_back((double) (row * n + col));
+        }
+        colStarts.push_back((CPUSPARSE_INDEX_TYPE) rowIndices.size());
+    }
+    const size_t nz = values.size();
+
+    SparseMatrix sm0(MatrixFormat::matrixFormatSparseCSC);
+    sm0.SetMatrixFromCSCFormat(colStarts.data(), rowIndices.data(), values.data(), nz, m, n);
+
+    SparseMatrix sm1(MatrixFormat::matrixFormatSparseCSC);
+    CPUSPARSE_INDEX_TYPE* colStarts1;
+    CPUSPARSE_INDEX_TYPE* rowIndices1;
+    double* values1;
+    sm1.PrepareCSCFormatBuffers(nz, m, n, colStarts1, rowIndices1, values1);
+    memcpy(colStarts1, colStarts.data(), sizeof(CPUSPARSE_INDEX_TYPE) * (n + 1));
+    memcpy(rowIndices1, rowIndices.data(), sizeof(CPUSPARSE_INDEX_TYPE) * nz);
+    memcpy(values1, values.data(), sizeof(double) * nz);
+
+    BOOST_CHECK_EQUAL(nz, sm1.NzCount());
+    DenseMatrix dm0 = sm0.CopyColumnSliceToDense(0, n);
+    DenseMatrix dm1 = sm1.CopyColumnSliceToDense(0, n);
+    BOOST_CHECK(dm0.IsEqualTo(dm1, c_epsilonFloatE4));
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixDenseTimesSparseParallel, RandomSeedFixture)
+{
+    // large enough for the products to run in parallel, with an uneven number of nonzeros per column
+    const size_t m = 300;
+    const size_t k = 500;
+    const size_t n = 80;
+    std::vector<CPUSPARSE_INDEX_TYPE> colStarts(1, 0);
+    std::vector<CPUSPARSE_INDEX_TYPE> rowIndices;
+    std::vector<double> values;
+    for (size_t col = 0; col < n; col++)
+    {
+        for (size_t row = col % 5; row < k; row += (col % 4 == 0) ? 3 : 37)
+        {
+            rowIndices.push_back((CPUSPARSE_INDEX_TYPE) row);
+            values.push_back((double) (row + 1) / (col + 1));
+        }
+        colStarts.push_back((CPUSPARSE_INDEX_TYPE) rowIndices.size());
+    }
+    SparseMatrix sparse(MatrixFormat::matrixFormatSparseCSC);
+    sparse.SetMatrixFromCSCFormat(colStarts.data(), rowIndices.data(), values.data(), values.size(), k, n);
+    DenseMatrix dense = sparse.CopyColumnSliceToDense(0, n);
+
+    // dense x sparse
+    DenseMatrix a = DenseMatrix::RandomUniform(m, k, -1, 1, IncrementCounter());
+    DenseMatrix c0 = DenseMatrix::RandomUniform(m, n, -1, 1, IncrementCounter());
+    DenseMatrix c1(c0);
+    DenseMatrix::MultiplyAndWeightedAdd(0.5, a, false, dense, false, 2, c0);
+    SparseMatrix::MultiplyAndWeightedAdd(0.5, a, false, sparse, false, 2, c1);
+    BOOST_CHECK(c0.IsEqualTo(c1, c_epsilonFloatE4));
+
+    // dense x sparse^T
+    DenseMatrix b = DenseMatrix::RandomUniform(m, n, -1, 1, IncrementCounter());
+    DenseMatrix d0(m, k);
+    DenseMatrix d1(m, k);
+    DenseMatrix::MultiplyAndWeightedAdd(0.5, b, false, dense, true, 0, d0);
+    SparseMatrix::MultiplyAndWeightedAdd(0.5, b, false, sparse, true, 0, d1);
+    BOOST_CHECK(d0.IsEqualTo(d1, c_epsilonFloatE4));
+
+    // dense x sparse^T as a block-sparse gradient
+    SparseMatrix block(MatrixFormat::matrixFormatSparseBlockCol);
+    SparseMatrix::MultiplyAndAdd(0.5, b, false, sparse, true, block);
+    DenseMatrix d2(m, k);
+    d2.SetValue(0);
+    SparseMatrix::ScaleAndAdd(1, block, d2);
+    BOOST_CHECK(d0.IsEqualTo(d2, c_epsilonFloatE4));
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixSoftmaxAndCrossEntropy, RandomSeedFixture)
+{
+    // one-hot labels, with large offsets in some columns to exercise the log-sum-exp
+    const size_t m = 50;
+    const size_t n = 30;
+    std::vector<CPUSPARSE_INDEX_TYPE> colStarts(1, 0);
+    std::vector<CPUSPARSE_INDEX_TYPE> rowIndices;
+    std::vector<double> values;
+    for (size_t col = 0; col < n; col++)
+    {
+        rowIndices.push_back((CPUSPARSE_INDEX_TYPE) ((col * 7) % m));
+        values.push_back(1);
+        colStarts.push_back((CPUSPARSE_INDEX_TYPE) rowIndices.size());
+    }
+    SparseMatrix sparseLabels(MatrixFormat::matrixFormatSparseCSC);
+    sparseLabels.SetMatrixFromCSCFormat(colStarts.data(), rowIndices.data(), values.data(), values.size(), m, n);
+    DenseMatrix denseLabels = sparseLabels.CopyColumnSliceToDense(0, n);
+
+    DenseMatrix input = DenseMatrix::RandomUniform(m, n, -20, 20, IncrementCounter());
+    for (size_t col = 0; col < n; col += 3)
+        for (size_t row = 0; row < m; row++)
+            input(row, col) += 1000;
+
+    // reference: log(softmax) and the inner product with the labels
+    DenseMatrix logSoftmax(input);
+    logSoftmax.InplaceLogSoftmax(true);
+    double expectedCriterion = 0;
+    foreach_coord (i, j, input)
+        expectedCriterion -= denseLabels(i, j) * logSoftmax(i, j);
+    DenseMatrix expectedSoftmax(logSoftmax);
+    expectedSoftmax.InplaceExp();
+
+    DenseMatrix softmax0;
+    double criterion0 = DenseMatrix::SoftmaxAndCrossEntropy(denseLabels, input, softmax0);
+    BOOST_CHECK_CLOSE(expectedCriterion, criterion0, 1e-8);
+    BOOST_CHECK(softmax0.IsEqualTo(expectedSoftmax, c_epsilonFloatE4));
+
+    DenseMatrix softmax1;
+    double criterion1 = SparseMatrix::SoftmaxAndCrossEntropy(sparseLabels, input, softmax1);
+    BOOST_CHECK_CLOSE(expectedCriterion, criterion1, 1e-8);
+    BOOST_CHECK(softmax1.IsEqualTo(expectedSoftmax, c_epsilonFloatE4));
+
+    // gradient c += alpha * (softmax - labels)
+    DenseMatrix c0 = DenseMatrix::RandomUniform(m, n, -1, 1, IncrementCounter());
+    DenseMatrix c1(c0);
+    DenseMatrix::AddScaledDifference(0.5, softmax0, denseLabels, c0);
+    SparseMatrix::AddScaledDifference(0.5, softmax0, sparseLabels, c1);
+    BOOST_CHECK(c0.IsEqualTo(c1, c_epsilonFloatE4));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
 } } }
@@ -12,6 +12,7 @@
 #include "../../../Source/Math/GPUMatrix.h"
 #include "../../../Source/Math/ConvolutionEngine.h"
 #include "../../../Source/Math/CuDnnFactories.h"
+#include "../../../Source/Math/CPUConvolution.h"
 #include "common.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
@@ -121,6 +122,51 @@ std::vector<ConvolveGeometryPtr> GenerateConvTestConfigs()
     return res;
 }
 
+// 2D convolutions supported by the Direct engine, with enough channels for the blocked and Winograd paths.
+std::vector<ConvolveGeometryPtr> GenerateDirectConvTestConfigs()
+{
+    std::vector<ConvolveGeometryPtr> res;
+    // 3x3 with stride 1, padded and not padded, with channel counts that are and are not multiples of the block size.
+    for (size_t inC : {3, 8, 13})
+    {
+        for (size_t mapCount : {5, 16})
+        {
+            for (bool pad : {false, true})
+            {
+                res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(19, 17, inC),
+                    TensorShape(3, 3, inC), TensorShape(mapCount), TensorShape(1, 1, inC),
+                    ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{pad, pad, false},
+                    TensorShape(0), TensorShape(0)));
+            }
+        }
+    }
+    // Small images with less than one Winograd tile in a dimension.
+    res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(4, 3, 8),
+        TensorShape(3, 3, 8), TensorShape(8), TensorShape(1, 1, 8),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{true, true, false},
+        TensorShape(0), TensorShape(0)));
+    // Explicit padding on one side only.
+    res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(10, 9, 8),
+        TensorShape(3, 3, 8), TensorShape(12), TensorShape(1, 1, 8),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{false},
+        TensorShape(1, 1, 0), TensorShape(0, 0, 0)));
+    // Strided convolutions with larger kernels (the first layers of image classification networks).
+    res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(23, 21, 3),
+        TensorShape(7, 7, 3), TensorShape(16), TensorShape(2, 2, 3),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{true, true, false},
+        TensorShape(0), TensorShape(0)));
+    res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(15, 16, 10),
+        TensorShape(5, 3, 10), TensorShape(9), TensorShape(2, 1, 10),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{false, true, false},
+        TensorShape(0), TensorShape(0)));
+    // 1x1 convolution with stride 2.
+    res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(16, 16, 24),
+        TensorShape(1, 1, 24), TensorShape(8), TensorShape(2, 2, 24),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{false},
+        TensorShape(0), TensorShape(0)));
+    return res;
+}
+
 std::vector<ConvolveGeometryPtr> GeneratePoolTestConfigs()
 {
     std::vector<ConvolveGeometryPtr> res;
@@ -230,6 +276,104 @@ BOOST_AUTO_TEST_CASE(ConvolutionForward)
     }
 }
 
+BOOST_AUTO_TEST_CASE(DirectConvolutionForward)
+{
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<> batchSizeG(1, 3);
+    std::normal_distribution<float> nd;
+
+    int deviceId = -1;
+    for (auto algorithm : {CPUConvolutionAlgorithm::Direct, CPUConvolutionAlgorithm::Winograd2x2, CPUConvolutionAlgorithm::Winograd4x4, CPUConvolutionAlgorithm::Auto})
+    {
+        SetCPUConvolutionAlgorithm(algorithm);
+        for (const auto& g : GenerateDirectConvTestConfigs())
+        {
+            auto baseEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Reference);
+            auto testEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Direct);
+
+            size_t n = batchSizeG(rng);
+            vec buf;
+            buf.resize(g->InputShape().GetNumElements() * n);
+            std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+            SingleMatrix in(g->InputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+
+            size_t mapCount = g->GetMapCount(g->InputShape().GetRank() - 1);
+            buf.resize(g->KernelShape().GetNumElements() * mapCount);
+            std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+            SingleMatrix kernel(mapCount, g->KernelShape().GetNumElements(), buf.data(), deviceId, matrixFlagNormal);
+
+            buf.resize(mapCount);
+            std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+            SingleMatrix bias(mapCount, 1, buf.data(), deviceId, matrixFlagNormal);
+
+            size_t crowOut = g->OutputShape().GetNumElements();
+            SingleMatrix out(crowOut, n, deviceId);
+            SingleMatrix outB(crowOut, n, deviceId);
+            SingleMatrix outBias(crowOut, n, deviceId);
+            SingleMatrix outBiasB(crowOut, n, deviceId);
+            SingleMatrix workspace(deviceId);
+
+            testEng->Forward(in, kernel, out, workspace);
+            baseEng->Forward(in, kernel, outB, workspace);
+            testEng->ForwardWithBias(in, kernel, bias, true, outBias, workspace);
+            baseEng->ForwardWithBias(in, kernel, bias, true, outBiasB, workspace);
+
+            // Bias and ReLU applied by hand to the output of the reference engine.
+            SingleMatrix expectedBias(outB.DeepClone(), deviceId);
+            size_t mapSize = crowOut / mapCount;
+            foreach_coord (i, j, expectedBias)
+            {
+                expectedBias(i, j) = std::max(expectedBias(i, j) + bias(i / mapSize, 0), 0.0f);
+            }
+
+            std::stringstream tmsg;
+            tmsg << "Geometry: " << (std::string)(*g) << ", Batch: " << n << ", Algorithm: " << (int)algorithm;
+            std::string msg = " are not equal, " + tmsg.str();
+
+            // Winograd transforms lose some precision, mostly for outputs close to 0.
+            bool winograd = algorithm == CPUConvolutionAlgorithm::Winograd2x2 || algorithm == CPUConvolutionAlgorithm::Winograd4x4;
+            float relErr = winograd ? 1e-3f : 1e-4f;
+            float absErr = winograd ? 1e-3f : 1e-4f;
+            std::string emsg;
+
+            BOOST_REQUIRE_MESSAGE(CheckEqual(out, outB, emsg, relErr, absErr), "out" << msg << ". " << emsg);
+            BOOST_REQUIRE_MESSAGE(CheckEqual(outBiasB, expectedBias, emsg, Err<float>::Rel, Err<float>::Abs * 8), "outBiasB" << msg << ". " << emsg);
+            BOOST_REQUIRE_MESSAGE(CheckEqual(outBias, expectedBias, emsg, relErr, absErr), "outBias" << msg << ". " << emsg);
+        }
+    }
+    SetCPUConvolutionAlgorithm(CPUConvolutionAlgorithm::Auto);
+}
+
+BOOST_AUTO_TEST_CASE(DirectConvolutionSelection)
+{
+    auto shape = [](int size, int channels, int kernel, int stride)
+    {
+        CPUConvolution2DShape s;
+        s.m_inW = s.m_inH = size;
+        s.m_inC = s.m_outC = channels;
+        s.m_kernelW = s.m_kernelH = kernel;
+        s.m_strideW = s.m_strideH = stride;
+        s.m_outW = s.m_outH = (size - 1) / stride + 1;
+        s.m_firstW = s.m_firstH = -(kernel - 1) / 2;
+        return s;
+    };
+    auto large = shape(56, 64, 3, 1);
+    auto small = shape(7, 512, 3, 1);
+
+    // By default, the Direct engine is only picked for large outputs and never uses Winograd.
+    SetCPUConvolutionAlgorithm(CPUConvolutionAlgorithm::Auto);
+    BOOST_CHECK(CPUConvolution<float>::IsFasterThanGemm(large));
+    BOOST_CHECK(!CPUConvolution<float>::IsFasterThanGemm(small));
+    BOOST_CHECK(CPUConvolution<float>::ChooseAlgorithm(large) == CPUConvolutionAlgorithm::Direct);
+
+    // Setting an algorithm opts into the Direct engine for all geometries.
+    SetCPUConvolutionAlgorithm(CPUConvolutionAlgorithm::Winograd4x4);
+    BOOST_CHECK(CPUConvolution<float>::IsFasterThanGemm(small));
+    BOOST_CHECK(CPUConvolution<float>::ChooseAlgorithm(large) == CPUConvolutionAlgorithm::Winograd4x4);
+    BOOST_CHECK(CPUConvolution<float>::ChooseAlgorithm(shape(224, 3, 7, 2)) == CPUConvolutionAlgorithm::Direct);
+    SetCPUConvolutionAlgorithm(CPUConvolutionAlgorithm::Auto);
+}
+
 BOOST_AUTO_TEST_CASE(ConvolutionBackwardData)
 {
     std::mt19937 rng(0);
@@ -7,6 +7,7 @@
 #include <crtdefs.h>
 #include "../../../Source/Math/Matrix.h"
 #include "../../../Source/Math/CPUMatrix.h"
+#include "../../../Source/Math/TensorView.h"
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -307,6 +308,93 @@ BOOST_FIXTURE_TEST_CASE(MatrixInnerProductOfMatrices, RandomSeedFixture)
     BOOST_CHECK_EQUAL(217, ip);
 }
 
+BOOST_FIXTURE_TEST_CASE(MatrixBatchMultiplyAndWeightedAdd, RandomSeedFixture)
+{
+    const size_t batchSize = 6;
+    const size_t m = 5, n = 3, k = 7;
+
+    // strided: a holds batchSize m x k matrices, b batchSize (n x k)' matrices
+    SingleMatrix a = SingleMatrix::RandomUniform(m, k * batchSize, CPUDEVICE, -1, 1, IncrementCounter());
+    SingleMatrix b = SingleMatrix::RandomUniform(n, k * batchSize, CPUDEVICE, -1, 1, IncrementCounter());
+    SingleMatrix c = SingleMatrix::RandomUniform(m, n * batchSize, CPUDEVICE, -1, 1, IncrementCounter());
+    SingleMatrix expected(c.DeepClone());
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        SingleMatrix ci = expected.ColumnSlice(i * n, n);
+        SingleMatrix::MultiplyAndWeightedAdd(2.0f, a.ColumnSlice(i * k, k), false, b.ColumnSlice(i * k, k), true, 0.5f, ci);
+    }
+    SingleMatrix::BatchMultiplyAndWeightedAdd(2.0f, a, false, b, true, 0.5f, c, batchSize);
+    BOOST_CHECK(c.IsEqualTo(expected, c_epsilonFloatE5));
+
+    // offsets: the same a for all products, the results in reverse order
+    std::vector<size_t> offsetsA(batchSize, 0), offsetsB(batchSize), offsetsC(batchSize);
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        offsetsB[i] = i * n * k;
+        offsetsC[i] = (batchSize - 1 - i) * m * n;
+    }
+    SingleMatrix::BatchMultiplyAndWeightedAdd(1.0f, a, false, offsetsA, b, true, offsetsB, 0.0f, c, offsetsC, m, n, k);
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        SingleMatrix ci(CPUDEVICE);
+        SingleMatrix::Multiply(a.ColumnSlice(0, k), false, b.ColumnSlice(i * k, k), true, ci);
+        BOOST_CHECK(c.ColumnSlice((batchSize - 1 - i) * n, n).IsEqualTo(ci, c_epsilonFloatE5));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(TensorViewBatchMatrixProduct, RandomSeedFixture)
+{
+    const size_t batchSize = 4;
+    const size_t m = 5, n = 3, k = 7;
+    auto a = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(m, k * batchSize, CPUDEVICE, -1, 1, IncrementCounter()));
+    auto b = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(k, n * batchSize, CPUDEVICE, -1, 1, IncrementCounter()));
+    auto c = make_shared<SingleMatrix>(m, n * batchSize, CPUDEVICE);
+    auto cShared = make_shared<SingleMatrix>(m, n * batchSize, CPUDEVICE);
+    TensorView<float> cView(c, TensorShape(m, n, batchSize)), cSharedView(cShared, TensorShape(m, n, batchSize));
+
+    // [m x k x batch] * [k x n x batch], and [m x k] * [k x n x batch] with the first matrix of a for all products
+    cView.AssignBatchMatrixProductOf(TensorView<float>(a, TensorShape(m, k, batchSize)), false, TensorView<float>(b, TensorShape(k, n, batchSize)), false);
+    cSharedView.AssignBatchMatrixProductOf(TensorView<float>(a, TensorShape(m, k)), false, TensorView<float>(b, TensorShape(k, n, batchSize)), false);
+
+    for (size_t i = 0; i < batchSize; i++)
+    {
+        SingleMatrix expected(CPUDEVICE);
+        SingleMatrix::Multiply(a->ColumnSlice(i * k, k), false, b->ColumnSlice(i * n, n), false, expected);
+        BOOST_CHECK(c->ColumnSlice(i * n, n).IsEqualTo(expected, c_epsilonFloatE5));
+        SingleMatrix::Multiply(a->ColumnSlice(0, k), false, b->ColumnSlice(i * n, n), false, expected);
+        BOOST_CHECK(cShared->ColumnSlice(i * n, n).IsEqualTo(expected, c_epsilonFloatE5));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(TensorViewMatrixProductWithGaps, RandomSeedFixture)
+{
+    // W * x for the frames of one of numSequences parallel sequences: x is [k x 1 x numFrames] with a gap between the frames,
+    // which cannot be flattened into a single matrix
+    const size_t m = 5, k = 7, numSequences = 3, numFrames = 4, sequence = 1;
+    auto w = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(m, k, CPUDEVICE, -1, 1, IncrementCounter()));
+    auto x = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(k, numSequences * numFrames, CPUDEVICE, -1, 1, IncrementCounter()));
+    auto y = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(m, numSequences * numFrames, CPUDEVICE, -1, 1, IncrementCounter()));
+    SingleMatrix yBefore(y->DeepClone());
+
+    TensorShape xShape(k, numSequences, numFrames), yShape(m, numSequences, numFrames);
+    xShape.NarrowTo(1, sequence, sequence + 1);
+    yShape.NarrowTo(1, sequence, sequence + 1);
+    TensorView<float> yView(y, yShape);
+    yView.AddMatrixProductOf(false, TensorView<float>(w, TensorShape(m, k)), false, TensorView<float>(x, xShape), false);
+
+    for (size_t t = 0; t < numFrames; t++)
+    {
+        for (size_t s = 0; s < numSequences; s++)
+        {
+            size_t col = t * numSequences + s;
+            SingleMatrix expected(yBefore.ColumnSlice(col, 1).DeepClone());
+            if (s == sequence) // the other sequences are not touched
+                SingleMatrix::MultiplyAndAdd(*w, false, x->ColumnSlice(col, 1), false, expected);
+            BOOST_CHECK(y->ColumnSlice(col, 1).IsEqualTo(expected, c_epsilonFloatE5));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
 } } }
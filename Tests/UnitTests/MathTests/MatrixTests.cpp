@@ -5,7 +5,10 @@
 #include "stdafx.h"
 #include "../../../Source/Math/Matrix.h"
 #include "../../../Source/Math/CPUMatrix.h"
+#include "../../../Source/Math/CPUFastMath.h"
 #include "../../../Source/Math/Helpers.h"
+#include "../../../Source/Math/TensorView.h"
+#include <thread>
 
 #define IDX2C(i, j, ld) (((j) * (ld)) + (i)) // 0 based indexing
 
@@ -686,6 +689,172 @@ BOOST_FIXTURE_TEST_CASE(MatrixElementOps, RandomSeedFixture)
     BOOST_CHECK(m3.IsEqualTo(m2, c_epsilonFloatE3));
 }
 
+BOOST_FIXTURE_TEST_CASE(MatrixFusedElementwiseTensorOps, RandomSeedFixture)
+{
+    // the ops of FusedElementwiseNode must match the chains of ops they replace
+    const size_t rows = 37, cols = 11;
+    const TensorShape shape(rows, cols);
+    auto a = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(rows, cols, c_deviceIdZero, -3.0f, 3.0f, IncrementCounter()));
+    auto b = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(rows, cols, c_deviceIdZero, -3.0f, 3.0f, IncrementCounter()));
+    auto c = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(rows, cols, c_deviceIdZero, -3.0f, 3.0f, IncrementCounter()));
+    auto fused = make_shared<SingleMatrix>(rows, cols, c_deviceIdZero);
+    auto expected = make_shared<SingleMatrix>(rows, cols, c_deviceIdZero);
+    TensorView<float> aView(a, shape), bView(b, shape), cView(c, shape), fusedView(fused, shape), expectedView(expected, shape);
+
+    expectedView.AssignSumOf(aView, bView);
+    expectedView.AssignSigmoidOf(expectedView);
+    fusedView.AssignSigmoidOfSumOf(aView, bView);
+    BOOST_CHECK(fused->IsEqualTo(*expected, c_epsilonFloatE5));
+
+    // derivative with respect to a or b, with a as the incoming gradient
+    expectedView.AssignElementwiseProductWithSigmoidDerivativeFromOutputOf(cView, expectedView);
+    fusedView.AssignElementwiseProductWithSigmoidDerivativeOfSumOf(cView, aView, bView);
+    BOOST_CHECK(fused->IsEqualTo(*expected, c_epsilonFloatE5));
+
+    expectedView.AssignSumOf(aView, bView);
+    expectedView.AssignSigmoidOf(expectedView);
+    expectedView.AssignElementwiseProductOf(expectedView, cView);
+    fusedView.AssignSigmoidOfSumTimesOf(aView, bView, cView);
+    BOOST_CHECK(fused->IsEqualTo(*expected, c_epsilonFloatE5));
+
+    expectedView.AssignSumOf(aView, bView);
+    expectedView.AssignTanhOf(expectedView);
+    fusedView.AssignTanhOfSumOf(aView, bView);
+    BOOST_CHECK(fused->IsEqualTo(*expected, c_epsilonFloatE5));
+
+    expectedView.AssignElementwiseProductWithTanhDerivativeFromOutputOf(cView, expectedView);
+    fusedView.AssignElementwiseProductWithTanhDerivativeOfSumOf(cView, aView, bView);
+    BOOST_CHECK(fused->IsEqualTo(*expected, c_epsilonFloatE5));
+
+    expectedView.AssignSumOf(aView, bView);
+    expectedView.AssignTanhOf(expectedView);
+    expectedView.AssignElementwiseProductOf(expectedView, cView);
+    fusedView.AssignTanhOfSumTimesOf(aView, bView, cView);
+    BOOST_CHECK(fused->IsEqualTo(*expected, c_epsilonFloatE5));
+
+    expectedView.AssignSumOf(aView, bView);
+    expectedView.AssignLinearRectifierOf(expectedView);
+    fusedView.AssignLinearRectifierOfSumOf(aView, bView);
+    BOOST_CHECK(fused->IsEqualTo(*expected, c_epsilonFloatE5));
+}
+
+// a and b differ by at most one unit in the last place in every element
+static bool IsEqualWithinOneUlp(const SingleMatrix& a, const SingleMatrix& b)
+{
+    if (a.GetNumElements() != b.GetNumElements())
+        return false;
+    unique_ptr<float[]> aValues(a.CopyToArray());
+    unique_ptr<float[]> bValues(b.CopyToArray());
+    for (size_t i = 0; i < a.GetNumElements(); i++)
+    {
+        if (fabs(aValues[i] - bValues[i]) > 1.2e-7f * max(fabs(aValues[i]), fabs(bValues[i])))
+            return false;
+    }
+    return true;
+}
+
+BOOST_FIXTURE_TEST_CASE(MatrixFastMathFunctions, RandomSeedFixture)
+{
+    // the fast functions of the CPU tensor ops must stay within the errors documented in TensorOps.h
+    const size_t rows = 67, cols = 23; // not a multiple of 4, to also cover the elements after the SSE loop
+    const TensorShape shape(rows, cols);
+    auto a = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(rows, cols, CPUDEVICE, -10.0f, 10.0f, IncrementCounter()));
+    auto positive = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(rows, cols, CPUDEVICE, 0.001f, 10.0f, IncrementCounter()));
+    auto zero = make_shared<SingleMatrix>(rows, cols, CPUDEVICE);
+    zero->SetValue(0);
+    auto exact = make_shared<SingleMatrix>(rows, cols, CPUDEVICE);
+    auto fast = make_shared<SingleMatrix>(rows, cols, CPUDEVICE);
+    auto fastOfSum = make_shared<SingleMatrix>(rows, cols, CPUDEVICE);
+    TensorView<float> aView(a, shape), positiveView(positive, shape), zeroView(zero, shape);
+    TensorView<float> exactView(exact, shape), fastView(fast, shape), fastOfSumView(fastOfSum, shape);
+
+    SetCPUMathFunctions(CPUMathFunctions::Exact);
+    exactView.AssignSigmoidOf(aView);
+    SetCPUMathFunctions(CPUMathFunctions::Fast);
+    fastView.AssignSigmoidOf(aView);
+    BOOST_CHECK(fast->IsEqualTo(*exact, c_epsilonFloatE5));
+    // the fused op goes through the scalar version, which computes the same sequence of operations as the SSE
+    // version; allow for one ulp, since the compiler may contract or reorder them (Math is built with /fp:fast)
+    fastOfSumView.AssignSigmoidOfSumOf(aView, zeroView);
+    BOOST_CHECK(IsEqualWithinOneUlp(*fastOfSum, *fast));
+
+    SetCPUMathFunctions(CPUMathFunctions::Exact);
+    exactView.AssignTanhOf(aView);
+    SetCPUMathFunctions(CPUMathFunctions::Fast);
+    fastView.AssignTanhOf(aView);
+    BOOST_CHECK(fast->IsEqualTo(*exact, c_epsilonFloatE5));
+    fastOfSumView.AssignTanhOfSumOf(aView, zeroView);
+    BOOST_CHECK(IsEqualWithinOneUlp(*fastOfSum, *fast));
+
+    SetCPUMathFunctions(CPUMathFunctions::Exact);
+    exactView.AssignExpOf(aView);
+    SetCPUMathFunctions(CPUMathFunctions::Fast);
+    fastView.AssignExpOf(aView);
+    BOOST_CHECK(fast->IsEqualTo(*exact, c_epsilonFloatE2)); // e^10 = 22026 with a relative error of 1e-7
+
+    SetCPUMathFunctions(CPUMathFunctions::Exact);
+    exactView.AssignLogOf(positiveView);
+    SetCPUMathFunctions(CPUMathFunctions::Fast);
+    fastView.AssignLogOf(positiveView);
+    BOOST_CHECK(fast->IsEqualTo(*exact, c_epsilonFloatE5));
+
+    SetCPUMathFunctions(CPUMathFunctions::Exact);
+    exactView.AssignLogSumOf(aView, positiveView);
+    SetCPUMathFunctions(CPUMathFunctions::Fast);
+    fastView.AssignLogSumOf(aView, positiveView);
+    BOOST_CHECK(fast->IsEqualTo(*exact, c_epsilonFloatE5));
+
+    // log(+inf) and log(NaN) are returned unchanged, by the SSE (first 4 elements) as well as the scalar version
+    auto special = make_shared<SingleMatrix>(1, 5, CPUDEVICE);
+    float specialValues[] = { numeric_limits<float>::infinity(), numeric_limits<float>::quiet_NaN(), 1.0f, numeric_limits<float>::infinity(), numeric_limits<float>::quiet_NaN() };
+    special->SetValue(1, 5, CPUDEVICE, specialValues);
+    TensorView<float> specialView(special, TensorShape(5));
+    specialView.AssignLogOf(specialView);
+    unique_ptr<float[]> logOfSpecial(special->CopyToArray());
+    BOOST_CHECK(logOfSpecial[0] == numeric_limits<float>::infinity() && logOfSpecial[3] == numeric_limits<float>::infinity());
+    BOOST_CHECK(std::isnan(logOfSpecial[1]) && std::isnan(logOfSpecial[4]));
+    BOOST_CHECK_EQUAL(logOfSpecial[2], 0.0f);
+
+    SetCPUMathFunctions(CPUMathFunctions::Exact);
+}
+
+BOOST_FIXTURE_TEST_CASE(MatrixTensorReductions, RandomSeedFixture)
+{
+    // sums over the columns, like the gradient of a bias, for the shapes the CPU implementation handles differently:
+    // blocks of outputs, long reductions split into chunks, and the reduction to a scalar
+    const int maxNumThreads = (int) std::thread::hardware_concurrency();
+    for (const auto& dims : vector<pair<size_t, size_t>>{ {300, 57}, {3, 40000}, {1, 100000}, {64, 1} })
+    {
+        const size_t rows = dims.first, cols = dims.second;
+        auto input = make_shared<SingleMatrix>(SingleMatrix::RandomUniform(rows, cols, CPUDEVICE, -1.0f, 1.0f, IncrementCounter()));
+        unique_ptr<float[]> inputValues(input->CopyToArray());
+
+        // the partial sums only depend on the dimensions, so the result must be the same for any number of threads
+        unique_ptr<float[]> resultValuesOneThread;
+        for (int numThreads : { 1, max(maxNumThreads, 2) })
+        {
+            CPUMatrix<float>::SetNumThreads(numThreads);
+            auto result = make_shared<SingleMatrix>(SingleMatrix::Ones(rows, 1, CPUDEVICE));
+            TensorView<float> inputView(input, TensorShape(rows, cols)), resultView(result, TensorShape(rows, 1));
+            resultView.DoUnaryOpOf(0.5f, inputView, 2.0f, opCopy, opSum); // result = 0.5 * result + 2 * sum(input)
+
+            unique_ptr<float[]> resultValues(result->CopyToArray());
+            for (size_t i = 0; i < rows; i++)
+            {
+                double sum = 0;
+                for (size_t j = 0; j < cols; j++)
+                    sum += inputValues[j * rows + i];
+                BOOST_CHECK_SMALL(resultValues[i] - (0.5 + 2 * sum), 1e-4 * (1 + fabs(sum)));
+            }
+            if (!resultValuesOneThread)
+                resultValuesOneThread = move(resultValues);
+            else
+                BOOST_CHECK(memcmp(resultValues.get(), resultValuesOneThread.get(), rows * sizeof(float)) == 0);
+        }
+    }
+    CPUMatrix<float>::SetNumThreads(maxNumThreads);
+}
+
 BOOST_FIXTURE_TEST_CASE(MatrixColumnElementMultiply, RandomSeedFixture)
 {
     CPUMatrix<float> mcpu = CPUMatrix<float>::RandomUniform(429, 1024, -3.4f, 1, IncrementCounter());
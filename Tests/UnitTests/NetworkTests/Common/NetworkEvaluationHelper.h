@@ -0,0 +1,109 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Helpers for tests that build small networks in C++ and run them on random data.
+//
+#pragma once
+
+#include "ComputationNetwork.h"
+#include "ComputationNetworkBuilder.h"
+#include "InputAndParamNodes.h"
+#include <boost/test/unit_test.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// The random values of a node only depend on its name, so that two networks that are built the same way get the same
+// parameters and inputs.
+inline unsigned long NodeSeed(const ComputationNodeBasePtr& node)
+{
+    return (unsigned long) (std::hash<wstring>()(node->NodeName()) % 1000000);
+}
+
+template <class ElemType>
+vector<ElemType> GetMatrixValues(const Matrix<ElemType>& matrix)
+{
+    unique_ptr<ElemType[]> data(matrix.CopyToArray());
+    return vector<ElemType>(data.get(), data.get() + matrix.GetNumElements());
+}
+
+// Set all parameters of the network to uniform random values in [low, high].
+template <class ElemType>
+void InitParametersRandomly(ComputationNetwork& net, ElemType low = -1, ElemType high = 1)
+{
+    for (const auto& node : net.GetNodesWithType(OperationNameOf(LearnableParameter)))
+        dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value().SetUniformRandomValue(low, high, NodeSeed(node));
+}
+
+// Set all feature nodes to a minibatch of one sequence of numSamples random samples.
+template <class ElemType>
+void SetRandomInputs(ComputationNetwork& net, size_t numSamples)
+{
+    for (const auto& node : net.FeatureNodes())
+    {
+        Matrix<ElemType>& value = dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value();
+        value.Resize(node->GetSampleLayout().GetNumElements(), numSamples);
+        value.SetUniformRandomValue(-1, 1, NodeSeed(node));
+        node->GetMBLayout()->Init(1, numSamples);
+        node->GetMBLayout()->AddSequence(0, 0, 0, numSamples);
+    }
+    ComputationNetwork::BumpEvalTimeStamp(net.FeatureNodes());
+}
+
+// Evaluate the named nodes in inference mode on random inputs and return their values.
+template <class ElemType>
+vector<vector<ElemType>> EvaluateNodes(const ComputationNetworkPtr& net, const vector<wstring>& nodeNames, size_t numSamples)
+{
+    ScopedNetworkOperationMode modeGuard(net, NetworkOperationMode::inferring);
+    auto nodes = net->OutputNodesByName(nodeNames);
+    net->AllocateAllMatrices({}, nodes, nullptr);
+    net->StartEvaluateMinibatchLoop(nodes);
+    SetRandomInputs<ElemType>(*net, numSamples);
+    net->ForwardProp(nodes);
+
+    vector<vector<ElemType>> values;
+    for (const auto& node : nodes)
+        values.push_back(GetMatrixValues(dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value()));
+    return values;
+}
+
+// Run forward and backward propagation of the first criterion node on random inputs and return the gradients of the
+// named parameters.
+template <class ElemType>
+vector<vector<ElemType>> ComputeGradients(const ComputationNetworkPtr& net, const vector<wstring>& parameterNames, size_t numSamples)
+{
+    ScopedNetworkOperationMode modeGuard(net, NetworkOperationMode::training);
+    auto criterion = net->FinalCriterionNodes().front();
+    net->AllocateAllMatrices({}, {}, criterion);
+    net->StartEvaluateMinibatchLoop(criterion);
+    SetRandomInputs<ElemType>(*net, numSamples);
+    net->ForwardProp(criterion);
+    net->Backprop(criterion);
+
+    vector<vector<ElemType>> gradients;
+    for (const auto& name : parameterNames)
+        gradients.push_back(GetMatrixValues(dynamic_pointer_cast<ComputationNode<ElemType>>(net->GetNodeFromName(name))->Gradient()));
+    return gradients;
+}
+
+// Check that two lists of values agree up to a relative tolerance.
+template <class ElemType>
+void CheckValuesClose(const vector<vector<ElemType>>& expected, const vector<vector<ElemType>>& actual, double tolerance)
+{
+    BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        BOOST_REQUIRE_EQUAL(expected[i].size(), actual[i].size());
+        for (size_t j = 0; j < expected[i].size(); j++)
+            BOOST_CHECK_SMALL((double) actual[i][j] - expected[i][j], tolerance * (1 + fabs((double) expected[i][j])));
+    }
+}
+
+}}}}
@@ -0,0 +1,135 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests for ComputationNetwork::FuseElementwiseNodes() and FusedElementwiseNode
+//
+#include "stdafx.h"
+#include "Common/NetworkEvaluationHelper.h"
+#include "LinearAlgebraNodes.h"
+#include "NonlinearityNodes.h"
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+static const size_t c_inputDim = 5;
+static const size_t c_outputDim = 3;
+static const size_t c_numSamples = 7;
+
+// A gate of an LSTM cell, h = f(a + b) .* c with a = Wa * x, and the criterion sum(h .* h).
+// Without broadcasting, b = Wb * x and c = Wc * x. With broadcasting, b is a bias and c a parameter, both of shape [outputDim].
+static ComputationNetworkPtr BuildGateNetwork(const wstring& nonlinearity, bool broadcast, bool fuse)
+{
+    auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+    ComputationNetworkBuilder<float> builder(*net);
+
+    auto x = builder.CreateInputNode(L"x", c_inputDim);
+    auto a = builder.Times(builder.CreateLearnableParameter(L"Wa", c_outputDim, c_inputDim), x, 1, L"a");
+    shared_ptr<ComputationNode<float>> b, c;
+    if (broadcast)
+    {
+        b = builder.CreateLearnableParameter(L"b", TensorShape(c_outputDim));
+        c = builder.CreateLearnableParameter(L"c", TensorShape(c_outputDim));
+    }
+    else
+    {
+        b = builder.Times(builder.CreateLearnableParameter(L"Wb", c_outputDim, c_inputDim), x, 1, L"b");
+        c = builder.Times(builder.CreateLearnableParameter(L"Wc", c_outputDim, c_inputDim), x, 1, L"c");
+    }
+    auto sum = builder.Plus(a, b, L"sum");
+    auto gate = nonlinearity == L"Tanh" ? builder.Tanh(sum, L"gate") : builder.Sigmoid(sum, L"gate");
+    auto h = builder.ElementTimes(gate, c, L"h");
+    auto criterion = builder.Sum(builder.ElementTimes(h, h, L"hSquared"), L"criterion");
+
+    net->AddToNodeGroup(L"feature", x);
+    net->AddToNodeGroup(L"output", h);
+    net->AddToNodeGroup(L"criterion", criterion);
+    InitParametersRandomly<float>(*net);
+
+    if (fuse)
+        BOOST_CHECK_EQUAL(net->FuseElementwiseNodes(), (size_t) 1);
+    net->CompileNetwork();
+    return net;
+}
+
+static vector<wstring> GateParameterNames(bool broadcast)
+{
+    return broadcast ? vector<wstring>{ L"Wa", L"b", L"c" } : vector<wstring>{ L"Wa", L"Wb", L"Wc" };
+}
+
+BOOST_AUTO_TEST_SUITE(ElementwiseFusionSuite)
+
+BOOST_AUTO_TEST_CASE(FuseSigmoidGate)
+{
+    auto net = BuildGateNetwork(L"Sigmoid", false /*broadcast*/, true /*fuse*/);
+
+    // the chain is replaced by one node that keeps the name and the node group of the last node
+    auto h = net->GetNodeFromName(L"h");
+    BOOST_CHECK(h->OperationName() == OperationNameOf(FusedElementwiseNode));
+    BOOST_CHECK(!net->NodeNameExists(L"sum"));
+    BOOST_CHECK(!net->NodeNameExists(L"gate"));
+    BOOST_REQUIRE_EQUAL(net->OutputNodes().size(), (size_t) 1);
+    BOOST_CHECK(net->OutputNodes()[0] == h);
+    BOOST_CHECK(net->GetNodeFromName(L"hSquared")->GetInputs()[0] == h);
+
+    // its inputs are a, b and c, which keep their names
+    BOOST_REQUIRE_EQUAL(h->GetNumInputs(), (size_t) 3);
+    BOOST_CHECK(h->GetInputs()[0]->NodeName() == L"a");
+    BOOST_CHECK(h->GetInputs()[1]->NodeName() == L"b");
+    BOOST_CHECK(h->GetInputs()[2]->NodeName() == L"c");
+}
+
+BOOST_AUTO_TEST_CASE(FuseOnlyUnsharedChains)
+{
+    auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+    ComputationNetworkBuilder<float> builder(*net);
+    auto x = builder.CreateInputNode(L"x", c_inputDim);
+    auto a = builder.Times(builder.CreateLearnableParameter(L"Wa", c_outputDim, c_inputDim), x, 1, L"a");
+    auto sum = builder.Plus(a, builder.CreateLearnableParameter(L"b", TensorShape(c_outputDim)), L"sum");
+    auto gate = builder.Sigmoid(sum, L"gate");
+    auto h = builder.ElementTimes(gate, builder.CreateLearnableParameter(L"c", TensorShape(c_outputDim)), L"h");
+    net->AddToNodeGroup(L"feature", x);
+    net->AddToNodeGroup(L"output", h);
+    net->AddToNodeGroup(L"output", gate); // the gate is requested as an output, so it must not disappear
+
+    BOOST_CHECK_EQUAL(net->FuseElementwiseNodes(), (size_t) 1); // only Plus -> Sigmoid is fused
+    BOOST_CHECK(net->GetNodeFromName(L"gate")->OperationName() == OperationNameOf(FusedElementwiseNode));
+    BOOST_CHECK(net->GetNodeFromName(L"h")->OperationName() == OperationNameOf(ElementTimesNode));
+    BOOST_CHECK(!net->NodeNameExists(L"sum"));
+}
+
+BOOST_AUTO_TEST_CASE(FusedGateMatchesUnfusedChain)
+{
+    for (const wstring& nonlinearity : { L"Sigmoid", L"Tanh" })
+    {
+        for (bool broadcast : { false, true })
+        {
+            auto reference = BuildGateNetwork(nonlinearity, broadcast, false /*fuse*/);
+            auto fused = BuildGateNetwork(nonlinearity, broadcast, true /*fuse*/);
+
+            CheckValuesClose(EvaluateNodes<float>(reference, { L"h" }, c_numSamples), EvaluateNodes<float>(fused, { L"h" }, c_numSamples), 1e-5);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FusedGateGradientsMatchUnfusedChain)
+{
+    // the gradients for a, b and c reach Wa, b/Wb and c/Wc; with broadcasting, b and c must be reduced over the minibatch
+    for (const wstring& nonlinearity : { L"Sigmoid", L"Tanh" })
+    {
+        for (bool broadcast : { false, true })
+        {
+            auto reference = BuildGateNetwork(nonlinearity, broadcast, false /*fuse*/);
+            auto fused = BuildGateNetwork(nonlinearity, broadcast, true /*fuse*/);
+
+            auto referenceGradients = ComputeGradients<float>(reference, GateParameterNames(broadcast), c_numSamples);
+            auto fusedGradients = ComputeGradients<float>(fused, GateParameterNames(broadcast), c_numSamples);
+            CheckValuesClose(referenceGradients, fusedGradients, 1e-5);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
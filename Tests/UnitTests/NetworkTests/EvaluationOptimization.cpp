@@ -0,0 +1,223 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests for ComputationNetwork::OptimizeForEvaluation() and ComputationNetwork::ReplaceNode()
+//
+#include "stdafx.h"
+#include "Common/NetworkEvaluationHelper.h"
+#include "LinearAlgebraNodes.h"
+#include "NonlinearityNodes.h"
+#include "ConvolutionalNodes.h"
+#include "PreComputeNodes.h"
+#include "TrainingNodes.h"
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+typedef shared_ptr<ComputationNode<float>> NodePtr;
+typedef function<void(ComputationNetwork&, ComputationNetworkBuilder<float>&)> NetworkDefinition;
+
+static const size_t c_inputDim = 4;
+static const size_t c_outputDim = 3;
+static const size_t c_numSamples = 5;
+static const size_t c_mapCount = 4;
+
+// a parameter that holds statistics, which are not learned
+static NodePtr CreateStatistics(ComputationNetworkBuilder<float>& builder, const wstring& name, size_t rows)
+{
+    auto node = builder.CreateLearnableParameter(name, rows, 1);
+    node->SetLearningRateMultiplier(0);
+    return node;
+}
+
+// inverse standard deviations must be positive
+static void InitInvStdDevRandomly(const NodePtr& node)
+{
+    node->Value().SetUniformRandomValue(0.5f, 2.0f, NodeSeed(node));
+}
+
+// Build the network twice, optimize one of them, and check that the named nodes still exist and compute the same values.
+// Returns the optimized network.
+static ComputationNetworkPtr CheckOptimizedNetwork(const NetworkDefinition& definition, const vector<wstring>& nodeNames)
+{
+    ComputationNetworkPtr nets[2];
+    for (auto& net : nets)
+    {
+        net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<float> builder(*net);
+        definition(*net, builder);
+        net->CompileNetwork();
+    }
+    auto& reference = nets[0];
+    auto& optimized = nets[1];
+    optimized->OptimizeForEvaluation<float>();
+
+    for (const auto& name : nodeNames)
+        BOOST_CHECK_MESSAGE(optimized->NodeNameExists(name), "node name does not resolve after the optimization");
+    BOOST_CHECK_EQUAL(optimized->OutputNodes().size(), reference->OutputNodes().size());
+    BOOST_CHECK_LT(optimized->GetTotalNumberOfNodes(), reference->GetTotalNumberOfNodes());
+
+    CheckValuesClose(EvaluateNodes<float>(reference, nodeNames, c_numSamples), EvaluateNodes<float>(optimized, nodeNames, c_numSamples), 1e-4);
+    return optimized;
+}
+
+BOOST_AUTO_TEST_SUITE(EvaluationOptimizationSuite)
+
+BOOST_AUTO_TEST_CASE(FoldBatchNormalizationIntoTimes)
+{
+    auto optimized = CheckOptimizedNetwork([](ComputationNetwork& net, ComputationNetworkBuilder<float>& builder)
+    {
+        auto x = builder.CreateInputNode(L"x", c_inputDim);
+        auto z = builder.Plus(builder.Times(builder.CreateLearnableParameter(L"W", c_outputDim, c_inputDim), x, 1, L"Wx"),
+                              builder.CreateLearnableParameter(L"b", c_outputDim, 1), L"z");
+        auto runInvStdDev = CreateStatistics(builder, L"runInvStdDev", c_outputDim);
+        auto bn = builder.BatchNormalization(z, builder.CreateLearnableParameter(L"scale", c_outputDim, 1), builder.CreateLearnableParameter(L"shift", c_outputDim, 1),
+                                             CreateStatistics(builder, L"runMean", c_outputDim), runInvStdDev,
+                                             false /*spatial*/, 0, 0, 1e-5, true /*useCntkEngine*/, ImageLayoutKind::CHW, L"bn");
+        InitParametersRandomly<float>(net);
+        InitInvStdDevRandomly(runInvStdDev);
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", builder.Sigmoid(bn, L"out"));
+    }, { L"out", L"bn" });
+
+    BOOST_CHECK(optimized->GetNodesWithType(OperationNameOf(BatchNormalizationNode)).empty());
+    BOOST_CHECK(optimized->GetNodeFromName(L"bn")->OperationName() == OperationNameOf(PlusNode));
+}
+
+BOOST_AUTO_TEST_CASE(FoldBatchNormalizationIntoConvolution)
+{
+    auto optimized = CheckOptimizedNetwork([](ComputationNetwork& net, ComputationNetworkBuilder<float>& builder)
+    {
+        auto x = builder.CreateInputNode(L"x", TensorShape(5, 5, 2)); // W x H x C
+        auto conv = builder.Convolution(builder.CreateLearnableParameter(L"W", c_mapCount, 3 * 3 * 2), x, 3, 3, c_mapCount, 1, 1, ImageLayoutKind::CHW,
+                                        false /*zeroPadding*/, 0, L"conv");
+        auto runInvStdDev = CreateStatistics(builder, L"runInvStdDev", c_mapCount);
+        auto bn = builder.BatchNormalization(conv, builder.CreateLearnableParameter(L"scale", c_mapCount, 1), builder.CreateLearnableParameter(L"shift", c_mapCount, 1),
+                                             CreateStatistics(builder, L"runMean", c_mapCount), runInvStdDev,
+                                             true /*spatial*/, 0, 0, 1e-5, true /*useCntkEngine*/, ImageLayoutKind::CHW, L"bn");
+        InitParametersRandomly<float>(net);
+        InitInvStdDevRandomly(runInvStdDev);
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", bn); // keeps the ReLU out of the fused convolution
+        net.AddToNodeGroup(L"output", builder.RectifiedLinear(bn, L"out"));
+    }, { L"out", L"bn" });
+
+    // without a bias, the folded shift is added by a new Plus node, which is then fused with the convolution and takes over
+    // the name of the BatchNormalization node
+    BOOST_CHECK(optimized->GetNodesWithType(OperationNameOf(BatchNormalizationNode)).empty());
+    auto bn = optimized->GetNodeFromName(L"bn");
+    BOOST_REQUIRE(bn->OperationName() == OperationNameOf(FusedConvolutionNode));
+    BOOST_CHECK(!dynamic_pointer_cast<FusedConvolutionNode<float>>(bn)->HasReLU());
+    BOOST_CHECK(bn->GetInputs()[0]->NodeName() == L"W");
+    BOOST_CHECK(optimized->GetNodeFromName(L"out")->OperationName() == OperationNameOf(RectifiedLinearNode));
+}
+
+BOOST_AUTO_TEST_CASE(FuseConvolutionBiasAndReLU)
+{
+    for (bool zeroPadding : { false, true })
+    {
+        auto optimized = CheckOptimizedNetwork([zeroPadding](ComputationNetwork& net, ComputationNetworkBuilder<float>& builder)
+        {
+            auto x = builder.CreateInputNode(L"x", TensorShape(5, 5, 2)); // W x H x C
+            auto conv = builder.Convolution(builder.CreateLearnableParameter(L"W", c_mapCount, 3 * 3 * 2), x, 3, 3, c_mapCount, 1, 1, ImageLayoutKind::CHW,
+                                            zeroPadding, 0, L"conv");
+            auto z = builder.Plus(conv, builder.CreateLearnableParameter(L"b", TensorShape(1, 1, c_mapCount)), L"z");
+            InitParametersRandomly<float>(net);
+            net.AddToNodeGroup(L"feature", x);
+            net.AddToNodeGroup(L"output", builder.RectifiedLinear(z, L"out"));
+        }, { L"out" });
+
+        // Convolution -> Plus -> RectifiedLinear is one node under the name of the last one
+        auto out = optimized->GetNodeFromName(L"out");
+        BOOST_REQUIRE(out->OperationName() == OperationNameOf(FusedConvolutionNode));
+        BOOST_CHECK(dynamic_pointer_cast<FusedConvolutionNode<float>>(out)->HasReLU());
+        BOOST_REQUIRE_EQUAL(out->GetNumInputs(), (size_t) 3);
+        BOOST_CHECK(out->GetInputs()[1]->NodeName() == L"x");
+        BOOST_CHECK(out->GetInputs()[2]->NodeName() == L"b");
+        BOOST_CHECK(!optimized->NodeNameExists(L"conv"));
+        BOOST_CHECK(!optimized->NodeNameExists(L"z"));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RemoveDropout)
+{
+    auto optimized = CheckOptimizedNetwork([](ComputationNetwork& net, ComputationNetworkBuilder<float>& builder)
+    {
+        auto x = builder.CreateInputNode(L"x", c_inputDim);
+        auto z = builder.Plus(builder.Times(builder.CreateLearnableParameter(L"W", c_outputDim, c_inputDim), x, 1, L"Wx"),
+                              builder.CreateLearnableParameter(L"b", c_outputDim, 1), L"z");
+        auto dropout = builder.Dropout(builder.Tanh(z, L"h"), L"dropout");
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", builder.Times(builder.CreateLearnableParameter(L"V", 2, c_outputDim), dropout, 1, L"out"));
+        InitParametersRandomly<float>(net);
+    }, { L"out", L"dropout" });
+
+    BOOST_CHECK(optimized->GetNodesWithType(OperationNameOf(DropoutNode)).empty());
+    BOOST_CHECK(optimized->GetNodeFromName(L"dropout")->OperationName() == OperationNameOf(TanhNode));
+}
+
+BOOST_AUTO_TEST_CASE(FoldPerDimMeanVarNormalization)
+{
+    auto optimized = CheckOptimizedNetwork([](ComputationNetwork& net, ComputationNetworkBuilder<float>& builder)
+    {
+        auto x = builder.CreateInputNode(L"x", c_inputDim);
+        auto invStdDev = CreateStatistics(builder, L"invStdDev", c_inputDim);
+        auto normalized = builder.PerDimMeanVarNormalization(x, CreateStatistics(builder, L"mean", c_inputDim), invStdDev, L"normalized");
+        auto z = builder.Plus(builder.Times(builder.CreateLearnableParameter(L"W", c_outputDim, c_inputDim), normalized, 1, L"Wx"),
+                              builder.CreateLearnableParameter(L"b", c_outputDim, 1), L"z");
+        InitParametersRandomly<float>(net);
+        InitInvStdDevRandomly(invStdDev);
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", builder.Sigmoid(z, L"out"));
+    }, { L"out", L"z" });
+
+    // the normalization is folded into W and b, and Times reads the input directly
+    BOOST_CHECK(optimized->GetNodesWithType(OperationNameOf(PerDimMeanVarNormalizationNode)).empty());
+    BOOST_CHECK(optimized->GetNodeFromName(L"Wx")->GetInputs()[1]->NodeName() == L"x");
+}
+
+BOOST_AUTO_TEST_CASE(FoldConstantSubgraph)
+{
+    auto optimized = CheckOptimizedNetwork([](ComputationNetwork& net, ComputationNetworkBuilder<float>& builder)
+    {
+        // a weight matrix given as the product of two factors
+        auto w = builder.Times(builder.CreateLearnableParameter(L"U", c_outputDim, 2), builder.CreateLearnableParameter(L"V", 2, c_inputDim), 1, L"W");
+        auto x = builder.CreateInputNode(L"x", c_inputDim);
+        auto z = builder.Plus(builder.Times(w, x, 1, L"Wx"), builder.CreateLearnableParameter(L"b", c_outputDim, 1), L"z");
+        InitParametersRandomly<float>(net);
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", builder.Sigmoid(z, L"out"));
+    }, { L"out", L"W" });
+
+    // the product is now a parameter under the same name, and its factors are gone
+    BOOST_CHECK(optimized->GetNodeFromName(L"W")->OperationName() == OperationNameOf(LearnableParameter));
+    BOOST_CHECK(!optimized->NodeNameExists(L"U"));
+    BOOST_CHECK(!optimized->NodeNameExists(L"V"));
+}
+
+BOOST_AUTO_TEST_CASE(ReplaceNodeMovesLinksAndGroups)
+{
+    auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+    ComputationNetworkBuilder<float> builder(*net);
+    auto x = builder.CreateInputNode(L"x", c_inputDim);
+    auto h = builder.Sigmoid(x, L"h");
+    auto out = builder.Tanh(h, L"out");
+    auto replacement = builder.RectifiedLinear(x, L"replacement");
+    net->AddToNodeGroup(L"feature", x);
+    net->AddToNodeGroup(L"output", h);
+    net->AddToNodeGroup(L"output", out);
+
+    net->ReplaceNode(h, replacement);
+
+    BOOST_CHECK(!net->NodeNameExists(L"h"));
+    BOOST_CHECK(out->GetInputs()[0] == replacement);
+    BOOST_REQUIRE_EQUAL(net->OutputNodes().size(), (size_t) 2);
+    BOOST_CHECK(net->OutputNodes()[0] == replacement);
+    BOOST_CHECK(net->OutputNodes()[1] == out);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
@@ -0,0 +1,143 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests for the CPU lattice forward-backward of sequence training (lattice::forwardbackward)
+//
+#include "stdafx.h"
+#include "Common/NetworkTestHelper.h"
+#include "CPUMatrix.h"
+#include "latticearchive.h"
+#include "simplesenonehmm.h"
+#include "ssematrix.h"
+#include <thread>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace msra::lattices;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+static const size_t c_numSlots = 4;       // layers of word nodes between the start and the end node
+static const size_t c_numSlotNodes = 24;  // word nodes per layer, each connected to all nodes of the next layer
+static const size_t c_slotFrames = 12;    // frames between two layers
+static const size_t c_numUnits = 3;       // sil, a, b; 3 states each
+static const size_t c_numSenones = 3 * c_numUnits;
+
+struct LatticeForwardBackwardFixture : DataFixture
+{
+    LatticeForwardBackwardFixture()
+        : DataFixture("/Data")
+    {
+    }
+
+    static wstring ToWide(const string& path)
+    {
+        return wstring(path.begin(), path.end());
+    }
+
+    static void WriteTextFile(const string& fileName, const string& contents)
+    {
+        ofstream file(fileName, ios::out | ios::binary);
+        file << contents;
+    }
+
+    void LoadModel(msra::asr::simplesenonehmm& hset)
+    {
+        const string base = currentPath() + "/LatticeForwardBackward";
+        WriteTextFile(base + ".statelist", "sil_s2\nsil_s3\nsil_s4\na_s2\na_s3\na_s4\nb_s2\nb_s3\nb_s4\nsp_s2\n");
+        WriteTextFile(base + ".transP",
+            "T3 3 1 0 0 0 0.6 0.4 0 0 0 0.7 0.3 0 0 0 0.5 0.5\n"
+            "T1 1 1 0 0.5 0.5\n");
+        WriteTextFile(base + ".tying",
+            "sil T3 sil_s2 sil_s3 sil_s4\n"
+            "a T3 a_s2 a_s3 a_s4\n"
+            "b T3 b_s2 b_s3 b_s4\n"
+            "sp T1 sp_s2\n");
+        hset.loadfromfile(ToWide(base + ".tying"), ToWide(base + ".statelist"), ToWide(base + ".transP"));
+    }
+
+    // A lattice whose topological layers are wide enough for the lattice-level passes to run multi-threaded:
+    // a start node, c_numSlots layers of c_numSlotNodes nodes, and an end node. Each edge carries two units.
+    void LoadLattice(lattice& L, const msra::asr::simplesenonehmm& hset)
+    {
+        static const char* unitNames[c_numUnits] = { "sil", "a", "b" };
+        const size_t numNodes = 2 + c_numSlots * c_numSlotNodes;
+        // node 0 is the start node, node 1 + k * c_numSlotNodes + n is node n of layer k, and the last node is the end node
+        auto nodeSlot = [&](size_t i) { return i == 0 ? 0 : i == numNodes - 1 ? c_numSlots + 1 : 1 + (i - 1) / c_numSlotNodes; };
+
+        string text = msra::strfun::strprintf("N=%d L=%d\n", (int) numNodes, (int) (2 * c_numSlotNodes + (c_numSlots - 1) * c_numSlotNodes * c_numSlotNodes));
+        for (size_t i = 0; i < numNodes; i++)
+            text += msra::strfun::strprintf("I=%d t=%.2f\n", (int) i, nodeSlot(i) * c_slotFrames * 0.01);
+        size_t numEdges = 0;
+        for (size_t E = 1; E < numNodes; E++) // sorted by end node, then start node
+        {
+            for (size_t S = 0; S < E; S++)
+            {
+                if (nodeSlot(S) + 1 != nodeSlot(E))
+                    continue;
+                const size_t firstUnit = (S + E) % c_numUnits;
+                const size_t secondUnit = (firstUnit + 1 + E % 2) % c_numUnits;
+                const size_t firstFrames = 3 + (7 * S + 3 * E) % 7; // each unit gets at least one frame per state
+                const float a = -(float) (firstFrames * 1.5 + (13 * S + 5 * E) % 17);
+                const float l = -0.5f * (float) ((S + 2 * E) % 5);
+                text += msra::strfun::strprintf("J=%d S=%d E=%d a=%.2f l=%.2f d=:%s,%.2f:%s,%.2f:\n", (int) numEdges++, (int) S, (int) E, a, l,
+                                                unitNames[firstUnit], firstFrames * 0.01, unitNames[secondUnit], (c_slotFrames - firstFrames) * 0.01);
+            }
+        }
+        const string path = currentPath() + "/LatticeForwardBackward.lat";
+        WriteTextFile(path, text);
+        L.fromhtklattice(ToWide(path), hset.getsymmap());
+        L.rebuildedges(false);
+    }
+
+    // Run the forward-backward with the given number of threads; returns its result and the gammas resp. error signal.
+    static double ForwardBackward(const lattice& L, const msra::asr::simplesenonehmm& hset, bool sMBRmode, int numThreads, msra::dbn::matrix& result)
+    {
+        const size_t numFrames = L.getnumframes();
+        msra::dbn::matrix logLLs(c_numSenones, numFrames);
+        std::vector<size_t> uids(numFrames);
+        for (size_t t = 0; t < numFrames; t++)
+        {
+            for (size_t s = 0; s < c_numSenones; s++)
+                logLLs(s, t) = -1.0f - 0.37f * (float) ((31 * s + 17 * t) % 23);
+            uids[t] = (7 * t) % c_numSenones;
+        }
+        result.resize(c_numSenones, numFrames);
+        msra::dbn::matrix errorSignalBuffer;
+
+        CPUMatrix<float>::SetNumThreads(numThreads);
+        lattice::parallelstate parallelState; // not enabled: CPU code path
+        return L.forwardbackward(parallelState, logLLs, hset, result, errorSignalBuffer, 14.0f /*lmf*/, 0.0f /*wp*/, 14.0f /*amf*/, 0.0f /*boostingfactor*/,
+                                 sMBRmode, array_ref<size_t>(uids.data(), uids.size()));
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(NetworkTestSuite, LatticeForwardBackwardFixture)
+
+BOOST_AUTO_TEST_CASE(LatticeForwardBackwardSerialParallelParity)
+{
+    msra::asr::simplesenonehmm hset;
+    LoadModel(hset);
+    lattice L;
+    LoadLattice(L, hset);
+    BOOST_REQUIRE_EQUAL(L.getnumedges(), 2 * c_numSlotNodes + (c_numSlots - 1) * c_numSlotNodes * c_numSlotNodes);
+
+    // each node sums its incoming resp. outgoing path scores in a fixed order, so the result must be the same for any number of threads
+    const int maxNumThreads = (int) std::thread::hardware_concurrency();
+    for (bool sMBRmode : { false, true })
+    {
+        msra::dbn::matrix serialResult, parallelResult;
+        const double serial = ForwardBackward(L, hset, sMBRmode, 1, serialResult);
+        const double parallel = ForwardBackward(L, hset, sMBRmode, max(maxNumThreads, 2), parallelResult);
+        BOOST_CHECK(serial > LOGZERO);
+        BOOST_CHECK_EQUAL(serial, parallel);
+        for (size_t t = 0; t < serialResult.cols(); t++)
+            for (size_t s = 0; s < serialResult.rows(); s++)
+                BOOST_CHECK_EQUAL(serialResult(s, t), parallelResult(s, t));
+    }
+    CPUMatrix<float>::SetNumThreads(maxNumThreads);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -14,4 +14,8 @@ Microsoft::MSR::CNTK::MPIWrapper* g_mpi = nullptr;
 // TODO: Temporary mechanism to enable memory sharing for
 // node output value matrices. This will go away when the
 // sharing is ready to be enabled by default
-bool g_shareNodeValueMatrices = false;
\ No newline at end of file
+bool g_shareNodeValueMatrices = false;
+
+// Flag that enables fusing chains of element-wise nodes when compiling a network,
+// see ComputationNetwork::FuseElementwiseNodes()
+bool g_fuseElementwiseNodes = false;
\ No newline at end of file
@@ -0,0 +1,123 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests for the implicit frame permutation of the HTKMLFReader (compactFrameRandomization=true)
+//
+#include "stdafx.h"
+#include "framepermutation.h"
+#include <random>
+
+using namespace msra::dbn;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// the parts of a randomized chunk of the utterance source that the permutation looks at
+struct TestChunk
+{
+    size_t windowbegin;
+    size_t windowend;
+    size_t globalts;
+    size_t numframes;
+    size_t globalte() const
+    {
+        return globalts + numframes;
+    }
+};
+
+// Chunks of random size starting at frame position sweepts, each with a rolling window of
+// windowRadius chunks to either side.
+static std::vector<TestChunk> CreateChunks(size_t numChunks, size_t windowRadius, size_t sweepts)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> chunkSize(50, 400);
+    std::vector<TestChunk> chunks(numChunks);
+    size_t ts = sweepts;
+    for (size_t i = 0; i < numChunks; i++)
+    {
+        chunks[i].windowbegin = i > windowRadius ? i - windowRadius : 0;
+        chunks[i].windowend = std::min(i + windowRadius + 1, numChunks);
+        chunks[i].globalts = ts;
+        chunks[i].numframes = chunkSize(rng);
+        ts += chunks[i].numframes;
+    }
+    return chunks;
+}
+
+// the permuted position of each frame position of the sweep
+static std::vector<size_t> PermutedPositions(const std::vector<TestChunk>& chunks, unsigned int seed)
+{
+    framepermutation permutation;
+    permutation.reset(chunks, seed);
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        for (size_t t = chunks[i].globalts; t < chunks[i].globalte(); t++)
+            positions.push_back(permutation.permutedposition(t, i));
+    }
+    return positions;
+}
+
+static size_t ChunkOf(const std::vector<TestChunk>& chunks, size_t t)
+{
+    size_t i = 0;
+    while (chunks[i].globalte() <= t)
+        i++;
+    return i;
+}
+
+BOOST_AUTO_TEST_SUITE(ReaderTestSuite)
+
+BOOST_AUTO_TEST_CASE(FramePermutationIsPermutationWithinWindow)
+{
+    const size_t sweepts = 123456;
+    const auto chunks = CreateChunks(200, 5, sweepts);
+    const size_t numFrames = chunks.back().globalte() - sweepts;
+
+    framepermutation permutation;
+    permutation.reset(chunks, 1);
+    BOOST_CHECK_GT(permutation.numblocks(), (size_t) 1);
+    BOOST_CHECK_LT(permutation.numblocks(), chunks.size());
+
+    auto positions = PermutedPositions(chunks, 1);
+    BOOST_REQUIRE_EQUAL(positions.size(), numFrames);
+
+    // every frame of a position comes from a chunk within the randomization window of the position's chunk
+    size_t fixedPoints = 0;
+    size_t movedToOtherChunk = 0;
+    for (size_t j = 0; j < numFrames; j++)
+    {
+        const size_t t = sweepts + j;
+        const size_t positionChunk = ChunkOf(chunks, t);
+        const size_t frameChunk = ChunkOf(chunks, positions[j]);
+        BOOST_REQUIRE(frameChunk >= chunks[positionChunk].windowbegin && frameChunk < chunks[positionChunk].windowend);
+        fixedPoints += positions[j] == t;
+        movedToOtherChunk += frameChunk != positionChunk;
+    }
+    // the frames are actually mixed, also across chunks
+    BOOST_CHECK_LT(fixedPoints, numFrames / 100);
+    BOOST_CHECK_GT(movedToOtherChunk, numFrames / 2);
+
+    // and each frame is returned exactly once
+    std::sort(positions.begin(), positions.end());
+    for (size_t j = 0; j < numFrames; j++)
+        BOOST_REQUIRE_EQUAL(positions[j], sweepts + j);
+}
+
+BOOST_AUTO_TEST_CASE(FramePermutationIsReproduciblePerSeed)
+{
+    const auto chunks = CreateChunks(50, 3, 0);
+
+    BOOST_CHECK(PermutedPositions(chunks, 1) == PermutedPositions(chunks, 1));
+
+    const auto positions1 = PermutedPositions(chunks, 1);
+    const auto positions2 = PermutedPositions(chunks, 2);
+    size_t same = 0;
+    for (size_t j = 0; j < positions1.size(); j++)
+        same += positions1[j] == positions2[j];
+    BOOST_CHECK_LT(same, positions1.size() / 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -3,6 +3,7 @@
 // Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
 //
 #include "stdafx.h"
+#include <chrono>
 #include "Common/ReaderTestHelper.h"
 
 using namespace Microsoft::MSR::CNTK;
@@ -151,6 +152,46 @@ BOOST_AUTO_TEST_CASE(ImageReaderZipMissingFile)
             [](std::runtime_error const& ex) { return string("Failed to get file info of missing.jpg, zip library error: Unknown error -1") == ex.what(); });
 }
 
+// Reads many small JPEGs from a zip archive and reports the throughput.
+// Each group of 8 entries in the archive contains the same 4 images, first stored, then deflated,
+// so that both ways of reading have to produce the same features.
+BOOST_AUTO_TEST_CASE(ImageReaderZipThroughput)
+{
+    const size_t imageCount = 128;
+    const size_t mbSize = 32;
+    const size_t epochs = 10;
+
+    auto reader = GetDataReader(testDataPath() + "/Config/ImageReaderZipThroughput_Config.cntk", "ZipThroughput_Test", "reader");
+    auto inputs = CreateStreamMinibatchInputs<float>(1, 1);
+
+    size_t imagesRead = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t epoch = 0; epoch < epochs; epoch++)
+    {
+        reader->StartMinibatchLoop(mbSize, epoch, imageCount);
+        while (reader->GetMinibatch(*inputs))
+        {
+            auto& features = inputs->GetInputMatrix<float>(L"features");
+            std::unique_ptr<float[]> data{ features.CopyToArray() };
+            size_t numRows = features.GetNumRows();
+            size_t numCols = features.GetNumCols();
+            BOOST_REQUIRE_EQUAL(numCols % 8, 0);
+            for (size_t col = 0; col < numCols; col += 8)
+            {
+                const float* stored = data.get() + col * numRows;
+                const float* deflated = stored + 4 * numRows;
+                BOOST_REQUIRE(std::equal(stored, stored + 4 * numRows, deflated));
+            }
+
+            imagesRead += numCols;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    BOOST_CHECK_EQUAL(imagesRead, epochs * imageCount);
+    BOOST_TEST_MESSAGE("Read " << imagesRead << " images in " << seconds << " seconds (" << imagesRead / seconds << " images/s)");
+}
+
 BOOST_AUTO_TEST_CASE(ImageReaderMultiView)
 {
     HelperRunReaderTest<float>(
@@ -203,6 +244,43 @@ BOOST_AUTO_TEST_CASE(ImageReaderColorTransform)
         1);
 }
 
+// The ImageReader applies crop, scale, color, intensity, mean and transpose with one fused transformer.
+// Reading the same images with the same seeds through the individual transformers of the composite
+// reader has to produce the same features, also in the second epoch, where the aspect ratio is jittered.
+BOOST_AUTO_TEST_CASE(ImageReaderFusedTransformMatchesChain)
+{
+    const size_t imageCount = 5;
+    const size_t epochs = 2;
+
+    auto readFeatures = [&](const string& testSection)
+    {
+        auto reader = GetDataReader(testDataPath() + "/Config/ImageReaderFusedTransform_Config.cntk", testSection, "reader");
+        auto inputs = CreateStreamMinibatchInputs<float>(1, 1);
+
+        vector<float> result;
+        for (size_t epoch = 0; epoch < epochs; epoch++)
+        {
+            // one image per minibatch, so that the transformers draw from their random generators in a fixed order
+            reader->StartMinibatchLoop(1, epoch, imageCount);
+            while (reader->GetMinibatch(*inputs))
+            {
+                auto& features = inputs->GetInputMatrix<float>(L"features");
+                BOOST_REQUIRE_EQUAL(features.GetNumRows(), 4 * 4 * 3);
+                std::unique_ptr<float[]> data{ features.CopyToArray() };
+                result.insert(result.end(), data.get(), data.get() + features.GetNumElements());
+            }
+        }
+        return result;
+    };
+
+    vector<float> fused = readFeatures("Fused_Test");
+    vector<float> chain = readFeatures("Chain_Test");
+    BOOST_REQUIRE_EQUAL(fused.size(), epochs * imageCount * 4 * 4 * 3);
+    BOOST_REQUIRE_EQUAL(fused.size(), chain.size());
+    for (size_t i = 0; i < fused.size(); i++)
+        BOOST_CHECK_SMALL(fused[i] - chain[i], 1e-4f);
+}
+
 BOOST_AUTO_TEST_CASE(ImageReaderGrayscale)
 {
     HelperRunReaderTest<float>(
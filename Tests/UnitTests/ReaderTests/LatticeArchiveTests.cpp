@@ -0,0 +1,155 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests for lattice archives (V2 and the compact V3 format), read eagerly and on demand
+//
+#include "stdafx.h"
+#include "Common/ReaderTestHelper.h"
+#include "htkfeatio.h"
+#include "latticearchive.h"
+#include "msra_mgram.h"
+#include "simplesenonehmm.h"
+
+using namespace Microsoft::MSR::CNTK;
+using namespace msra::lattices;
+
+namespace msra { namespace lm {
+/*static*/ const mgram_map::index_t mgram_map::nindex = (mgram_map::index_t) -1; // invalid index
+}}
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+struct LatticeArchiveFixture : ReaderFixture
+{
+    LatticeArchiveFixture()
+        : ReaderFixture("/Data")
+    {
+    }
+
+    static wstring ToWide(const string& path)
+    {
+        return wstring(path.begin(), path.end());
+    }
+
+    static void WriteTextFile(const string& fileName, const string& contents)
+    {
+        ofstream file(fileName, ios::out | ios::binary);
+        file << contents;
+    }
+
+    // A model with the units sil, a, b (3 states each) and sp (1 state).
+    void LoadModel(msra::asr::simplesenonehmm& hset)
+    {
+        const string base = currentPath() + "/LatticeArchive";
+        WriteTextFile(base + ".statelist", "sil_s2\nsil_s3\nsil_s4\na_s2\na_s3\na_s4\nb_s2\nb_s3\nb_s4\nsp_s2\n");
+        WriteTextFile(base + ".transP",
+            "T3 3 1 0 0 0 0.5 0.5 0 0 0 0.5 0.5 0 0 0 0.5 0.5\n"
+            "T1 1 1 0 0.5 0.5\n");
+        WriteTextFile(base + ".tying",
+            "sil T3 sil_s2 sil_s3 sil_s4\n"
+            "a T3 a_s2 a_s3 a_s4\n"
+            "b T3 b_s2 b_s3 b_s4\n"
+            "sp T1 sp_s2\n");
+        hset.loadfromfile(ToWide(base + ".tying"), ToWide(base + ".statelist"), ToWide(base + ".transP"));
+    }
+
+    // Dump a lattice as text, which lists its node times, edges and alignment records.
+    static string Dump(const lattice& L, const vector<const char*>& unitNames)
+    {
+        L.ensuredecoded();
+        FILE* f = tmpfile();
+        BOOST_REQUIRE(f != nullptr);
+        L.dump(f, [&](size_t unit) { return unitNames[unit]; });
+        string text(ftell(f), '\0');
+        rewind(f);
+        BOOST_REQUIRE_EQUAL(fread(&text[0], 1, text.size(), f), text.size());
+        fclose(f);
+        return text;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(ReaderTestSuite, LatticeArchiveFixture)
+
+BOOST_AUTO_TEST_CASE(LatticeArchiveCompactRoundTrip)
+{
+    msra::asr::simplesenonehmm hset;
+    LoadModel(hset);
+    const auto& symmap = hset.getsymmap();
+    vector<const char*> unitNames(symmap.size());
+    for (const auto& unit : symmap)
+        unitNames[unit.second] = unit.first.c_str();
+
+    // the second lattice has edges longer than 127 frames and a 0-frame /sp/, which take the multi-byte paths of the V3 coding
+    const string latticePaths[] = { currentPath() + "/LatticeArchiveShort.lat", currentPath() + "/LatticeArchiveLong.lat" };
+    WriteTextFile(latticePaths[0],
+        "VERSION=1.0\n"
+        "lmscale=12.00 wdpenalty=0.00\n"
+        "N=4 L=4\n"
+        "I=0 t=0.00\n"
+        "I=1 t=0.05\n"
+        "I=2 t=0.09\n"
+        "I=3 t=0.12\n"
+        "J=0 S=0 E=1 a=-10.50 l=-1.250 d=:sil,0.05:\n"
+        "J=1 S=0 E=2 a=-30.00 l=-3.000 d=:sil,0.03:b,0.06:\n"
+        "J=2 S=1 E=2 a=-20.25 l=-2.500 d=:a,0.02:b,0.01:sp,0.01:\n"
+        "J=3 S=2 E=3 a=-5.00 l=0.000 d=:sil,0.03:\n");
+    WriteTextFile(latticePaths[1],
+        "VERSION=1.0\n"
+        "lmscale=12.00 wdpenalty=0.00\n"
+        "N=4 L=5\n"
+        "I=0 t=0.00\n"
+        "I=1 t=1.50\n"
+        "I=2 t=1.62\n"
+        "I=3 t=3.00\n"
+        "J=0 S=0 E=1 a=-410.75 l=-4.125 d=:sil,0.20:a,1.20:sp,0.10:\n"
+        "J=1 S=0 E=2 a=-512.00 l=-6.000 d=:sil,0.50:b,1.12:\n"
+        "J=2 S=1 E=2 a=-40.50 l=-0.500 d=:b,0.12:\n"
+        "J=3 S=1 E=3 a=-420.00 l=-3.750 d=:a,1.50:sp,0.00:\n"
+        "J=4 S=2 E=3 a=-380.25 l=0.000 d=:sil,1.38:\n");
+    const wstring keys[] = { L"LatticeArchiveShort", L"LatticeArchiveLong" };
+
+    const string v2Path = currentPath() + "/LatticeArchive.v2.lats";
+    const string v3Path = currentPath() + "/LatticeArchive.v3.lats";
+    const msra::asr::htkmlfreader<msra::asr::htkmlfentry, lattice::htkmlfwordsequence> noLabels((vector<wstring>()), set<wstring>());
+    archive::build(vector<wstring>{ ToWide(latticePaths[0]), ToWide(latticePaths[1]) }, ToWide(v2Path), symmap, noLabels, msra::lm::CMGramLM(), msra::lm::CSymbolSet());
+    archive::compact(ToWide(v2Path + ".toc"), ToWide(v3Path), hset);
+    BOOST_CHECK_LT(filesize(ToWide(v3Path).c_str()), filesize(ToWide(v2Path).c_str()));
+
+    const archive v2(vector<wstring>{ ToWide(v2Path + ".toc") }, symmap);
+    const archive v3(vector<wstring>{ ToWide(v3Path + ".toc") }, symmap);
+    for (const wstring& key : keys)
+    {
+        BOOST_REQUIRE(v2.haslattice(key));
+        BOOST_REQUIRE(v3.haslattice(key));
+
+        // the V2 archive read eagerly is the reference for both formats in both modes
+        lattice reference;
+        v2.getlattice(key, reference);
+        const string expected = Dump(reference, unitNames);
+        BOOST_CHECK_NE(expected.find("d=:"), string::npos);
+
+        for (const archive* a : { &v2, &v3 })
+        {
+            for (bool ondemand : { false, true })
+            {
+                lattice L;
+                a->getlattice(key, L, reference.getnumframes(), ondemand);
+                BOOST_CHECK_EQUAL(L.getnumnodes(), reference.getnumnodes());
+                BOOST_CHECK_EQUAL(L.getnumedges(), reference.getnumedges());
+                BOOST_CHECK_EQUAL(Dump(L, unitNames), expected);
+
+                // a lattice read on demand is decoded to the same content again after releasing it
+                if (ondemand)
+                {
+                    L.releasedecoded();
+                    BOOST_CHECK_EQUAL(Dump(L, unitNames), expected);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
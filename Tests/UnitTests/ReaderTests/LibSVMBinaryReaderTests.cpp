@@ -0,0 +1,135 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/ReaderTestHelper.h"
+#include <set>
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+struct LibSVMBinaryReaderFixture : ReaderFixture
+{
+    LibSVMBinaryReaderFixture()
+        : ReaderFixture("/Data")
+    {
+    }
+
+    template <class T>
+    static void Write(ofstream& file, T value)
+    {
+        file.write((const char*) &value, sizeof(value));
+    }
+
+    static void WriteName(ofstream& file, const string& name, int32_t numCols)
+    {
+        Write(file, (int32_t) name.size());
+        file.write(name.data(), name.size());
+        Write(file, numCols);
+    }
+
+    // Write a file in the LibSVMBinaryReader format with a sparse input "features" and a dense input "labels".
+    // It holds numMicroBatches microbatches of microBatchSize samples; sample s has the features s % featureDim and
+    // (3 * s) % featureDim, and the one-hot label s % labelDim.
+    static void WriteBinaryFile(const string& fileName, int32_t microBatchSize, int32_t numMicroBatches, int32_t featureDim, int32_t labelDim)
+    {
+        vector<vector<char>> microBatches(numMicroBatches);
+        for (int32_t mb = 0; mb < numMicroBatches; mb++)
+        {
+            vector<float> values;
+            vector<int32_t> rowIndices;
+            vector<int32_t> colIndices(1, 0);
+            vector<float> labels(microBatchSize * labelDim, 0.0f);
+            for (int32_t i = 0; i < microBatchSize; i++)
+            {
+                int32_t s = mb * microBatchSize + i;
+                set<int32_t> rows = { s % featureDim, (3 * s) % featureDim };
+                for (int32_t row : rows)
+                {
+                    values.push_back(1.0f + s * 0.5f + row);
+                    rowIndices.push_back(row);
+                }
+                colIndices.push_back((int32_t) values.size());
+                labels[i * labelDim + s % labelDim] = 1.0f;
+            }
+
+            auto append = [&microBatches, mb](const void* data, size_t numBytes)
+            {
+                microBatches[mb].insert(microBatches[mb].end(), (const char*) data, (const char*) data + numBytes);
+            };
+            int32_t nnz = (int32_t) values.size();
+            append(&microBatchSize, sizeof(microBatchSize));
+            append(&nnz, sizeof(nnz));
+            append(values.data(), sizeof(float) * values.size());
+            append(rowIndices.data(), sizeof(int32_t) * rowIndices.size());
+            append(colIndices.data(), sizeof(int32_t) * colIndices.size());
+            append(labels.data(), sizeof(float) * labels.size());
+        }
+
+        ofstream file(fileName, ios::out | ios::binary);
+        Write(file, (int64_t) microBatchSize * numMicroBatches);
+        Write(file, (int64_t) numMicroBatches);
+        Write(file, (int32_t) 1); // one sparse input
+        Write(file, (int32_t) 1); // one dense input
+        WriteName(file, "features", featureDim);
+        WriteName(file, "labels", labelDim);
+        int64_t offset = 0;
+        for (const auto& microBatch : microBatches)
+        {
+            Write(file, offset);
+            offset += microBatch.size();
+        }
+        for (const auto& microBatch : microBatches)
+        {
+            file.write(microBatch.data(), microBatch.size());
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(ReaderTestSuite, LibSVMBinaryReaderFixture)
+
+BOOST_AUTO_TEST_CASE(LibSVMBinaryReaderMemoryMapped)
+{
+    // 11 microbatches of 4 samples read as minibatches of 8, so the last one is partial. The memory-mapped reader
+    // assembles the sparse features in place and its read threads have to wait for free slots, it must still
+    // deliver the same minibatches as the reader that reads into buffers.
+    WriteBinaryFile(currentPath() + "/LibSVMBinaryReaderSimpleDataLoop_Train.bin", 4, 11, 10, 3);
+
+    HelperReadInAndWriteOut<float>(
+        testDataPath() + "/Config/LibSVMBinaryReaderSimpleDataLoop_Config.cntk",
+        testDataPath() + "/Control/LibSVMBinaryReaderSimpleDataLoop_Output.txt",
+        "Simple_Test",
+        "reader",
+        44,
+        8,
+        1,
+        1,
+        1,
+        0,
+        1,
+        true /*sparseFeatures*/);
+    HelperReadInAndWriteOut<float>(
+        testDataPath() + "/Config/LibSVMBinaryReaderSimpleDataLoop_Config.cntk",
+        testDataPath() + "/Control/LibSVMBinaryReaderSimpleDataLoopMemoryMapped_Output.txt",
+        "Simple_Test_MemoryMapped",
+        "reader",
+        44,
+        8,
+        1,
+        1,
+        1,
+        0,
+        1,
+        true /*sparseFeatures*/);
+
+    BOOST_CHECK(boost::filesystem::file_size(testDataPath() + "/Control/LibSVMBinaryReaderSimpleDataLoop_Output.txt") > 0);
+    CheckFilesEquivalent(
+        testDataPath() + "/Control/LibSVMBinaryReaderSimpleDataLoop_Output.txt",
+        testDataPath() + "/Control/LibSVMBinaryReaderSimpleDataLoopMemoryMapped_Output.txt");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -0,0 +1,117 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/ReaderTestHelper.h"
+#include "MLFLabelCache.h"
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+struct MLFLabelCacheFixture : ReaderFixture
+{
+    MLFLabelCacheFixture()
+        : ReaderFixture("/Data")
+    {
+    }
+
+    static wstring ToWide(const string& path)
+    {
+        return wstring(path.begin(), path.end());
+    }
+
+    static void WriteTextFile(const string& fileName, const string& contents)
+    {
+        ofstream file(fileName, ios::out | ios::binary);
+        file << contents;
+    }
+
+    // Expected (class id, number of frames) runs of an utterance.
+    typedef vector<pair<uint32_t, uint32_t>> Runs;
+
+    static void CheckUtterance(const MLFLabelCache& cache, const string& key, size_t numberOfFrames, const Runs& expected)
+    {
+        size_t utterance = cache.Find(key);
+        BOOST_REQUIRE_NE(utterance, SIZE_MAX);
+        BOOST_CHECK_EQUAL(string(cache.GetKey(utterance)), key);
+        BOOST_CHECK_EQUAL(cache.GetNumberOfFrames(utterance), numberOfFrames);
+
+        size_t numberOfRuns = 0;
+        const MLFLabelCache::Run* runs = cache.GetRuns(utterance, numberOfRuns);
+        Runs actual;
+        for (size_t i = 0; i < numberOfRuns; i++)
+            actual.push_back(make_pair(runs[i].m_classId, runs[i].m_numberOfFrames));
+        BOOST_CHECK(actual == expected);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(ReaderTestSuite, MLFLabelCacheFixture)
+
+BOOST_AUTO_TEST_CASE(MLFLabelCacheBuildAndLoad)
+{
+    const string stateListPath = currentPath() + "/MLFLabelCache.statelist";
+    const string mlfPath = currentPath() + "/MLFLabelCache.mlf";
+    const string cachePath = currentPath() + "/MLFLabelCache.cache";
+    remove(cachePath.c_str());
+
+    WriteTextFile(stateListPath, "sil\na_s2\na_s3\nb_s2\n");
+    // utterance 'first' has two adjacent entries of a_s2, which become one run
+    WriteTextFile(mlfPath,
+        "#!MLF!#\n"
+        "\"*/first.lab\"\n"
+        "0 300000 sil\n"
+        "300000 500000 a_s2\n"
+        "500000 600000 a_s2\n"
+        "600000 800000 a_s3\n"
+        "800000 1200000 b_s2\n"
+        ".\n"
+        "\"*/second.lab\"\n"
+        "0 200000 b_s2\n"
+        "200000 300000 sil\n"
+        ".\n");
+
+    const vector<wstring> mlfPaths{ ToWide(mlfPath) };
+    const Runs first{ { 0, 3 }, { 1, 3 }, { 2, 2 }, { 3, 4 } };
+    const Runs second{ { 3, 2 }, { 0, 1 } };
+
+    // the first instance compiles the cache, the second one maps it
+    for (int pass = 0; pass < 2; pass++)
+    {
+        MLFLabelCache cache(ToWide(cachePath), mlfPaths, ToWide(stateListPath), 100000.0);
+        BOOST_CHECK(fexists(cachePath.c_str()));
+        BOOST_CHECK_EQUAL(cache.GetNumberOfUtterances(), 2);
+        CheckUtterance(cache, "first", 12, first);
+        CheckUtterance(cache, "second", 3, second);
+        BOOST_CHECK_EQUAL(cache.Find("third"), SIZE_MAX);
+    }
+
+    // a changed MLF makes the cache stale, it is rebuilt with the new utterance
+    WriteTextFile(mlfPath,
+        "#!MLF!#\n"
+        "\"*/first.lab\"\n"
+        "0 300000 sil\n"
+        "300000 500000 a_s2\n"
+        "500000 600000 a_s2\n"
+        "600000 800000 a_s3\n"
+        "800000 1200000 b_s2\n"
+        ".\n"
+        "\"*/second.lab\"\n"
+        "0 200000 b_s2\n"
+        "200000 300000 sil\n"
+        ".\n"
+        "\"*/third.lab\"\n"
+        "0 100000 a_s3\n"
+        ".\n");
+
+    MLFLabelCache rebuilt(ToWide(cachePath), mlfPaths, ToWide(stateListPath), 100000.0);
+    BOOST_CHECK_EQUAL(rebuilt.GetNumberOfUtterances(), 3);
+    CheckUtterance(rebuilt, "first", 12, first);
+    CheckUtterance(rebuilt, "second", 3, second);
+    CheckUtterance(rebuilt, "third", 1, Runs{ { 2, 1 } });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
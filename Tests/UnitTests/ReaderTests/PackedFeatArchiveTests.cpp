@@ -0,0 +1,149 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests for the packed feature archive of the HTKMLFReader (packedArchive option of a feature)
+//
+#include "stdafx.h"
+#include "Common/ReaderTestHelper.h"
+#include "htkfeatio.h"
+
+using namespace Microsoft::MSR::CNTK;
+using namespace msra::asr;
+
+namespace msra { namespace asr {
+/*static*/ std::unordered_map<std::wstring, unsigned int> htkfeatreader::parsedpath::archivePathStringMap;
+/*static*/ std::vector<std::wstring> htkfeatreader::parsedpath::archivePathStringVector;
+}}
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// column-major frames, as the HTK reader and writer expect them
+struct TestFeatures
+{
+    size_t numRows = 0;
+    size_t numCols = 0;
+    vector<float> values;
+
+    size_t rows() const { return numRows; }
+    size_t cols() const { return numCols; }
+    void resize(size_t n, size_t m)
+    {
+        numRows = n;
+        numCols = m;
+        values.assign(n * m, 0);
+    }
+    float& operator()(size_t i, size_t j) { return values[j * numRows + i]; }
+    const float& operator()(size_t i, size_t j) const { return values[j * numRows + i]; }
+};
+
+struct PackedFeatArchiveFixture : ReaderFixture
+{
+    PackedFeatArchiveFixture()
+        : ReaderFixture("/Data")
+    {
+    }
+
+    static wstring ToWide(const string& path)
+    {
+        return wstring(path.begin(), path.end());
+    }
+
+    // Write numUtterances HTK files of different lengths, in both the plain and the archive syntax of script entries.
+    vector<wstring> WriteFeatureFiles(const string& baseName, size_t numUtterances, vector<TestFeatures>& features)
+    {
+        vector<wstring> entries;
+        for (size_t u = 0; u < numUtterances; u++)
+        {
+            TestFeatures feat;
+            feat.resize(3, 5 + 7 * u);
+            for (size_t t = 0; t < feat.cols(); t++)
+                for (size_t k = 0; k < feat.rows(); k++)
+                    feat(k, t) = (float) (u * 1000 + t) + k * 0.125f;
+
+            const wstring path = ToWide(currentPath() + "/" + baseName + std::to_string(u) + ".fbank");
+            htkfeatwriter::write(path, "FBANK", 100000, feat);
+            if (u % 2 == 0)
+                entries.push_back(path);
+            else
+                entries.push_back(msra::strfun::wstrprintf(L"utterance%d.fbank=%ls[0,%d]", (int) u, path.c_str(), (int) feat.cols() - 1));
+            features.push_back(feat);
+        }
+        return entries;
+    }
+
+    // Read the utterances back from the script entries, in reverse order, and compare them with the written ones.
+    static void CheckFeatures(const vector<wstring>& entries, const vector<TestFeatures>& expected)
+    {
+        BOOST_REQUIRE_EQUAL(entries.size(), expected.size());
+        htkfeatreader reader;
+        for (size_t u = entries.size(); u-- > 0;)
+        {
+            string featKind;
+            unsigned int featPeriod = 0;
+            TestFeatures feat;
+            reader.read(htkfeatreader::parsedpath(entries[u]), featKind, featPeriod, feat);
+            BOOST_CHECK_EQUAL(featKind, "FBANK");
+            BOOST_CHECK_EQUAL(featPeriod, 100000);
+            BOOST_REQUIRE_EQUAL(feat.rows(), expected[u].rows());
+            BOOST_REQUIRE_EQUAL(feat.cols(), expected[u].cols());
+            BOOST_CHECK_EQUAL_COLLECTIONS(feat.values.begin(), feat.values.end(), expected[u].values.begin(), expected[u].values.end());
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(ReaderTestSuite, PackedFeatArchiveFixture)
+
+BOOST_AUTO_TEST_CASE(PackedFeatArchiveRoundTrip)
+{
+    const string scpPath = currentPath() + "/PackedFeatArchive.scp";
+    const string archivePath = currentPath() + "/PackedFeatArchive.pfa";
+    const size_t numUtterances = 6;
+    remove(archivePath.c_str());
+
+    vector<TestFeatures> features;
+    vector<wstring> entries = WriteFeatureFiles("PackedFeatArchive", numUtterances, features);
+    ofstream(scpPath) << "(only the time stamp of the script is used)\n";
+
+    vector<wstring> packed = packedfeatarchive::packscript(entries, ToWide(archivePath), ToWide(scpPath));
+    BOOST_REQUIRE_EQUAL(packed.size(), numUtterances);
+    for (size_t u = 0; u < numUtterances; u++)
+    {
+        // the packed entries keep the logical paths and point into the archive
+        htkfeatreader::parsedpath original(entries[u]), packedPath(packed[u]);
+        BOOST_CHECK((wstring) original == (wstring) packedPath);
+        BOOST_CHECK(packedPath.physicallocation() == ToWide(archivePath));
+    }
+    CheckFeatures(entries, features);
+    CheckFeatures(packed, features);
+
+    // the archive is up to date, so it is used without reading the feature files again
+    for (size_t u = 0; u < numUtterances; u++)
+        unlinkOrDie(htkfeatreader::parsedpath(entries[u]).physicallocation());
+    vector<wstring> reused = packedfeatarchive::packscript(entries, ToWide(archivePath), ToWide(scpPath));
+    BOOST_CHECK(reused == packed);
+    CheckFeatures(reused, features);
+}
+
+BOOST_AUTO_TEST_CASE(PackedFeatArchiveRepacksChangedScript)
+{
+    const string scpPath = currentPath() + "/PackedFeatArchiveChanged.scp";
+    const string archivePath = currentPath() + "/PackedFeatArchiveChanged.pfa";
+    remove(archivePath.c_str());
+
+    vector<TestFeatures> features;
+    vector<wstring> entries = WriteFeatureFiles("PackedFeatArchiveChanged", 4, features);
+    ofstream(scpPath) << "(only the time stamp of the script is used)\n";
+    CheckFeatures(packedfeatarchive::packscript(entries, ToWide(archivePath), ToWide(scpPath)), features);
+
+    // an archive that holds other utterances than the script is packed again
+    entries.pop_back();
+    features.pop_back();
+    reverse(entries.begin(), entries.end());
+    reverse(features.begin(), features.end());
+    CheckFeatures(packedfeatarchive::packscript(entries, ToWide(archivePath), ToWide(scpPath)), features);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -9,6 +9,9 @@
 #include "DataDeserializer.h"
 #include "BlockRandomizer.h"
 #include "CorpusDescriptor.h"
+#include "ChunkCache.h"
+#include "SequencePacker.h"
+#include "HeapMemoryProvider.h"
 
 #include <numeric>
 #include <random>
@@ -26,15 +29,13 @@ private:
     size_t m_chunkBegin;
     size_t m_chunkEnd;
     TensorShapePtr m_sampleLayout;
-    size_t m_sequenceLength;
     vector<vector<float>>& m_sequenceData;
 
 public:
-    MockChunk(size_t chunkBegin, size_t chunkEnd, vector<vector<float>>& sequenceData, size_t sequenceLength)
+    MockChunk(size_t chunkBegin, size_t chunkEnd, vector<vector<float>>& sequenceData)
         : m_chunkBegin(chunkBegin),
           m_chunkEnd(chunkEnd),
           m_sampleLayout(make_shared<TensorShape>(1)),
-          m_sequenceLength(sequenceLength),
           m_sequenceData(sequenceData)
     {
         assert(chunkBegin <= chunkEnd);
@@ -48,7 +49,7 @@ public:
 
         auto data = make_shared<DenseSequenceData>();
         data->m_data = &m_sequenceData[sequenceId][0];
-        data->m_numberOfSamples = m_sequenceLength;
+        data->m_numberOfSamples = m_sequenceData[sequenceId].size();
         data->m_sampleLayout = m_sampleLayout;
         result.push_back(data);
     }
@@ -59,7 +60,6 @@ public:
 class MockDeserializer : public IDataDeserializer
 {
 private:
-    size_t m_sequenceLength;
     size_t m_numChunks;
     size_t m_numSequencesPerChunk;
     vector<SequenceDescription> m_descriptions;
@@ -69,16 +69,27 @@ private:
     vector<vector<float>> m_sequenceData;
 
 public:
+    // Ids of chunks in the order they were requested.
+    vector<size_t> m_requestedChunks;
+    // Ids of prefetched chunks together with the number of chunks requested before the hint.
+    vector<pair<size_t, size_t>> m_prefetchedChunks;
+
     MockDeserializer(size_t numChunks, size_t numSequencesPerChunks, vector<float>& data, size_t sequenceLength = 1)
+        : MockDeserializer(numChunks, numSequencesPerChunks, data, vector<size_t>(data.size(), sequenceLength))
+    {
+    }
+
+    // Sequence i has sequenceLengths[i] samples, all with the value data[i].
+    MockDeserializer(size_t numChunks, size_t numSequencesPerChunks, vector<float>& data, const vector<size_t>& sequenceLengths)
         : m_numChunks(numChunks),
           m_numSequencesPerChunk(numSequencesPerChunks),
-          m_sampleLayout(make_shared<TensorShape>(1)),
-          m_sequenceLength(sequenceLength)
+          m_sampleLayout(make_shared<TensorShape>(1))
     {
+        assert(data.size() == sequenceLengths.size());
         m_sequenceData.reserve(data.size());
-        for (float d : data)
+        for (size_t i = 0; i < data.size(); i++)
         {
-            m_sequenceData.push_back(vector<float>(m_sequenceLength, d));
+            m_sequenceData.push_back(vector<float>(sequenceLengths[i], data[i]));
         }
 
         size_t numSequences = numChunks * numSequencesPerChunks;
@@ -89,7 +100,7 @@ public:
         {
             m_descriptions.push_back(SequenceDescription {
                 i,
-                m_sequenceLength,
+                m_sequenceData[i].size(),
                 i / m_numSequencesPerChunk,
                 true,
                 { 0, i }
@@ -98,9 +109,15 @@ public:
 
         for (size_t i = 0; i < numChunks; i++)
         {
+            size_t numSamples = 0;
+            for (size_t j = i * m_numSequencesPerChunk; j < (i + 1) * m_numSequencesPerChunk; j++)
+            {
+                numSamples += m_sequenceData[j].size();
+            }
+
             m_chunkDescriptions.push_back(make_shared<ChunkDescription>(ChunkDescription {
                 i,
-                m_numSequencesPerChunk * m_sequenceLength,
+                numSamples,
                 m_numSequencesPerChunk
             }));
         }
@@ -124,12 +141,20 @@ public:
     virtual ChunkPtr GetChunk(size_t chunkId) override
     {
         assert(chunkId < m_numChunks);
+        m_requestedChunks.push_back(chunkId);
         size_t chunkBegin = chunkId * m_numSequencesPerChunk;
         size_t chunkEnd = chunkBegin + m_numSequencesPerChunk;
-        shared_ptr<Chunk> chunk = make_shared<MockChunk>(chunkBegin, chunkEnd, m_sequenceData, m_sequenceLength);
+        shared_ptr<Chunk> chunk = make_shared<MockChunk>(chunkBegin, chunkEnd, m_sequenceData);
         return chunk;
     }
 
+    virtual void PrefetchChunk(size_t chunkId) override
+    {
+        assert(chunkId < m_numChunks);
+        // Remembering how many chunks have been requested so far, to check that the hint comes ahead of the request.
+        m_prefetchedChunks.push_back(make_pair(chunkId, m_requestedChunks.size()));
+    }
+
     virtual void GetSequenceDescriptionByKey(const KeyType&, SequenceDescription&) override
     {
         throw logic_error("Not implemented");
@@ -146,7 +171,7 @@ public:
         {
             descriptions.push_back(SequenceDescription{
                 i,
-                m_sequenceLength,
+                m_sequenceData[i].size(),
                 chunkId,
                 true,
                 { 0, i }
@@ -236,6 +261,40 @@ BOOST_AUTO_TEST_CASE(BlockRandomizerOneEpochWithChunks1)
         actual.begin(), actual.end());
 }
 
+BOOST_AUTO_TEST_CASE(BlockRandomizerPrefetchesNextChunk)
+{
+    vector<float> data(10);
+    iota(data.begin(), data.end(), 0.0f);
+    auto mockDeserializer = make_shared<MockDeserializer>(5, 2, data);
+
+    auto randomizer = make_shared<BlockRandomizer>(0, 4, mockDeserializer, BlockRandomizer::DecimationMode::chunk, false);
+
+    EpochConfiguration epochConfiguration;
+    epochConfiguration.m_numberOfWorkers = 1;
+    epochConfiguration.m_workerRank = 0;
+    epochConfiguration.m_minibatchSizeInSamples = 0;
+    epochConfiguration.m_totalEpochSizeInSamples = data.size();
+    epochConfiguration.m_epochIndex = 0;
+    randomizer->StartEpoch(epochConfiguration);
+
+    Sequences sequences;
+    do
+    {
+        sequences = randomizer->GetNextSequences(1);
+    } while (!sequences.m_endOfEpoch);
+
+    // All chunks are requested once, and all but the ones of the first window are hinted beforehand.
+    const auto& requested = mockDeserializer->m_requestedChunks;
+    const auto& prefetched = mockDeserializer->m_prefetchedChunks;
+    BOOST_CHECK_EQUAL(requested.size(), 5);
+    BOOST_CHECK(!prefetched.empty());
+    for (const auto& p : prefetched)
+    {
+        auto position = find(requested.begin() + p.second, requested.end(), p.first);
+        BOOST_CHECK(position != requested.end());
+    }
+}
+
 BOOST_AUTO_TEST_CASE(BlockRandomizerOneEpochWithChunks2)
 {
     vector<float> data(20);
@@ -275,6 +334,84 @@ BOOST_AUTO_TEST_CASE(BlockRandomizerOneEpochWithChunks2)
         actual.begin(), actual.end());
 }
 
+// Reads one epoch of sequences between 1 and 20 samples long through a sequence packer,
+// with or without bucketing by length. Returns the first sample of each sequence and the padding efficiency.
+static double ReadEpochWithLengthBuckets(size_t bucketSizeInSamples, vector<float>& firstSamples)
+{
+    const size_t numChunks = 10;
+    const size_t numSequencesPerChunk = 20;
+    const size_t minibatchSize = 40;
+    vector<float> data(numChunks * numSequencesPerChunk);
+    iota(data.begin(), data.end(), 0.0f);
+    vector<size_t> sequenceLengths(data.size());
+    for (size_t i = 0; i < sequenceLengths.size(); i++)
+    {
+        sequenceLengths[i] = 1 + (7 * i) % 20;
+    }
+
+    auto mockDeserializer = make_shared<MockDeserializer>(numChunks, numSequencesPerChunk, data, sequenceLengths);
+    auto randomizer = make_shared<BlockRandomizer>(0, SIZE_MAX, mockDeserializer,
+        BlockRandomizer::DecimationMode::chunk, false, false, bucketSizeInSamples);
+    auto packer = make_shared<SequencePacker>(make_shared<HeapMemoryProvider>(), randomizer, mockDeserializer->GetStreamDescriptions());
+
+    EpochConfiguration epochConfiguration;
+    epochConfiguration.m_numberOfWorkers = 1;
+    epochConfiguration.m_workerRank = 0;
+    epochConfiguration.m_minibatchSizeInSamples = minibatchSize;
+    epochConfiguration.m_totalEpochSizeInSamples = accumulate(sequenceLengths.begin(), sequenceLengths.end(), (size_t)0);
+    epochConfiguration.m_epochIndex = 0;
+    randomizer->StartEpoch(epochConfiguration);
+    packer->StartEpoch(epochConfiguration);
+
+    size_t numSamples = 0;
+    for (;;)
+    {
+        Minibatch minibatch = packer->ReadMinibatch();
+        if (!minibatch.m_data.empty())
+        {
+            const auto& layout = minibatch.m_data[0]->m_layout;
+            const float* samples = reinterpret_cast<const float*>(minibatch.m_data[0]->m_data);
+            for (const auto& sequence : layout->GetAllSequences())
+            {
+                if (sequence.seqId != GAP_SEQUENCE_ID)
+                {
+                    firstSamples.push_back(samples[layout->GetColumnIndex(sequence, 0)]);
+                }
+            }
+
+            numSamples += layout->GetActualNumSamples();
+        }
+
+        if (minibatch.m_endOfEpoch)
+        {
+            break;
+        }
+    }
+
+    BOOST_CHECK_EQUAL(numSamples, epochConfiguration.m_totalEpochSizeInSamples);
+    return packer->GetPaddingEfficiency();
+}
+
+BOOST_AUTO_TEST_CASE(BlockRandomizerOneEpochWithLengthBuckets)
+{
+    vector<float> unbucketed;
+    double unbucketedEfficiency = ReadEpochWithLengthBuckets(0, unbucketed);
+    vector<float> bucketed;
+    double bucketedEfficiency = ReadEpochWithLengthBuckets(40, bucketed);
+
+    // Bucketing only reorders sequences, each sequence is still returned exactly once per sweep.
+    BOOST_CHECK(bucketed != unbucketed);
+    sort(unbucketed.begin(), unbucketed.end());
+    sort(bucketed.begin(), bucketed.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(unbucketed.begin(), unbucketed.end(), bucketed.begin(), bucketed.end());
+    BOOST_CHECK_EQUAL(bucketed.size(), 200);
+
+    // Sequences of similar length share minibatches, so fewer gaps are allocated.
+    BOOST_TEST_MESSAGE("Padding efficiency " << unbucketedEfficiency << " without and " << bucketedEfficiency << " with buckets");
+    BOOST_CHECK_LT(unbucketedEfficiency, 1.0);
+    BOOST_CHECK_GT(bucketedEfficiency, unbucketedEfficiency);
+}
+
 BOOST_AUTO_TEST_CASE(BlockRandomizerChaosMonkey)
 {
     const int sequenceLength = 3;
@@ -406,6 +543,59 @@ BOOST_AUTO_TEST_CASE(NoRandomizerOneEpoch)
                                   actual.begin(), actual.end());
 }
 
+BOOST_AUTO_TEST_CASE(ChunkCacheUnbounded)
+{
+    vector<float> data(10);
+    iota(data.begin(), data.end(), 0.0f);
+    auto mockDeserializer = make_shared<MockDeserializer>(5, 2, data);
+
+    auto cache = make_shared<ChunkCache>(mockDeserializer);
+    cache->GetChunkDescriptions();
+
+    for (int epoch = 0; epoch < 3; epoch++)
+    {
+        for (size_t chunkId = 0; chunkId < 5; chunkId++)
+        {
+            cache->GetChunk(chunkId);
+        }
+    }
+
+    BOOST_CHECK_EQUAL(cache->GetMissCount(), 5);
+    BOOST_CHECK_EQUAL(cache->GetHitCount(), 10);
+    BOOST_CHECK_EQUAL(cache->GetEvictionCount(), 0);
+    // 5 chunks, 2 samples per chunk, 1 float per sample.
+    BOOST_CHECK_EQUAL(cache->GetSizeInBytes(), 5 * 2 * sizeof(float));
+}
+
+BOOST_AUTO_TEST_CASE(ChunkCacheLeastRecentlyUsedEviction)
+{
+    vector<float> data(10);
+    iota(data.begin(), data.end(), 0.0f);
+    auto mockDeserializer = make_shared<MockDeserializer>(5, 2, data);
+
+    // Budget for exactly two chunks.
+    auto cache = make_shared<ChunkCache>(mockDeserializer, 2 * 2 * sizeof(float));
+    cache->GetChunkDescriptions();
+
+    auto chunk0 = cache->GetChunk(0);
+    cache->GetChunk(1);
+    BOOST_CHECK(cache->GetChunk(0) == chunk0); // hit, chunk 1 becomes the least recently used one
+    cache->GetChunk(2);                        // miss, evicts chunk 1
+    BOOST_CHECK(cache->GetChunk(0) == chunk0); // hit
+    cache->GetChunk(1);                        // miss, evicts chunk 2
+
+    BOOST_CHECK_EQUAL(cache->GetHitCount(), 2);
+    BOOST_CHECK_EQUAL(cache->GetMissCount(), 4);
+    BOOST_CHECK_EQUAL(cache->GetEvictionCount(), 2);
+    BOOST_CHECK_EQUAL(cache->GetSizeInBytes(), 2 * 2 * sizeof(float));
+
+    // The data is still served correctly through the cache.
+    vector<SequenceDataPtr> sequences;
+    cache->GetChunk(1)->GetSequence(3, sequences);
+    BOOST_CHECK_EQUAL(sequences.size(), 1);
+    BOOST_CHECK_EQUAL(*reinterpret_cast<float*>(sequences[0]->m_data), 3.0f);
+}
+
 BOOST_AUTO_TEST_CASE(DefaultCorpusDescriptor)
 {
     const int seed = 13;
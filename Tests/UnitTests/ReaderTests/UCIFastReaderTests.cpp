@@ -36,6 +36,23 @@ BOOST_AUTO_TEST_CASE(UCIFastReaderSimpleDataLoop)
         1);
 };
 
+BOOST_AUTO_TEST_CASE(UCIFastReaderSimpleDataLoopMemoryMapped)
+{
+    HelperRunReaderTest<float>(
+        testDataPath() + "/Config/UCIFastReaderSimpleDataLoop_Config.cntk",
+        testDataPath() + "/Control/UCIFastReaderSimpleDataLoop_Control.txt",
+        testDataPath() + "/Control/UCIFastReaderSimpleDataLoopMemoryMapped_Output.txt",
+        "Simple_Test_MemoryMapped",
+        "reader",
+        500,
+        250,
+        2,
+        1,
+        1,
+        0,
+        1);
+};
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } } } }
@@ -0,0 +1,90 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/ReaderTestHelper.h"
+#include "UCIParser.h"
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+struct UCIParserFixture : ReaderFixture
+{
+    UCIParserFixture()
+        : ReaderFixture("/Data")
+    {
+    }
+
+    // Write numRecords records of three features and a string label, with blank lines and '\r\n' line ends mixed in.
+    static void WriteTextFile(const string& fileName, size_t numRecords)
+    {
+        ofstream file(fileName, ios::out | ios::binary);
+        for (size_t i = 0; i < numRecords; i++)
+        {
+            file << i * 0.25 << " " << -(double) (i % 97) << " " << (i % 13) * 1e-3 << " class" << i % 7;
+            file << (i % 5 == 0 ? "\r\n" : "\n");
+            if (i % 11 == 0)
+                file << "\n";
+        }
+    }
+
+    // Parse the whole file in requests of recordsPerRequest records, record the results of every request.
+    static void ParseFile(UCIParser<float, string>& parser, size_t recordsPerRequest, vector<long>& recordCounts, vector<int64_t>& positions, vector<float>& numbers, vector<string>& labels)
+    {
+        for (;;)
+        {
+            vector<float> requestNumbers;
+            vector<string> requestLabels;
+            long recordCount = parser.Parse(recordsPerRequest, &requestNumbers, &requestLabels);
+            recordCounts.push_back(recordCount);
+            positions.push_back(parser.GetFilePosition());
+            numbers.insert(numbers.end(), requestNumbers.begin(), requestNumbers.end());
+            labels.insert(labels.end(), requestLabels.begin(), requestLabels.end());
+            if (recordCount < (long) recordsPerRequest)
+                break;
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(ReaderTestSuite, UCIParserFixture)
+
+BOOST_AUTO_TEST_CASE(UCIParserParallelMatchesSerial)
+{
+    // a request is only split into pieces of at least 64KB, these are large enough for four of them
+    const size_t numRecords = 50000;
+    const size_t recordsPerRequest = 20000;
+    const string fileName = currentPath() + "/UCIParserParallel_Train.txt";
+    WriteTextFile(fileName, numRecords);
+    const wstring wideFileName(fileName.begin(), fileName.end());
+
+    vector<long> serialRecordCounts, parallelRecordCounts;
+    vector<int64_t> serialPositions, parallelPositions;
+    vector<float> serialNumbers, parallelNumbers;
+    vector<string> serialLabels, parallelLabels;
+
+    // the reference is mapped as well, since the file position of a parser that reads through a buffer is the end of the buffer
+    UCIParser<float, string> serialParser(' ', '.');
+    serialParser.SetMemoryMapping(true, 1);
+    serialParser.ParseInit(wideFileName.c_str(), 0, 3, 3, 1);
+    ParseFile(serialParser, recordsPerRequest, serialRecordCounts, serialPositions, serialNumbers, serialLabels);
+
+    UCIParser<float, string> parallelParser(' ', '.');
+    parallelParser.SetMemoryMapping(true, 4);
+    parallelParser.ParseInit(wideFileName.c_str(), 0, 3, 3, 1);
+    ParseFile(parallelParser, recordsPerRequest, parallelRecordCounts, parallelPositions, parallelNumbers, parallelLabels);
+
+    BOOST_REQUIRE_EQUAL(serialNumbers.size(), numRecords * 3);
+    BOOST_REQUIRE_EQUAL(serialLabels.size(), numRecords);
+    BOOST_CHECK_GT(serialPositions[0], 4 * 64 * 1024);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(serialRecordCounts.begin(), serialRecordCounts.end(), parallelRecordCounts.begin(), parallelRecordCounts.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(serialPositions.begin(), serialPositions.end(), parallelPositions.begin(), parallelPositions.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(serialNumbers.begin(), serialNumbers.end(), parallelNumbers.begin(), parallelNumbers.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(serialLabels.begin(), serialLabels.end(), parallelLabels.begin(), parallelLabels.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }